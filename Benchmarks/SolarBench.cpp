@@ -0,0 +1,487 @@
+// solar_bench: runs Game through scripted, deterministic scenarios and reports frame-time statistics as JSON.
+// Every scenario gets a fresh Game with a fixed simulation step, so two runs of the same build see the same frames.
+// Results can be compared against a saved run (--baseline); the exit code is 1 when a scenario regressed.
+// Input recordings (solar_system --record) can be added as scenarios (--replay); they run for their whole length.
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "Game.h"
+#include "Settings.h"
+#include "LaunchOptions.h"
+#include "AssetPack.h"
+#include "SceneDescription.h"
+
+namespace {
+	struct BenchOptions
+	{
+		int frames = 240;					//Measured frames per scenario.
+		int warmupFrames = 30;				//Frames run before measuring (shader/texture first use, caches).
+		float fixedDeltaTime = 1.0f / 60.0f;
+		bool headless = true;
+		int stressAsteroidCount = 20000;
+		float stressTimeSpeed = 50.0f;
+		int stressOrbitCount = 5000;
+		int stressTrailCount = 2000;
+		int qualityLevel = 0;				//QualityGovernor level every scenario is pinned to (0 = full detail).
+		float renderScale = 1.0f;			//Share of the framebuffer width/height the scene is rendered at (1 = native).
+		std::vector<std::string> filters;	//Scenario name prefixes to run (empty = all).
+		std::vector<std::string> replayPaths;	//Input recordings run as extra scenarios.
+		std::string outputPath = "solar_bench.json";	//JSON results.
+		std::string baselinePath;			//Previous results to diff against.
+		std::string scenePath;				//Scene every scenario builds (empty = settings::scenePath).
+		float thresholdPercent = 5.0f;		//Slowdown of mean or p95 that counts as a regression.
+	};
+
+	struct Scenario
+	{
+		std::string name;
+		int asteroidCount = -1;				//-1 = as many as the scene's belts hold.
+		float timeSpeed = 1.0f;
+		bool showOrbitPaths = false;
+		std::function<void(Game& game, int frame)> script;	//Positions the camera before each frame.
+		std::string replayPath = "";		//Input recording that drives the scenario instead (empty = none).
+	};
+
+	struct Result
+	{
+		std::string name;
+		int frames = 0;
+		double meanMs = 0.0;
+		double p50Ms = 0.0;
+		double p95Ms = 0.0;
+		double p99Ms = 0.0;
+		double cpuMeanMs = 0.0;
+		double drawCalls = 0.0;			//Mean per frame.
+		double triangles = 0.0;			//Mean per frame.
+		double stateIssued = 0.0;		//Mean GL state calls per frame that reached the driver.
+		double stateElided = 0.0;		//Mean redundant GL state calls per frame.
+		double firstFrameMs = 0.0;		//Startup: construction until the first frame was presented.
+		double fullQualityMs = 0.0;		//Startup: construction until every texture was uploaded.
+	};
+
+	void PrintUsage(const char* program)
+	{
+		std::cout << "Usage: " << program << " [options]\n"
+			<< "  --frames N               measured frames per scenario (default 240)\n"
+			<< "  --warmup N               unmeasured frames before each scenario (default 30)\n"
+			<< "  --fixed-dt SECONDS       simulation step per frame (default 1/60)\n"
+			<< "  --windowed               render into a visible window instead of offscreen\n"
+			<< "  --stress-asteroids N     belt size of the stress_asteroids scenario (default 20000)\n"
+			<< "  --stress-time-speed X    time speed of the stress_time_speed scenario (default 50)\n"
+			<< "  --stress-orbits N        extra minor-body orbit guides of the stress_orbits scenario (default 5000)\n"
+			<< "  --stress-trails N        extra asteroid trails of the stress_trails scenario (default 2000)\n"
+			<< "  --quality LEVEL          scene quality level, 0 = full detail (default) to 4 = lowest\n"
+			<< "  --render-scale S         render the scene at S x the resolution and upscale it (0.5 - 1, default 1)\n"
+			<< "  --scenario PREFIX        only run scenarios whose name starts with PREFIX (repeatable)\n"
+			<< "  --replay FILE            add the input recording FILE as scenario replay_<name> (repeatable)\n"
+			<< "  --scene FILE             run every scenario on the scene in FILE (see scene_generator)\n"
+			<< "  --out FILE               where to write the JSON results (default solar_bench.json)\n"
+			<< "  --baseline FILE          compare against results saved from an earlier run\n"
+			<< "  --threshold PERCENT      mean/p95 slowdown reported as a regression (default 5)\n";
+	}
+
+	bool ParseNumber(const char* text, double& value)
+	{
+		char* end = nullptr;
+		value = std::strtod(text, &end);
+		return end != text && *end == '\0';
+	}
+
+	bool ParseBenchOptions(int argc, char** argv, BenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			double number = 0.0;
+			if (arg == "--frames" && hasValue && ParseNumber(argv[i + 1], number) && number >= 1.0)
+			{
+				options.frames = (int)number;
+				++i;
+			}
+			else if (arg == "--warmup" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.warmupFrames = (int)number;
+				++i;
+			}
+			else if (arg == "--fixed-dt" && hasValue && ParseNumber(argv[i + 1], number) && number > 0.0)
+			{
+				options.fixedDeltaTime = (float)number;
+				++i;
+			}
+			else if (arg == "--windowed")
+			{
+				options.headless = false;
+			}
+			else if (arg == "--stress-asteroids" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.stressAsteroidCount = (int)number;
+				++i;
+			}
+			else if (arg == "--stress-time-speed" && hasValue && ParseNumber(argv[i + 1], number))
+			{
+				options.stressTimeSpeed = (float)number;
+				++i;
+			}
+			else if (arg == "--stress-orbits" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.stressOrbitCount = (int)number;
+				++i;
+			}
+			else if (arg == "--stress-trails" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.stressTrailCount = (int)number;
+				++i;
+			}
+			else if (arg == "--quality" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.qualityLevel = (int)number;
+				++i;
+			}
+			else if (arg == "--render-scale" && hasValue && ParseNumber(argv[i + 1], number) && number > 0.0 && number <= 1.0)
+			{
+				options.renderScale = (float)number;
+				++i;
+			}
+			else if (arg == "--scenario" && hasValue)
+			{
+				options.filters.push_back(argv[++i]);
+			}
+			else if (arg == "--replay" && hasValue)
+			{
+				options.replayPaths.push_back(argv[++i]);
+			}
+			else if (arg == "--scene" && hasValue)
+			{
+				options.scenePath = argv[++i];
+			}
+			else if (arg == "--out" && hasValue)
+			{
+				options.outputPath = argv[++i];
+			}
+			else if (arg == "--baseline" && hasValue)
+			{
+				options.baselinePath = argv[++i];
+			}
+			else if (arg == "--threshold" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.thresholdPercent = (float)number;
+				++i;
+			}
+			else
+			{
+				std::cout << "Invalid argument: " << arg << "\n";
+				PrintUsage(argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	//Wide view of the inner system, slowly circling the Sun.
+	void OverviewScript(Game& game, int frame)
+	{
+		const float distance = glm::length(settings::cameraInitialPosition);
+		float angle = frame * 0.004f;
+		glm::vec3 eye(distance * std::sin(angle), distance * 0.25f, distance * std::cos(angle));
+		game.SetCameraLookAt(eye, glm::vec3(0.0f));
+	}
+
+	//Skims along the middle of the scene's first asteroid belt, looking ahead along the orbit.
+	void BeltScript(Game& game, int frame)
+	{
+		const std::vector<SceneBelt>& belts = game.GetScene().belts;
+		const AsteroidBelt::Band band = belts.empty() ? AsteroidBelt::Band() : belts.front().band;
+		const float radius = 0.5f * (band.innerRadiusAU + band.outerRadiusAU) * settings::keplerAUScale;
+		float angle = frame * 0.003f;
+		glm::vec3 eye(radius * std::cos(angle), band.halfThickness * 2.0f, radius * std::sin(angle));
+		glm::vec3 ahead(radius * std::cos(angle + 0.05f), 0.0f, radius * std::sin(angle + 0.05f));
+		game.SetCameraLookAt(eye, ahead);
+	}
+
+	std::vector<Scenario> BuildScenarios(const BenchOptions& options, const SceneDescription& scene)
+	{
+		std::vector<Scenario> scenarios;
+		scenarios.push_back({ "overview", -1, 1.0f, false, OverviewScript, {} });
+		scenarios.push_back({ "belt_flythrough", -1, 1.0f, false, BeltScript, {} });
+		//Follow targets in Game's order (the scene's planets and moons), the first nine of them.
+		int followIndex = 0;
+		for (const SceneBody& body : scene.bodies)
+		{
+			if (body.kind == SceneBody::Kind::Star || followIndex == 9)
+				continue;
+			std::string name = body.name;
+			std::transform(name.begin(), name.end(), name.begin(),
+				[](unsigned char c) { return c == ' ' ? '_' : (char)std::tolower(c); });
+			const int i = followIndex++;
+			scenarios.push_back({ "follow_" + name, -1, 1.0f, false,
+				[i](Game& game, int frame) { if (frame == 0) game.SetFollowTarget(i); }, {} });
+		}
+		scenarios.push_back({ "orbit_guides", -1, 1.0f, true, OverviewScript, {} });
+		scenarios.push_back({ "body_labels", -1, 1.0f, false,
+			[](Game& game, int frame) { game.SetShowBodyLabels(true); OverviewScript(game, frame); }, {} });
+		scenarios.push_back({ "stress_asteroids", options.stressAsteroidCount, 1.0f, false, BeltScript, {} });
+		scenarios.push_back({ "stress_time_speed", -1, options.stressTimeSpeed, true, OverviewScript, {} });
+		const int orbitCount = options.stressOrbitCount;
+		scenarios.push_back({ "stress_orbits", -1, 1.0f, true,
+			[orbitCount](Game& game, int frame) { if (frame == 0) game.AddMinorBodyOrbits(orbitCount, 777); OverviewScript(game, frame); }, {} });
+		scenarios.push_back({ "trails", -1, 20.0f, false,
+			[](Game& game, int frame) { game.SetShowTrails(true); OverviewScript(game, frame); }, {} });
+		const int trailCount = options.stressTrailCount;
+		scenarios.push_back({ "stress_trails", -1, 20.0f, false,
+			[trailCount](Game& game, int frame) {
+				if (frame == 0) { game.AddAsteroidTrails(trailCount); game.SetShowTrails(true); }
+				OverviewScript(game, frame);
+			}, {} });
+		for (const std::string& path : options.replayPaths)
+		{
+			scenarios.push_back({ "replay_" + std::filesystem::path(path).stem().string(), -1, 1.0f, false,
+				[](Game&, int) {}, path });
+		}
+		return scenarios;
+	}
+
+	bool IsSelected(const BenchOptions& options, const std::string& name)
+	{
+		if (options.filters.empty())
+			return true;
+		for (const std::string& filter : options.filters)
+		{
+			if (name.compare(0, filter.size(), filter) == 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	double Percentile(const std::vector<double>& sorted, double fraction)
+	{
+		//Nearest rank.
+		size_t rank = (size_t)std::ceil(fraction * sorted.size());
+		return sorted[std::min(std::max<size_t>(rank, 1), sorted.size()) - 1];
+	}
+
+	Result RunScenario(const Scenario& scenario, const BenchOptions& options)
+	{
+		LaunchOptions launchOptions;
+		launchOptions.headless = options.headless;
+		launchOptions.fixedDeltaTime = options.fixedDeltaTime;
+		launchOptions.recordFrames = true;
+		launchOptions.asteroidCount = scenario.asteroidCount;
+		launchOptions.qualityLevel = options.qualityLevel;
+		launchOptions.renderScale = options.renderScale;
+		launchOptions.vsync = false;			//Windowed runs measure the frames, not the display's refresh.
+		launchOptions.renderOnDemand = false;
+		launchOptions.replayPath = scenario.replayPath;
+		launchOptions.scenePath = options.scenePath;
+
+		using namespace settings;
+		Game game{ windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, windowTitle, launchOptions };
+		game.SetShowOrbitPaths(scenario.showOrbitPaths);
+		game.SetTimeSpeed(scenario.timeSpeed);
+		const int totalFrames = options.warmupFrames + options.frames;
+		//A replay ends by closing the game once its recording runs out.
+		const bool replay = !scenario.replayPath.empty();
+		for (int frame = 0; (replay || frame < totalFrames) && !game.ShouldClose(); ++frame)
+		{
+			scenario.script(game, frame);
+			game.Tick();
+		}
+
+		Result result;
+		result.name = scenario.name;
+		const std::vector<Game::FrameRecord>& records = game.GetFrameRecords();
+		if ((int)records.size() <= options.warmupFrames)
+			return result;
+		std::vector<double> frameMs;
+		for (size_t i = options.warmupFrames; i < records.size(); ++i)
+		{
+			const Game::FrameRecord& record = records[i];
+			frameMs.push_back(record.frameMs);
+			result.meanMs += record.frameMs;
+			result.cpuMeanMs += record.cpuMs;
+			result.drawCalls += record.drawCalls;
+			result.triangles += (double)record.triangles;
+			result.stateIssued += record.stateChangesIssued;
+			result.stateElided += record.stateChangesElided;
+		}
+		result.frames = (int)frameMs.size();
+		result.meanMs /= result.frames;
+		result.cpuMeanMs /= result.frames;
+		result.drawCalls /= result.frames;
+		result.triangles /= result.frames;
+		result.stateIssued /= result.frames;
+		result.stateElided /= result.frames;
+		std::sort(frameMs.begin(), frameMs.end());
+		result.p50Ms = Percentile(frameMs, 0.50);
+		result.p95Ms = Percentile(frameMs, 0.95);
+		result.p99Ms = Percentile(frameMs, 0.99);
+		result.firstFrameMs = game.GetTimeToFirstFrameMs();
+		result.fullQualityMs = game.GetTimeToFullQualityMs();
+		return result;
+	}
+
+	//One scenario per line so that baselines can be read back without a JSON library.
+	void WriteResults(std::ostream& out, const BenchOptions& options, const std::vector<Result>& results)
+	{
+		out << std::fixed << std::setprecision(4);
+		out << "{\n\"benchmark\": \"solar_bench\", \"frames\": " << options.frames << ", \"warmup\": " << options.warmupFrames
+			<< ", \"fixed_dt\": " << options.fixedDeltaTime << ", \"quality\": " << options.qualityLevel
+			<< ", \"render_scale\": " << options.renderScale
+			<< ", \"headless\": " << (options.headless ? "true" : "false")
+			<< ", \"width\": " << settings::viewportWidth << ", \"height\": " << settings::viewportHeight << ",\n\"scenarios\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Result& r = results[i];
+			out << "{\"name\": \"" << r.name << "\", \"frames\": " << r.frames
+				<< ", \"mean_ms\": " << r.meanMs << ", \"p50_ms\": " << r.p50Ms << ", \"p95_ms\": " << r.p95Ms
+				<< ", \"p99_ms\": " << r.p99Ms << ", \"cpu_mean_ms\": " << r.cpuMeanMs
+				<< ", \"draw_calls\": " << r.drawCalls << ", \"triangles\": " << r.triangles
+				<< ", \"state_issued\": " << r.stateIssued << ", \"state_elided\": " << r.stateElided
+				<< ", \"time_to_first_frame_ms\": " << r.firstFrameMs << ", \"time_to_full_quality_ms\": " << r.fullQualityMs << "}"
+				<< (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		out << "]\n}\n";
+	}
+
+	bool ReadField(const std::string& line, const std::string& key, double& value)
+	{
+		size_t position = line.find("\"" + key + "\":");
+		if (position == std::string::npos)
+			return false;
+		value = std::strtod(line.c_str() + position + key.size() + 3, nullptr);
+		return true;
+	}
+
+	bool ReadBaseline(const std::string& path, std::vector<Result>& baseline)
+	{
+		std::ifstream file(path);
+		if (!file)
+		{
+			std::cout << "Could not read baseline: " << path << "\n";
+			return false;
+		}
+		std::string line;
+		while (std::getline(file, line))
+		{
+			size_t nameStart = line.find("\"name\": \"");
+			if (nameStart == std::string::npos)
+			{
+				continue;
+			}
+			nameStart += 9;
+			Result r;
+			r.name = line.substr(nameStart, line.find('"', nameStart) - nameStart);
+			double frames = 0.0;
+			ReadField(line, "frames", frames);
+			r.frames = (int)frames;
+			ReadField(line, "mean_ms", r.meanMs);
+			ReadField(line, "p50_ms", r.p50Ms);
+			ReadField(line, "p95_ms", r.p95Ms);
+			ReadField(line, "p99_ms", r.p99Ms);
+			ReadField(line, "cpu_mean_ms", r.cpuMeanMs);
+			ReadField(line, "draw_calls", r.drawCalls);
+			ReadField(line, "triangles", r.triangles);
+			ReadField(line, "state_issued", r.stateIssued);
+			ReadField(line, "state_elided", r.stateElided);
+			baseline.push_back(r);
+		}
+		return true;
+	}
+
+	//Prints the change of every metric and returns the number of scenarios that regressed.
+	int DiffAgainstBaseline(const std::vector<Result>& results, const std::vector<Result>& baseline, float thresholdPercent)
+	{
+		auto change = [](double before, double after) { return before > 0.0 ? (after - before) / before * 100.0 : 0.0; };
+		int regressions = 0;
+		std::cout << std::fixed << std::setprecision(2);
+		std::cout << std::left << std::setw(20) << "scenario" << std::right
+			<< std::setw(12) << "mean %" << std::setw(12) << "p50 %" << std::setw(12) << "p95 %" << std::setw(12) << "p99 %"
+			<< std::setw(12) << "draws %" << std::setw(12) << "tris %" << "\n";
+		for (const Result& r : results)
+		{
+			auto match = std::find_if(baseline.begin(), baseline.end(), [&](const Result& b) { return b.name == r.name; });
+			if (match == baseline.end())
+			{
+				std::cout << std::left << std::setw(20) << r.name << std::right << "  (not in baseline)\n";
+				continue;
+			}
+			double meanChange = change(match->meanMs, r.meanMs);
+			double p95Change = change(match->p95Ms, r.p95Ms);
+			bool regressed = meanChange > thresholdPercent || p95Change > thresholdPercent;
+			regressions += regressed ? 1 : 0;
+			std::cout << std::left << std::setw(20) << r.name << std::right
+				<< std::setw(12) << meanChange << std::setw(12) << change(match->p50Ms, r.p50Ms)
+				<< std::setw(12) << p95Change << std::setw(12) << change(match->p99Ms, r.p99Ms)
+				<< std::setw(12) << change(match->drawCalls, r.drawCalls) << std::setw(12) << change(match->triangles, r.triangles)
+				<< (regressed ? "  REGRESSION" : "") << "\n";
+		}
+		return regressions;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchOptions options;
+	if (!ParseBenchOptions(argc, argv, options))
+	{
+		return EXIT_FAILURE;
+	}
+	//The follow scenarios are named after the scene's bodies.
+	SceneDescription scene;
+	{
+		const std::string scenePath = options.scenePath.empty() ? settings::scenePath : options.scenePath;
+		AssetPack assetPack(settings::assetPackPath);
+		if (!LoadScene(scenePath, assetPack, scene))
+		{
+			std::cout << "Failed to load the scene: " << scenePath << "\n";
+			return EXIT_FAILURE;
+		}
+	}
+	std::vector<Result> results;
+	for (const Scenario& scenario : BuildScenarios(options, scene))
+	{
+		if (!IsSelected(options, scenario.name))
+			continue;
+		std::cout << "Running " << scenario.name << "...\n";
+		results.push_back(RunScenario(scenario, options));
+		const Result& r = results.back();
+		std::cout << std::fixed << std::setprecision(2) << "  mean " << r.meanMs << " ms, p95 " << r.p95Ms << " ms, "
+			<< r.drawCalls << " draws, " << r.triangles << " triangles, "
+			<< r.stateIssued << " state calls (" << r.stateElided << " skipped)\n";
+	}
+
+	{
+		std::ofstream file(options.outputPath);
+		if (!file)
+		{
+			std::cout << "Could not write results: " << options.outputPath << "\n";
+			return EXIT_FAILURE;
+		}
+		WriteResults(file, options, results);
+		std::cout << "Wrote " << results.size() << " scenarios to " << options.outputPath << "\n";
+	}
+
+	if (!options.baselinePath.empty())
+	{
+		std::vector<Result> baseline;
+		if (!ReadBaseline(options.baselinePath, baseline))
+		{
+			return EXIT_FAILURE;
+		}
+		if (DiffAgainstBaseline(results, baseline, options.thresholdPercent) > 0)
+		{
+			return 1;
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,489 @@
+// solar_microbench: throughput of the simulation and asset hot paths, one kernel at a time.
+// Each benchmark is warmed up, calibrated so that one sample lasts at least --min-sample-ms, then sampled
+// --repetitions times on a pinned CPU; the median and the relative spread are reported so that
+// regressions in a kernel show up before they are buried in whole-frame numbers (see solar_bench).
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "AsteroidBelt.h"
+#include "Mesh.h"
+#include "Orbital.h"
+#include "Settings.h"
+#include "Window.h"
+#include "objload.h"
+#include "stb_image.h"
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <sched.h>
+#endif
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+	struct MicrobenchOptions
+	{
+		int repetitions = 15;			//Samples per benchmark.
+		double minSampleMs = 20.0;		//Calibrate the calls per sample until a sample lasts this long.
+		double warmupMs = 100.0;		//Run the kernel this long before calibrating.
+		double maxBenchSeconds = 5.0;	//Fewer repetitions (at least 3) for kernels slower than this budget allows.
+		int cpu = 0;					//CPU to pin the benchmark thread to.
+		bool pin = true;
+		std::vector<std::string> filters;	//Substrings of benchmark names to run (empty = all).
+		std::string outputPath;			//JSON results (empty = table only).
+	};
+
+	struct Statistics
+	{
+		std::string name;
+		double itemsPerCall;
+		long long callsPerSample;
+		int samples;
+		double medianNs = 0.0;			//Per call.
+		double minNs = 0.0;
+		double meanNs = 0.0;
+		double relativeStdDev = 0.0;	//Percent of the mean.
+	};
+
+#if defined(_MSC_VER)
+	volatile char optimizationSink;
+	template<class T> void DoNotOptimize(const T& value)
+	{
+		optimizationSink = *reinterpret_cast<const volatile char*>(&value);
+		_ReadWriteBarrier();
+	}
+#else
+	//Makes the compiler assume value is read, so the work producing it cannot be removed.
+	template<class T> void DoNotOptimize(const T& value)
+	{
+		asm volatile("" : : "r,m"(value) : "memory");
+	}
+#endif
+
+	bool PinToCpu(int cpu)
+	{
+#if defined(_WIN32)
+		return SetThreadAffinityMask(GetCurrentThread(), DWORD_PTR(1) << cpu) != 0;
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return sched_setaffinity(0, sizeof(set), &set) == 0;
+#else
+		(void)cpu;
+		return false;	//No affinity API (macOS): results are noisier.
+#endif
+	}
+
+	class Harness
+	{
+	public:
+		explicit Harness(const MicrobenchOptions& options) : options(options) {}
+		bool IsSelected(const std::string& name) const
+		{
+			if (options.filters.empty())
+				return true;
+			for (const std::string& filter : options.filters)
+			{
+				if (name.find(filter) != std::string::npos)
+					return true;
+			}
+			return false;
+		}
+		//Times body(), which processes itemsPerCall items (vertices, positions, steps, pixels...).
+		template<class Body> void Run(const std::string& name, double itemsPerCall, Body&& body)
+		{
+			if (!IsSelected(name))
+				return;
+			using Clock = std::chrono::steady_clock;
+			auto timeCalls = [&](long long calls)
+			{
+				auto start = Clock::now();
+				for (long long i = 0; i < calls; ++i)
+				{
+					body();
+				}
+				return std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+			};
+			//Warm caches, branch predictors and the CPU clock.
+			auto warmupStart = Clock::now();
+			do
+			{
+				body();
+			} while (std::chrono::duration<double, std::milli>(Clock::now() - warmupStart).count() < options.warmupMs);
+			//Calibrate.
+			long long calls = 1;
+			double sampleNs = timeCalls(calls);
+			while (sampleNs < options.minSampleMs * 1e6 && calls < (1LL << 40))
+			{
+				calls *= 2;
+				sampleNs = timeCalls(calls);
+			}
+			int repetitions = options.repetitions;
+			double budgetSamples = options.maxBenchSeconds * 1e9 / std::max(sampleNs, 1.0);
+			repetitions = std::max(3, std::min(repetitions, (int)budgetSamples));
+			std::vector<double> perCallNs;
+			for (int r = 0; r < repetitions; ++r)
+			{
+				perCallNs.push_back(timeCalls(calls) / calls);
+			}
+
+			Statistics stats{ name, itemsPerCall, calls, repetitions };
+			std::sort(perCallNs.begin(), perCallNs.end());
+			stats.medianNs = perCallNs[perCallNs.size() / 2];
+			stats.minNs = perCallNs.front();
+			double sum = 0.0, squares = 0.0;
+			for (double ns : perCallNs)
+			{
+				sum += ns;
+			}
+			stats.meanNs = sum / perCallNs.size();
+			for (double ns : perCallNs)
+			{
+				squares += (ns - stats.meanNs) * (ns - stats.meanNs);
+			}
+			stats.relativeStdDev = 100.0 * std::sqrt(squares / perCallNs.size()) / stats.meanNs;
+			Print(stats);
+			results.push_back(stats);
+		}
+		const std::vector<Statistics>& GetResults() const
+		{
+			return results;
+		}
+	private:
+		static void Print(const Statistics& stats)
+		{
+			double itemsPerSecond = stats.itemsPerCall / (stats.medianNs * 1e-9);
+			std::cout << std::left << std::setw(36) << stats.name << std::right << std::fixed
+				<< std::setw(14) << std::setprecision(1) << stats.medianNs << " ns/call"
+				<< std::setw(12) << std::setprecision(2) << stats.medianNs / stats.itemsPerCall << " ns/item"
+				<< std::setw(12) << std::setprecision(2) << itemsPerSecond * 1e-6 << " M items/s"
+				<< "  +-" << std::setprecision(1) << stats.relativeStdDev << "%\n";
+		}
+	private:
+		const MicrobenchOptions& options;
+		std::vector<Statistics> results;
+	};
+
+	void PrintUsage(const char* program)
+	{
+		std::cout << "Usage: " << program << " [options]\n"
+			<< "  --filter TEXT          only run benchmarks whose name contains TEXT (repeatable)\n"
+			<< "  --repetitions N        samples per benchmark (default 15)\n"
+			<< "  --min-sample-ms MS     minimum duration of one sample (default 20)\n"
+			<< "  --warmup-ms MS         warmup per benchmark (default 100)\n"
+			<< "  --cpu N                CPU to pin to (default 0)\n"
+			<< "  --no-pin               do not pin the thread\n"
+			<< "  --out FILE             also write the results as JSON\n";
+	}
+
+	bool ParseNumber(const char* text, double& value)
+	{
+		char* end = nullptr;
+		value = std::strtod(text, &end);
+		return end != text && *end == '\0';
+	}
+
+	bool ParseMicrobenchOptions(int argc, char** argv, MicrobenchOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			double number = 0.0;
+			if (arg == "--filter" && hasValue)
+			{
+				options.filters.push_back(argv[++i]);
+			}
+			else if (arg == "--repetitions" && hasValue && ParseNumber(argv[i + 1], number) && number >= 1.0)
+			{
+				options.repetitions = (int)number;
+				++i;
+			}
+			else if (arg == "--min-sample-ms" && hasValue && ParseNumber(argv[i + 1], number) && number > 0.0)
+			{
+				options.minSampleMs = number;
+				++i;
+			}
+			else if (arg == "--warmup-ms" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.warmupMs = number;
+				++i;
+			}
+			else if (arg == "--cpu" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+			{
+				options.cpu = (int)number;
+				++i;
+			}
+			else if (arg == "--no-pin")
+			{
+				options.pin = false;
+			}
+			else if (arg == "--out" && hasValue)
+			{
+				options.outputPath = argv[++i];
+			}
+			else
+			{
+				std::cout << "Invalid argument: " << arg << "\n";
+				PrintUsage(argv[0]);
+				return false;
+			}
+		}
+		return true;
+	}
+
+	void BenchmarkOrbits(Harness& harness)
+	{
+		//Earth's elements with the eccentricity swept up to near-parabolic (more Newton iterations matter there).
+		const double eccentricities[] = { 0.0, 0.0167, 0.2056, 0.5, 0.9, 0.99 };
+		const int positionsPerCall = 1000;
+		for (double e : eccentricities)
+		{
+			OrbitalElements elements{ settings::keplerAUScale, e, 7.0, 48.3, 29.1, 174.8, 360.0 / 365.256, settings::epochJD_J2000 };
+			std::ostringstream name;
+			name << "orbital/positionAtJD/e=" << std::fixed << std::setprecision(4) << e;
+			double jd = settings::epochJD_J2000;
+			harness.Run(name.str(), positionsPerCall, [&]()
+			{
+				glm::vec3 sum(0.0f);
+				for (int i = 0; i < positionsPerCall; ++i)
+				{
+					sum += orbitalPositionAtJD(elements, jd + i * 0.37);
+				}
+				jd += 1.0;
+				DoNotOptimize(sum);
+			});
+		}
+
+		//The Moon's sub-steps, as Game::Update runs them (orbit of the default scene's Moon).
+		const double twoPi = 6.283185307179586;
+		const double moonOrbitRadius = 35.0;
+		const double periodMoonSec = 27.321661 * 86400.0;
+		const float muEarth = (float)(twoPi * twoPi * std::pow(moonOrbitRadius, 3.0) / (periodMoonSec * periodMoonSec));
+		glm::vec3 position((float)moonOrbitRadius, 0.0f, 0.0f);
+		glm::vec3 velocity(0.0f, 0.0f, (float)(twoPi * moonOrbitRadius / periodMoonSec));
+		const int stepsPerCall = 1000;
+		harness.Run("orbital/moonLeapfrog/step", stepsPerCall, [&]()
+		{
+			integrateLeapfrog(position, velocity, muEarth, 600.0 * stepsPerCall, 600.0);
+			DoNotOptimize(position);
+		});
+	}
+
+	void BenchmarkMeshes(Harness& harness)
+	{
+		//Generation includes the upload into a fresh VAO/VBOs, like at startup.
+		for (int subdivisions = 0; subdivisions <= 5; ++subdivisions)
+		{
+			double vertices = 60.0 * std::pow(4.0, subdivisions);	//20 faces * 4^n, 3 vertices each.
+			harness.Run("mesh/icoSphere/sub=" + std::to_string(subdivisions), vertices, [&]()
+			{
+				Mesh mesh = Mesh::GenerateIcoSphere(subdivisions, 1.0f);
+				DoNotOptimize(mesh.GetVAO());
+			});
+			harness.Run("mesh/craggyAsteroid/sub=" + std::to_string(subdivisions), vertices, [&]()
+			{
+				Mesh mesh = Mesh::GenerateCraggyAsteroid(subdivisions, 1.0f, 0.2f, 3.0f, 101);
+				DoNotOptimize(mesh.GetVAO());
+			});
+		}
+	}
+
+	//A generated 1000x1000 quad grid (2M triangles, ~90 MB) written in the mixed forms loadOBJ accepts: quads,
+	//v/vt/vn and v//vn corners, negative indices. The parser threads share the pinned CPU unless --no-pin is given.
+	void BenchmarkLargeObj(Harness& harness)
+	{
+		const std::string name = "obj/loadOBJ/grid_2M_triangles";
+		if (!harness.IsSelected(name))
+			return;
+		const int side = 1000;
+		std::error_code ec;
+		const std::filesystem::path path = std::filesystem::temp_directory_path(ec) / "solar_microbench_grid.obj";
+		{
+			std::ofstream file(path);
+			file << std::fixed << std::setprecision(6);
+			for (int z = 0; z <= side; ++z)
+			{
+				for (int x = 0; x <= side; ++x)
+				{
+					file << "v " << x / (float)side << ' ' << 0.05f * std::sin(x * 0.1f + z * 0.07f) << ' ' << z / (float)side << '\n';
+					file << "vt " << x / (float)side << ' ' << z / (float)side << '\n';
+				}
+			}
+			file << "vn 0 1 0\n";
+			for (int z = 0; z < side; ++z)
+			{
+				for (int x = 0; x < side; ++x)
+				{
+					int a = z * (side + 1) + x + 1;
+					int b = a + side + 1;
+					if ((x + z) % 2 == 0)
+						file << "f " << a << '/' << a << "/1 " << b << '/' << b << "/1 " << b + 1 << '/' << b + 1 << "/1 " << a + 1 << '/' << a + 1 << "/1\n";
+					else
+						file << "f " << a << "//-1 " << b << "//-1 " << b + 1 << "//-1 " << a + 1 << "//-1\n";
+				}
+			}
+		}
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		ObjLoadStatistics statistics;
+		if (loadOBJ(path.string().c_str(), positions, uvs, normals, &statistics))
+		{
+			std::cout << "  " << name << ": " << statistics.bytes / (1024 * 1024) << " MB, " << statistics.chunks << " chunks\n";
+			harness.Run(name, (double)statistics.triangles, [&]()
+			{
+				positions.clear();
+				uvs.clear();
+				normals.clear();
+				loadOBJ(path.string().c_str(), positions, uvs, normals);
+				DoNotOptimize(positions.data());
+			});
+		}
+		std::filesystem::remove(path, ec);
+	}
+
+	void BenchmarkObj(Harness& harness)
+	{
+		const std::string path = settings::meshesPath + "sphere.obj";
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		if (!harness.IsSelected("obj/loadOBJ/sphere.obj") || !loadOBJ(path.c_str(), positions, uvs, normals))
+			return;
+		double vertices = (double)positions.size();
+		harness.Run("obj/loadOBJ/sphere.obj", vertices, [&]()
+		{
+			positions.clear();
+			uvs.clear();
+			normals.clear();
+			loadOBJ(path.c_str(), positions, uvs, normals);
+			DoNotOptimize(positions.data());
+		});
+	}
+
+	void BenchmarkTextureDecode(Harness& harness)
+	{
+		std::error_code ec;
+		std::vector<std::filesystem::path> files;
+		for (const auto& entry : std::filesystem::directory_iterator(settings::texturesPath, ec))
+		{
+			if (entry.is_regular_file())
+				files.push_back(entry.path());
+		}
+		std::sort(files.begin(), files.end());
+		for (const std::filesystem::path& file : files)
+		{
+			std::string name = "stb/decode/" + file.filename().string();
+			if (!harness.IsSelected(name))
+				continue;
+			//Decode from memory so the disk is not part of the measurement.
+			std::ifstream stream(file, std::ios::binary);
+			std::vector<unsigned char> bytes((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+			int width = 0, height = 0, channels = 0;
+			if (!stbi_info_from_memory(bytes.data(), (int)bytes.size(), &width, &height, &channels))
+				continue;
+			harness.Run(name, (double)width * height, [&]()
+			{
+				int w, h, c;
+				unsigned char* pixels = stbi_load_from_memory(bytes.data(), (int)bytes.size(), &w, &h, &c, 0);
+				DoNotOptimize(pixels);
+				stbi_image_free(pixels);
+			});
+		}
+	}
+
+	void BenchmarkAsteroids(Harness& harness)
+	{
+		const int counts[] = { 1000, 10000, 100000, 1000000 };
+		for (int count : counts)
+		{
+			std::string updateName = "asteroids/update/" + std::to_string(count);
+			std::string matricesName = "asteroids/modelMatrices/" + std::to_string(count);
+			if (!harness.IsSelected(updateName) && !harness.IsSelected(matricesName))
+				continue;
+			AsteroidBelt belt;
+			AsteroidBelt::Band band;
+			band.count = count;
+			belt.Generate({ band }, 4);
+			std::vector<glm::mat4> matrices;
+			harness.Run(updateName, count, [&]()
+			{
+				belt.Update(1.0f / 60.0f);
+				DoNotOptimize(belt.GetAsteroids().data());
+			});
+			harness.Run(matricesName, count, [&]()
+			{
+				belt.BuildModelMatrices(matrices);
+				DoNotOptimize(matrices.data());
+			});
+		}
+	}
+
+	void WriteResults(const std::string& path, const std::vector<Statistics>& results)
+	{
+		std::ofstream file(path);
+		if (!file)
+		{
+			std::cout << "Could not write results: " << path << "\n";
+			return;
+		}
+		file << std::fixed << std::setprecision(3) << "{\n\"benchmark\": \"solar_microbench\",\n\"results\": [\n";
+		for (size_t i = 0; i < results.size(); ++i)
+		{
+			const Statistics& s = results[i];
+			file << "{\"name\": \"" << s.name << "\", \"items_per_call\": " << s.itemsPerCall
+				<< ", \"calls_per_sample\": " << s.callsPerSample << ", \"samples\": " << s.samples
+				<< ", \"median_ns\": " << s.medianNs << ", \"min_ns\": " << s.minNs << ", \"mean_ns\": " << s.meanNs
+				<< ", \"rsd_percent\": " << s.relativeStdDev << "}" << (i + 1 < results.size() ? ",\n" : "\n");
+		}
+		file << "]\n}\n";
+	}
+}
+
+int main(int argc, char** argv)
+{
+	MicrobenchOptions options;
+	if (!ParseMicrobenchOptions(argc, argv, options))
+	{
+		return EXIT_FAILURE;
+	}
+	if (options.pin && !PinToCpu(options.cpu))
+	{
+		std::cout << "Could not pin to CPU " << options.cpu << ", results may be noisy\n";
+	}
+	Harness harness(options);
+	BenchmarkOrbits(harness);
+	BenchmarkAsteroids(harness);
+	BenchmarkObj(harness);
+	BenchmarkLargeObj(harness);
+	BenchmarkTextureDecode(harness);
+	bool anyMeshSelected = false;
+	for (int subdivisions = 0; subdivisions <= 5; ++subdivisions)
+	{
+		anyMeshSelected |= harness.IsSelected("mesh/icoSphere/sub=" + std::to_string(subdivisions))
+			|| harness.IsSelected("mesh/craggyAsteroid/sub=" + std::to_string(subdivisions));
+	}
+	if (anyMeshSelected)
+	{
+		//Mesh generators upload to the GPU: they need a (headless) context.
+		using namespace settings;
+		Window window(windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, windowTitle, nullptr, nullptr, true);
+		BenchmarkMeshes(harness);
+	}
+	if (!options.outputPath.empty())
+	{
+		WriteResults(options.outputPath, harness.GetResults());
+	}
+	return 0;
+}
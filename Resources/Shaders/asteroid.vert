@@ -0,0 +1,72 @@
+// Vertex shader for the instanced asteroid belt: every rock is the same unit icosphere, displaced here by
+// the value noise Mesh::GenerateCraggyAsteroid uses on the CPU, with a per-instance seed
+// - Inputs: unit sphere position (0); per instance: model matrix (1-4), shape (5) = seed offset, amplitude,
+//   frequency, radius
+// - Outputs: world-space normal and position, plus flipped V texcoord (same as surface.vert)
+// - Uniforms: viewProjection
+// Also used for the depth prepass and the overdraw view, so gl_Position stays invariant across the passes
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in mat4 aModel;
+layout (location = 5) in vec4 aShape;
+
+out vec2 textureCoordinate;
+out vec3 normal;
+out vec3 fragmentPosition;
+
+invariant gl_Position;
+
+uniform mat4 viewProjection;
+
+const float normalStep = 0.01; // angle between the vertex and the neighbours the normal is measured with
+
+float hash31(vec3 p)
+{
+    vec3 q = fract(p * 0.3183099 + vec3(0.71, 0.113, 0.419));
+    q += dot(q, q.yzx + 19.19);
+    return fract((q.x + q.y) * q.z);
+}
+
+float noise3D(vec3 p)
+{
+    vec3 i = floor(p);
+    vec3 f = p - i;
+    vec3 u = f * f * (3.0 - 2.0 * f);
+    float nx00 = mix(hash31(i + vec3(0, 0, 0)), hash31(i + vec3(1, 0, 0)), u.x);
+    float nx01 = mix(hash31(i + vec3(0, 0, 1)), hash31(i + vec3(1, 0, 1)), u.x);
+    float nx10 = mix(hash31(i + vec3(0, 1, 0)), hash31(i + vec3(1, 1, 0)), u.x);
+    float nx11 = mix(hash31(i + vec3(0, 1, 1)), hash31(i + vec3(1, 1, 1)), u.x);
+    return mix(mix(nx00, nx10, u.y), mix(nx01, nx11, u.y), u.z);
+}
+
+// Surface point in the direction of the unit vector d
+vec3 displace(vec3 d)
+{
+    vec3 p = d * aShape.z + aShape.x;
+    float n = 0.0;
+    float scale = 1.0;
+    for (int o = 0; o < 4; ++o)
+    {
+        n += noise3D(p) * scale;
+        p *= 2.0;
+        scale *= 0.5;
+    }
+    return d * (aShape.w * (1.0 + aShape.y * (n - 0.5)));
+}
+
+void main()
+{
+    vec3 d = normalize(aPosition);
+    vec3 surface = displace(d);
+    // Normal from two neighbouring surface points, along tangents with cross(t1, t2) = d (points outwards)
+    vec3 t1 = normalize(cross(abs(d.y) < 0.99 ? vec3(0.0, 1.0, 0.0) : vec3(1.0, 0.0, 0.0), d));
+    vec3 t2 = cross(d, t1);
+    vec3 s1 = displace(normalize(d + normalStep * t1));
+    vec3 s2 = displace(normalize(d + normalStep * t2));
+    vec3 localNormal = cross(s1 - surface, s2 - surface);
+
+    textureCoordinate = vec2(0.5 + atan(d.z, d.x) / 6.2831853, 0.5 + asin(d.y) / 3.14159265);
+    normal = transpose(inverse(mat3(aModel))) * localNormal;
+    fragmentPosition = vec3(aModel * vec4(surface, 1.0));
+    gl_Position = viewProjection * vec4(fragmentPosition, 1.0);
+}
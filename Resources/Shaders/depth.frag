@@ -0,0 +1,6 @@
+// Empty fragment shader for the depth prepass (color writes are masked off)
+#version 330 core
+
+void main()
+{
+}
@@ -0,0 +1,13 @@
+// Position-only vertex shader for the depth prepass and the overdraw view
+// gl_Position is invariant so depth matches the shading pass exactly (GL_LEQUAL)
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+
+invariant gl_Position;
+
+uniform mat4 MVP;
+
+void main()
+{
+    gl_Position = MVP * vec4(aPosition, 1.0);
+}
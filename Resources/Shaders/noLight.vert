@@ -1,16 +0,0 @@
-// Minimal vertex shader for unlit rendering (sun, skybox)
-// Passes only texture coordinates; no normals/lighting
-#version 330 core
-layout (location = 0) in vec3 aPos;
-layout (location = 1) in vec2 aTexture;
-layout (location = 2) in vec3 aNormals;
-
-out vec2 textureCoordinate;
-
-uniform mat4 MVP;
-
-void main()
-{
-    gl_Position = MVP * vec4(aPos, 1.0);
-    textureCoordinate = aTexture;
-}
@@ -1,12 +1,10 @@
 #version 330 core
 
-out vec4 FragColor;
+in vec4 pathColor;
 
-uniform vec3 color;
-uniform float opacity;
+out vec4 FragColor;
 
 void main()
 {
-    FragColor = vec4(color, opacity);
+    FragColor = pathColor;
 }
-
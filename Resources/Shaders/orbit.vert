@@ -1,11 +1,31 @@
 #version 330 core
 
 layout (location = 0) in vec3 aPos;
+layout (location = 1) in uint aPath;
+layout (location = 2) in float aTime;   // trails: sample time (orbit guides leave it at 0)
 
-uniform mat4 MVP;
+uniform mat4 viewProjection;
+uniform samplerBuffer pathData; // per path: (color, opacity), (offset, fade duration; 0 = no fade)
+uniform int highlightedPath;
+uniform float time;             // trails: current time on the same clock as aTime
+
+out vec4 pathColor;
 
 void main()
 {
-    gl_Position = MVP * vec4(aPos, 1.0);
-}
+    int path = int(aPath);
+    vec4 style = texelFetch(pathData, path * 2);
+    vec4 placement = texelFetch(pathData, path * 2 + 1);
+    gl_Position = viewProjection * vec4(aPos + placement.xyz, 1.0);
 
+    pathColor = style;
+    if (placement.w > 0.0)
+    {
+        // Older samples fade out linearly
+        pathColor.a *= clamp(1.0 - (time - aTime) / placement.w, 0.0, 1.0);
+    }
+    if (path == highlightedPath)
+    {
+        pathColor = vec4(mix(style.rgb, vec3(1.0), 0.35), min(style.a + 0.2, 1.0));
+    }
+}
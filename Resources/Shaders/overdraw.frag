@@ -0,0 +1,10 @@
+// Overdraw view: every shaded fragment adds a fixed amount (additive blending),
+// so brighter pixels were shaded more times
+#version 330 core
+
+out vec4 FragColor;
+
+void main()
+{
+    FragColor = vec4(0.15, 0.06, 0.02, 1.0);
+}
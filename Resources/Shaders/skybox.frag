@@ -0,0 +1,20 @@
+// Fragment shader for the cubemap skybox
+// Slowly rotates the sky about the Y axis (same drift the old textured sphere had)
+#version 330 core
+
+in vec3 viewDirection;
+
+out vec4 FragColor;
+
+uniform samplerCube skyboxSampler;
+uniform float timeSeconds;
+
+void main()
+{
+    vec3 d = normalize(viewDirection);
+    float a = 0.06283185307 * timeSeconds; // 0.01 turns per time unit
+    float c = cos(a), s = sin(a);
+    d = vec3(d.x * c - d.z * s, d.y, d.x * s + d.z * c);
+    vec3 col = texture(skyboxSampler, d).rgb;
+    FragColor = vec4(min(col * 1.15, 1.0), 1.0);
+}
@@ -0,0 +1,18 @@
+// Vertex shader for the cubemap skybox
+// Emits one full-screen triangle from gl_VertexID (no vertex buffers) at depth 1,
+// so with GL_LEQUAL the sky only shades pixels that no opaque geometry covered.
+// - Uniforms: inverseViewProjection (inverse of projection * rotation-only view)
+#version 330 core
+
+out vec3 viewDirection;
+
+uniform mat4 inverseViewProjection;
+
+void main()
+{
+    // Vertices (-1,-1), (3,-1), (-1,3) cover the whole viewport
+    vec2 ndc = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2)) * 2.0 - 1.0;
+    vec4 world = inverseViewProjection * vec4(ndc, 1.0, 1.0);
+    viewDirection = world.xyz / world.w;
+    gl_Position = vec4(ndc, 1.0, 1.0);
+}
@@ -0,0 +1,96 @@
+// Fragment shader of the surface uber-shader. Every feature is a compile-time #define, so each permutation
+// only pays for the lighting terms and texture fetches it uses:
+//  - RIM_LIGHT: soft rim that eases the terminator of small bodies (viewPosition)
+//  - UV_FLOW: slowly drifting UVs for the gas giants (timeSeconds)
+//  - NIGHT_LIGHTS: night-side map on unit 1, blended in across the terminator (nightTexture)
+//  - SPECULAR_MASK: sun highlight masked by a map on unit 2 (specularTexture, specularStrength, specularShininess)
+//  - CLOUDS: cloud layer on unit 3 added on top (cloudsTexture)
+//  - ALPHA_OVERLAY: translucent, texture alpha * overlayAlpha with a color tint; U is the radial coordinate
+//  - UNLIT: emissive, horizontally scrolling texture for the Sun (timeSeconds); no lighting at all
+// Lit permutations use ambientColor, sunlightColor, lightPosition; all of them sample textureSampler (unit 0).
+#version 330 core
+
+in vec2 textureCoordinate;
+#ifndef UNLIT
+in vec3 normal;
+in vec3 fragmentPosition;
+#endif
+
+out vec4 FragColor;
+
+uniform sampler2D textureSampler;
+#if defined(UV_FLOW) || defined(UNLIT)
+uniform float timeSeconds;
+#endif
+#ifndef UNLIT
+uniform vec3 ambientColor;
+uniform vec3 sunlightColor;
+uniform vec3 lightPosition;
+#endif
+#if defined(RIM_LIGHT) || defined(SPECULAR_MASK)
+uniform vec3 viewPosition;
+#endif
+#ifdef NIGHT_LIGHTS
+uniform sampler2D nightTexture;
+#endif
+#ifdef SPECULAR_MASK
+uniform sampler2D specularTexture;
+uniform float specularStrength;
+uniform float specularShininess;
+#endif
+#ifdef CLOUDS
+uniform sampler2D cloudsTexture;
+#endif
+#ifdef ALPHA_OVERLAY
+uniform float overlayAlpha;
+uniform vec3 colorTint; // multiplier for tinting overlays (e.g., darker Uranus rings)
+#endif
+
+void main()
+{
+#ifdef UNLIT
+    // Slow horizontal flow to emulate gas motion / rotation
+    vec2 uv = vec2(textureCoordinate.x + 0.01 * timeSeconds, 1.0 - textureCoordinate.y);
+    vec4 col = texture(textureSampler, uv);
+    // Slight emissive boost for the sun
+    FragColor = vec4(min(col.rgb * 1.15, 1.0), col.a);
+#else
+    vec3 n = normalize(normal);
+    vec3 l = normalize(lightPosition - fragmentPosition);
+    float ndotl = max(dot(n, l), 0.0);
+
+    vec2 uv = textureCoordinate;
+#ifdef UV_FLOW
+    uv += vec2(0.02 * sin(timeSeconds*0.1), 0.01 * cos(timeSeconds*0.08));
+#endif
+#ifdef ALPHA_OVERLAY
+    uv = vec2(uv.x, 0.5); // radial mapping: x = inner->outer, y is ignored (use midline)
+#endif
+    vec4 albedo = texture(textureSampler, uv);
+#ifdef NIGHT_LIGHTS
+    albedo = mix(texture(nightTexture, uv), albedo, ndotl);
+#endif
+#ifdef CLOUDS
+    albedo += 0.3 * texture(cloudsTexture, uv);
+#endif
+
+    vec3 color = ambientColor + ndotl * sunlightColor;
+#if defined(RIM_LIGHT) || defined(SPECULAR_MASK)
+    vec3 v = normalize(viewPosition - fragmentPosition);
+#endif
+#ifdef RIM_LIGHT
+    float rim = pow(1.0 - max(dot(n, v), 0.0), 2.0);
+    color += 0.1 * rim * sunlightColor;
+#endif
+#ifdef SPECULAR_MASK
+    float spec = pow(max(dot(v, reflect(-l, n)), 0.0), specularShininess);
+    color += (specularStrength * spec * sunlightColor) * vec3(texture(specularTexture, uv));
+#endif
+
+#ifdef ALPHA_OVERLAY
+    FragColor = vec4(color * (albedo.rgb * colorTint), albedo.a * overlayAlpha);
+#else
+    FragColor = vec4(color, 1.0) * albedo;
+#endif
+#endif
+}
@@ -0,0 +1,37 @@
+// Vertex shader of the surface uber-shader (planets, Earth, Moon, Sun, atmospheres and rings)
+// - Inputs: position (0), texcoord (1), normal (2)
+// - Outputs: texcoord; world-space normal and position unless UNLIT
+// - Uniforms: MVP; modelMatrix, normalMatrix unless UNLIT
+// Feature #defines (see surface.frag) are injected after the #version line by SurfaceShaders
+#version 330 core
+layout (location = 0) in vec3 aPosition;
+layout (location = 1) in vec2 aTexture;
+layout (location = 2) in vec3 aNormal;
+
+out vec2 textureCoordinate;
+#ifndef UNLIT
+out vec3 normal;
+out vec3 fragmentPosition;
+#endif
+
+invariant gl_Position; // must match depth.vert for the depth prepass
+
+uniform mat4 MVP;
+#ifndef UNLIT
+uniform mat4 modelMatrix;
+uniform mat3 normalMatrix;
+#endif
+
+void main()
+{
+#if defined(UNLIT) || defined(ALPHA_OVERLAY)
+    textureCoordinate = aTexture; // the Sun flips V along with its scroll, overlays only read U
+#else
+    textureCoordinate = vec2(aTexture.x, 1.0 - aTexture.y); // flip V to match the equirectangular maps
+#endif
+#ifndef UNLIT
+    normal = normalMatrix * aNormal;
+    fragmentPosition = vec3(modelMatrix * vec4(aPosition, 1.0));
+#endif
+    gl_Position = MVP * vec4(aPosition, 1.0);
+}
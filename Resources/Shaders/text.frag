@@ -1,11 +1,19 @@
 #version 330 core
 
+in vec2 texCoord;
+in vec4 textColor;
+
 out vec4 FragColor;
 
-uniform vec4 textColor;
+uniform sampler2D atlas; // signed distance field, 0.5 on the glyph outline
 
 void main()
 {
-    FragColor = textColor;
+    float distance = texture(atlas, texCoord).r;
+    // Antialias over about one screen pixel, whatever the text scale
+    float width = max(fwidth(distance) * 0.75, 1e-4);
+    float alpha = smoothstep(0.5 - width, 0.5 + width, distance);
+    if (alpha <= 0.0)
+        discard;
+    FragColor = vec4(textColor.rgb, textColor.a * alpha);
 }
-
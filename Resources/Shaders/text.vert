@@ -1,11 +1,29 @@
 #version 330 core
 
-layout (location = 0) in vec2 aPos;
+#define MAX_LABELS 64
 
-uniform mat4 MVP;
+layout (location = 0) in vec2 aCorner;      // unit quad corner
+layout (location = 1) in vec2 aOffset;      // glyph cell origin relative to its label, in font units
+layout (location = 2) in uvec2 aGlyphLabel; // atlas cell, label slot
+
+uniform mat4 projection;
+uniform vec4 labelPlacements[MAX_LABELS];   // xy: top-left corner in pixels, z: pixels per font unit (0 hides the label)
+uniform vec4 labelColors[MAX_LABELS];
+uniform vec2 cellSize;                      // glyph cell in font units
+uniform vec2 atlasCellSize;                 // glyph cell in texture coordinates
+uniform int atlasColumns;
+
+out vec2 texCoord;
+out vec4 textColor;
 
 void main()
 {
-    gl_Position = MVP * vec4(aPos, 0.0, 1.0);
-}
+    vec4 placement = labelPlacements[aGlyphLabel.y];
+    vec2 position = placement.xy + (aOffset + aCorner * cellSize) * placement.z;
+    gl_Position = projection * vec4(position, 0.0, 1.0);
 
+    uint columns = uint(atlasColumns);
+    vec2 cell = vec2(float(aGlyphLabel.x % columns), float(aGlyphLabel.x / columns));
+    texCoord = (cell + aCorner) * atlasCellSize;
+    textColor = labelColors[aGlyphLabel.y];
+}
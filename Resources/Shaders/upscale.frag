@@ -0,0 +1,43 @@
+// Fragment shader of the dynamic resolution upscale
+// Bilinear fetch of the resolved scene, then an edge-aware sharpen: the four neighbours one source texel away
+// form a negative lobe whose weight shrinks where the local contrast is already high, so soft edges regain
+// some crispness without halos around the bright planet limbs.
+// - Uniforms: sceneTexture (unit 0), texelSize (1 / texture size), uvMax (last rendered texel center),
+//   sharpness (0 = plain bilinear, 1 = strongest)
+#version 330 core
+
+in vec2 textureCoordinate;
+
+out vec4 FragColor;
+
+uniform sampler2D sceneTexture;
+uniform vec2 texelSize;
+uniform vec2 uvMax;
+uniform float sharpness;
+
+vec3 Fetch(vec2 uv)
+{
+    // Stay inside the rendered corner: bilinear taps past it would read texels left from a larger scale
+    return texture(sceneTexture, min(uv, uvMax)).rgb;
+}
+
+void main()
+{
+    vec3 center = Fetch(textureCoordinate);
+    if (sharpness <= 0.0)
+    {
+        FragColor = vec4(center, 1.0);
+        return;
+    }
+    vec3 north = Fetch(textureCoordinate + vec2(0.0, texelSize.y));
+    vec3 south = Fetch(textureCoordinate - vec2(0.0, texelSize.y));
+    vec3 east = Fetch(textureCoordinate + vec2(texelSize.x, 0.0));
+    vec3 west = Fetch(textureCoordinate - vec2(texelSize.x, 0.0));
+    vec3 low = min(center, min(min(north, south), min(east, west)));
+    vec3 high = max(center, max(max(north, south), max(east, west)));
+    // Room left before clipping to black or white, relative to the brightest tap: 1 on flat areas, 0 on hard edges
+    vec3 amount = sqrt(clamp(min(low, 1.0 - high) / max(high, vec3(1.0 / 256.0)), 0.0, 1.0));
+    vec3 weight = -amount * mix(0.0, 0.2, sharpness);
+    vec3 color = (center + (north + south + east + west) * weight) / (1.0 + 4.0 * weight);
+    FragColor = vec4(clamp(color, 0.0, 1.0), 1.0);
+}
@@ -0,0 +1,17 @@
+// Vertex shader of the dynamic resolution upscale
+// Emits one full-screen triangle from gl_VertexID (no vertex buffers); texture coordinates cover the
+// part of the scene texture that was rendered (the lower-left renderScale of it).
+// - Uniforms: uvScale (rendered size / texture size)
+#version 330 core
+
+out vec2 textureCoordinate;
+
+uniform vec2 uvScale;
+
+void main()
+{
+    // Vertices (-1,-1), (3,-1), (-1,3) cover the whole viewport
+    vec2 ndc = vec2(float((gl_VertexID << 1) & 2), float(gl_VertexID & 2)) * 2.0 - 1.0;
+    textureCoordinate = (ndc * 0.5 + 0.5) * uvScale;
+    gl_Position = vec4(ndc, 0.0, 1.0);
+}
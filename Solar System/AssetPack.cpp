@@ -0,0 +1,219 @@
+// AssetPack: memory-mapped asset archive (reading) and its writer (used by asset_packer).
+#include "AssetPack.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr char packMagic[4] = { 'S', 'P', 'A', 'K' };
+    constexpr uint32_t packVersion = 3;
+    constexpr size_t payloadAlignment = 4096;   //Payloads start on their own page.
+
+    //File layout: header, entry table, names, then the payloads.
+    struct PackHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t entryCount;
+        uint32_t reserved;
+        uint64_t fileSize;          //A truncated pack is rejected instead of faulting on a missing page.
+    };
+
+    struct PackEntry
+    {
+        uint64_t nameOffset;        //From the start of the file, not null-terminated.
+        uint32_t nameLength;
+        uint32_t type;
+        uint64_t offset;
+        uint64_t size;
+        uint64_t sourceHash;
+        uint64_t sourceSize;
+        int64_t sourceWriteTime;
+        uint64_t buildHash;
+        uint64_t payloadHash;
+    };
+
+    size_t AlignUp(size_t value, size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+}
+
+AssetPack::AssetPack(const std::string& packPath)
+    :
+    file(packPath)
+{
+    if (!file.IsOpen())
+        return;
+    const unsigned char* base = file.GetData();
+    const size_t size = file.GetSize();
+    PackHeader header{};
+    if (size >= sizeof(header))
+        std::memcpy(&header, base, sizeof(header));
+    if (size < sizeof(header) || std::memcmp(header.magic, packMagic, sizeof(packMagic)) != 0 || header.version != packVersion
+        || header.fileSize != size || sizeof(PackHeader) + (uint64_t)header.entryCount * sizeof(PackEntry) > size)
+    {
+        std::cout << "Ignoring outdated or damaged asset pack: " << packPath << "\n";
+        Close();
+        return;
+    }
+    const PackEntry* table = reinterpret_cast<const PackEntry*>(base + sizeof(PackHeader));
+    for (uint32_t i = 0; i < header.entryCount; ++i)
+    {
+        const PackEntry& entry = table[i];
+        if (entry.nameOffset + entry.nameLength > size || entry.offset + entry.size > size)
+        {
+            std::cout << "Ignoring damaged asset pack: " << packPath << "\n";
+            Close();
+            return;
+        }
+        std::string name(reinterpret_cast<const char*>(base + entry.nameOffset), entry.nameLength);
+        entries[name] = { (Type)entry.type, base + entry.offset, (size_t)entry.size, entry.sourceHash, entry.sourceSize,
+            entry.sourceWriteTime, entry.buildHash, entry.payloadHash };
+    }
+}
+
+bool AssetPack::IsOpen() const
+{
+    return file.IsOpen();
+}
+
+size_t AssetPack::GetEntryCount() const
+{
+    return entries.size();
+}
+
+const AssetPack::Entry* AssetPack::Find(const std::string& assetPath, Type type) const
+{
+    const Entry* entry = FindByName(GetAssetName(assetPath));
+    if (entry == nullptr || entry->type != type)
+        return nullptr;
+    //A pack shipped without the loose files is trusted; one built before an edit to them is not. One stat, so the
+    //check costs nothing next to reading the file.
+    uint64_t sourceSize = 0;
+    int64_t sourceWriteTime = 0;
+    if (!GetSourceStamp(assetPath, sourceSize, sourceWriteTime))
+        return entry;
+    if (sourceSize != entry->sourceSize || sourceWriteTime != entry->sourceWriteTime)
+    {
+        std::cout << "Asset pack is stale for " << assetPath << ", using the loose file (rerun asset_packer)\n";
+        return nullptr;
+    }
+    return entry;
+}
+
+const AssetPack::Entry* AssetPack::FindByName(const std::string& name) const
+{
+    auto found = entries.find(name);
+    return found != entries.end() ? &found->second : nullptr;
+}
+
+std::string AssetPack::GetAssetName(const std::string& assetPath)
+{
+    std::string name = assetPath;
+    std::replace(name.begin(), name.end(), '\\', '/');
+    const std::string root = "Resources/";
+    size_t rootPosition = name.rfind(root);
+    return rootPosition == std::string::npos ? name : name.substr(rootPosition + root.size());
+}
+
+uint64_t AssetPack::Hash(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    uint64_t hash = 14695981039346656037ull;
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+bool AssetPack::GetSourceStamp(const std::string& path, uint64_t& size, int64_t& writeTime)
+{
+    std::error_code ec;
+    size = std::filesystem::file_size(path, ec);
+    if (ec)
+        return false;
+    auto time = std::filesystem::last_write_time(path, ec);
+    if (ec)
+        return false;
+    writeTime = (int64_t)time.time_since_epoch().count();
+    return true;
+}
+
+void AssetPack::Prefetch(const void* data, size_t size)
+{
+    //One read per page is enough to have the kernel bring it in; the sum only keeps the reads alive.
+    const volatile unsigned char* bytes = static_cast<const volatile unsigned char*>(data);
+    unsigned char sum = 0;
+    for (size_t i = 0; i < size; i += 4096)
+        sum = (unsigned char)(sum + bytes[i]);
+    if (size > 0)
+        sum = (unsigned char)(sum + bytes[size - 1]);
+    (void)sum;
+}
+
+void AssetPack::Close()
+{
+    file.Close();
+    entries.clear();
+}
+
+bool WriteAssetPack(const std::string& packPath, const std::vector<PackedAsset>& assets)
+{
+    //Lay the file out first: the table and the names up front, then every payload on a page boundary.
+    std::vector<PackEntry> table(assets.size());
+    size_t position = sizeof(PackHeader) + table.size() * sizeof(PackEntry);
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        table[i].nameOffset = position;
+        table[i].nameLength = (uint32_t)assets[i].name.size();
+        position += assets[i].name.size();
+    }
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        position = AlignUp(position, payloadAlignment);
+        table[i].type = (uint32_t)assets[i].type;
+        table[i].offset = position;
+        table[i].size = assets[i].payload.size();
+        table[i].sourceHash = assets[i].sourceHash;
+        table[i].sourceSize = assets[i].sourceSize;
+        table[i].sourceWriteTime = assets[i].sourceWriteTime;
+        table[i].buildHash = assets[i].buildHash;
+        table[i].payloadHash = AssetPack::Hash(assets[i].payload.data(), assets[i].payload.size());
+        position += assets[i].payload.size();
+    }
+    PackHeader header{};
+    std::memcpy(header.magic, packMagic, sizeof(packMagic));
+    header.version = packVersion;
+    header.entryCount = (uint32_t)assets.size();
+    header.fileSize = position;
+
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(packPath).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, ec);
+    std::ofstream file(packPath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Could not write asset pack: " << packPath << "\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(table.data()), (std::streamsize)(table.size() * sizeof(PackEntry)));
+    for (const PackedAsset& asset : assets)
+        file.write(asset.name.data(), (std::streamsize)asset.name.size());
+    const std::vector<char> padding(payloadAlignment, 0);
+    size_t written = (size_t)file.tellp();
+    for (size_t i = 0; i < assets.size(); ++i)
+    {
+        file.write(padding.data(), (std::streamsize)(table[i].offset - written));
+        file.write(reinterpret_cast<const char*>(assets[i].payload.data()), (std::streamsize)assets[i].payload.size());
+        written = (size_t)(table[i].offset + table[i].size);
+    }
+    file.close();
+    return !file.fail();
+}
@@ -0,0 +1,68 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "MappedFile.h"
+// Read-only view of the asset pack: one file holding every mesh, shader, texture and scene already in the form
+// the GPU or the game takes (vertex arrays, mip chains, shader sources, binary scenes), written at build time by asset_packer. The file is
+// memory-mapped and payloads are page aligned, so assets are uploaded straight from the mapped pages; nothing
+// is parsed, decoded or copied into intermediate buffers. Without a pack the callers fall back to the loose files
+// under Resources; so do they for an entry whose loose file changed after packing (Find compares its size and
+// write time with the ones recorded by the packer).
+class AssetPack
+{
+public:
+	enum class Type : uint32_t
+	{
+		Raw,		//The source file as is (shaders).
+		Mesh,		//Mesh::PackData.
+		Texture,	//PackBakedTexture.
+		Cubemap,	//Skybox::PackFaces.
+		Scene		//PackScene.
+	};
+	struct Entry
+	{
+		Type type;
+		const unsigned char* data;	//Inside the mapping, valid as long as the pack.
+		size_t size;
+		uint64_t sourceHash;		//Content hash of the file the payload was built from.
+		uint64_t sourceSize;		//Size and write time of that file when it was packed.
+		int64_t sourceWriteTime;
+		uint64_t buildHash;			//Packer version and build parameters (skybox face size, ...).
+		uint64_t payloadHash;
+	};
+public:
+	explicit AssetPack(const std::string& packPath);	//Maps the pack. A missing or unreadable pack is just empty.
+	AssetPack(const AssetPack& other) = delete;				//No copy construction allowed.
+	AssetPack& operator=(const AssetPack& other) = delete;	//No copy assignment allowed.
+	bool IsOpen() const;
+	size_t GetEntryCount() const;
+	//The payload built from assetPath (a settings path such as ..\Resources\Textures\earth.jpg), null when absent
+	//or stale: when the loose file exists it must still have the size and write time it was packed with.
+	const Entry* Find(const std::string& assetPath, Type type) const;
+	const Entry* FindByName(const std::string& name) const;	//By pack name (Textures/earth.jpg).
+	static std::string GetAssetName(const std::string& assetPath);	//Pack name: the path below Resources, with '/'.
+	static uint64_t Hash(const void* data, size_t size);		//64-bit FNV-1a.
+	static bool GetSourceStamp(const std::string& path, uint64_t& size, int64_t& writeTime);	//False when there is no such file.
+	static void Prefetch(const void* data, size_t size);		//Faults the pages in (call it on a worker thread).
+private:
+	void Close();
+private:
+	MappedFile file;
+	std::unordered_map<std::string, Entry> entries;
+};
+
+//One asset for WriteAssetPack.
+struct PackedAsset
+{
+	std::string name;
+	AssetPack::Type type;
+	uint64_t sourceHash;
+	uint64_t sourceSize;
+	int64_t sourceWriteTime;
+	uint64_t buildHash;
+	std::vector<unsigned char> payload;
+};
+bool WriteAssetPack(const std::string& packPath, const std::vector<PackedAsset>& assets);
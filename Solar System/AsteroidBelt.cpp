@@ -0,0 +1,105 @@
+// AsteroidBelt: procedural belt generation, per-frame angle update and model matrix construction.
+#include "AsteroidBelt.h"
+#include "Settings.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <cmath>
+#include <algorithm>
+
+void AsteroidBelt::Generate(const std::vector<Band>& bands, int meshCount)
+{
+    asteroids.clear();
+    size_t total = 0;
+    for (const Band& band : bands)
+    {
+        total += (size_t)std::max(band.count, 0);
+    }
+    asteroids.reserve(total);
+    //Each band has its own generator, so adding a belt to a scene leaves the others as they were.
+    for (const Band& band : bands)
+    {
+        std::mt19937 rng(band.seed);
+        std::uniform_real_distribution<float> r01(0.0f, 1.0f);
+        std::uniform_real_distribution<float> rSign(-1.0f, 1.0f);
+        float innerWorld = band.innerRadiusAU * settings::keplerAUScale;
+        float outerWorld = band.outerRadiusAU * settings::keplerAUScale;
+        for (int i = 0; i < band.count; ++i)
+        {
+            float t = r01(rng);
+            float radius = glm::mix(innerWorld, outerWorld, t);
+            // Vary irregular scale along axes with tighter bounds for rocky appearance
+            float baseScale = glm::mix(band.minScale, band.maxScale, r01(rng));
+            // Random deviations from base to create rocky, lumpy shape (not bean-like)
+            float sx = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
+            float sy = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
+            float sz = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
+            float angleDeg = r01(rng) * 360.0f;
+            // Kepler-like speed: v ~ r^(-3/2) so angular speed ~ r^(-3/2)
+            float angularSpeedDeg = band.angularSpeedDegrees * powf(radius / innerWorld, -band.speedExponent);
+            // small vertical/lateral noise
+            glm::vec3 offset = { 0.0f, (r01(rng) - 0.5f) * 2.0f * band.halfThickness, 0.0f };
+            // random spin
+            glm::vec3 axis = glm::normalize(glm::vec3(rSign(rng), rSign(rng), rSign(rng)));
+            float spinSpeed = glm::mix(10.0f, 60.0f, r01(rng));
+            int meshIndex = int(r01(rng) * meshCount) % meshCount;
+            asteroids.push_back({ radius, angleDeg, angularSpeedDeg, {sx, sy, sz}, offset, band.tiltDegrees, r01(rng) * 360.0f, axis, spinSpeed, meshIndex });
+        }
+    }
+}
+
+void AsteroidBelt::Update(float deltatime)
+{
+    for (auto& a : asteroids)
+    {
+        a.angleDeg += a.angularSpeedDeg * deltatime;
+        if (a.angleDeg > 360.0f) a.angleDeg -= 360.0f;
+        a.spinDeg += a.spinSpeedDeg * deltatime;
+        if (a.spinDeg > 360.0f) a.spinDeg -= 360.0f;
+    }
+}
+
+void AsteroidBelt::BuildModelMatrices(std::vector<glm::mat4>& modelMatrices) const
+{
+    BuildModelMatrices(modelMatrices, asteroids.size());
+}
+
+void AsteroidBelt::BuildModelMatrices(std::vector<glm::mat4>& modelMatrices, size_t count) const
+{
+    modelMatrices.resize(std::min(count, asteroids.size()));
+    for (size_t i = 0; i < modelMatrices.size(); ++i)
+    {
+        const Asteroid& a = asteroids[i];
+        glm::mat4 model = glm::mat4(1.0f);
+        // Orbital rotation around Y, then translate to belt radius
+        model = glm::rotate(model, glm::radians(a.angleDeg), glm::vec3(0,1,0));
+        model = glm::translate(model, glm::vec3(a.radius, 0.0f, 0.0f));
+        // Apply belt tilt and vertical offset
+        model = glm::rotate(model, glm::radians(a.tiltDeg), glm::vec3(1,0,0));
+        model = glm::translate(model, a.offset);
+        // Random local spin for sparkle
+        model = glm::rotate(model, glm::radians(a.spinDeg), a.spinAxis);
+        model = glm::scale(model, a.scale);
+        modelMatrices[i] = model;
+    }
+}
+
+glm::vec3 AsteroidBelt::GetPosition(size_t index) const
+{
+    // Same placement as BuildModelMatrices, without the spin and scale
+    const Asteroid& a = asteroids[index];
+    glm::mat4 model = glm::rotate(glm::mat4(1.0f), glm::radians(a.angleDeg), glm::vec3(0,1,0));
+    model = glm::translate(model, glm::vec3(a.radius, 0.0f, 0.0f));
+    model = glm::rotate(model, glm::radians(a.tiltDeg), glm::vec3(1,0,0));
+    model = glm::translate(model, a.offset);
+    return glm::vec3(model[3]);
+}
+
+const std::vector<AsteroidBelt::Asteroid>& AsteroidBelt::GetAsteroids() const
+{
+    return asteroids;
+}
+
+size_t AsteroidBelt::GetCount() const
+{
+    return asteroids.size();
+}
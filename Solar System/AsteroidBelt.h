@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include <glm/glm.hpp>
+// Simulation state of the asteroid belt: one record per rock, advanced every frame and turned into model
+// matrices for rendering. Kept free of OpenGL so it can be generated, updated and benchmarked on its own.
+class AsteroidBelt
+{
+public:
+	struct Asteroid
+	{
+		float radius;
+		float angleDeg;
+		float angularSpeedDeg;
+		glm::vec3 scale;
+		glm::vec3 offset;
+		float tiltDeg;			//Inclination of the rock's band.
+		float spinDeg;
+		glm::vec3 spinAxis;
+		float spinSpeedDeg;
+		int meshIndex;
+	};
+	//One ring of rocks around the origin; a scene's belts are bands (the defaults are the Sun's main belt).
+	struct Band
+	{
+		int count = 0;
+		float innerRadiusAU = 2.2f;				//Scaled by settings::keplerAUScale.
+		float outerRadiusAU = 3.2f;
+		float tiltDegrees = 2.0f;				//Inclination of the band.
+		float halfThickness = 15.0f;			//Vertical scatter, scene units.
+		float minScale = 0.79999995f;			//Rock size range, scene units.
+		float maxScale = 2.2f;
+		float angularSpeedDegrees = 7.0f;		//Orbit speed at the inner edge, degrees per second.
+		float speedExponent = 1.5f;				//Angular speed falls off as (radius / inner)^-exponent (Kepler: 1.5).
+		unsigned int seed = 12345;
+	};
+public:
+	//Scatters every band's rocks, band after band; meshIndex picks one of meshCount shapes.
+	void Generate(const std::vector<Band>& bands, int meshCount);
+	void Update(float deltatime);	//Advances orbit and spin angles (deltatime already scaled by the time speed).
+	void BuildModelMatrices(std::vector<glm::mat4>& modelMatrices) const;	//One matrix per asteroid, same order.
+	//Only the first count rocks; they are scattered at random, so any prefix thins the belt out evenly.
+	void BuildModelMatrices(std::vector<glm::mat4>& modelMatrices, size_t count) const;
+	glm::vec3 GetPosition(size_t index) const;	//World position of one asteroid's center.
+	const std::vector<Asteroid>& GetAsteroids() const;
+	size_t GetCount() const;
+private:
+	std::vector<Asteroid> asteroids;
+};
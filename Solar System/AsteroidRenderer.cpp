@@ -0,0 +1,132 @@
+// AsteroidRenderer: one shared icosphere, displaced per instance in the vertex shader and drawn in one call.
+#include "AsteroidRenderer.h"
+#include "Mesh.h"
+#include "ShaderProgram.h"
+#include "Window.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <unordered_map>
+
+AsteroidRenderer::AsteroidRenderer(int subdivisions)
+{
+    //The generator expands faces to one vertex per corner; shared corners are bit-identical, so welding them
+    //back by value gives the indexed sphere and lets the post-transform cache skip most of the noise work.
+    MeshData sphere = Mesh::GenerateIcoSphereData(subdivisions, 1.0f);
+    struct BitsHash
+    {
+        size_t operator()(const glm::vec3& p) const
+        {
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            return (size_t)bits[0] * 73856093u ^ (size_t)bits[1] * 19349663u ^ (size_t)bits[2] * 83492791u;
+        }
+    };
+    std::unordered_map<glm::vec3, unsigned short, BitsHash> welded;
+    std::vector<glm::vec3> positions;
+    std::vector<unsigned short> indices;
+    indices.reserve(sphere.positions.size());
+    for (const glm::vec3& p : sphere.positions)
+    {
+        auto inserted = welded.emplace(p, (unsigned short)positions.size());
+        if (inserted.second)
+            positions.push_back(p);
+        indices.push_back(inserted.first->second);
+    }
+    CreateBuffers(positions, indices);
+}
+
+AsteroidRenderer::~AsteroidRenderer() noexcept
+{
+    glDeleteBuffers(1, &shapeBuffer);
+    glDeleteBuffers(1, &modelBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+void AsteroidRenderer::GenerateShapes(size_t count, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> r01(0.0f, 1.0f);
+    std::vector<glm::vec4> shapes(count);
+    for (glm::vec4& shape : shapes)
+    {
+        float radius = 0.9f + 0.3f * r01(rng);
+        float amplitude = 0.15f + 0.07f * r01(rng);
+        float frequency = 2.0f + 1.0f * r01(rng);
+        float noiseOffset = float(rng() % 1000) * 0.01f;
+        shape = glm::vec4(noiseOffset, amplitude, frequency, radius);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, shapeBuffer);
+    glBufferData(GL_ARRAY_BUFFER, shapes.size() * sizeof(glm::vec4), shapes.data(), GL_STATIC_DRAW);
+    shapeCount = count;
+}
+
+void AsteroidRenderer::SetModelMatrices(const std::vector<glm::mat4>& modelMatrices)
+{
+    instanceCount = std::min(modelMatrices.size(), shapeCount);
+    if (instanceCount == 0)
+    {
+        return;
+    }
+    //Orphan last frame's storage so the upload never waits for the passes still reading it.
+    modelCapacity = std::max(modelCapacity, instanceCount);
+    glBindBuffer(GL_ARRAY_BUFFER, modelBuffer);
+    glBufferData(GL_ARRAY_BUFFER, modelCapacity * sizeof(glm::mat4), nullptr, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instanceCount * sizeof(glm::mat4), modelMatrices.data());
+}
+
+void AsteroidRenderer::Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection)
+{
+    if (instanceCount == 0)
+    {
+        return;
+    }
+    window.UseShader(shader);
+    shader.SendUniform<glm::mat4>("viewProjection", viewProjection);
+    window.BindVertexArray(vertexArray);
+    window.DrawElementsInstanced(GL_TRIANGLES, indexCount, GL_UNSIGNED_SHORT, (int)instanceCount);
+}
+
+size_t AsteroidRenderer::GetInstanceCount() const
+{
+    return instanceCount;
+}
+
+int AsteroidRenderer::GetBaseTriangleCount() const
+{
+    return indexCount / 3;
+}
+
+void AsteroidRenderer::CreateBuffers(const std::vector<glm::vec3>& positions, const std::vector<unsigned short>& indices)
+{
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glGenBuffers(1, &modelBuffer);
+    glGenBuffers(1, &shapeBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, positions.size() * sizeof(glm::vec3), positions.data(), GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned short), indices.data(), GL_STATIC_DRAW);
+    //A mat4 attribute takes four locations, one column each.
+    glBindBuffer(GL_ARRAY_BUFFER, modelBuffer);
+    for (int column = 0; column < 4; ++column)
+    {
+        glEnableVertexAttribArray(1 + column);
+        glVertexAttribPointer(1 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4), (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(1 + column, 1);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, shapeBuffer);
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 4, GL_FLOAT, GL_FALSE, sizeof(glm::vec4), (void*)0);
+    glVertexAttribDivisor(5, 1);
+    glBindVertexArray(0);
+    indexCount = (int)indices.size();
+}
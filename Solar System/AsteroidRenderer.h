@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+class Window;
+class ShaderProgram;
+// Asteroid belt drawn as instances of one unit icosphere. The craggy shape is not stored: asteroid.vert
+// displaces every vertex with the same value noise Mesh::GenerateCraggyAsteroid uses, seeded per instance,
+// and derives the normal from two neighbouring surface points. Every rock gets its own shape for the memory
+// of one small mesh plus a vec4 per rock, and the whole belt is a single glDrawElementsInstanced call.
+// Model matrices are streamed into an instance buffer once per frame and shared by every opaque pass.
+class AsteroidRenderer
+{
+public:
+	explicit AsteroidRenderer(int subdivisions);
+	AsteroidRenderer(const AsteroidRenderer& other) = delete;				//No copy construction allowed.
+	AsteroidRenderer& operator=(const AsteroidRenderer& other) = delete;	//No copy assignment allowed.
+	~AsteroidRenderer() noexcept;											//Frees the buffers.
+	//One random shape per rock, from the ranges of the CPU mesh pool (radius, amplitude, frequency, noise seed).
+	void GenerateShapes(size_t count, unsigned int seed);
+	void SetModelMatrices(const std::vector<glm::mat4>& modelMatrices);	//This frame's matrices, one per shape.
+	//Works with any program built on asteroid.vert (shaded, depth prepass, overdraw view).
+	void Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection);
+	size_t GetInstanceCount() const;
+	int GetBaseTriangleCount() const;
+private:
+	void CreateBuffers(const std::vector<glm::vec3>& positions, const std::vector<unsigned short>& indices);
+private:
+	unsigned int vertexArray = 0;
+	unsigned int vertexBuffer = 0;
+	unsigned int indexBuffer = 0;
+	unsigned int modelBuffer = 0;		//mat4 per instance, rewritten every frame.
+	unsigned int shapeBuffer = 0;		//vec4 per instance: seed offset, amplitude, frequency, radius.
+	int indexCount = 0;
+	size_t shapeCount = 0;
+	size_t instanceCount = 0;			//Matrices uploaded by the last SetModelMatrices.
+	size_t modelCapacity = 0;
+};
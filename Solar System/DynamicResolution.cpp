@@ -0,0 +1,231 @@
+// DynamicResolution: scaled scene target, the resolve/upscale pass and the GPU-time driven scale controller.
+#include "DynamicResolution.h"
+#include "Window.h"
+#include "ShaderProgram.h"
+#include "Settings.h"
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    constexpr float smoothingSeconds = 0.25f;   //Time constant of the GPU time average.
+    constexpr float scaleQuantum = 1.0f / 40.0f; //Scales are rounded to this, so noise does not cause tiny changes.
+    constexpr float maxRaiseStep = 0.125f;       //Growing is capped per change; the prediction is less reliable upwards.
+}
+
+DynamicResolution::DynamicResolution(float targetFrameMs) :
+    targetFrameMs(targetFrameMs)
+{
+}
+
+DynamicResolution::~DynamicResolution() noexcept
+{
+    DestroyTargets();
+}
+
+void DynamicResolution::AddFrame(float frameSeconds, float gpuMs)
+{
+    //Exponential average with a fixed time constant, whatever the frame rate.
+    float weight = hasSample ? 1.0f - std::exp(-frameSeconds / smoothingSeconds) : 1.0f;
+    smoothedGpuMs += (gpuMs - smoothedGpuMs) * weight;
+    hasSample = true;
+    if (!enabled || gpuMs <= 0.0f)
+    {
+        return;     //Without timer queries there is nothing to steer by.
+    }
+    if (settleSeconds > 0.0f)
+    {
+        //The profiler averages GPU time over half a second, a few frames late: judge the new scale afterwards.
+        settleSeconds -= frameSeconds;
+        return;
+    }
+    //Fill cost follows the area, so the side goes with the square root of the time ratio. Aiming under the target
+    //leaves a band in which the scale holds still.
+    const float aimMs = targetFrameMs * settings::renderScaleAim;
+    const float fitted = scale * std::sqrt(aimMs / std::max(smoothedGpuMs, 0.01f));
+    overBudgetSeconds = smoothedGpuMs > targetFrameMs ? overBudgetSeconds + frameSeconds : 0.0f;
+    underBudgetSeconds = fitted >= std::min(scale + scaleQuantum, 1.0f) ? underBudgetSeconds + frameSeconds : 0.0f;
+    if (overBudgetSeconds >= settings::renderScaleLowerAfterSeconds && scale > settings::minRenderScale)
+    {
+        Step(fitted);
+    }
+    else if (underBudgetSeconds >= settings::renderScaleRaiseAfterSeconds && scale < 1.0f)
+    {
+        Step(std::min(fitted, scale + maxRaiseStep));
+    }
+}
+
+void DynamicResolution::Step(float newScale)
+{
+    newScale = std::round(newScale / scaleQuantum) * scaleQuantum;
+    if (newScale == scale)
+    {
+        overBudgetSeconds = underBudgetSeconds = 0.0f;
+        return;
+    }
+    SetScale(newScale);
+}
+
+void DynamicResolution::SetEnabled(bool enabled)
+{
+    this->enabled = enabled;
+    overBudgetSeconds = underBudgetSeconds = 0.0f;
+}
+
+bool DynamicResolution::IsEnabled() const
+{
+    return enabled;
+}
+
+void DynamicResolution::SetScale(float scale)
+{
+    this->scale = std::clamp(scale, settings::minRenderScale, 1.0f);
+    overBudgetSeconds = underBudgetSeconds = 0.0f;
+    settleSeconds = settings::renderScaleSettleSeconds;
+}
+
+float DynamicResolution::GetScale() const
+{
+    return scale;
+}
+
+bool DynamicResolution::IsActive() const
+{
+    return (enabled || scale < 1.0f) && !targetsFailed;
+}
+
+void DynamicResolution::BeginScene(Window& window)
+{
+    if (!IsActive())
+    {
+        return;
+    }
+    const glm::ivec2 framebufferSize = window.GetFramebufferSize();
+    if (framebufferSize.x <= 0 || framebufferSize.y <= 0)
+    {
+        return;     //Minimized.
+    }
+    if (framebufferSize != targetSize && !CreateTargets(window, framebufferSize))
+    {
+        return;
+    }
+    renderSize = glm::max(glm::ivec2(glm::round(glm::vec2(targetSize) * scale)), glm::ivec2(1));
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glViewport(0, 0, renderSize.x, renderSize.y);
+    //Only the rendered corner is cleared and later resolved; the rest of the target is never read.
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(0, 0, renderSize.x, renderSize.y);
+    window.SetDepthMask(true);
+    window.SetColorMask(true);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    glDisable(GL_SCISSOR_TEST);
+    sceneBegun = true;
+}
+
+void DynamicResolution::EndScene(Window& window, ShaderProgram& upscaleShader)
+{
+    if (!sceneBegun)
+    {
+        return;
+    }
+    sceneBegun = false;
+    //Resolve the multisampled corner into the texture, then stretch it over the window's framebuffer.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, sceneFBO);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+    glBlitFramebuffer(0, 0, renderSize.x, renderSize.y, 0, 0, renderSize.x, renderSize.y, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+    glBindFramebuffer(GL_FRAMEBUFFER, window.GetFramebuffer());
+    glViewport(0, 0, targetSize.x, targetSize.y);
+    const glm::vec2 size(targetSize);
+    const glm::vec2 rendered(renderSize);
+    window.SetDepthTest(false);
+    window.SetBlend(false);
+    window.UseShader(upscaleShader);
+    upscaleShader.SendUniform<glm::vec2>("uvScale", rendered / size);
+    upscaleShader.SendUniform<glm::vec2>("texelSize", 1.0f / size);
+    upscaleShader.SendUniform<glm::vec2>("uvMax", (rendered - 0.5f) / size);
+    //Sharpen in proportion to the upscale: none at native scale, the full amount at the minimum.
+    const float stretch = std::clamp((1.0f - scale) / (1.0f - settings::minRenderScale), 0.0f, 1.0f);
+    upscaleShader.SendUniform<float>("sharpness", settings::upscaleSharpness * stretch);
+    window.BindTexture(0, GL_TEXTURE_2D, resolveTexture);
+    window.DrawFullscreenTriangle();
+}
+
+std::string DynamicResolution::GetHudText() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "RENDER SCALE " << scale * 100.0f << "%";
+    if (IsActive())
+    {
+        oss << " (" << std::max((int)std::lround(targetSize.x * scale), 1) << "X"
+            << std::max((int)std::lround(targetSize.y * scale), 1) << ")";
+    }
+    oss << (enabled ? "" : " FIXED") << "  GPU " << smoothedGpuMs << " / " << targetFrameMs << " MS";
+    return oss.str();
+}
+
+bool DynamicResolution::CreateTargets(Window& window, const glm::ivec2& size)
+{
+    DestroyTargets();
+    //Same 4x MSAA the window asks GLFW for.
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    GLsizei samples = std::min(4, (int)maxSamples);
+    glGenRenderbuffers(1, &sceneColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, size.x, size.y);
+    glGenRenderbuffers(1, &sceneDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, sceneDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, size.x, size.y);
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glGenFramebuffers(1, &sceneFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, sceneFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, sceneColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, sceneDepth);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    //Linear filtering does the bilinear part of the upscale.
+    glGenTextures(1, &resolveTexture);
+    glBindTexture(GL_TEXTURE_2D, resolveTexture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, size.x, size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, resolveTexture, 0);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+    {
+        std::cout << "Failed to create the dynamic resolution targets, rendering at native resolution.\n";
+        DestroyTargets();
+        glBindFramebuffer(GL_FRAMEBUFFER, window.GetFramebuffer());
+        window.InvalidateStateCache();
+        targetsFailed = true;
+        return false;
+    }
+    //The texture binding changed behind the window's back.
+    window.InvalidateStateCache();
+    targetSize = size;
+    return true;
+}
+
+void DynamicResolution::DestroyTargets() noexcept
+{
+    if (sceneFBO == 0)
+    {
+        return;
+    }
+    glDeleteFramebuffers(1, &sceneFBO);
+    glDeleteFramebuffers(1, &resolveFBO);
+    glDeleteRenderbuffers(1, &sceneColor);
+    glDeleteRenderbuffers(1, &sceneDepth);
+    glDeleteTextures(1, &resolveTexture);
+    sceneFBO = resolveFBO = sceneColor = sceneDepth = resolveTexture = 0;
+    targetSize = glm::ivec2(0);
+}
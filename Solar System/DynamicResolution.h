@@ -0,0 +1,52 @@
+#pragma once
+#include <string>
+#include <glm/vec2.hpp>
+class Window;
+class ShaderProgram;
+// Dynamic resolution: the scene is rendered into an offscreen multisampled target covering only renderScale of the
+// framebuffer's width and height, resolved, and stretched over the framebuffer by the upscale shader (bilinear with
+// an edge-aware sharpen); the HUD is drawn afterwards at native resolution. The targets are allocated at the
+// framebuffer size and the scene renders into their lower-left corner, so a new scale costs no reallocation.
+// The scale follows the smoothed GPU frame time: over the target it shrinks to the scale predicted to fit (fill
+// cost grows with the area), and grows back once a larger one is predicted to fit, with hold and settle times like
+// the quality governor.
+// While disabled at native scale nothing is redirected and the scene goes straight to the window.
+class DynamicResolution
+{
+public:
+	explicit DynamicResolution(float targetFrameMs);
+	DynamicResolution(const DynamicResolution& other) = delete;				//No copy construction allowed.
+	DynamicResolution& operator=(const DynamicResolution& other) = delete;	//No copy assignment allowed.
+	~DynamicResolution() noexcept;											//Frees the render targets.
+	void AddFrame(float frameSeconds, float gpuMs);	//gpuMs is 0 when the GPU time is not known.
+	void SetEnabled(bool enabled);		//A disabled controller keeps its current scale.
+	bool IsEnabled() const;
+	void SetScale(float scale);			//Jumps to a scale, clamped to [settings::minRenderScale, 1].
+	float GetScale() const;
+	bool IsActive() const;				//Whether the scene goes through the offscreen target this frame.
+	void BeginScene(Window& window);	//Binds and clears the scene target and sets the scaled viewport (no-op when inactive).
+	void EndScene(Window& window, ShaderProgram& upscaleShader);	//Resolves and upscales into the window's framebuffer.
+	std::string GetHudText() const;		//One line: scale, rendered size and smoothed GPU time.
+private:
+	void Step(float scale);				//Budget-driven change of scale.
+	bool CreateTargets(Window& window, const glm::ivec2& size);
+	void DestroyTargets() noexcept;
+private:
+	float targetFrameMs;
+	bool enabled = true;
+	float scale = 1.0f;
+	float smoothedGpuMs = 0.0f;
+	bool hasSample = false;
+	float overBudgetSeconds = 0.0f;		//How long the GPU time has been over the target.
+	float underBudgetSeconds = 0.0f;	//How long it has been comfortably under it.
+	float settleSeconds = 0.0f;			//Left before the measurements reflect the last change.
+	bool targetsFailed = false;			//The driver refused the targets: stay at native resolution.
+	bool sceneBegun = false;			//BeginScene redirected this frame (IsActive may change before EndScene).
+	glm::ivec2 targetSize = glm::ivec2(0);	//Allocated size, the framebuffer's.
+	glm::ivec2 renderSize = glm::ivec2(0);	//Rendered corner of this frame.
+	unsigned int sceneFBO = 0;			//Multisampled color and depth at targetSize.
+	unsigned int sceneColor = 0;
+	unsigned int sceneDepth = 0;
+	unsigned int resolveFBO = 0;		//Single-sample texture the upscale samples.
+	unsigned int resolveTexture = 0;
+};
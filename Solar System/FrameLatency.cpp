@@ -0,0 +1,172 @@
+// FrameLatency: frames-in-flight limit with fences and timestamp-based input-to-present measurement.
+#include "FrameLatency.h"
+#include <glad/glad.h>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    constexpr GLuint64 fenceTimeoutNs = 1000000000ull;  //A frame that takes longer than this is not waited for.
+    constexpr auto calibrationInterval = std::chrono::seconds(1);
+    constexpr auto averageWindow = std::chrono::milliseconds(500);
+    constexpr size_t maxPendingFrames = 8;              //Beyond this the oldest results are read even if that stalls.
+}
+
+FrameLatency::FrameLatency(int maxFramesInFlight) :
+    maxFramesInFlight(maxFramesInFlight > 0 ? maxFramesInFlight : 1)
+{
+}
+
+FrameLatency::~FrameLatency() noexcept
+{
+    for (PendingFrame& frame : pendingFrames)
+    {
+        if (frame.fence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(frame.fence));
+        }
+        freeQueries.push_back(frame.query);
+    }
+    if (!freeQueries.empty())
+    {
+        glDeleteQueries((GLsizei)freeQueries.size(), freeQueries.data());
+    }
+}
+
+void FrameLatency::SetLimitEnabled(bool enabled)
+{
+    limitEnabled = enabled;
+}
+
+bool FrameLatency::IsLimitEnabled() const
+{
+    return limitEnabled;
+}
+
+void FrameLatency::WaitForFrameSlot()
+{
+    if (!limitEnabled)
+    {
+        return;
+    }
+    int inFlight = 0;
+    for (const PendingFrame& frame : pendingFrames)
+    {
+        inFlight += frame.fence != nullptr ? 1 : 0;
+    }
+    const Clock::time_point start = Clock::now();
+    for (PendingFrame& frame : pendingFrames)
+    {
+        if (inFlight < maxFramesInFlight)
+        {
+            break;
+        }
+        if (frame.fence == nullptr)
+        {
+            continue;
+        }
+        GLsync fence = static_cast<GLsync>(frame.fence);
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, fenceTimeoutNs);
+        glDeleteSync(fence);
+        frame.fence = nullptr;
+        --inFlight;
+    }
+    waitAccumulatedMs += std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    ++waitSamples;
+}
+
+void FrameLatency::MarkInputSampled()
+{
+    inputTime = Clock::now();
+}
+
+void FrameLatency::EndFrame()
+{
+    if (!calibrated || Clock::now() - lastCalibration >= calibrationInterval)
+    {
+        Calibrate();
+    }
+    PendingFrame frame;
+    if (freeQueries.empty())
+    {
+        freeQueries.resize(1);
+        glGenQueries(1, freeQueries.data());
+    }
+    frame.query = freeQueries.back();
+    freeQueries.pop_back();
+    glQueryCounter(frame.query, GL_TIMESTAMP);
+    frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frame.inputTime = inputTime;
+    pendingFrames.push_back(frame);
+    CollectFinishedFrames();
+
+    const Clock::time_point now = Clock::now();
+    if (now - windowStart >= averageWindow)
+    {
+        if (latencySamples > 0)
+        {
+            averageLatencyMs = (float)(latencyAccumulatedMs / latencySamples);
+        }
+        averageWaitMs = waitSamples > 0 ? (float)(waitAccumulatedMs / waitSamples) : 0.0f;
+        latencyAccumulatedMs = waitAccumulatedMs = 0.0;
+        latencySamples = waitSamples = 0;
+        windowStart = now;
+    }
+}
+
+void FrameLatency::CollectFinishedFrames()
+{
+    while (!pendingFrames.empty())
+    {
+        PendingFrame& frame = pendingFrames.front();
+        GLint available = 0;
+        glGetQueryObjectiv(frame.query, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available && pendingFrames.size() <= maxPendingFrames)
+        {
+            break;  //Later frames cannot have finished either.
+        }
+        GLuint64 gpuTimeNs = 0;
+        glGetQueryObjectui64v(frame.query, GL_QUERY_RESULT, &gpuTimeNs);
+        const long long finishedNs = (long long)gpuTimeNs + gpuToCpuOffsetNs;
+        const long long inputNs = std::chrono::duration_cast<std::chrono::nanoseconds>(frame.inputTime.time_since_epoch()).count();
+        if (gpuTimeNs != 0 && finishedNs > inputNs)
+        {
+            latencyAccumulatedMs += (finishedNs - inputNs) * 1e-6;
+            ++latencySamples;
+        }
+        if (frame.fence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(frame.fence));
+        }
+        freeQueries.push_back(frame.query);
+        pendingFrames.pop_front();
+    }
+}
+
+void FrameLatency::Calibrate()
+{
+    //GL_TIMESTAMP read on the CPU is the GPU clock now, without waiting for queued work.
+    GLint64 gpuNowNs = 0;
+    glGetInteger64v(GL_TIMESTAMP, &gpuNowNs);
+    const Clock::time_point cpuNow = Clock::now();
+    gpuToCpuOffsetNs = std::chrono::duration_cast<std::chrono::nanoseconds>(cpuNow.time_since_epoch()).count() - gpuNowNs;
+    lastCalibration = cpuNow;
+    calibrated = true;
+}
+
+float FrameLatency::GetAverageLatencyMs() const
+{
+    return averageLatencyMs;
+}
+
+std::string FrameLatency::GetHudText() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "LATENCY " << averageLatencyMs << " MS INPUT TO GPU DONE";
+    if (limitEnabled)
+    {
+        oss << "  LOW LATENCY: " << maxFramesInFlight << " FRAME" << (maxFramesInFlight > 1 ? "S" : "")
+            << " IN FLIGHT, WAIT " << averageWaitMs << " MS";
+    }
+    return oss.str();
+}
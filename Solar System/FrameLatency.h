@@ -0,0 +1,53 @@
+#pragma once
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+// Input-to-present latency: bounds how many frames the GPU may still be working on and measures how long input
+// takes to reach the screen. After every present a fence and a GL_TIMESTAMP query are inserted. With the limit on,
+// a new frame does not start until the fence of the frame maxFramesInFlight back has signaled, so input is read
+// against a drained queue instead of several frames ahead of the GPU. The timestamp of a finished frame, mapped
+// onto the CPU clock, minus the moment its input was read is the measured latency (up to the end of the GPU's work;
+// with vsync the display adds up to one refresh on top).
+class FrameLatency
+{
+public:
+	explicit FrameLatency(int maxFramesInFlight);
+	FrameLatency(const FrameLatency& other) = delete;				//No copy construction allowed.
+	FrameLatency& operator=(const FrameLatency& other) = delete;	//No copy assignment allowed.
+	~FrameLatency() noexcept;										//Frees the pending fences and queries.
+	void SetLimitEnabled(bool enabled);
+	bool IsLimitEnabled() const;
+	void WaitForFrameSlot();	//Blocks while maxFramesInFlight frames are still on the GPU (limit on).
+	void MarkInputSampled();	//The input the current frame shows was read now.
+	void EndFrame();			//After present: fences and timestamps the frame, collects the finished ones.
+	float GetAverageLatencyMs() const;	//0 until the first frames have finished.
+	std::string GetHudText() const;		//One line: latency, limit and time spent waiting for the GPU.
+private:
+	using Clock = std::chrono::steady_clock;
+	struct PendingFrame
+	{
+		void* fence;				//GLsync, kept opaque so GL headers stay out of this header; null once waited on.
+		unsigned int query;			//GL_TIMESTAMP written after the frame's commands.
+		Clock::time_point inputTime;
+	};
+	void CollectFinishedFrames();
+	void Calibrate();				//Offset between the GL timestamp clock and the steady clock.
+private:
+	int maxFramesInFlight;
+	bool limitEnabled = false;
+	std::deque<PendingFrame> pendingFrames;
+	std::vector<unsigned int> freeQueries;
+	Clock::time_point inputTime = Clock::now();
+	Clock::time_point lastCalibration;
+	bool calibrated = false;
+	long long gpuToCpuOffsetNs = 0;	//Steady clock nanoseconds minus GL timestamp nanoseconds.
+	//Averages over half a second, like the profiler HUD.
+	Clock::time_point windowStart = Clock::now();
+	double latencyAccumulatedMs = 0.0;
+	double waitAccumulatedMs = 0.0;
+	int latencySamples = 0;
+	int waitSamples = 0;
+	float averageLatencyMs = 0.0f;
+	float averageWaitMs = 0.0f;
+};
@@ -0,0 +1,78 @@
+// FramePacer: sleep-then-spin frame cap.
+#include "FramePacer.h"
+#include "Settings.h"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+FramePacer::FramePacer(float targetFps, bool vsync) :
+    targetFps(targetFps),
+    vsync(vsync)
+{
+    if (targetFps > 0.0f)
+    {
+        frameInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / targetFps));
+    }
+}
+
+void FramePacer::WaitForNextFrame()
+{
+    if (frameInterval == Clock::duration::zero())
+    {
+        return;
+    }
+    const Clock::time_point start = Clock::now();
+    if (scheduled && start < nextFrame)
+    {
+        //Sleep while the deadline is far off, then spin (yielding) for the precise part.
+        const auto spin = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<float, std::milli>(settings::frameSpinMs));
+        if (nextFrame - start > spin)
+        {
+            std::this_thread::sleep_for(nextFrame - start - spin);
+        }
+        while (Clock::now() < nextFrame)
+        {
+            std::this_thread::yield();
+        }
+        nextFrame += frameInterval;
+    }
+    else
+    {
+        nextFrame = start + frameInterval;  //First frame, or late: no catching up.
+    }
+    scheduled = true;
+    lastWaitMs = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+}
+
+void FramePacer::AddSkippedFrame()
+{
+    ++skippedFrames;
+    scheduled = false;  //The next frame after an idle stretch starts a new schedule.
+}
+
+float FramePacer::GetTargetFps() const
+{
+    return targetFps;
+}
+
+bool FramePacer::IsVsync() const
+{
+    return vsync;
+}
+
+std::string FramePacer::GetHudText() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "PACING ";
+    if (targetFps > 0.0f)
+    {
+        oss << targetFps << " FPS CAP, WAIT " << lastWaitMs << " MS";
+    }
+    else
+    {
+        oss << "UNCAPPED";
+    }
+    oss << (vsync ? "  VSYNC" : "  NO VSYNC") << "  IDLE FRAMES " << skippedFrames;
+    return oss.str();
+}
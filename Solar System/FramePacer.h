@@ -0,0 +1,26 @@
+#pragma once
+#include <chrono>
+#include <string>
+// Frame pacing: caps the frame rate at a target by sleeping until the next frame is due and spinning through the
+// last stretch (OS sleeps overshoot by up to a scheduler tick; the spin absorbs that without burning a whole core).
+// A frame that starts late does not leave a debt behind: the schedule restarts from it instead of rushing the next
+// few. Vsync is only recorded here; the window applies it as the swap interval.
+class FramePacer
+{
+public:
+	FramePacer(float targetFps, bool vsync);	//targetFps 0 = no cap.
+	void WaitForNextFrame();		//Returns once the next frame is due (at once without a cap).
+	void AddSkippedFrame();			//Render on demand left a frame out.
+	float GetTargetFps() const;
+	bool IsVsync() const;
+	std::string GetHudText() const;	//One line: cap, vsync, last wait and frames left out.
+private:
+	using Clock = std::chrono::steady_clock;
+	float targetFps;
+	bool vsync;
+	Clock::duration frameInterval = Clock::duration::zero();
+	Clock::time_point nextFrame;
+	bool scheduled = false;			//nextFrame holds a deadline.
+	float lastWaitMs = 0.0f;
+	unsigned long long skippedFrames = 0;
+};
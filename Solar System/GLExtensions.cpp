@@ -0,0 +1,64 @@
+// GLExtensions: extension queries and the entry points GLAD was not generated with.
+#include "GLExtensions.h"
+#include <cstring>
+
+namespace {
+    constexpr GLenum numProgramBinaryFormats = 0x87FE;     //GL_NUM_PROGRAM_BINARY_FORMATS
+
+    GLExtensions extensions;
+
+    template<typename Function>
+    void LoadFunction(GLADloadproc load, Function& function, const char* name)
+    {
+        function = reinterpret_cast<Function>(load(name));
+    }
+}
+
+void LoadGLExtensions(GLADloadproc load)
+{
+    extensions = GLExtensions{};
+    GLint majorVersion = 0, minorVersion = 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &majorVersion);
+    glGetIntegerv(GL_MINOR_VERSION, &minorVersion);
+    if (majorVersion * 10 + minorVersion >= 41 || HasGLExtension("GL_ARB_get_program_binary"))
+    {
+        LoadFunction(load, extensions.getProgramBinary, "glGetProgramBinary");
+        LoadFunction(load, extensions.programBinary, "glProgramBinary");
+        LoadFunction(load, extensions.programParameteri, "glProgramParameteri");
+        GLint formatCount = 0;
+        glGetIntegerv(numProgramBinaryFormats, &formatCount);
+        extensions.hasProgramBinary = formatCount > 0 && extensions.getProgramBinary != nullptr
+            && extensions.programBinary != nullptr && extensions.programParameteri != nullptr;
+    }
+    if (HasGLExtension("GL_KHR_parallel_shader_compile"))
+    {
+        LoadFunction(load, extensions.maxShaderCompilerThreads, "glMaxShaderCompilerThreadsKHR");
+    }
+    else if (HasGLExtension("GL_ARB_parallel_shader_compile"))
+    {
+        LoadFunction(load, extensions.maxShaderCompilerThreads, "glMaxShaderCompilerThreadsARB");
+    }
+    extensions.hasParallelShaderCompile = extensions.maxShaderCompilerThreads != nullptr;
+    if (extensions.hasParallelShaderCompile)
+    {
+        extensions.maxShaderCompilerThreads(0xFFFFFFFFu);   //As many threads as the driver wants.
+    }
+}
+
+const GLExtensions& GetGLExtensions()
+{
+    return extensions;
+}
+
+bool HasGLExtension(const char* name)
+{
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; ++i)
+    {
+        const char* extension = reinterpret_cast<const char*>(glGetStringi(GL_EXTENSIONS, i));
+        if (extension != nullptr && std::strcmp(extension, name) == 0)
+            return true;
+    }
+    return false;
+}
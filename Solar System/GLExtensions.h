@@ -0,0 +1,20 @@
+#pragma once
+#include <glad/glad.h>
+// OpenGL extensions used on top of the 3.3 core profile the GLAD loader was generated for. Their entry points
+// are fetched with the same loader as the core functions (the window does it right after loading GLAD); a null
+// pointer or a false flag means the driver lacks the extension and callers take the plain 3.3 path.
+struct GLExtensions
+{
+	//ARB_get_program_binary (core since 4.1): linked programs can be saved and loaded back without compiling.
+	bool hasProgramBinary = false;		//Also needs the driver to offer at least one binary format.
+	void (APIENTRYP getProgramBinary)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary) = nullptr;
+	void (APIENTRYP programBinary)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length) = nullptr;
+	void (APIENTRYP programParameteri)(GLuint program, GLenum pname, GLint value) = nullptr;
+	//KHR/ARB_parallel_shader_compile: compiles and links return at once and finish on driver threads.
+	bool hasParallelShaderCompile = false;
+	void (APIENTRYP maxShaderCompilerThreads)(GLuint count) = nullptr;
+};
+//Queries the extensions of the current context and, with parallel compilation, lets the driver pick its thread count.
+void LoadGLExtensions(GLADloadproc load);
+const GLExtensions& GetGLExtensions();
+bool HasGLExtension(const char* name);	//Listed by the current context.
@@ -1,9 +1,9 @@
 // Implements the simulation step and rendering of the solar system.
 // Responsibilities:
-//  - Initialize shaders, meshes (sphere, ring), textures, and planet parameters
+//  - Load the scene description and initialize shaders, meshes (sphere, rings), textures and body parameters
 //  - Handle input (camera motion, toggles, time scaling)
-//  - Advance or pause simulation state (planets, moon, asteroids)
-//  - Render solid bodies (default + earth shader), overlays (atmospheres/rings), and unlit (sun, skybox)
+//  - Advance or pause simulation state (planets, moons, asteroids)
+//  - Render solid bodies (one surface permutation each), cubemap skybox, then overlays (atmospheres/rings)
 #include "Game.h"
 #include "Settings.h"
 #include <glm/gtc/matrix_transform.hpp>
@@ -14,316 +14,587 @@
 #include <cmath>
 #include <sstream>
 #include <iomanip>
-#include "../Dependencies/stb_easy_font.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <limits>
+#include <unordered_map>
 #include "Orbital.h"
 
-Game::Game(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight, const std::string title, GLFWmonitor* monitor, GLFWwindow* share)
+Game::Game(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight, const std::string title, const LaunchOptions& options, GLFWmonitor* monitor, GLFWwindow* share)
     :
-    window(windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, title, monitor, share),
-    defaultShader(settings::shadersPath + "default.vert", settings::shadersPath + "default.frag"),
-    noLightShader(settings::shadersPath + "noLight.vert", settings::shadersPath + "noLight.frag"),
-    overlayShader(settings::shadersPath + "overlay.vert", settings::shadersPath + "overlay.frag"),
-    textShader(settings::shadersPath + "text.vert", settings::shadersPath + "text.frag"),
-    orbitShader(settings::shadersPath + "orbit.vert", settings::shadersPath + "orbit.frag"),
-    earthShader(settings::shadersPath + "earth.vert", settings::shadersPath + "earth.frag"),
+    options(options),
+    window(windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, title, monitor, share, options.headless),
+    qualityGovernor(settings::frameTimeTargetMs),
+    dynamicResolution(settings::frameTimeTargetMs),
+    framePacer(options.targetFps >= 0.0f ? options.targetFps : settings::targetFps, settings::vsync && options.vsync && !options.headless),
+    frameLatency(settings::maxFramesInFlight),
+    renderOnDemand(settings::renderOnDemand && options.renderOnDemand && !options.headless && options.replayPath.empty()),
+    assetPack(options.useAssetPack ? settings::assetPackPath : std::string()),
+    textureStreamer(jobSystem, assetPack, settings::cachePath),
+    scene(LoadSceneDescription()),
+    sceneTextures(RequestSceneTextures()),
+    sphereMeshData(SubmitSphereMeshJob()),
+    asteroidMeshData(SubmitAsteroidMeshJobs()),
+    surfaceShaders(settings::shadersPath + "surface.vert", settings::shadersPath + "surface.frag", assetPack, GetScenePermutations()),
+    textShader(settings::shadersPath + "text.vert", settings::shadersPath + "text.frag", assetPack),
+    orbitShader(settings::shadersPath + "orbit.vert", settings::shadersPath + "orbit.frag", assetPack),
+    skyboxShader(settings::shadersPath + "skybox.vert", settings::shadersPath + "skybox.frag", assetPack),
+    depthShader(settings::shadersPath + "depth.vert", settings::shadersPath + "depth.frag", assetPack),
+    overdrawShader(settings::shadersPath + "depth.vert", settings::shadersPath + "overdraw.frag", assetPack),
+    asteroidShader(settings::shadersPath + "asteroid.vert", settings::shadersPath + "surface.frag", assetPack,
+        SurfaceShaders::GetDefines(SurfaceShaders::RimLight)),
+    asteroidDepthShader(settings::shadersPath + "asteroid.vert", settings::shadersPath + "depth.frag", assetPack),
+    asteroidOverdrawShader(settings::shadersPath + "asteroid.vert", settings::shadersPath + "overdraw.frag", assetPack),
+    upscaleShader(settings::shadersPath + "upscale.vert", settings::shadersPath + "upscale.frag", assetPack),
     camera(settings::cameraInitialPosition, settings::cameraSpeed, settings::cameraYaw,
         settings::cameraPitch, settings::cameraMaxPitch, settings::cameraSensitivity, settings::cameraFOV,
         settings::screenRatio, settings::cameraNearPlaneDistance, settings::cameraFarPlaneDistance),
-    sphereMesh(settings::meshesPath + "sphere.obj"),
-    earthNightTexture(settings::texturesPath + "earth_night.jpg"),
-    earthSpecularTexture(settings::texturesPath + "earth_specular.jpg"),
-    earthCloudsTexture(settings::texturesPath + "earth_clouds.jpg"),
-    skyboxTexture(settings::texturesPath + "stars_milkyway.jpg"),
-    venusAtmosphereTexture(settings::texturesPath + "venus atmosphere.jpg"),
-    saturnRingTexture(settings::texturesPath + "saturn ring.png"),
-    moonTexture(settings::texturesPath + "moon.jpg"),
-    asteroidTexture(settings::texturesPath + "asteroid.jpg"),
-    uranusRingTexture(settings::texturesPath + "saturn ring.png")
+    skybox(settings::texturesPath + "stars_milkyway.jpg", settings::cachePath + "stars_milkyway.cube", settings::skyboxFaceSize, assetPack),
+    asteroidRenderer(settings::asteroidBaseSubdivisions)
 {
     lastMousePosition = window.GetMousePosition();
     lastTime = window.GetElapsedTime();
-    skyBox.ApplyScale(glm::vec3{ settings::cameraFarPlaneDistance });
-    //Load the textures and initialize the planets.
-    //Sun
-    planetTextures.emplace_back(settings::texturesPath + "sun.jpg");
-    planets.emplace_back(0.f, settings::sunScale, 0.f, settings::sunRotationSpeed);
-    //Earth
-    planetTextures.emplace_back(settings::texturesPath + "earth.jpg");
-    planets.emplace_back(settings::earthOrbitRadius, settings::earthScale, settings::earthOrbitSpeed, settings::earthRotationSpeed);
-    //Mercury
-    planetTextures.emplace_back(settings::texturesPath + "mercury.jpg");
-    planets.emplace_back(settings::mercuryOrbitRadius, settings::mercuryScale, settings::mercuryOrbitSpeed, settings::mercuryRotationSpeed);
-    //Venus
-    planetTextures.emplace_back(settings::texturesPath + "venus.jpg");
-    planets.emplace_back(settings::venusOrbitRadius, settings::venusScale, settings::venusOrbitSpeed, settings::venusRotationSpeed);
-    //Mars
-    planetTextures.emplace_back(settings::texturesPath + "mars.jpg");
-    planets.emplace_back(settings::marsOrbitRadius, settings::marsScale, settings::marsOrbitSpeed, settings::marsRotationSpeed);
-    //Jupiter
-    planetTextures.emplace_back(settings::texturesPath + "jupiter.jpg");
-    planets.emplace_back(settings::jupiterOrbitRadius, settings::jupiterScale, settings::jupiterOrbitSpeed, settings::jupiterRotationSpeed);
-    //Saturn
-    planetTextures.emplace_back(settings::texturesPath + "saturn.jpg");
-    planets.emplace_back(settings::saturnOrbitRadius, settings::saturnScale, settings::saturnOrbitSpeed, settings::saturnRotationSpeed);
-    //Uranus
-    planetTextures.emplace_back(settings::texturesPath + "uranus.jpg");
-    planets.emplace_back(settings::uranusOrbitRadius, settings::uranusScale, settings::uranusOrbitSpeed, settings::uranusRotationSpeed);
-    //Neptune
-    planetTextures.emplace_back(settings::texturesPath + "neptune.jpg");
-    planets.emplace_back(settings::neptuneOrbitRadius, settings::neptuneScale, settings::neptuneOrbitSpeed, settings::neptuneRotationSpeed);
-
-    // Kepler elements (approx J2000) scaled to scene units (a in Earth-orbit-radius units)
-    planetElements.resize(planets.size());
-    planetSelfRotationDeg.assign(planets.size(), 0.0f);
-    planetRotationSpeedDeg.clear();
-    planetObliquityDeg.clear();
-    planetRotationSpeedDeg.push_back(settings::sunRotationSpeed);
-    planetObliquityDeg.push_back(0.0f); // Sun (unused)
-
-    auto AU = settings::keplerAUScale; // scene units per AU for Kepler mapping
-    auto make = [&](int idx, double aAU, double e, double i, double Om, double om, double M0, double nDegPerDay,
-                    float rotSpeedDeg, float obliqDeg)
-    {
-        planetElements[idx] = { aAU * AU, e, i, Om, om, M0, nDegPerDay, settings::epochJD_J2000 };
-        planetRotationSpeedDeg.push_back(rotSpeedDeg);
-        planetObliquityDeg.push_back(obliqDeg);
-    };
-    if (planets.size() >= 9)
-    {
-        // Indexing: 0 Sun, 1 Earth, 2 Mercury, 3 Venus, 4 Mars, 5 Jupiter, 6 Saturn, 7 Uranus, 8 Neptune
-        make(2, 0.387098, 0.205630, 7.00487, 48.33167, 29.12478, 174.79588, 360.0/87.969, settings::mercuryRotationSpeed, settings::obliqMercury);
-        make(3, 0.723332, 0.006772, 3.39471, 76.68069, 54.85229, 50.41611, 360.0/224.701, settings::venusRotationSpeed,   settings::obliqVenus);
-        make(1, 1.000000, 0.016710, 0.00005, -11.26064, 102.94719, 357.51716, 360.0/365.256, settings::earthRotationSpeed,   settings::obliqEarth);
-        make(4, 1.523662, 0.093412, 1.85061, 49.57854, 336.04084, 19.41248, 360.0/686.980, settings::marsRotationSpeed,    settings::obliqMars);
-        make(5, 5.203363, 0.048393, 1.30530, 100.55615, 14.75385, 20.02019, 360.0/4332.59, settings::jupiterRotationSpeed, settings::obliqJupiter);
-        make(6, 9.537070, 0.054151, 2.48446, 113.71504, 92.43194, 317.02069, 360.0/10759.22, settings::saturnRotationSpeed,  settings::obliqSaturn);
-        make(7, 19.191264, 0.047168, 0.76986, 74.22988, 170.96424, 142.23860, 360.0/30688.5, settings::uranusRotationSpeed,  settings::obliqUranus);
-        make(8, 30.068964, 0.008586, 1.76917, 131.72169, 44.97135, 256.22800, 360.0/60182.0, settings::neptuneRotationSpeed, settings::obliqNeptune);
-
-        // Ensure Mercury's perihelion clears the Sun radius with a small safety margin
-        if (planetElements.size() > 2)
+    window.SetSwapInterval(framePacer.IsVsync() ? 1 : 0);
+    frameLatency.SetLimitEnabled(settings::lowLatencyMode || options.lowLatency);
+    StartInputRecording();
+    InitializeBodies();
+    FinishShaders();
+    //Setup the lighting in the shaders.
+    for (const auto& permutation : surfaceShaders.GetPrograms())
+    {
+        SetupSurfaceUniforms(*permutation.second, permutation.first);
+    }
+    SetupSurfaceUniforms(asteroidShader, SurfaceShaders::RimLight);
+    window.UseShader(skyboxShader);
+    skyboxShader.SendUniform<int>("skyboxSampler", 0);
+    window.UseShader(upscaleShader);
+    upscaleShader.SendUniform<int>("sceneTexture", 0);
+
+    // One ring mesh per inner radius (rings are scaled to their body's size)
+    bodyRingMeshes.assign(bodies.size(), -1);
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const SceneBody& body = scene.bodies[i];
+        if (body.ringTexture.empty())
         {
-            double peri = planetElements[2].a * (1.0 - planetElements[2].e);
-            double minClear = (double)settings::sunScale + 6.0; // margin
-            if (peri < minClear)
-            {
-                planetElements[2].a = minClear / (1.0 - planetElements[2].e);
-            }
+            continue;
+        }
+        const float innerRadius = body.ringInner / body.ringOuter;
+        auto found = std::find(ringMeshInnerRadii.begin(), ringMeshInnerRadii.end(), innerRadius);
+        if (found == ringMeshInnerRadii.end())
+        {
+            ringMeshes.push_back(CreateRingMesh(innerRadius));
+            found = ringMeshInnerRadii.insert(ringMeshInnerRadii.end(), innerRadius);
         }
+        bodyRingMeshes[i] = (int)(found - ringMeshInnerRadii.begin());
     }
-    //Setup the lighting in the shaders.
-    window.UseShader(defaultShader);
-    defaultShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
-    defaultShader.SendUniform<float>("timeSeconds", lastTime);
-    defaultShader.SendUniform<glm::vec3>("lightPosition", { 0.0f,0.0f,0.0f });
-    defaultShader.SendUniform<glm::vec3>("ambientColor", settings::ambientColor);
-    defaultShader.SendUniform<glm::vec3>("sunlightColor", settings::sunlightColor);
-    window.UseShader(earthShader);
-    earthShader.SendUniform<glm::vec3>("ambientColor", settings::earthAmbientColor);
-    earthShader.SendUniform<glm::vec3>("sunlightColor", settings::sunlightColor);
-    earthShader.SendUniform<glm::vec3>("lightPosition", { 0.0f,0.0f,0.0f });
-    earthShader.SendUniform<float>("specularStrength", settings::earthSpecularStrength);
-    earthShader.SendUniform<float>("specularShininess", settings::earthSpecularShininess);
-    earthShader.SendUniform<int>("textureEarth", 0); //Assign locations to the texture samplers.
-    earthShader.SendUniform<int>("textureEarthNight", 1);
-    earthShader.SendUniform<int>("textureSpecular", 2);
-    earthShader.SendUniform<int>("textureClouds", 3);
-    // overlay shader lighting
-    window.UseShader(overlayShader);
-    overlayShader.SendUniform<glm::vec3>("ambientColor", settings::earthAmbientColor);
-    overlayShader.SendUniform<glm::vec3>("sunlightColor", settings::sunlightColor);
-    overlayShader.SendUniform<glm::vec3>("lightPosition", { 0.0f,0.0f,0.0f });
-
-    // Create a simple ring mesh (unit ring in XZ plane) - positions and texcoords
-    {
-        std::vector<glm::vec3> pos;
-        std::vector<glm::vec2> uv;
-        std::vector<glm::vec3> nrm;
-        const int segments = 128;
-        const float innerR = settings::saturnRingInner / settings::saturnRingOuter; // normalized inner radius based on settings
-        const float outerR = 1.0f; // normalized outer radius
-        for (int i = 0; i < segments; ++i)
+
+    // Generate the asteroid belts (their radii are in AU, rescaled by the Kepler AU)
+    {
+        // The pool of irregular icosphere meshes was generated on the workers; upload it in one batch, then assign randomly per asteroid
+        std::vector<MeshData> variants;
+        variants.reserve(asteroidMeshData.size());
+        for (std::future<MeshData>& data : asteroidMeshData)
+        {
+            variants.push_back(data.get());
+        }
+        asteroidMeshData.clear();
+        asteroidMeshes = MeshBatch(variants);
+        std::vector<AsteroidBelt::Band> bands;
+        for (const SceneBelt& belt : scene.belts)
         {
-            float a0 = (float)i * 6.28318530718f / segments;
-            float a1 = (float)(i+1) * 6.28318530718f / segments;
-            float c0 = cos(a0), s0 = sin(a0);
-            float c1 = cos(a1), s1 = sin(a1);
-            // quad two triangles: outer0, inner0, inner1 and outer0, inner1, outer1
-            glm::vec3 o0 = { outerR*c0, 0.0f, outerR*s0 };
-            glm::vec3 i0 = { innerR*c0, 0.0f, innerR*s0 };
-            glm::vec3 o1 = { outerR*c1, 0.0f, outerR*s1 };
-            glm::vec3 i1 = { innerR*c1, 0.0f, innerR*s1 };
-            // simple radial UV: r mapped to [0,1], angle to [0,1]
-            // Radial mapping only: sample the ring texture horizontally from rightmost (inner) to leftmost (outer).
-            // We'll map radius to U and ignore V (sample midline).
-            // Avoid sampling extreme edges of the PNG where premultiplied alpha/bleed is visible
-            float uInner = 0.98f; // rightmost of the PNG (clamped)
-            float uOuter = 0.02f; // leftmost of the PNG (clamped)
-            float uInnerMapped = glm::mix(uInner, uOuter, innerR);
-            glm::vec2 uvo0 = { uOuter, 0.5f };
-            glm::vec2 uvi0 = { uInnerMapped, 0.5f };
-            glm::vec2 uvo1 = { uOuter, 0.5f };
-            glm::vec2 uvi1 = { uInnerMapped, 0.5f };
-            glm::vec3 up = {0,1,0};
-            // tri1
-            pos.push_back(o0); uv.push_back(uvo0); nrm.push_back(up);
-            pos.push_back(i0); uv.push_back(uvi0); nrm.push_back(up);
-            pos.push_back(i1); uv.push_back(uvi1); nrm.push_back(up);
-            // tri2
-            pos.push_back(o0); uv.push_back(uvo0); nrm.push_back(up);
-            pos.push_back(i1); uv.push_back(uvi1); nrm.push_back(up);
-            pos.push_back(o1); uv.push_back(uvo1); nrm.push_back(up);
+            bands.push_back(belt.band);
         }
-        ringMesh = Mesh(pos, uv, nrm);
+        asteroidBelt.Generate(bands, asteroidMeshes.GetMeshCount());
+        asteroidRenderer.GenerateShapes(asteroidBelt.GetCount(), 2024);
+    }
+
+    InitializeOrbitPaths();
+    InitializeFollowTargets();
+    InitializeTrails();
+    InitializeHudResources();
+    //Without a pending job the sphere comes straight from the asset pack.
+    sphereMesh = sphereMeshData.valid() ? Mesh(sphereMeshData.get()) : LoadPackedMesh(settings::meshesPath + "sphere.obj");
+    for (int slices : sphereLodSlices)
+    {
+        sphereLods.emplace_back(Mesh::GenerateUVSphereData(slices, slices / 2, 0.99f));  // sphere.obj's mean radius
+    }
+    //Reproducible runs keep full detail unless asked to adapt; a pinned level never changes.
+    qualityGovernor.SetEnabled(options.governQuality
+        || (settings::qualityGovernor && options.qualityLevel < 0 && !IsFixedStep()));
+    qualityGovernor.SetLevel(std::max(options.qualityLevel, 0));
+    //Same for the render scale: captures and benchmarks stay at native resolution by default.
+    dynamicResolution.SetEnabled(options.governRenderScale
+        || (settings::dynamicResolution && options.renderScale < 0.0f && !IsFixedStep()));
+    dynamicResolution.SetScale(options.renderScale < 0.0f ? 1.0f : options.renderScale);
+    savedCameraPosition = camera.GetPosition();
+    savedCameraYaw = camera.GetYaw();
+    savedCameraPitch = camera.GetPitch();
+    if (!options.tracePath.empty())
+    {
+        profiler.SetTraceRecording(true);
+    }
+}
+
+SceneDescription Game::LoadSceneDescription() const
+{
+    const std::string path = options.scenePath.empty() ? settings::scenePath : options.scenePath;
+    const auto begin = std::chrono::steady_clock::now();
+    SceneDescription loaded;
+    if (!LoadScene(path, assetPack, loaded))
+    {
+        std::cout << "Failed to load the scene: " << path << "\n";
+        exit(EXIT_FAILURE);
     }
+    //--asteroids shares its count among the belts in the proportions the scene gives them.
+    if (options.asteroidCount >= 0)
+    {
+        SetAsteroidCount(loaded, options.asteroidCount);
+    }
+    size_t asteroidCount = 0;
+    for (const SceneBelt& belt : loaded.belts)
+    {
+        asteroidCount += (size_t)belt.band.count;
+    }
+    std::cout << "Scene " << path << ": " << loaded.bodies.size() << " bodies, " << asteroidCount << " asteroids in "
+        << loaded.belts.size() << " belts (" << std::fixed << std::setprecision(1)
+        << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count() << " ms)\n" << std::defaultfloat;
+    return loaded;
+}
 
-    // Generate asteroid belt (rescaled by Kepler AU so it sits between Mars and Jupiter)
+std::vector<Texture> Game::RequestSceneTextures()
+{
+    //Each file is requested once, however many bodies name it; the first placeholder color wins.
+    std::vector<Texture> textures;
+    std::unordered_map<std::string, int> indices;
+    auto request = [&](const std::string& file, const glm::vec4& placeholder)
     {
-        asteroids.reserve(settings::asteroidCount);
-        // Pre-generate a small pool of irregular icosphere meshes, then assign randomly per asteroid
+        if (file.empty())
         {
-            asteroidMeshes.reserve(4);
-            asteroidMeshes.push_back(Mesh::GenerateCraggyAsteroid(1, 1.0f, 0.15f, 3.0f, 11));
-            asteroidMeshes.push_back(Mesh::GenerateCraggyAsteroid(2, 1.0f, 0.18f, 2.0f, 37));
-            asteroidMeshes.push_back(Mesh::GenerateCraggyAsteroid(2, 1.2f, 0.2f, 2.5f, 73));
-            asteroidMeshes.push_back(Mesh::GenerateCraggyAsteroid(3, 0.9f, 0.22f, 3.0f, 101));
+            return -1;
         }
-        std::mt19937 rng(12345);
-        std::uniform_real_distribution<float> r01(0.0f, 1.0f);
-        std::uniform_real_distribution<float> rSign(-1.0f, 1.0f);
-        float asteroidBeltInnerWorld = 2.2f * settings::keplerAUScale;
-        float asteroidBeltOuterWorld = 3.2f * settings::keplerAUScale;
-        for (int i = 0; i < settings::asteroidCount; ++i)
+        auto found = indices.find(file);
+        if (found != indices.end())
         {
-            float t = r01(rng);
-            float radius = glm::mix(asteroidBeltInnerWorld, asteroidBeltOuterWorld, t);
-            // Vary irregular scale along axes with tighter bounds for rocky appearance
-            float baseScale = glm::mix(settings::asteroidMinScale, settings::asteroidMaxScale, r01(rng));
-            // Random deviations from base to create rocky, lumpy shape (not bean-like)
-            float sx = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
-            float sy = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
-            float sz = baseScale * glm::mix(0.7f, 1.3f, r01(rng));
-            float angleDeg = r01(rng) * 360.0f;
-            // Kepler-like speed: v ~ r^(-3/2) so angular speed ~ r^(-3/2)
-            float angularSpeedDeg = settings::asteroidBaseAngularSpeed * powf(radius / asteroidBeltInnerWorld, -settings::asteroidSpeedExponent);
-            // small vertical/lateral noise
-            glm::vec3 offset = { 0.0f, (r01(rng) - 0.5f) * 2.0f * settings::asteroidBeltHalfThickness, 0.0f };
-            // random spin
-            glm::vec3 axis = glm::normalize(glm::vec3(rSign(rng), rSign(rng), rSign(rng)));
-            float spinSpeed = glm::mix(10.0f, 60.0f, r01(rng));
-            int meshIndex = int(r01(rng) * asteroidMeshes.size()) % asteroidMeshes.size();
-            asteroids.push_back({ radius, angleDeg, angularSpeedDeg, {sx, sy, sz}, offset, r01(rng) * 360.0f, axis, spinSpeed, meshIndex });
+            return found->second;
         }
+        textures.emplace_back(settings::texturesPath + file, textureStreamer, placeholder);
+        return indices[file] = (int)textures.size() - 1;
+    };
+    const glm::vec4 black(0.0f, 0.0f, 0.0f, 1.0f);
+    bodyTextures.clear();
+    bodyTextures.reserve(scene.bodies.size());
+    for (const SceneBody& body : scene.bodies)
+    {
+        bodyTextures.push_back({ request(body.texture, body.color), request(body.nightMap, black), request(body.specularMap, black),
+            request(body.cloudsMap, black), request(body.atmosphereTexture, body.atmosphereColor), request(body.ringTexture, body.ringColor) });
     }
+    asteroidTexture = request(scene.asteroidTexture, scene.asteroidColor);
+    return textures;
+}
+
+unsigned int Game::GetSurfacePermutation(const SceneBody& body)
+{
+    if (body.unlit)
+    {
+        return SurfaceShaders::Unlit;
+    }
+    unsigned int features = 0;
+    if (body.rimLight)
+        features |= SurfaceShaders::RimLight;
+    if (body.uvFlow)
+        features |= SurfaceShaders::UvFlow;
+    if (!body.nightMap.empty())
+        features |= SurfaceShaders::NightLights;
+    if (!body.specularMap.empty())
+        features |= SurfaceShaders::SpecularMask;
+    if (!body.cloudsMap.empty())
+        features |= SurfaceShaders::Clouds;
+    return features;
+}
 
-    planetHudData.clear();
-    planetHudData.resize(planets.size());
-    if (planetHudData.size() > 1)
+std::vector<unsigned int> Game::GetScenePermutations() const
+{
+    //Asteroids drawn from the mesh pool use the rim light permutation, atmospheres and rings the overlay one.
+    std::vector<unsigned int> permutations = { SurfaceShaders::RimLight, SurfaceShaders::AlphaOverlay };
+    for (const SceneBody& body : scene.bodies)
     {
-        planetHudData[1] = { "EARTH", 149.6f, 29.78f, 23.93f, false };
+        unsigned int features = GetSurfacePermutation(body);
+        if (std::find(permutations.begin(), permutations.end(), features) == permutations.end())
+        {
+            permutations.push_back(features);
+        }
     }
-    if (planetHudData.size() > 2)
+    return permutations;
+}
+
+void Game::InitializeBodies()
+{
+    //Stars sit at the origin, where the light is, and spin in place; planets follow their Kepler orbits and
+    //moons are integrated around their planet.
+    double starRadius = 0.0;
+    for (const SceneBody& body : scene.bodies)
     {
-        planetHudData[2] = { "MERCURY", 57.9f, 47.36f, 1407.5f, false };
+        if (body.kind == SceneBody::Kind::Star)
+        {
+            starRadius = std::max(starRadius, (double)body.radius);
+        }
     }
-    if (planetHudData.size() > 3)
+    const auto AU = settings::keplerAUScale; // scene units per AU for Kepler mapping
+    for (size_t i = 0; i < scene.bodies.size(); ++i)
     {
-        planetHudData[3] = { "VENUS", 108.2f, 35.02f, 5832.5f, true };
+        const SceneBody& body = scene.bodies[i];
+        const bool star = body.kind == SceneBody::Kind::Star;
+        bodies.emplace_back(0.0f, body.radius, 0.0f, star ? body.rotationSpeedDeg : 0.0f);
+        bodyPermutations.push_back(GetSurfacePermutation(body));
+        std::string name = body.name;
+        std::transform(name.begin(), name.end(), name.begin(), [](unsigned char c) { return (char)std::toupper(c); });
+        bodyDisplayNames.push_back(name);
+        OrbitalElements elements{};
+        if (body.kind == SceneBody::Kind::Planet)
+        {
+            elements = { body.semiMajorAxisAU * AU, body.eccentricity, body.inclinationDeg, body.ascendingNodeDeg,
+                body.periapsisDeg, body.meanAnomalyDeg, 360.0 / body.periodDays, settings::epochJD_J2000 };
+            // Ensure the perihelion clears the stars with a small safety margin
+            double peri = elements.a * (1.0 - elements.e);
+            double minClear = starRadius + 6.0; // margin
+            if (peri < minClear)
+            {
+                elements.a = minClear / (1.0 - elements.e);
+            }
+        }
+        bodyElements.push_back(elements);
+        if (body.kind == SceneBody::Kind::Moon)
+        {
+            moons.push_back({ i, 0.0f, glm::vec3(0.0f), glm::vec3(0.0f) });
+            ResetMoon(moons.size() - 1);
+        }
     }
-    if (planetHudData.size() > 4)
+    bodySelfRotationDeg.assign(bodies.size(), 0.0f);
+    lastSimTimeSec = simulationTimeSec;
+}
+
+void Game::ResetMoon(size_t index)
+{
+    // Circular start around the parent, about its Y axis; the parent's gravity follows from the orbit's period
+    MoonState& moon = moons[index];
+    const SceneBody& body = scene.bodies[moon.body];
+    const double twoPi = 6.283185307179586;
+    double radius = body.orbitRadius; // world units
+    double periodSec = body.periodDays * 86400.0; // sidereal
+    moon.mu = (float)((twoPi * twoPi) * (radius * radius * radius) / (periodSec * periodSec));
+    float vCirc = (float)(twoPi * radius / periodSec);
+    const float phase = glm::radians(body.phaseDeg);
+    const glm::vec3 direction(std::cos(phase), 0.0f, std::sin(phase));
+    moon.relativePosition = direction * (float)radius;
+    moon.relativeVelocity = glm::vec3(-direction.z, 0.0f, direction.x) * vCirc;
+}
+
+glm::mat4 Game::BuildBodyModelMatrix(size_t index, const glm::vec3& position) const
+{
+    // Positive speed spins prograde; retrograde comes from a negative speed or an obliquity over 90 degrees
+    const float obq = scene.bodies[index].obliquityDeg;
+    const float selfDeg = bodySelfRotationDeg[index];
+    glm::mat4 model = glm::translate(glm::mat4(1.0f), position);
+    glm::mat4 tiltMat = glm::rotate(glm::mat4(1.0f), glm::radians(obq), glm::vec3(1, 0, 0));
+    glm::vec3 spinAxis = glm::vec3(tiltMat * glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
+    spinAxis = glm::normalize(spinAxis);
+
+    model = glm::rotate(model, glm::radians(selfDeg), spinAxis);
+    model = model * tiltMat;
+    model = glm::scale(model, glm::vec3(bodies[index].GetScale()));
+    return model;
+}
+
+Mesh Game::CreateRingMesh(float innerRadius)
+{
+    std::vector<glm::vec3> pos;
+    std::vector<glm::vec2> uv;
+    std::vector<glm::vec3> nrm;
+    const int segments = 128;
+    const float innerR = innerRadius; // normalized inner radius
+    const float outerR = 1.0f; // normalized outer radius
+    for (int i = 0; i < segments; ++i)
     {
-        planetHudData[4] = { "MARS", 227.9f, 24.07f, 24.62f, false };
+        float a0 = (float)i * 6.28318530718f / segments;
+        float a1 = (float)(i+1) * 6.28318530718f / segments;
+        float c0 = cos(a0), s0 = sin(a0);
+        float c1 = cos(a1), s1 = sin(a1);
+        // quad two triangles: outer0, inner0, inner1 and outer0, inner1, outer1
+        glm::vec3 o0 = { outerR*c0, 0.0f, outerR*s0 };
+        glm::vec3 i0 = { innerR*c0, 0.0f, innerR*s0 };
+        glm::vec3 o1 = { outerR*c1, 0.0f, outerR*s1 };
+        glm::vec3 i1 = { innerR*c1, 0.0f, innerR*s1 };
+        // simple radial UV: r mapped to [0,1], angle to [0,1]
+        // Radial mapping only: sample the ring texture horizontally from rightmost (inner) to leftmost (outer).
+        // We'll map radius to U and ignore V (sample midline).
+        // Avoid sampling extreme edges of the PNG where premultiplied alpha/bleed is visible
+        float uInner = 0.98f; // rightmost of the PNG (clamped)
+        float uOuter = 0.02f; // leftmost of the PNG (clamped)
+        float uInnerMapped = glm::mix(uInner, uOuter, innerR);
+        glm::vec2 uvo0 = { uOuter, 0.5f };
+        glm::vec2 uvi0 = { uInnerMapped, 0.5f };
+        glm::vec2 uvo1 = { uOuter, 0.5f };
+        glm::vec2 uvi1 = { uInnerMapped, 0.5f };
+        glm::vec3 up = {0,1,0};
+        // tri1
+        pos.push_back(o0); uv.push_back(uvo0); nrm.push_back(up);
+        pos.push_back(i0); uv.push_back(uvi0); nrm.push_back(up);
+        pos.push_back(i1); uv.push_back(uvi1); nrm.push_back(up);
+        // tri2
+        pos.push_back(o0); uv.push_back(uvo0); nrm.push_back(up);
+        pos.push_back(i1); uv.push_back(uvi1); nrm.push_back(up);
+        pos.push_back(o1); uv.push_back(uvo1); nrm.push_back(up);
     }
-    if (planetHudData.size() > 5)
+    return Mesh(pos, uv, nrm);
+}
+
+std::future<MeshData> Game::SubmitSphereMeshJob()
+{
+    if (assetPack.Find(settings::meshesPath + "sphere.obj", AssetPack::Type::Mesh) != nullptr)
+        return {};
+    return jobSystem.Submit([]() { return Mesh::LoadData(settings::meshesPath + "sphere.obj"); });
+}
+
+Mesh Game::LoadPackedMesh(const std::string& path) const
+{
+    if (const AssetPack::Entry* entry = assetPack.Find(path, AssetPack::Type::Mesh))
     {
-        planetHudData[5] = { "JUPITER", 778.5f, 13.07f, 9.93f, false };
+        Mesh mesh = Mesh::FromPacked(entry->data, entry->size);
+        if (mesh.GetVertexCount() > 0)
+            return mesh;
     }
-    if (planetHudData.size() > 6)
+    //Gone from the pack since SubmitSphereMeshJob looked, or damaged: the OBJ it was built from.
+    return Mesh(Mesh::LoadData(path));
+}
+
+void Game::FinishShaders()
+{
+    //The constructors only started compiling; the work since then overlapped with the driver's compile threads.
+    int cachedCount = 0;
+    double milliseconds = 0.0;
+    std::vector<ShaderProgram*> shaders = { &textShader, &orbitShader, &skyboxShader, &depthShader, &overdrawShader,
+        &asteroidShader, &asteroidDepthShader, &asteroidOverdrawShader, &upscaleShader };
+    for (const auto& permutation : surfaceShaders.GetPrograms())
     {
-        planetHudData[6] = { "SATURN", 1434.0f, 9.68f, 10.7f, false };
+        shaders.push_back(permutation.second.get());
     }
-    if (planetHudData.size() > 7)
+    std::vector<std::string> failed;
+    for (ShaderProgram* shader : shaders)
     {
-        planetHudData[7] = { "URANUS", 2871.0f, 6.80f, 17.24f, true };
+        if (!shader->Finish())
+            failed.push_back(shader->GetName());
+        cachedCount += shader->IsFromBinaryCache() ? 1 : 0;
+        milliseconds += shader->GetBuildMilliseconds();
     }
-    if (planetHudData.size() > 8)
+    if (!failed.empty())
     {
-        planetHudData[8] = { "NEPTUNE", 4495.1f, 5.43f, 16.11f, false };
+        std::cout << "Failed to build " << failed.size() << " of " << shaders.size() << " shader programs:\n";
+        for (const std::string& name : failed)
+            std::cout << "  " << name << "\n";
+        exit(EXIT_FAILURE);
     }
+    std::cout << "Shaders ready: " << shaders.size() << " programs, " << cachedCount << " from the shader cache, "
+        << std::fixed << std::setprecision(1) << milliseconds << " ms on the main thread\n" << std::defaultfloat;
+}
 
-    moonHudData = { "MOON", 0.384f, 1.022f, 655.7f, false };
+void Game::SetupSurfaceUniforms(ShaderProgram& shader, unsigned int features)
+{
+    //Only the uniforms this permutation declares; the others were compiled out.
+    window.UseShader(shader);
+    if (features & SurfaceShaders::Unlit)
+    {
+        return;
+    }
+    const bool earthLike = (features & (SurfaceShaders::NightLights | SurfaceShaders::AlphaOverlay)) != 0;
+    shader.SendUniform<glm::vec3>("ambientColor", earthLike ? settings::earthAmbientColor : settings::ambientColor);
+    shader.SendUniform<glm::vec3>("sunlightColor", settings::sunlightColor);
+    shader.SendUniform<glm::vec3>("lightPosition", { 0.0f,0.0f,0.0f });
+    if (features & SurfaceShaders::SpecularMask)
+    {
+        shader.SendUniform<float>("specularStrength", settings::earthSpecularStrength);
+        shader.SendUniform<float>("specularShininess", settings::earthSpecularShininess);
+    }
+    //Assign locations to the texture samplers (textureSampler stays on unit 0).
+    if (features & SurfaceShaders::NightLights)
+        shader.SendUniform<int>("nightTexture", 1);
+    if (features & SurfaceShaders::SpecularMask)
+        shader.SendUniform<int>("specularTexture", 2);
+    if (features & SurfaceShaders::Clouds)
+        shader.SendUniform<int>("cloudsTexture", 3);
+}
 
-    // Initialize N-body constants and Moon state
+std::vector<std::future<MeshData>> Game::SubmitAsteroidMeshJobs()
+{
+    // A pool of irregular icosphere meshes, one job each (subdivisions, radius, amplitude, frequency, seed drawn at random)
+    std::mt19937 rng(2024);
+    std::uniform_real_distribution<float> r01(0.0f, 1.0f);
+    std::vector<std::future<MeshData>> jobs;
+    jobs.reserve(settings::asteroidMeshVariants);
+    for (int i = 0; i < settings::asteroidMeshVariants; ++i)
     {
-        const double twoPi = 6.283185307179586;
-        double rMoon = settings::moonOrbitRadius; // world units
-        double periodMoonSec = (double)27.321661 * 86400.0; // sidereal
-        muEarth = (float)((twoPi * twoPi) * (rMoon * rMoon * rMoon) / (periodMoonSec * periodMoonSec));
+        int subdivisions = r01(rng) < 0.5f ? 2 : 3;
+        float radius = 0.9f + 0.3f * r01(rng);
+        float amplitude = 0.15f + 0.07f * r01(rng);
+        float frequency = 2.0f + 1.0f * r01(rng);
+        unsigned int seed = (unsigned int)rng() % 1000;
+        jobs.push_back(jobSystem.Submit([=]() { return Mesh::GenerateCraggyAsteroidData(subdivisions, radius, amplitude, frequency, seed); }));
+    }
+    return jobs;
+}
 
-        double aEarth = settings::keplerAUScale * 1.0; // Earth a in world units
-        double periodEarthSec = 365.256 * 86400.0;
-        muSun = (float)((twoPi * twoPi) * (aEarth * aEarth * aEarth) / (periodEarthSec * periodEarthSec));
+void Game::RequestTextureDetail(const glm::mat4& projection, const glm::mat4& viewMatrix)
+{
+    //Pixels covered by one world unit at the closest point of a sphere; 0 when the sphere is out of view.
+    const glm::vec3 cameraPosition = camera.GetPosition();
+    const float tanHalfX = 1.0f / projection[0][0];
+    const float tanHalfY = 1.0f / projection[1][1];
+    auto pixelsPerUnit = [&](const glm::vec3& center, float radius)
+    {
+        glm::vec3 view = glm::vec3(viewMatrix * glm::vec4(center, 1.0f));
+        float depth = -view.z;
+        bool outside = depth < -radius
+            || (std::abs(view.x) - depth * tanHalfX) / std::sqrt(1.0f + tanHalfX * tanHalfX) > radius
+            || (std::abs(view.y) - depth * tanHalfY) / std::sqrt(1.0f + tanHalfY * tanHalfY) > radius;
+        if (outside)
+        {
+            return 0.0f;
+        }
+        float distance = std::max(glm::length(center - cameraPosition) - radius, settings::cameraNearPlaneDistance);
+        return settings::viewportHeight * 0.5f / (tanHalfY * distance);
+    };
+    //Sphere UVs wrap U once around the equator, so the full width spans the circumference.
+    const float twoPi = 6.28318530718f;
+    auto requestSphere = [&](const Texture& texture, const glm::vec3& center, float radius)
+    {
+        textureStreamer.RequestDetail(texture.GetID(), twoPi * radius * pixelsPerUnit(center, radius));
+    };
 
-        double currentJD = settings::epochJD_J2000 + simulationTimeSec / 86400.0;
-        glm::vec3 earthPos = orbitalPositionAtJD(planetElements[1], currentJD);
-        // Approximate Earth inertial velocity via forward difference
-        double epsSec = 10.0;
-        glm::vec3 earthPos2 = orbitalPositionAtJD(planetElements[1], currentJD + epsSec / 86400.0);
-        glm::vec3 earthVel = (earthPos2 - earthPos) / (float)epsSec;
-
-        // Place Moon on +X from Earth; give it a circular tangential speed about Y axis
-        moonRelPos = glm::vec3((float)rMoon, 0.0f, 0.0f);
-        float vCirc = (float)(twoPi * rMoon / periodMoonSec);
-        moonRelVel = glm::vec3(0.0f, 0.0f, vCirc);
-        lastSimTimeSec = simulationTimeSec;
+    auto requestRing = [&](int texture, const glm::vec3& center, float radius)
+    {
+        if (texture >= 0)
+        {
+            textureStreamer.RequestDetail(sceneTextures[texture].GetID(), radius * pixelsPerUnit(center, radius));
+        }
+    };
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const SceneBody& body = scene.bodies[i];
+        const BodyTextures& textures = bodyTextures[i];
+        const glm::vec3 center = GetBodyWorldPosition(i);
+        const float radius = bodies[i].GetScale();
+        for (int texture : { textures.albedo, textures.night, textures.specular, textures.clouds })
+        {
+            if (texture >= 0)
+            {
+                requestSphere(sceneTextures[texture], center, radius);
+            }
+        }
+        if (textures.atmosphere >= 0)
+        {
+            requestSphere(sceneTextures[textures.atmosphere], center, radius * body.atmosphereScale);
+        }
+        //Ring UVs run across the ring's width, less than its outer radius.
+        requestRing(textures.ring, center, radius * body.ringOuter);
+    }
+    //All rocks share one texture: the largest one on screen sets its detail.
+    const std::vector<AsteroidBelt::Asteroid>& asteroids = asteroidBelt.GetAsteroids();
+    float asteroidDetail = 0.0f;
+    for (size_t i = 0; i < asteroidModelMatrices.size(); ++i)
+    {
+        const glm::vec3& scale = asteroids[i].scale;
+        float radius = 1.4f * std::max(scale.x, std::max(scale.y, scale.z));
+        asteroidDetail = std::max(asteroidDetail, twoPi * radius * pixelsPerUnit(glm::vec3(asteroidModelMatrices[i][3]), radius));
+    }
+    if (asteroidDetail > 0.0f)
+    {
+        textureStreamer.RequestDetail(sceneTextures[asteroidTexture].GetID(), asteroidDetail);
     }
+}
 
-    InitializeHudResources();
-    InitializeOrbitPaths();
-    InitializeFollowTargets();
-    savedCameraPosition = camera.GetPosition();
-    savedCameraYaw = camera.GetYaw();
-    savedCameraPitch = camera.GetPitch();
+void Game::UpdateStreaming()
+{
+    //Reproducible runs (captures, benchmarks, replays) must not depend on decode speed: they never show a placeholder.
+    if (IsFixedStep())
+    {
+        textureStreamer.Finish(window);
+    }
+    else
+    {
+        textureStreamer.Update(window);
+    }
+    if (timeToFullQualityMs < 0.0f && textureStreamer.IsIdle())
+    {
+        timeToFullQualityMs = MillisecondsSinceStartup();
+        std::cout << "Full quality after " << timeToFullQualityMs << " ms (textures: "
+            << textureStreamer.GetResidentBytes() / 1024 << " KB on the GPU"
+            << (textureStreamer.IsCompressionEnabled() ? ", BC1/BC3" : ", uncompressed") << ", "
+            << textureStreamer.GetUncompressedBytes() / (1024 * 1024) << " MB as RGBA8)\n";
+    }
+}
+
+float Game::MillisecondsSinceStartup() const
+{
+    return std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - startupBegin).count();
+}
+
+float Game::GetTimeToFirstFrameMs() const
+{
+    return timeToFirstFrameMs;
+}
+
+float Game::GetTimeToFullQualityMs() const
+{
+    return timeToFullQualityMs;
 }
 
 void Game::InitializeFollowTargets()
 {
     followTargets.clear();
 
-    if (planets.size() > 1)
+    // Every planet and moon in scene order; the stars sit at the origin, where the free camera starts
+    for (size_t i = 0; i < bodies.size(); ++i)
     {
-        for (size_t i = 1; i < planets.size(); ++i)
+        if (scene.bodies[i].kind != SceneBody::Kind::Star)
         {
-            followTargets.push_back({ FollowTargetEntry::Kind::Planet, i });
+            followTargets.push_back(i);
         }
     }
-
-    // Always add the moon follow option last
-    followTargets.push_back({ FollowTargetEntry::Kind::Moon, 0 });
 }
 
 void Game::InitializeHudResources()
 {
-    if (textVAO == 0)
+    hudProjection = glm::ortho(0.0f, static_cast<float>(settings::viewportWidth), static_cast<float>(settings::viewportHeight), 0.0f);
+
+    followHudLabel = textRenderer.CreateLabel();
+    textRenderer.SetVisible(followHudLabel, false);
+    profilerHudLabel = textRenderer.CreateLabel();
+    textRenderer.SetVisible(profilerHudLabel, false);
+    qualityHudLabel = textRenderer.CreateLabel();
+    textRenderer.SetColor(qualityHudLabel, glm::vec4(1.0f, 0.85f, 0.55f, 0.85f));
+    textRenderer.SetVisible(qualityHudLabel, false);
+
+    // Names above the bodies (the first follow targets, as many as there are label slots left); the text never
+    // changes, only the placement does
+    bodyLabels.clear();
+    for (size_t body : followTargets)
     {
-        glGenVertexArrays(1, &textVAO);
-        glGenBuffers(1, &textVBO);
-        glBindVertexArray(textVAO);
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferData(GL_ARRAY_BUFFER, 0, nullptr, GL_DYNAMIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
-        glBindVertexArray(0);
+        if (textRenderer.GetFreeLabelCount() == 0)
+        {
+            break;
+        }
+        int label = textRenderer.CreateLabel();
+        textRenderer.SetText(label, bodyDisplayNames[body]);
+        textRenderer.SetColor(label, glm::vec4(0.8f, 0.87f, 1.0f, 0.85f));
+        textRenderer.SetVisible(label, false);
+        bodyLabels.push_back(label);
     }
-
-    hudVertices.reserve(4096);
-    hudProjection = glm::ortho(0.0f, static_cast<float>(settings::viewportWidth), static_cast<float>(settings::viewportHeight), 0.0f);
-    stb_easy_font_spacing(1.0f);
 }
 
 void Game::InitializeOrbitPaths()
 {
-    const int segments = 512;
     const glm::vec3 palette[] = {
         {0.9f, 0.6f, 0.2f},
         {0.7f, 0.8f, 0.9f},
@@ -334,76 +605,39 @@ void Game::InitializeOrbitPaths()
         {0.6f, 0.8f, 0.95f}
     };
 
-    orbitPaths.clear();
-    orbitPaths.resize(planets.size());
-
-    for (size_t i = 1; i < planets.size() && i < planetElements.size(); ++i)
+    // Planets take the palette in turn unless the scene names a color; moon circles follow their planet every frame
+    bodyOrbitPaths.assign(bodies.size(), -1);
+    size_t planetOrdinal = 0;
+    for (size_t i = 0; i < bodies.size(); ++i)
     {
-        const OrbitalElements& el = planetElements[i];
-        std::vector<float> vertices;
-        vertices.reserve(static_cast<size_t>(segments) * 3);
-        for (int s = 0; s < segments; ++s)
+        const SceneBody& body = scene.bodies[i];
+        if (body.kind == SceneBody::Kind::Planet)
         {
-            float t = (float)s / (float)segments;
-            double nu = t * glm::two_pi<double>();
-            double e = el.e;
-            // radius from true anomaly
-            double r = el.a * (1.0 - e * e) / (1.0 + e * cos(nu));
-            double x_orb = r * cos(nu);
-            double z_orb = r * sin(nu);
-            glm::vec3 p = glm::vec3((float)x_orb, 0.0f, (float)z_orb);
-            glm::mat4 R(1.0f);
-            R = glm::rotate(R, (float)glm::radians((float)el.OmegaDeg), glm::vec3(0,1,0));
-            R = glm::rotate(R, (float)glm::radians((float)el.iDeg),   glm::vec3(1,0,0));
-            R = glm::rotate(R, (float)glm::radians((float)el.omegaDeg),glm::vec3(0,1,0));
-            glm::vec3 w = glm::vec3(R * glm::vec4(p, 1.0f));
-            vertices.push_back(w.x);
-            vertices.push_back(w.y);
-            vertices.push_back(w.z);
+            glm::vec3 color = palette[planetOrdinal++ % (sizeof(palette) / sizeof(palette[0]))];
+            bodyOrbitPaths[i] = orbitRenderer.AddOrbit(bodyElements[i], body.customOrbitColor ? body.orbitColor : color, 0.35f);
         }
-
-        OrbitPath& path = orbitPaths[i];
-        path.radius = (float)el.a;
-        path.vertexCount = segments;
-        path.color = palette[(i - 1) % (sizeof(palette) / sizeof(palette[0]))];
-
-        glGenVertexArrays(1, &path.vao);
-        glGenBuffers(1, &path.vbo);
-        glBindVertexArray(path.vao);
-        glBindBuffer(GL_ARRAY_BUFFER, path.vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glBindVertexArray(0);
-    }
-
-    // Moon orbit path (circle around Earth)
-    {
-        float radius = settings::moonOrbitRadius;
-        std::vector<float> vertices;
-        vertices.reserve(static_cast<size_t>(segments) * 3);
-        for (int s = 0; s < segments; ++s)
+        else if (body.kind == SceneBody::Kind::Moon)
         {
-            float angle = (static_cast<float>(s) / segments) * glm::two_pi<float>();
-            float x = radius * std::cos(angle);
-            float z = radius * std::sin(angle);
-            vertices.push_back(x);
-            vertices.push_back(0.0f);
-            vertices.push_back(z);
+            glm::vec3 color = body.customOrbitColor ? body.orbitColor : glm::vec3(0.85f, 0.85f, 0.95f);
+            bodyOrbitPaths[i] = orbitRenderer.AddCircle(body.orbitRadius, color, 0.35f);
         }
+    }
+}
 
-        moonOrbitPath.radius = radius;
-        moonOrbitPath.vertexCount = segments;
-        moonOrbitPath.color = glm::vec3(0.85f, 0.85f, 0.95f);
-
-        glGenVertexArrays(1, &moonOrbitPath.vao);
-        glGenBuffers(1, &moonOrbitPath.vbo);
-        glBindVertexArray(moonOrbitPath.vao);
-        glBindBuffer(GL_ARRAY_BUFFER, moonOrbitPath.vbo);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
-        glEnableVertexAttribArray(0);
-        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-        glBindVertexArray(0);
+void Game::AddMinorBodyOrbits(int count, unsigned int seed)
+{
+    // Faint belt-like orbits: 2.1 - 3.3 AU, mildly eccentric and inclined
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    for (int i = 0; i < count; ++i)
+    {
+        OrbitalElements elements{};
+        elements.a = settings::keplerAUScale * (2.1 + 1.2 * unit(rng));
+        elements.e = 0.3 * unit(rng) * unit(rng);
+        elements.iDeg = 20.0 * unit(rng) * unit(rng);
+        elements.OmegaDeg = 360.0 * unit(rng);
+        elements.omegaDeg = 360.0 * unit(rng);
+        orbitRenderer.AddOrbit(elements, glm::vec3(0.55f, 0.5f, 0.45f), 0.08f);
     }
 }
 
@@ -432,7 +666,8 @@ void Game::CycleFollowTarget()
             {
                 camera.SetPose(savedCameraPosition, savedCameraYaw, savedCameraPitch);
             }
-            followHudText.clear();
+            textRenderer.SetVisible(followHudLabel, false);
+            followHudTarget = -1;
         }
     }
 }
@@ -444,43 +679,30 @@ void Game::UpdateFollowCamera()
         return;
     }
 
-    const FollowTargetEntry& entry = followTargets[followTargetIndex];
-    glm::vec3 targetPos = GetFollowTargetPosition(entry);
-    glm::vec3 cameraPos = ComputeFollowCameraPosition(entry, targetPos);
+    const size_t body = followTargets[followTargetIndex];
+    glm::vec3 targetPos = GetBodyWorldPosition(body);
+    glm::vec3 cameraPos = ComputeFollowCameraPosition(body, targetPos);
     camera.LookAt(cameraPos, targetPos);
-    UpdateFollowHud(entry);
-}
-
-void Game::UpdateFollowHud(const FollowTargetEntry& entry)
-{
-    const PlanetHudInfo* info = nullptr;
-    if (entry.kind == FollowTargetEntry::Kind::Planet)
+    // The info only depends on the body, rebuild it when the target changes
+    if (followHudTarget != followTargetIndex)
     {
-        if (entry.index < planetHudData.size())
-        {
-            info = &planetHudData[entry.index];
-        }
-    }
-    else
-    {
-        info = &moonHudData;
-    }
-
-    if (!info)
-    {
-        followHudText.clear();
-        return;
+        UpdateFollowHud(body);
+        followHudTarget = followTargetIndex;
     }
+}
 
+void Game::UpdateFollowHud(size_t body)
+{
+    const SceneBody& info = scene.bodies[body];
     std::ostringstream oss;
-    oss << info->name << '\n';
+    oss << bodyDisplayNames[body] << '\n';
 
     oss << std::fixed << std::setprecision(1);
-    oss << "ORBIT RADIUS: " << info->orbitRadiusMillionKm << " MILLION KM\n";
-    oss << "ORBIT SPEED: " << info->orbitSpeedKmPerSec << " KM/S\n";
+    oss << "ORBIT RADIUS: " << info.orbitRadiusMillionKm << " MILLION KM\n";
+    oss << "ORBIT SPEED: " << info.orbitSpeedKmPerSec << " KM/S\n";
 
-    double hours = static_cast<double>(info->rotationPeriodHours);
-    bool retrograde = info->retrograde || hours < 0.0;
+    double hours = static_cast<double>(info.rotationPeriodHours);
+    bool retrograde = info.retrograde || hours < 0.0;
     double absHours = std::abs(hours);
 
     oss << "ROTATION PERIOD: ";
@@ -500,59 +722,97 @@ void Game::UpdateFollowHud(const FollowTargetEntry& entry)
     }
     oss << '\n';
 
-    followHudText = oss.str();
+    // Bottom-left corner
+    const std::string text = oss.str();
+    const float textScale = 5.0f;
+    const float margin = 24.0f;
+    const float blockHeight = textRenderer.MeasureText(text).y * textScale;
+    textRenderer.SetText(followHudLabel, text);
+    textRenderer.SetPlacement(followHudLabel, glm::vec2(margin, static_cast<float>(settings::viewportHeight) - margin - blockHeight), textScale);
+    textRenderer.SetVisible(followHudLabel, true);
 }
 
-void Game::DrawFollowHud()
+void Game::UpdateProfilerHud()
 {
-    if (followTargetIndex < 0 || followHudText.empty() || textVAO == 0)
+    textRenderer.SetVisible(profilerHudLabel, showProfilerHud);
+    if (!showProfilerHud)
     {
         return;
     }
-
-    const size_t estimatedVertices = std::max<size_t>(followHudText.size() * 210, 210);
-    if (hudVertices.size() < estimatedVertices * 2)
+    // Top-left, small enough to stay clear of the follow HUD
+    const float margin = 24.0f;
+    std::ostringstream oss;
+    oss << profiler.GetHudText() << "DRAWS " << lastDrawStatistics.drawCalls
+        << "  STATE " << lastDrawStatistics.stateChangesIssued << " SET / " << lastDrawStatistics.stateChangesElided << " SKIPPED\n"
+        << qualityGovernor.GetHudText() << "\n"
+        << dynamicResolution.GetHudText() << "\n"
+        << framePacer.GetHudText() << "\n"
+        << frameLatency.GetHudText() << "\n";
+    if (inputRecorder.IsRecording() || inputRecorder.IsReplaying())
     {
-        hudVertices.resize(estimatedVertices * 2);
+        oss << inputRecorder.GetHudText() << "\n";
     }
+    textRenderer.SetText(profilerHudLabel, oss.str());
+    textRenderer.SetPlacement(profilerHudLabel, glm::vec2(margin, margin), 2.0f);
+}
 
-    const float textScale = 5.0f;
-    const int rawHeightUnits = stb_easy_font_height(followHudText.c_str());
-    const float blockHeight = rawHeightUnits * textScale;
-    const float margin = 24.0f;
-    glm::vec2 origin(margin, static_cast<float>(settings::viewportHeight) - margin - blockHeight);
-
-    // Generate unscaled glyph geometry at origin
-    int vertexCount = stb_easy_font_print(0.0f, 0.0f, followHudText.c_str(), nullptr,
-        hudVertices.data(), static_cast<int>(hudVertices.size() * sizeof(float)));
-
-    if (vertexCount <= 0)
+void Game::UpdateQualityHud()
+{
+    // Top-right, only while detail is being shed (the profiler HUD always lists the level)
+    const bool reduced = qualityGovernor.GetLevel() > 0;
+    textRenderer.SetVisible(qualityHudLabel, reduced);
+    if (!reduced)
     {
         return;
     }
+    const float margin = 24.0f;
+    const float scale = 2.0f;
+    const std::string text = std::string("QUALITY ") + qualityGovernor.GetSettings().name;
+    textRenderer.SetText(qualityHudLabel, text);
+    textRenderer.SetPlacement(qualityHudLabel, glm::vec2(settings::viewportWidth - margin - textRenderer.MeasureText(text).x * scale, margin), scale);
+}
 
-    for (int i = 0; i < vertexCount; ++i)
+void Game::UpdateBodyLabels(const glm::mat4& viewProjection)
+{
+    const float textScale = 2.0f;
+    const glm::vec2 viewport(static_cast<float>(settings::viewportWidth), static_cast<float>(settings::viewportHeight));
+    for (size_t i = 0; i < bodyLabels.size() && i < followTargets.size(); ++i)
     {
-        hudVertices[i * 2 + 0] = origin.x + hudVertices[i * 2 + 0] * textScale;
-        hudVertices[i * 2 + 1] = origin.y + hudVertices[i * 2 + 1] * textScale;
+        int label = bodyLabels[i];
+        if (!showBodyLabels)
+        {
+            textRenderer.SetVisible(label, false);
+            continue;
+        }
+        // Anchor just above the top of the body, centered
+        const size_t body = followTargets[i];
+        glm::vec3 top = GetBodyWorldPosition(body) + glm::vec3(0.0f, bodies[body].GetScale(), 0.0f);
+        glm::vec4 clip = viewProjection * glm::vec4(top, 1.0f);
+        if (clip.w <= 0.0f)
+        {
+            textRenderer.SetVisible(label, false);
+            continue;
+        }
+        glm::vec2 ndc = glm::vec2(clip) / clip.w;
+        glm::vec2 screen((ndc.x * 0.5f + 0.5f) * viewport.x, (0.5f - ndc.y * 0.5f) * viewport.y);
+        glm::vec2 size = textRenderer.MeasureText(bodyDisplayNames[body]) * textScale;
+        glm::vec2 origin = screen - glm::vec2(size.x * 0.5f, size.y + 4.0f);
+        bool onScreen = origin.x + size.x > 0.0f && origin.x < viewport.x && origin.y + size.y > 0.0f && origin.y < viewport.y;
+        textRenderer.SetPlacement(label, origin, textScale);
+        textRenderer.SetVisible(label, onScreen);
     }
+}
 
-    glDisable(GL_DEPTH_TEST);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-
-    window.UseShader(textShader);
-    textShader.SendUniform<glm::mat4>("MVP", hudProjection);
-    textShader.SendUniform<glm::vec4>("textColor", glm::vec4(1.0f));
-
-    glBindVertexArray(textVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    glBufferData(GL_ARRAY_BUFFER, vertexCount * 2 * sizeof(float), hudVertices.data(), GL_DYNAMIC_DRAW);
-    glDrawArrays(GL_TRIANGLES, 0, vertexCount);
-    glBindVertexArray(0);
-
-    glDisable(GL_BLEND);
-    glEnable(GL_DEPTH_TEST);
+void Game::DrawHud(const glm::mat4& viewProjection)
+{
+    UpdateProfilerHud();
+    UpdateQualityHud();
+    UpdateBodyLabels(viewProjection);
+
+    window.SetDepthTest(false);
+    window.SetBlend(true);
+    window.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    textRenderer.Draw(window, textShader, hudProjection);
 }
 
 void Game::DrawOrbitPaths(const glm::mat4& projection, const glm::mat4& viewMatrix)
@@ -562,104 +822,115 @@ void Game::DrawOrbitPaths(const glm::mat4& projection, const glm::mat4& viewMatr
         return;
     }
 
-    window.UseShader(orbitShader);
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-    glDepthMask(GL_FALSE);
+    window.SetBlend(true);
+    window.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    window.SetDepthTest(true);
+    window.SetDepthFunc(GL_LESS);
+    window.SetDepthMask(false);
     glLineWidth(0.75f);
 
-    auto sendPath = [&](const OrbitPath& path, const glm::mat4& model, bool highlighted)
+    const bool followActive = followTargetIndex >= 0 && followTargetIndex < static_cast<int>(followTargets.size());
+    orbitRenderer.SetHighlighted(followActive ? bodyOrbitPaths[followTargets[followTargetIndex]] : -1);
+    for (const MoonState& moon : moons)
     {
-        if (path.vertexCount == 0 || path.vao == 0)
-        {
-            return;
-        }
-        glm::vec3 color = highlighted ? glm::mix(path.color, glm::vec3(1.0f), 0.35f) : path.color;
-        float opacity = highlighted ? 0.55f : 0.35f;
-        orbitShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        orbitShader.SendUniform<glm::vec3>("color", color);
-        orbitShader.SendUniform<float>("opacity", opacity);
-        glBindVertexArray(path.vao);
-        glDrawArrays(GL_LINE_LOOP, 0, path.vertexCount);
-    };
+        orbitRenderer.SetOffset(bodyOrbitPaths[moon.body], GetBodyWorldPosition(scene.bodies[moon.body].parent));
+    }
 
-    const bool followActive = followTargetIndex >= 0 && followTargetIndex < static_cast<int>(followTargets.size());
-    const FollowTargetEntry* activeEntry = followActive ? &followTargets[followTargetIndex] : nullptr;
+    const float pixelsPerRadian = settings::viewportHeight * 0.5f / std::tan(glm::radians(settings::cameraFOV) * 0.5f);
+    orbitRenderer.SetErrorScale(qualityGovernor.GetSettings().orbitErrorScale);
+    orbitRenderer.Draw(window, orbitShader, projection * viewMatrix, camera.GetPosition(), pixelsPerRadian);
+
+    glLineWidth(1.0f);
+}
 
-    for (size_t i = 1; i < orbitPaths.size(); ++i)
+void Game::InitializeTrails()
+{
+    // Each body's trail covers the same share of its own orbit
+    bodyTrails.clear();
+    for (size_t body : followTargets)
     {
-        const OrbitPath& path = orbitPaths[i];
-        if (path.vertexCount == 0)
-        {
-            continue;
-        }
-        glm::mat4 model(1.0f);
-        bool highlighted = activeEntry && activeEntry->kind == FollowTargetEntry::Kind::Planet && activeEntry->index == i;
-        sendPath(path, model, highlighted);
+        bool isMoon = scene.bodies[body].kind == SceneBody::Kind::Moon;
+        double periodDays = isMoon ? scene.bodies[body].periodDays : 360.0 / bodyElements[body].nDegPerDay;
+        glm::vec3 color = isMoon ? glm::vec3(0.85f, 0.85f, 0.95f) : glm::vec3(1.0f, 0.92f, 0.75f);
+        bodyTrails.push_back(trailRenderer.AddTrail(color, 0.6f, settings::trailOrbitFraction * periodDays * 86400.0));
     }
+    AddAsteroidTrails(settings::trailAsteroidCount);
+}
 
-    if (moonOrbitPath.vertexCount > 0)
+void Game::AddAsteroidTrails(int count)
+{
+    const std::vector<AsteroidBelt::Asteroid>& asteroids = asteroidBelt.GetAsteroids();
+    if (asteroids.empty() || count <= 0)
     {
-        glm::mat4 model = glm::mat4(1.0f);
-        if (planets.size() > 1)
-        {
-            glm::vec3 earthPos = GetPlanetWorldPosition(1);
-            model = glm::translate(model, earthPos);
-        }
-        bool highlighted = activeEntry && activeEntry->kind == FollowTargetEntry::Kind::Moon;
-        sendPath(moonOrbitPath, model, highlighted);
+        return;
+    }
+    // Asteroid angles advance by deltatime * timeSpeed; convert their period to simulation seconds
+    const double simulationSecondsPerUnit = (double)settings::keplerDaysPerSecond * 86400.0;
+    for (int i = 0; i < count; ++i)
+    {
+        size_t index = (size_t)i * asteroids.size() / (size_t)count % asteroids.size();
+        double period = 360.0 / std::max(std::abs((double)asteroids[index].angularSpeedDeg), 1e-6) * simulationSecondsPerUnit;
+        trailedAsteroids.push_back(index);
+        asteroidTrails.push_back(trailRenderer.AddTrail(glm::vec3(0.8f, 0.7f, 0.55f), 0.45f, settings::trailOrbitFraction * period, 64));
     }
-
-    glBindVertexArray(0);
-    glDepthMask(GL_TRUE);
-    glDisable(GL_BLEND);
-    glLineWidth(1.0f);
 }
 
-glm::vec3 Game::GetPlanetWorldPosition(size_t index) const
+void Game::UpdateTrails()
 {
-    if (index >= planets.size())
+    if (!showTrails)
     {
-        return glm::vec3(0.0f);
+        return;
+    }
+    for (size_t i = 0; i < bodyTrails.size() && i < followTargets.size(); ++i)
+    {
+        trailRenderer.Update(bodyTrails[i], GetBodyWorldPosition(followTargets[i]), simulationTimeSec);
+    }
+    for (size_t i = 0; i < asteroidTrails.size(); ++i)
+    {
+        trailRenderer.Update(asteroidTrails[i], asteroidBelt.GetPosition(trailedAsteroids[i]), simulationTimeSec);
     }
-    const glm::mat4& model = planets[index].GetModelMatrix();
-    glm::vec4 world = model * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-    return glm::vec3(world);
 }
 
-glm::vec3 Game::GetFollowTargetPosition(const FollowTargetEntry& entry) const
+void Game::DrawTrails(const glm::mat4& viewProjection)
 {
-    if (entry.kind == FollowTargetEntry::Kind::Planet)
+    if (!showTrails)
     {
-        return GetPlanetWorldPosition(entry.index);
+        return;
     }
+    window.SetBlend(true);
+    window.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    window.SetDepthTest(true);
+    window.SetDepthFunc(GL_LESS);
+    window.SetDepthMask(false);
+    trailRenderer.Draw(window, orbitShader, viewProjection, simulationTimeSec);
+}
 
-    glm::vec4 world = moonModelMatrix * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
-    return glm::vec3(world);
+const SceneDescription& Game::GetScene() const
+{
+    return scene;
 }
 
-float Game::GetFollowTargetRadius(const FollowTargetEntry& entry) const
+glm::vec3 Game::GetBodyWorldPosition(size_t index) const
 {
-    if (entry.kind == FollowTargetEntry::Kind::Planet)
+    if (index >= bodies.size())
     {
-        if (entry.index < planets.size())
-        {
-            return planets[entry.index].GetScale();
-        }
-        return settings::earthScale;
+        return glm::vec3(0.0f);
     }
-    return settings::moonScale;
+    const glm::mat4& model = bodies[index].GetModelMatrix();
+    glm::vec4 world = model * glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    return glm::vec3(world);
 }
 
-glm::vec3 Game::ComputeFollowCameraPosition(const FollowTargetEntry& entry, const glm::vec3& targetPos) const
+glm::vec3 Game::ComputeFollowCameraPosition(size_t body, const glm::vec3& targetPos) const
 {
-    float radius = GetFollowTargetRadius(entry);
+    const bool isMoon = scene.bodies[body].kind == SceneBody::Kind::Moon;
+    float radius = bodies[body].GetScale();
     float distance = std::max(radius * 3.0f, radius + 25.0f);
 
     glm::vec3 referencePos = glm::vec3(0.0f);
-    if (entry.kind == FollowTargetEntry::Kind::Moon)
+    if (isMoon)
     {
-        referencePos = GetPlanetWorldPosition(1); // Earth index.
+        referencePos = GetBodyWorldPosition(scene.bodies[body].parent);
     }
 
     glm::vec3 radialDir = targetPos - referencePos;
@@ -686,108 +957,381 @@ glm::vec3 Game::ComputeFollowCameraPosition(const FollowTargetEntry& entry, cons
 
     glm::vec3 elevatedDir = glm::normalize(glm::cross(radialDir, sideDir));
 
-    glm::vec3 viewingDir = (entry.kind == FollowTargetEntry::Kind::Moon) ? radialDir : -radialDir;
+    glm::vec3 viewingDir = isMoon ? radialDir : -radialDir;
     glm::vec3 offset = viewingDir * distance + elevatedDir * radius * 0.5f + sideDir * radius * 0.35f;
     return targetPos + offset;
 }
 
-glm::mat4 Game::BuildMoonModelMatrix() const
+Game::~Game() noexcept
 {
-    if (planets.size() <= 1)
+    if (!options.statsPath.empty())
     {
-        return glm::mat4(1.0f);
+        WriteFrameStats();
+    }
+    if (!options.tracePath.empty())
+    {
+        profiler.WriteChromeTrace(options.tracePath);
+    }
+    if (overdrawQueries[0] != 0)
+    {
+        glDeleteQueries(2, overdrawQueries);
     }
-
-    glm::vec3 earthPos = GetPlanetWorldPosition(1);
-    glm::mat4 model = glm::mat4(1.0f);
-    model = glm::translate(model, earthPos);
-    // Moon orbit around Earth in Earth's Y plane approximation
-    model = glm::rotate(model, glm::radians(moonOrbitDeg), glm::vec3(0, 1, 0));
-    model = glm::translate(model, glm::vec3(settings::moonOrbitRadius, 0.0f, 0.0f));
-    // Tidal locking
-    model = glm::rotate(model, glm::radians(-moonOrbitDeg), glm::vec3(0, 1, 0));
-    model = glm::scale(model, glm::vec3(settings::moonScale));
-    return model;
 }
 
 void Game::Tick()
 {
+    if (!ShouldRedraw())
+    {
+        //Nothing would change on screen: sleep until an event arrives instead of drawing the same frame again.
+        //The simulation holds still meanwhile, like it does while paused.
+        window.WaitEvents(settings::idleWaitSeconds);
+        lastTime = window.GetElapsedTime();
+        framePacer.AddSkippedFrame();
+        return;
+    }
+    framePacer.WaitForNextFrame();
+    frameLatency.WaitForFrameSlot();    //Low latency: input is read only once the GPU has caught up.
     //Measure the time that has passed since the previous frame.
     float now = window.GetElapsedTime();
     float deltatime = now - lastTime;
+    const float wallDeltaTime = deltatime;
     lastTime = now;
+    if (options.fixedDeltaTime > 0.0f)
+    {
+        deltatime = options.fixedDeltaTime;	//Reproducible stepping for captures and measurements.
+    }
+    //The window answers every key and mouse query of the frame from one snapshot, so a replay sees what the recording saw.
+    if (inputRecorder.IsReplaying())
+    {
+        if (!inputRecorder.ReplayFrame(deltatime, inputState))
+        {
+            window.Close();     //The recorded session is over.
+            return;
+        }
+    }
+    else if (inputRecorder.IsRecording())
+    {
+        window.SampleInput(inputState);
+        inputRecorder.RecordFrame(deltatime, inputState);
+    }
 
+    auto frameStart = std::chrono::steady_clock::now();
+    const int qualityLevel = qualityGovernor.GetLevel();    //The governor may change it once the frame is measured.
+    const float renderScale = dynamicResolution.GetScale();
+    profiler.BeginFrame();
     window.ClearBuffers();  //Clears the color and depth buffers.
-    Update(deltatime);
-    Draw(deltatime);
-    window.SwapBuffers();	//Swap the current buffer to display it.
-    window.PollEvents();    //Process the pending window events.
-}
+    {
+        PROFILE_SCOPE(profiler, "Update");
+        Update(deltatime);
+    }
+    {
+        PROFILE_SCOPE(profiler, "Draw");
+        Draw(deltatime);
+    }
+    auto submitted = std::chrono::steady_clock::now();
+    if (!options.captureDirectory.empty() && frameIndex % options.captureInterval == 0)
+    {
+        CaptureFrame();
+    }
+    {
+        PROFILE_SCOPE(profiler, "Present");
+        window.SwapBuffers();	//Swap the current buffer to display it.
+        frameLatency.EndFrame();
+    }
+    auto presented = std::chrono::steady_clock::now();
+    if (timeToFirstFrameMs < 0.0f)
+    {
+        timeToFirstFrameMs = MillisecondsSinceStartup();
+        std::cout << "First frame after " << timeToFirstFrameMs << " ms\n";
+    }
+    profiler.EndFrame();
+    //The CPU side excludes Present, which only waits for the display or the GPU.
+    const float frameSeconds = IsFixedStep() ? std::chrono::duration<float>(presented - frameStart).count() : wallDeltaTime;
+    const float gpuMs = profiler.GetAverageGpuFrameMs();
+    //The render scale absorbs GPU load first: the governor only sees the GPU over budget once the scale is at its
+    //floor, and only restores detail from GPU headroom once the scale is back at native.
+    float governedGpuMs = gpuMs;
+    if (dynamicResolution.IsEnabled() && dynamicResolution.GetScale() > settings::minRenderScale)
+    {
+        governedGpuMs = dynamicResolution.GetScale() < 1.0f ? settings::frameTimeTargetMs : std::min(gpuMs, settings::frameTimeTargetMs);
+    }
+    qualityGovernor.AddFrame(frameSeconds, std::chrono::duration<float, std::milli>(submitted - frameStart).count(), governedGpuMs);
+    dynamicResolution.AddFrame(frameSeconds, gpuMs);
+    lastDrawStatistics = window.GetDrawStatistics();
+    window.PollEvents();    //Process the pending window events.
 
-bool Game::ShouldClose() const
-{
-    return window.ShouldClose();
+    if (!options.statsPath.empty() || options.recordFrames)
+    {
+        frameRecords.push_back({ elapsedFrameSeconds,
+            std::chrono::duration<float, std::milli>(submitted - frameStart).count(),
+            std::chrono::duration<float, std::milli>(presented - frameStart).count(),
+            lastDrawStatistics.drawCalls, lastDrawStatistics.triangles,
+            lastDrawStatistics.stateChangesIssued, lastDrawStatistics.stateChangesElided, qualityLevel, renderScale,
+            frameLatency.GetAverageLatencyMs() });
+    }
+    ++frameIndex;
+    elapsedFrameSeconds += deltatime;
+    bool frameLimitReached = options.frameCount > 0 && frameIndex >= options.frameCount;
+    bool durationReached = options.durationSeconds > 0.0f && elapsedFrameSeconds >= options.durationSeconds;
+    if (frameLimitReached || durationReached)
+    {
+        window.Close();
+    }
 }
 
-void Game::Update(float deltatime)
+void Game::CaptureFrame()
 {
-    //Logic update happens here.
-    //Check if window should be closed.
-    if(window.IsKeyPressed(settings::exitKey))
+    int width = 0, height = 0;
+    std::vector<unsigned char> rgb;
+    window.ReadPixels(rgb, width, height);
+    std::error_code ec;
+    std::filesystem::create_directories(options.captureDirectory, ec);
+    std::ostringstream name;
+    name << "frame_" << std::setw(6) << std::setfill('0') << frameIndex << ".ppm";
+    std::filesystem::path path = std::filesystem::path(options.captureDirectory) / name.str();
+    std::ofstream file(path, std::ios::binary);
+    if (!file)
     {
-        window.Close();
+        std::cout << "Could not write frame capture: " << path.string() << "\n";
+        return;
     }
-    //Update camera rotation.
-    glm::vec2 mousePosition = window.GetMousePosition();
-    glm::vec2 cameraRotationOffset{ mousePosition.x - lastMousePosition.x, lastMousePosition.y - mousePosition.y };
-    lastMousePosition = mousePosition;
-
-    if (window.IsKeyPressedOnce(settings::cameraCycleKey))
+    //Binary PPM, top row first (GL rows come bottom row first).
+    file << "P6\n" << width << " " << height << "\n255\n";
+    for (int row = height - 1; row >= 0; --row)
     {
-        CycleFollowTarget();
+        file.write(reinterpret_cast<const char*>(rgb.data() + (size_t)row * width * 3), (std::streamsize)width * 3);
     }
+}
 
-    bool followActive = followTargetIndex >= 0;
-
-    if (!followActive)
+void Game::WriteFrameStats() const
+{
+    std::ofstream file(options.statsPath);
+    if (!file)
+    {
+        std::cout << "Could not write frame statistics: " << options.statsPath << "\n";
+        return;
+    }
+    file << "frame,simulated_s,cpu_ms,frame_ms,draw_calls,triangles,state_issued,state_elided,quality,render_scale,latency_ms\n";
+    double totalFrameMs = 0.0;
+    for (size_t i = 0; i < frameRecords.size(); ++i)
+    {
+        const FrameRecord& record = frameRecords[i];
+        file << i << ',' << record.simulatedSeconds << ',' << record.cpuMs << ',' << record.frameMs
+            << ',' << record.drawCalls << ',' << record.triangles
+            << ',' << record.stateChangesIssued << ',' << record.stateChangesElided << ',' << record.qualityLevel << ',' << record.renderScale << ',' << record.latencyMs << '\n';
+        totalFrameMs += record.frameMs;
+    }
+    if (!frameRecords.empty())
     {
-        camera.Rotate(cameraRotationOffset);
-        //Update camera position.
-        if (window.IsKeyPressed(settings::forwardKey))
-            camera.Move(Camera::Movement::FORWARD, deltatime);
-        if (window.IsKeyPressed(settings::backwardKey))
-            camera.Move(Camera::Movement::BACKWARD, deltatime);
-        if (window.IsKeyPressed(settings::leftKey))
-            camera.Move(Camera::Movement::LEFT, deltatime);
-        if (window.IsKeyPressed(settings::rightKey))
-            camera.Move(Camera::Movement::RIGHT, deltatime);
-        if (window.IsKeyPressed(settings::upKey1) || window.IsKeyPressed(settings::upKey2))
-            camera.Move(Camera::Movement::UP, deltatime);
-        if (window.IsKeyPressed(settings::downKey))
-            camera.Move(Camera::Movement::DOWN, deltatime);
+        std::cout << "Wrote " << frameRecords.size() << " frames to " << options.statsPath
+            << " (mean frame " << totalFrameMs / frameRecords.size() << " ms)\n";
     }
+}
+
+bool Game::ShouldClose() const
+{
+    return window.ShouldClose();
+}
+
+void Game::SetCameraPose(const glm::vec3& position, float yaw, float pitch)
+{
+    camera.SetPose(position, yaw, pitch);
+}
 
-    //Update wireframe mode.
-    if (window.IsKeyPressedOnce(settings::wireframeModeKey))
+void Game::SetCameraLookAt(const glm::vec3& eye, const glm::vec3& target)
+{
+    camera.LookAt(eye, target);
+}
+
+void Game::SetFollowTarget(int index)
+{
+    if (index >= static_cast<int>(followTargets.size()))
     {
-        window.ToggleWireframe();
+        index = -1;
     }
-    if (window.IsKeyPressedOnce(settings::orbitToggleKey))
+    if (index < 0)
     {
-        showOrbitPaths = !showOrbitPaths;
+        //Same as cycling past the last target: restore the free camera.
+        if (followTargetIndex >= 0)
+        {
+            followTargetIndex = static_cast<int>(followTargets.size()) - 1;
+            CycleFollowTarget();
+        }
+        return;
     }
-    //Update camera speed.
-    if (!followActive && window.IsKeyPressed(settings::cameraSpeedupKey))
+    if (followTargetIndex < 0)
     {
-        camera.AddMovementSpeed(settings::cameraSpeedupRate);
+        CycleFollowTarget();
     }
-    if (!followActive && window.IsKeyPressed(settings::cameraSlowdownKey))
+    followTargetIndex = index;
+}
+
+int Game::GetFollowTargetCount() const
+{
+    return static_cast<int>(followTargets.size());
+}
+
+void Game::SetShowOrbitPaths(bool show)
+{
+    showOrbitPaths = show;
+}
+
+void Game::SetShowBodyLabels(bool show)
+{
+    showBodyLabels = show;
+}
+
+void Game::SetShowTrails(bool show)
+{
+    // Trails are not sampled while hidden, start them fresh
+    if (show && !showTrails)
     {
-        camera.AddMovementSpeed(-settings::cameraSpeedupRate);
+        trailRenderer.Clear();
     }
-    if (window.IsKeyPressedOnce(settings::pauseKey))
+    showTrails = show;
+}
+
+void Game::SetTimeSpeed(float speed)
+{
+    timeSpeed = speed;
+}
+
+const std::vector<Game::FrameRecord>& Game::GetFrameRecords() const
+{
+    return frameRecords;
+}
+
+void Game::Update(float deltatime)
+{
+    //Logic update happens here.
     {
-        isPaused = !isPaused;
+        PROFILE_SCOPE(profiler, "Input");
+        //Check if window should be closed.
+        if(window.IsKeyPressed(settings::exitKey))
+        {
+            window.Close();
+        }
+        //Update camera rotation.
+        glm::vec2 mousePosition = window.GetMousePosition();
+        glm::vec2 cameraRotationOffset{ mousePosition.x - lastMousePosition.x, lastMousePosition.y - mousePosition.y };
+        lastMousePosition = mousePosition;
+        frameLatency.MarkInputSampled();
+
+        if (window.IsKeyPressedOnce(settings::cameraCycleKey))
+        {
+            CycleFollowTarget();
+        }
+
+        bool followActive = followTargetIndex >= 0;
+
+        if (!followActive)
+        {
+            camera.Rotate(cameraRotationOffset);
+            //Update camera position.
+            if (window.IsKeyPressed(settings::forwardKey))
+                camera.Move(Camera::Movement::FORWARD, deltatime);
+            if (window.IsKeyPressed(settings::backwardKey))
+                camera.Move(Camera::Movement::BACKWARD, deltatime);
+            if (window.IsKeyPressed(settings::leftKey))
+                camera.Move(Camera::Movement::LEFT, deltatime);
+            if (window.IsKeyPressed(settings::rightKey))
+                camera.Move(Camera::Movement::RIGHT, deltatime);
+            if (window.IsKeyPressed(settings::upKey1) || window.IsKeyPressed(settings::upKey2))
+                camera.Move(Camera::Movement::UP, deltatime);
+            if (window.IsKeyPressed(settings::downKey))
+                camera.Move(Camera::Movement::DOWN, deltatime);
+        }
+
+        //Update wireframe mode.
+        if (window.IsKeyPressedOnce(settings::wireframeModeKey))
+        {
+            window.ToggleWireframe();
+        }
+        if (window.IsKeyPressedOnce(settings::orbitToggleKey))
+        {
+            showOrbitPaths = !showOrbitPaths;
+        }
+        if (window.IsKeyPressedOnce(settings::bodyLabelsKey))
+        {
+            showBodyLabels = !showBodyLabels;
+        }
+        if (window.IsKeyPressedOnce(settings::trailsKey))
+        {
+            SetShowTrails(!showTrails);
+        }
+        if (window.IsKeyPressedOnce(settings::overdrawViewKey))
+        {
+            overdrawView = !overdrawView;
+            window.SetClearColor(overdrawView ? glm::vec3(0.0f) : settings::clearColor);
+            overdrawFrame = 0;  //The queries still hold the last session's counts; read none until they are reissued.
+            overdrawAccumulated = 0.0;
+            overdrawAccumulatedFrames = 0;
+            overdrawReportTimer = 0.0f;
+        }
+        if (window.IsKeyPressedOnce(settings::depthPrepassKey))
+        {
+            depthPrepass = !depthPrepass;
+        }
+        if (window.IsKeyPressedOnce(settings::asteroidDisplacementKey))
+        {
+            asteroidDisplacement = !asteroidDisplacement;
+        }
+        if (window.IsKeyPressedOnce(settings::qualityGovernorKey))
+        {
+            bool enabled = !qualityGovernor.IsEnabled();
+            qualityGovernor.SetEnabled(enabled);
+            if (!enabled)
+            {
+                qualityGovernor.SetLevel(0);
+            }
+            std::cout << "Quality governor " << (enabled ? "on" : "off (full detail)") << "\n";
+        }
+        if (window.IsKeyPressedOnce(settings::dynamicResolutionKey))
+        {
+            bool enabled = !dynamicResolution.IsEnabled();
+            dynamicResolution.SetEnabled(enabled);
+            if (!enabled)
+            {
+                dynamicResolution.SetScale(1.0f);
+            }
+            std::cout << "Dynamic resolution " << (enabled ? "on" : "off (native resolution)") << "\n";
+        }
+        if (window.IsKeyPressedOnce(settings::lowLatencyKey))
+        {
+            bool enabled = !frameLatency.IsLimitEnabled();
+            frameLatency.SetLimitEnabled(enabled);
+            std::cout << "Low latency mode " << (enabled ? "on" : "off") << "\n";
+        }
+        if (window.IsKeyPressedOnce(settings::profilerHudKey))
+        {
+            showProfilerHud = !showProfilerHud;
+        }
+        if (window.IsKeyPressedOnce(settings::profilerTraceKey))
+        {
+            bool recording = !profiler.IsTraceRecording();
+            profiler.SetTraceRecording(recording);
+            if (!recording)
+            {
+                profiler.WriteChromeTrace(options.tracePath.empty() ? settings::traceFileName : options.tracePath);
+            }
+            else
+            {
+                std::cout << "Recording trace (press again to stop and write it)\n";
+            }
+        }
+        //Update camera speed.
+        if (!followActive && window.IsKeyPressed(settings::cameraSpeedupKey))
+        {
+            camera.AddMovementSpeed(settings::cameraSpeedupRate);
+        }
+        if (!followActive && window.IsKeyPressed(settings::cameraSlowdownKey))
+        {
+            camera.AddMovementSpeed(-settings::cameraSpeedupRate);
+        }
+        if (window.IsKeyPressedOnce(settings::pauseKey))
+        {
+            isPaused = !isPaused;
+        }
     }
 
     if (!isPaused)
@@ -796,36 +1340,26 @@ void Game::Update(float deltatime)
         shaderTime += deltatime;
         // Advance simulation JD for Keplerian orbits
         simulationTimeSec += (double)deltatime * (double)timeSpeed * (double)settings::keplerDaysPerSecond * 86400.0;
-        // Update Sun (index 0) legacy spin
-        if (!planets.empty())
-        {
-            planets[0].Update(deltatime * timeSpeed);
-        }
-        // Accumulate self rotation for planets (1..8); use positive speed magnitude and encode
-        // retrograde solely via obliquity (>90 deg means spin axis flipped)
-        for (size_t i = 1; i < planets.size(); ++i)
+        // Stars spin in place through the legacy Planet update
+        for (size_t i = 0; i < bodies.size(); ++i)
         {
-            if (i < planetRotationSpeedDeg.size())
+            if (scene.bodies[i].kind == SceneBody::Kind::Star)
             {
-                // Simply accumulate rotation using configured speed
-                // Negative speed in settings means retrograde rotation
-                planetSelfRotationDeg[i] += planetRotationSpeedDeg[i] * deltatime * timeSpeed;
-                // Normalize angle
-                while (planetSelfRotationDeg[i] > 360.0f) planetSelfRotationDeg[i] -= 360.0f;
-                while (planetSelfRotationDeg[i] < -360.0f) planetSelfRotationDeg[i] += 360.0f;
+                bodies[i].Update(deltatime * timeSpeed);
+                continue;
             }
+            // Accumulate self rotation for planets and moons; a negative speed means retrograde rotation,
+            // an obliquity over 90 degrees flips the spin axis instead
+            bodySelfRotationDeg[i] += scene.bodies[i].rotationSpeedDeg * deltatime * timeSpeed;
+            // Normalize angle
+            while (bodySelfRotationDeg[i] > 360.0f) bodySelfRotationDeg[i] -= 360.0f;
+            while (bodySelfRotationDeg[i] < -360.0f) bodySelfRotationDeg[i] += 360.0f;
         }
-        // Update moon orbit angle only when not paused
-        moonOrbitDeg += settings::moonOrbitSpeed * deltatime;
-        if (moonOrbitDeg > 360.0f) moonOrbitDeg -= 360.0f;
 
         // Update asteroid angles
-        for (auto& a : asteroids)
         {
-            a.angleDeg += a.angularSpeedDeg * deltatime * timeSpeed;
-            if (a.angleDeg > 360.0f) a.angleDeg -= 360.0f;
-            a.spinDeg += a.spinSpeedDeg * deltatime * timeSpeed;
-            if (a.spinDeg > 360.0f) a.spinDeg -= 360.0f;
+            PROFILE_SCOPE(profiler, "Asteroids");
+            asteroidBelt.Update(deltatime * timeSpeed);
         }
 
         //Update the time speed.
@@ -835,227 +1369,501 @@ void Game::Update(float deltatime)
             timeSpeed -= settings::timeAdjustSpeed;
     }
 
-    // Build planet transforms from Kepler orbits (1..8)
-    double currentJD = settings::epochJD_J2000 + simulationTimeSec / 86400.0;
-    for (size_t i = 1; i < planets.size() && i < planetElements.size(); ++i)
+    // Build planet transforms from Kepler orbits
+    {
+        PROFILE_SCOPE(profiler, "Kepler");
+        double currentJD = settings::epochJD_J2000 + simulationTimeSec / 86400.0;
+        for (size_t i = 0; i < bodies.size(); ++i)
+        {
+            if (scene.bodies[i].kind == SceneBody::Kind::Planet)
+            {
+                bodies[i].SetModelMatrix(BuildBodyModelMatrix(i, orbitalPositionAtJD(bodyElements[i], currentJD)));
+                bodies[i].SetSelfRotationDegrees(bodySelfRotationDeg[i]);
+            }
+        }
+    }
+
+    // N-body integrate the moons around their planets (planets come first, so their positions are current)
+    {
+        PROFILE_SCOPE(profiler, "Moons");
+        double dtSim = simulationTimeSec - lastSimTimeSec;
+        lastSimTimeSec = simulationTimeSec;
+        for (size_t m = 0; m < moons.size(); ++m)
+        {
+            MoonState& moon = moons[m];
+            const SceneBody& body = scene.bodies[moon.body];
+            // Leapfrog in the planet's frame, small fixed steps for stability (10 min sim step)
+            integrateLeapfrog(moon.relativePosition, moon.relativeVelocity, moon.mu, dtSim, 600.0);
+            // Safety: if the moon drifted or became NaN, reinitialize to circular
+            glm::vec3 rNow = moon.relativePosition;
+            float rLen = glm::length(rNow);
+            if (!(std::isfinite(rNow.x) && std::isfinite(rNow.y) && std::isfinite(rNow.z)) || rLen < body.orbitRadius * 0.5f || rLen > body.orbitRadius * 2.0f)
+            {
+                ResetMoon(m);
+            }
+            glm::vec3 position = GetBodyWorldPosition(body.parent) + moon.relativePosition;
+            bodies[moon.body].SetModelMatrix(BuildBodyModelMatrix(moon.body, position));
+        }
+    }
+    {
+        PROFILE_SCOPE(profiler, "FollowCamera");
+        UpdateFollowCamera();
+    }
+    {
+        PROFILE_SCOPE(profiler, "Trails");
+        UpdateTrails();
+    }
+}
+
+void Game::BuildOpaqueQueue()
+{
+    const glm::vec3 cameraPosition = camera.GetPosition();
+    auto surfaceDistance = [&](const glm::vec3& center, float radius)
     {
-        const OrbitalElements& el = planetElements[i];
-        glm::vec3 pos = orbitalPositionAtJD(el, currentJD);
-        float scale = planets[i].GetScale();
-        float obq = (i < planetObliquityDeg.size()) ? planetObliquityDeg[i] : 0.0f;
-        float selfDeg = (i < planetSelfRotationDeg.size()) ? planetSelfRotationDeg[i] : 0.0f;
+        return std::max(glm::length(center - cameraPosition) - radius, 0.0f);
+    };
 
-        glm::mat4 model = glm::translate(glm::mat4(1.0f), pos);
-        glm::mat4 tiltMat = glm::rotate(glm::mat4(1.0f), glm::radians(obq), glm::vec3(1, 0, 0));
-        glm::vec3 spinAxis = glm::vec3(tiltMat * glm::vec4(0.0f, 1.0f, 0.0f, 0.0f));
-        spinAxis = glm::normalize(spinAxis);
+    opaqueQueue.clear();
+    const std::vector<AsteroidBelt::Asteroid>& asteroids = asteroidBelt.GetAsteroids();
+    opaqueQueue.reserve(bodies.size() + asteroids.size());
+    for (size_t i = 0; i < bodies.size(); ++i)
+    {
+        const glm::vec3 center = GetBodyWorldPosition(i);
+        opaqueQueue.push_back({ OpaqueDraw::Kind::Body, i, surfaceDistance(center, bodies[i].GetScale()), bodyPermutations[i],
+            &SelectSphereMesh(center, bodies[i].GetScale()) });
+    }
 
-        model = glm::rotate(model, glm::radians(selfDeg), spinAxis);
-        model = model * tiltMat;
-        model = glm::scale(model, glm::vec3(scale));
+    //The quality level thins the belt out; the hidden rocks keep moving, they just get no matrix.
+    const float asteroidFraction = qualityGovernor.GetSettings().asteroidFraction;
+    asteroidBelt.BuildModelMatrices(asteroidModelMatrices, (size_t)std::lround(asteroids.size() * (double)asteroidFraction));
+    if (asteroidDisplacement)
+    {
+        //One instanced draw covers the whole belt; the rocks stay out of the queue.
+        asteroidRenderer.SetModelMatrices(asteroidModelMatrices);
+    }
+    for (size_t i = 0; i < asteroidModelMatrices.size() && !asteroidDisplacement; ++i)
+    {
+        const AsteroidBelt::Asteroid& a = asteroids[i];
+        const glm::mat4& model = asteroidModelMatrices[i];
+        // Craggy meshes stay within ~1.4x their nominal radius
+        float radius = 1.4f * std::max(a.scale.x, std::max(a.scale.y, a.scale.z));
+        opaqueQueue.push_back({ OpaqueDraw::Kind::Asteroid, i, surfaceDistance(glm::vec3(model[3]), radius), SurfaceShaders::RimLight, nullptr });
+    }
 
-        planets[i].SetModelMatrix(model);
-        planets[i].SetSelfRotationDegrees(selfDeg);
+    std::sort(opaqueQueue.begin(), opaqueQueue.end(),
+        [](const OpaqueDraw& lhs, const OpaqueDraw& rhs) { return lhs.distance < rhs.distance; });
+}
+
+float Game::GetProjectedRadius(const glm::vec3& center, float radius) const
+{
+    //Tangent of the sphere's angular radius, in pixels at the center of the screen; from inside it fills the view.
+    const float pixelsPerRadian = settings::viewportHeight * 0.5f / std::tan(glm::radians(settings::cameraFOV) * 0.5f);
+    const glm::vec3 offset = center - camera.GetPosition();
+    const float tangentSquared = glm::dot(offset, offset) - radius * radius;
+    return tangentSquared > 0.0f ? pixelsPerRadian * radius / std::sqrt(tangentSquared) : std::numeric_limits<float>::max();
+}
+
+const Mesh& Game::SelectSphereMesh(const glm::vec3& center, float radius) const
+{
+    //An edge spanning 2 pi / slices cuts inside the silhouette by r (1 - cos(pi / slices)).
+    const float pixels = GetProjectedRadius(center, radius);
+    const float allowedError = qualityGovernor.GetSettings().sphereErrorPixels;
+    for (size_t level = sphereLods.size(); level-- > 0;)
+    {
+        if (pixels * (1.0f - std::cos(glm::pi<float>() / sphereLodSlices[level])) <= allowedError)
+        {
+            return sphereLods[level];
+        }
     }
+    return sphereMesh;
+}
 
-    // N-body integrate Moon around Earth (+Sun)
+void Game::DrawOpaqueQueue(const glm::mat4& viewProjection, OpaquePass pass)
+{
+    const ShaderProgram* boundShader = nullptr;
+    auto useShader = [&](ShaderProgram& shader)
     {
-        double dtSim = simulationTimeSec - lastSimTimeSec;
-        lastSimTimeSec = simulationTimeSec;
-        // Integrate using small fixed steps for stability
-        const double maxStep = 600.0; // 10 min sim step for stability
-        while (dtSim > 1e-6)
+        if (boundShader != &shader)
+        {
+            window.UseShader(shader);
+            boundShader = &shader;
+        }
+    };
+
+    const std::vector<OpaqueDraw>* queue = &opaqueQueue;
+    if (pass == OpaquePass::Shaded)
+    {
+        //Per-frame uniforms.
+        for (const auto& permutation : surfaceShaders.GetPrograms())
+        {
+            ShaderProgram& shader = *permutation.second;
+            const unsigned int features = permutation.first;
+            if (features & (SurfaceShaders::RimLight | SurfaceShaders::SpecularMask))
+            {
+                window.UseShader(shader);
+                shader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
+            }
+            // Provide stable time to shader effects regardless of pause toggles
+            if (features & SurfaceShaders::UvFlow)
+            {
+                window.UseShader(shader);
+                shader.SendUniform<float>("timeSeconds", shaderTime);
+            }
+            // Use accumulated time so pausing doesn't snap animation phase
+            if (features & SurfaceShaders::Unlit)
+            {
+                window.UseShader(shader);
+                shader.SendUniform<float>("timeSeconds", shaderTime * 0.25f);
+            }
+        }
+        window.UseShader(asteroidShader);
+        asteroidShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
+        if (depthPrepass)
+        {
+            //The prepass already resolved visibility, so draw order no longer saves shading: group by program instead.
+            shadedQueue = opaqueQueue;
+            std::stable_sort(shadedQueue.begin(), shadedQueue.end(),
+                [](const OpaqueDraw& lhs, const OpaqueDraw& rhs) { return lhs.permutation < rhs.permutation; });
+            queue = &shadedQueue;
+        }
+    }
+
+    for (const OpaqueDraw& item : *queue)
+    {
+        const Mesh* mesh = item.mesh;
+        int asteroidMesh = -1;  // index into asteroidMeshes instead of mesh
+        glm::mat4 model;
+        if (item.kind == OpaqueDraw::Kind::Asteroid)
+        {
+            model = asteroidModelMatrices[item.index];
+            // Use one of the irregular meshes, then scale to asteroid dimensions
+            asteroidMesh = asteroidBelt.GetAsteroids()[item.index].meshIndex;
+        }
+        else
+        {
+            model = bodies[item.index].GetModelMatrix();
+        }
+
+        if (pass != OpaquePass::Shaded)
+        {
+            ShaderProgram& shader = (pass == OpaquePass::Depth) ? depthShader : overdrawShader;
+            useShader(shader);
+            shader.SendUniform<glm::mat4>("MVP", viewProjection * model);
+            if (asteroidMesh >= 0)
+                window.DrawMesh(asteroidMeshes, asteroidMesh);
+            else
+                window.DrawMesh(*mesh);
+            continue;
+        }
+
+        ShaderProgram& shader = surfaceShaders.Get(item.permutation);
+        useShader(shader);
+        shader.SendUniform<glm::mat4>("MVP", viewProjection * model);
+        if (!(item.permutation & SurfaceShaders::Unlit))
+        {
+            shader.SendUniform<glm::mat4>("modelMatrix", model);
+        }
+        if (item.kind == OpaqueDraw::Kind::Body)
+        {
+            //Stars without lighting, with animated UVs and brightness boost; the maps a body lacks repeat its albedo,
+            //their features being compiled out of its permutation.
+            const BodyTextures& textures = bodyTextures[item.index];
+            const Texture& albedo = sceneTextures[textures.albedo];
+            if (!(item.permutation & SurfaceShaders::Unlit))
+            {
+                shader.SendUniform<glm::mat3>("normalMatrix", bodies[item.index].GetNormalMatrix());
+            }
+            if (item.permutation & (SurfaceShaders::NightLights | SurfaceShaders::SpecularMask | SurfaceShaders::Clouds))
+            {
+                auto map = [&](int texture) -> const Texture& { return texture >= 0 ? sceneTextures[texture] : albedo; };
+                window.DrawActor(*mesh, albedo, map(textures.night), map(textures.specular), map(textures.clouds));
+            }
+            else
+            {
+                window.DrawActor(*mesh, albedo);
+            }
+        }
+        else
+        {
+            shader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
+            window.DrawActor(asteroidMeshes, asteroidMesh, sceneTextures[asteroidTexture]);
+        }
+    }
+
+    //The belt goes last, in one call: the planets in front of it have already filled the depth buffer.
+    if (asteroidDisplacement)
+    {
+        switch (pass)
+        {
+        case OpaquePass::Depth:
+            asteroidRenderer.Draw(window, asteroidDepthShader, viewProjection);
+            break;
+        case OpaquePass::Overdraw:
+            asteroidRenderer.Draw(window, asteroidOverdrawShader, viewProjection);
+            break;
+        case OpaquePass::Shaded:
+            window.BindTexture(0, GL_TEXTURE_2D, sceneTextures[asteroidTexture].GetID());
+            asteroidRenderer.Draw(window, asteroidShader, viewProjection);
+            break;
+        }
+    }
+}
+
+void Game::ReportOverdraw(float deltatime)
+{
+    //Read last frame's query (the current one is still in flight) so the readback never stalls.
+    if (overdrawFrame > 0)
+    {
+        GLuint previousQuery = overdrawQueries[(overdrawFrame - 1) & 1];
+        GLint available = 0;
+        glGetQueryObjectiv(previousQuery, GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available)
         {
-            double h = std::min(dtSim, maxStep);
-            // Acceleration in Earth's frame
-            float dist = glm::length(moonRelPos) + 1e-6f;
-            glm::vec3 acc = -(muEarth) * moonRelPos / (dist * dist * dist);
-            // Leapfrog step in relative frame
-            moonRelVel += (float)(0.5 * h) * acc;
-            moonRelPos += (float)h * moonRelVel;
-            dist = glm::length(moonRelPos) + 1e-6f;
-            acc = -(muEarth) * moonRelPos / (dist * dist * dist);
-            moonRelVel += (float)(0.5 * h) * acc;
-            dtSim -= h;
+            GLuint samplesPassed = 0;
+            glGetQueryObjectuiv(previousQuery, GL_QUERY_RESULT, &samplesPassed);
+            GLint viewport[4] = { 0, 0, 0, 0 };
+            GLint samples = 0;
+            glGetIntegerv(GL_VIEWPORT, viewport);
+            glGetIntegerv(GL_SAMPLES, &samples);
+            double screenSamples = (double)viewport[2] * viewport[3] * std::max(samples, 1);
+            if (screenSamples > 0.0)
+            {
+                overdrawAccumulated += samplesPassed / screenSamples;
+                ++overdrawAccumulatedFrames;
+            }
         }
-        // Safety: if the Moon drifted or became NaN, reinitialize to circular
-        glm::vec3 rNow = moonRelPos;
-        float rLen = glm::length(rNow);
-        if (!(std::isfinite(rNow.x) && std::isfinite(rNow.y) && std::isfinite(rNow.z)) || rLen < settings::moonOrbitRadius * 0.5f || rLen > settings::moonOrbitRadius * 2.0f)
+    }
+    ++overdrawFrame;
+
+    overdrawReportTimer += deltatime;
+    if (overdrawReportTimer >= 1.0f && overdrawAccumulatedFrames > 0)
+    {
+        std::cout << std::fixed << std::setprecision(2)
+            << "Opaque overdraw: " << overdrawAccumulated / overdrawAccumulatedFrames
+            << " shaded samples per screen sample (depth prepass " << (depthPrepass ? "on" : "off") << ")\n";
+        overdrawAccumulated = 0.0;
+        overdrawAccumulatedFrames = 0;
+        overdrawReportTimer = 0.0f;
+    }
+}
+
+bool Game::ShouldRedraw()
+{
+    if (!renderOnDemand)
+    {
+        return true;
+    }
+    const bool activity = window.TakeActivity();
+    if (window.IsHidden())
+    {
+        return false;   //Iconified or hidden: nothing drawn would be seen.
+    }
+    //Input, a resize or an expose needs at least one frame; anything that moves on its own needs all of them.
+    return activity || !isPaused || showProfilerHud || profiler.IsTraceRecording() || !textureStreamer.IsIdle();
+}
+
+void Game::LatchMouseLook()
+{
+    //Process the events that arrived during Update, so the view reflects the newest cursor position.
+    window.PollEvents();
+    glm::vec2 mousePosition = window.GetMousePosition();
+    if (followTargetIndex < 0)
+    {
+        camera.Rotate({ mousePosition.x - lastMousePosition.x, lastMousePosition.y - mousePosition.y });
+    }
+    lastMousePosition = mousePosition;
+    frameLatency.MarkInputSampled();
+}
+
+void Game::StartInputRecording()
+{
+    if (!options.replayPath.empty())
+    {
+        if (!inputRecorder.StartReplay(options.replayPath))
         {
-            double periodMoonSec = (double)27.321661 * 86400.0;
-            float vCirc = (float)(6.28318530718 * settings::moonOrbitRadius / periodMoonSec);
-            moonRelPos = glm::vec3(settings::moonOrbitRadius, 0.0f, 0.0f);
-            moonRelVel = glm::vec3(0.0f, 0.0f, vCirc);
+            window.Close();     //Running on live input instead would measure something else.
+            return;
         }
-        glm::vec3 earthPosNow = GetPlanetWorldPosition(1);
-        glm::vec3 moonPosWorld = earthPosNow + moonRelPos;
-        glm::mat4 model(1.0f);
-        model = glm::translate(model, moonPosWorld);
-        model = glm::scale(model, glm::vec3(settings::moonScale));
-        moonModelMatrix = model;
-        moon.SetModelMatrix(moonModelMatrix);
+        lastMousePosition = inputRecorder.GetInitialMousePosition();
+        inputState.mousePosition = lastMousePosition;
+        window.SetInputOverride(&inputState);
+        std::cout << "Replaying input from " << options.replayPath << "\n";
+    }
+    else if (!options.recordPath.empty() && inputRecorder.StartRecording(options.recordPath, lastMousePosition))
+    {
+        inputState.mousePosition = lastMousePosition;
+        window.SetInputOverride(&inputState);
+        std::cout << "Recording input into " << options.recordPath << "\n";
+    }
+}
+
+bool Game::IsFixedStep() const
+{
+    return options.fixedDeltaTime > 0.0f || inputRecorder.IsReplaying();
+}
+
+void Game::UpscaleScene()
+{
+    if (dynamicResolution.IsActive())
+    {
+        PROFILE_PASS(profiler, "Upscale");
+        dynamicResolution.EndScene(window, upscaleShader);
     }
-    UpdateFollowCamera();
 }
 
 void Game::Draw(float deltatime)
 {
     //Drawing happens here.
+    if (frameLatency.IsLimitEnabled())
+    {
+        LatchMouseLook();
+    }
     glm::mat4 projection = camera.GetPerspectiveMatrix();
     glm::mat4 viewMatrix = camera.GetViewMatrix();
 
-    //Draw the planets (except for the sun and the earth) using the default shader (normal lighting).
-    window.UseShader(defaultShader);
-    defaultShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
-    // Provide stable time to shader effects regardless of pause toggles
-    defaultShader.SendUniform<float>("timeSeconds", shaderTime);
-    for (size_t i = 2; i < planets.size(); ++i)
-    {
-        // Enable flow only for gaseous giants (Jupiter=5, Saturn=6, Uranus=7, Neptune=8)
-        float flow = (i>=5 ? 1.0f : 0.0f);
-        defaultShader.SendUniform<float>("flowAmount", flow);
-        glm::mat4 model = planets[i].GetModelMatrix();
-        defaultShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        defaultShader.SendUniform<glm::mat4>("modelMatrix", model);
-        defaultShader.SendUniform<glm::mat3>("normalMatrix", planets[i].GetNormalMatrix());
-        window.DrawActor(sphereMesh, planetTextures[i]);
-    }
-    //Draw the earth using its own shader.
-    window.UseShader(earthShader);
-    earthShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * planets[1].GetModelMatrix());
-    earthShader.SendUniform<glm::mat4>("modelMatrix", planets[1].GetModelMatrix());
-    earthShader.SendUniform<glm::mat3>("normalMatrix", planets[1].GetNormalMatrix());
-    earthShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
-    window.DrawActor(sphereMesh, planetTextures[1], earthNightTexture, earthSpecularTexture, earthCloudsTexture);
-
-    // Venus atmosphere overlay using overlay shader
-    // planet indices: 0 Sun, 1 Earth, 2 Mercury, 3 Venus, 4 Mars, 5 Jupiter, 6 Saturn, 7 Uranus, 8 Neptune
-    const size_t venusIndex = 3;
-    window.UseShader(overlayShader);
-    {
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        // Build a model matrix matching Venus position/scale, with slight extra scale and a slow rotation
-        glm::mat4 model = glm::mat4(1.0f);
-        // Reconstruct from planet transform: orbit and base rotations reproduced via composition is complex.
-        // Simpler: use planet's model then add slight scale and an extra yaw rotation.
-        model = planets[venusIndex].GetModelMatrix();
-        // Undo self-rotation effect on normals not necessary for overlay; we just scale slightly and rotate a bit more.
-        model = glm::scale(model, glm::vec3(settings::venusAtmosphereScale));
-        // Visible haze; pale warm tint. Alpha kept moderate to avoid washing the albedo
-        overlayShader.SendUniform<float>("overlayAlpha", 0.55f);
-        overlayShader.SendUniform<glm::vec3>("colorTint", glm::vec3(1.0f, 0.96f, 0.9f));
-        overlayShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        overlayShader.SendUniform<glm::mat4>("modelMatrix", model);
-        overlayShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
-        window.DrawActor(sphereMesh, venusAtmosphereTexture);
-        glDisable(GL_BLEND);
-    }
-
-    // Saturn rings overlay using ring mesh and overlay shader
-    const size_t saturnIndex = 6;
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::vec3 saturnPos = GetPlanetWorldPosition(saturnIndex);
-        model = glm::translate(model, saturnPos);
-        model = glm::scale(model, glm::vec3(settings::saturnScale));
-        // Tilt ring plane around Z (equatorial tilt)
-        model = glm::rotate(model, glm::radians(settings::saturnRingTiltDegrees), glm::vec3(0,0,1));
-        // Apply ring outer radius and thin in Y
-        model = glm::scale(model, glm::vec3(settings::saturnRingOuter, 0.001f, settings::saturnRingOuter));
-        window.UseShader(overlayShader);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        overlayShader.SendUniform<float>("overlayAlpha", 0.7f);
-        overlayShader.SendUniform<glm::vec3>("colorTint", glm::vec3(1.0f));
-        // No UV wobble; rotation can be simulated by slightly rotating the model around Y when not paused
-        if (!isPaused)
+    //Opaque bodies go first, nearest first, so hidden fragments fail the depth test before they are shaded.
+    {
+        PROFILE_SCOPE(profiler, "OpaqueSort");
+        BuildOpaqueQueue();
+    }
+    //Texture levels follow what this frame shows, so they are settled before anything is drawn.
+    {
+        PROFILE_SCOPE(profiler, "Streaming");
+        RequestTextureDetail(projection, viewMatrix);
+        UpdateStreaming();
+    }
+    glm::mat4 viewProjection = projection * viewMatrix;
+    //With dynamic resolution the scene goes to the scaled target; the HUD is drawn after the upscale, at native resolution.
+    dynamicResolution.BeginScene(window);
+    //Each pass sets the state it needs; the window skips whatever is already set.
+    window.SetBlend(false);
+    window.SetDepthTest(true);
+    window.SetDepthFunc(GL_LESS);
+    window.SetDepthMask(true);
+    if (depthPrepass)
+    {
+        PROFILE_PASS(profiler, "DepthPrepass");
+        window.SetColorMask(false);
+        DrawOpaqueQueue(viewProjection, OpaquePass::Depth);
+        window.SetColorMask(true);
+        //Depth is final now: shade only the visible surface and leave the depth buffer alone.
+        window.SetDepthFunc(GL_LEQUAL);
+        window.SetDepthMask(false);
+    }
+    if (overdrawView)
+    {
+        //Debug view: count how many times each pixel gets shaded instead of drawing the scene.
+        PROFILE_PASS(profiler, "Overdraw");
+        if (overdrawQueries[0] == 0)
         {
-            model = glm::rotate(model, glm::radians(settings::saturnRingAngularSpeed) * deltatime * timeSpeed, glm::vec3(0,1,0));
+            glGenQueries(2, overdrawQueries);
         }
-        overlayShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        overlayShader.SendUniform<glm::mat4>("modelMatrix", model);
-        overlayShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
-        window.DrawActor(ringMesh, saturnRingTexture);
-        glDisable(GL_BLEND);
-    }
-
-    // Uranus rings (thin, smaller, vertical alignment) using same ring mesh
-    const size_t uranusIndex = 7;
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        glm::vec3 uranusPos = GetPlanetWorldPosition(uranusIndex);
-        model = glm::translate(model, uranusPos);
-        model = glm::scale(model, glm::vec3(settings::uranusScale));
-        // Vertical ring: 90 degrees about X
-        model = glm::rotate(model, glm::radians(90.0f), glm::vec3(1,0,0));
-        // Smaller and thinner than Saturn's
-        model = glm::scale(model, glm::vec3(settings::saturnRingOuter * 0.5f, 0.001f, settings::saturnRingOuter * 0.5f));
+        glBeginQuery(GL_SAMPLES_PASSED, overdrawQueries[overdrawFrame & 1]);
+        window.SetBlend(true);
+        window.SetBlendFunc(GL_ONE, GL_ONE);
+        DrawOpaqueQueue(viewProjection, OpaquePass::Overdraw);
+        glEndQuery(GL_SAMPLES_PASSED);
+    }
+    else
+    {
+        //Sun, planets, Earth, Moon and belt are interleaved by distance, so they are timed as one pass.
+        PROFILE_PASS(profiler, "Opaque");
+        DrawOpaqueQueue(viewProjection, OpaquePass::Shaded);
+    }
+    if (overdrawView)
+    {
+        ReportOverdraw(deltatime);
+        UpscaleScene();
+        PROFILE_PASS(profiler, "HUD");
+        DrawHud(viewProjection);
+        return;
+    }
+
+    //Draw the skybox after all opaque geometry so covered pixels fail the depth test before shading.
+    {
+        PROFILE_PASS(profiler, "Skybox");
+        glm::mat4 skyView = glm::mat4(glm::mat3(viewMatrix));//Remove the translation, the sky does not move with the camera.
+        window.UseShader(skyboxShader);
+        skyboxShader.SendUniform<glm::mat4>("inverseViewProjection", glm::inverse(projection * skyView));
+        // Keep same time base as the sun so it freezes consistently when paused
+        skyboxShader.SendUniform<float>("timeSeconds", shaderTime * 0.25f);
+        window.DrawSkybox(skybox);
+    }
+
+    //Translucent overlays go last so they blend over the planets and the sky: atmospheres and rings, using the
+    //overlay permutation.
+    {
+        PROFILE_PASS(profiler, "Overlays");
+        ShaderProgram& overlayShader = surfaceShaders.Get(SurfaceShaders::AlphaOverlay);
         window.UseShader(overlayShader);
-        glEnable(GL_BLEND);
-        glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-        overlayShader.SendUniform<float>("overlayAlpha", 0.9f);
-        // Darker tint for Uranus rings
-        overlayShader.SendUniform<glm::vec3>("colorTint", glm::vec3(0.5f, 0.55f, 0.6f));
-        overlayShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        overlayShader.SendUniform<glm::mat4>("modelMatrix", model);
-        overlayShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
-        window.DrawActor(ringMesh, uranusRingTexture);
-        glDisable(GL_BLEND);
-    }
-
-    // Asteroid belt draw (after planets, before sun/skybox)
-    window.UseShader(defaultShader);
-    defaultShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
-    for (const auto& a : asteroids)
-    {
-        glm::mat4 model = glm::mat4(1.0f);
-        // Orbital rotation around Y, then translate to belt radius
-        model = glm::rotate(model, glm::radians(a.angleDeg), glm::vec3(0,1,0));
-        model = glm::translate(model, glm::vec3(a.radius, 0.0f, 0.0f));
-        // Apply belt tilt and vertical offset
-        model = glm::rotate(model, glm::radians(settings::asteroidBeltTiltDegrees), glm::vec3(1,0,0));
-        model = glm::translate(model, a.offset);
-        // Random local spin for sparkle
-        model = glm::rotate(model, glm::radians(a.spinDeg), a.spinAxis);
-        model = glm::scale(model, a.scale);
-        defaultShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        defaultShader.SendUniform<glm::mat4>("modelMatrix", model);
-        defaultShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
-        // Use one of the irregular meshes, then scale to asteroid dimensions
-        window.DrawActor(asteroidMeshes[a.meshIndex], asteroidTexture);
-    }
-
-    // Moon: orbit Earth and stay tidally locked (same face toward Earth)
-    {
-        glm::mat4 model = moon.GetModelMatrix();
-        window.UseShader(defaultShader);
-        defaultShader.SendUniform<glm::vec3>("viewPosition", camera.GetPosition());
-        defaultShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
-        defaultShader.SendUniform<glm::mat4>("modelMatrix", model);
-        defaultShader.SendUniform<glm::mat3>("normalMatrix", moon.GetNormalMatrix());
-        window.DrawActor(sphereMesh, moonTexture);
-    }
-    // (cleanup) removed stray placeholder Venus code
-    //Draw the sun and the skybox without lighting.
-    window.UseShader(noLightShader);
-    //Draw sun with no-light shader but animated UVs and brightness boost
-    window.UseShader(noLightShader);
-    noLightShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * planets[0].GetModelMatrix());
-    // Use accumulated time so pausing doesn't snap animation phase
-    noLightShader.SendUniform<float>("timeSeconds", shaderTime * 0.25f);
-    window.DrawActor(sphereMesh, planetTextures[0]);
-    //Draw skybox.
-    viewMatrix = glm::mat4(glm::mat3(viewMatrix));//Remove the translation from the view matrix, we do not want our skybox to move around.
-    // Keep same time uniform for skybox so it freezes consistently when paused
-    noLightShader.SendUniform<float>("timeSeconds", shaderTime * 0.25f);
-    noLightShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * skyBox.GetModelMatrix());
-    window.DrawActor(sphereMesh, skyboxTexture);
-
-    // Draw orbit guides last using the REAL camera view (not skybox view without translation)
-    glm::mat4 viewMatrixForOrbits = camera.GetViewMatrix();
-    DrawOrbitPaths(projection, viewMatrixForOrbits);
-
-    DrawFollowHud();
+        window.SetBlend(true);
+        window.SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+        window.SetDepthFunc(GL_LESS);
+        window.SetDepthMask(true);
+        // Lower quality levels skip overlays that only cover a few pixels
+        const float overlayMinPixels = qualityGovernor.GetSettings().overlayMinPixels;
+        for (size_t i = 0; i < bodies.size(); ++i)
+        {
+            const SceneBody& body = scene.bodies[i];
+            const BodyTextures& textures = bodyTextures[i];
+            const glm::vec3 position = GetBodyWorldPosition(i);
+            const float atmosphereRadius = bodies[i].GetScale() * body.atmosphereScale;
+            if (textures.atmosphere >= 0 && GetProjectedRadius(position, atmosphereRadius) >= overlayMinPixels)
+            {
+                // The body's own transform, slightly enlarged, so the haze turns with the surface
+                glm::mat4 model = glm::scale(bodies[i].GetModelMatrix(), glm::vec3(body.atmosphereScale));
+                window.UseShader(overlayShader);
+                overlayShader.SendUniform<float>("overlayAlpha", body.atmosphereAlpha);
+                overlayShader.SendUniform<glm::vec3>("colorTint", body.atmosphereTint);
+                overlayShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
+                overlayShader.SendUniform<glm::mat4>("modelMatrix", model);
+                overlayShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
+                window.DrawActor(SelectSphereMesh(position, atmosphereRadius), sceneTextures[textures.atmosphere]);
+            }
+
+            if (textures.ring >= 0 && GetProjectedRadius(position, bodies[i].GetScale() * body.ringOuter) >= overlayMinPixels)
+            {
+                glm::mat4 model = glm::mat4(1.0f);
+                model = glm::translate(model, position);
+                model = glm::scale(model, glm::vec3(bodies[i].GetScale()));
+                // Tilt the ring plane about X, then Z; it ignores the body's own spin
+                if (body.ringTiltDeg.x != 0.0f)
+                {
+                    model = glm::rotate(model, glm::radians(body.ringTiltDeg.x), glm::vec3(1,0,0));
+                }
+                if (body.ringTiltDeg.y != 0.0f)
+                {
+                    model = glm::rotate(model, glm::radians(body.ringTiltDeg.y), glm::vec3(0,0,1));
+                }
+                // Apply ring outer radius and thin in Y
+                model = glm::scale(model, glm::vec3(body.ringOuter, 0.001f, body.ringOuter));
+                window.UseShader(overlayShader);
+                overlayShader.SendUniform<float>("overlayAlpha", body.ringAlpha);
+                overlayShader.SendUniform<glm::vec3>("colorTint", body.ringTint);
+                // No UV wobble; the shimmer slightly rotates the model around Y when not paused
+                if (!isPaused && body.ringSpinDeg != 0.0f)
+                {
+                    model = glm::rotate(model, glm::radians(body.ringSpinDeg) * deltatime * timeSpeed, glm::vec3(0,1,0));
+                }
+                overlayShader.SendUniform<glm::mat4>("MVP", projection * viewMatrix * model);
+                overlayShader.SendUniform<glm::mat4>("modelMatrix", model);
+                overlayShader.SendUniform<glm::mat3>("normalMatrix", glm::mat3(glm::transpose(glm::inverse(model))));
+                window.DrawActor(ringMeshes[bodyRingMeshes[i]], sceneTextures[textures.ring]);
+            }
+        }
+    }
+
+    // Draw orbit guides last so they blend over everything
+    {
+        PROFILE_PASS(profiler, "Orbits");
+        DrawOrbitPaths(projection, viewMatrix);
+    }
+    {
+        PROFILE_PASS(profiler, "Trails");
+        DrawTrails(viewProjection);
+    }
+    UpscaleScene();
+
+    PROFILE_PASS(profiler, "HUD");
+    DrawHud(viewProjection);
 }
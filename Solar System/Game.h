@@ -1,70 +1,180 @@
 #pragma once
 #include <string>
 #include "Window.h"
+#include "Settings.h"
 #include "ShaderProgram.h"
+#include "SurfaceShaders.h"
 #include "Actor.h"
 #include "Planet.h"
 #include "Camera.h"
 #include "Mesh.h"
 #include "Texture.h"
 #include "Orbital.h"
+#include "Skybox.h"
+#include "AsteroidBelt.h"
+#include "AsteroidRenderer.h"
+#include "LaunchOptions.h"
+#include "Profiler.h"
+#include "QualityGovernor.h"
+#include "DynamicResolution.h"
+#include "FramePacer.h"
+#include "FrameLatency.h"
+#include "InputRecorder.h"
+#include "TextRenderer.h"
+#include "OrbitRenderer.h"
+#include "TrailRenderer.h"
+#include "JobSystem.h"
+#include "TextureStreamer.h"
+#include "AssetPack.h"
+#include "SceneDescription.h"
 #include <vector>
+#include <future>
+#include <chrono>
 // Coordinates initialization, per-frame update, and rendering of the solar system.
-// Owns window/GL context, shaders, meshes, textures, camera and planet state.
-// Handles input (movement/time controls) and draws opaque bodies, overlays, and skybox.
+// Owns window/GL context, shaders, meshes, textures, camera and the state of the bodies the scene file describes.
+// Handles input (movement/time controls) and draws opaque bodies, skybox, and overlays.
 //A class that represents the game simulation and handles the logic/render loop.
 class Game
 {
+public:
+	struct FrameRecord
+	{
+		double simulatedSeconds; // frame time accumulated before this frame
+		float cpuMs;             // update + draw submission
+		float frameMs;           // until the frame is presented (headless: finished on the GPU)
+		unsigned int drawCalls;
+		unsigned long long triangles;
+		unsigned int stateChangesIssued; // GL state calls that reached the driver
+		unsigned int stateChangesElided; // redundant GL state calls skipped by the window
+		int qualityLevel;                // QualityGovernor level the frame was drawn at, 0 = full detail
+		float renderScale;               // share of the framebuffer width/height the scene was rendered at
+		float latencyMs;                 // input-to-present latency averaged over the last half second (a few frames behind)
+	};
 public:
 	Game(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight,
-		const std::string title, struct GLFWmonitor* monitor = nullptr, struct GLFWwindow* share = nullptr);
+		const std::string title, const LaunchOptions& options = LaunchOptions{}, struct GLFWmonitor* monitor = nullptr, struct GLFWwindow* share = nullptr);
+	~Game() noexcept;			//Writes the frame statistics file if one was requested, frees the overdraw queries.
 	void Tick();				//Updates the game and draws a frame.
 	bool ShouldClose() const;	//Returns whether or not the window is flagged for closing.
+public:
+	//Scripting hooks: let benchmarks drive the scene directly instead of through keyboard and mouse.
+	void SetCameraPose(const glm::vec3& position, float yaw, float pitch);
+	void SetCameraLookAt(const glm::vec3& eye, const glm::vec3& target);
+	void SetFollowTarget(int index);	//Follows the index-th body that is not a star, in scene order; -1 returns to the free camera.
+	int GetFollowTargetCount() const;
+	void SetShowOrbitPaths(bool show);
+	void SetShowBodyLabels(bool show);
+	void AddMinorBodyOrbits(int count, unsigned int seed);	//Random belt orbits for the orbit guides (stress tests).
+	void SetShowTrails(bool show);
+	void AddAsteroidTrails(int count);	//Trails behind count asteroids spread over the belt.
+	void SetTimeSpeed(float speed);
+	const SceneDescription& GetScene() const;
+	glm::vec3 GetBodyWorldPosition(size_t index) const;	//Index into GetScene().bodies.
+	const std::vector<FrameRecord>& GetFrameRecords() const;	//Filled when statsPath or recordFrames is set.
+	float GetTimeToFirstFrameMs() const;	//From construction until the first frame was presented (-1 before that).
+	float GetTimeToFullQualityMs() const;	//From construction until the last streamed texture was uploaded (-1 before that).
 private:
-	struct FollowTargetEntry;
+	enum class OpaquePass { Depth, Shaded, Overdraw };
 	void Update(float deltatime);
 	void Draw(float deltatime);
+	void BuildOpaqueQueue();
+	float GetProjectedRadius(const glm::vec3& center, float radius) const;	//Pixels on screen, ignoring the frustum.
+	const Mesh& SelectSphereMesh(const glm::vec3& center, float radius) const;	//Coarsest level within the quality's error.
+	void DrawOpaqueQueue(const glm::mat4& viewProjection, OpaquePass pass);
+	void ReportOverdraw(float deltatime);
+	void LatchMouseLook();	//Low latency: applies the mouse movement made since Update right before drawing.
+	void StartInputRecording();	//--record / --replay.
+	bool IsFixedStep() const;	//Frames advance by set steps (--fixed-dt or a replay), not by the wall clock.
+	void UpscaleScene();	//Ends the scaled scene (dynamic resolution) so the HUD goes on top at native resolution.
+	bool ShouldRedraw();	//Render on demand: false while the window is hidden or the frame would look like the last one.
+	SceneDescription LoadSceneDescription() const;	//Exits when the scene cannot be read.
+	std::vector<Texture> RequestSceneTextures();	//Fills bodyTextures and asteroidTexture.
+	std::vector<unsigned int> GetScenePermutations() const;
+	static unsigned int GetSurfacePermutation(const SceneBody& body);
+	static Mesh CreateRingMesh(float innerRadius);	//Unit outer radius, in the XZ plane.
+	void InitializeBodies();
+	void ResetMoon(size_t moon);	//Back on its starting circle.
+	glm::mat4 BuildBodyModelMatrix(size_t index, const glm::vec3& position) const;	//Spin about the tilted axis, then scale.
+	std::future<MeshData> SubmitSphereMeshJob();	//No job (an invalid future) when the pack has the mesh.
+	Mesh LoadPackedMesh(const std::string& path) const;	//Falls back to the OBJ when the pack has no usable payload.
+	std::vector<std::future<MeshData>> SubmitAsteroidMeshJobs();
+	void FinishShaders();	//Waits for every program and reports build times; exits naming the programs that failed.
+	void SetupSurfaceUniforms(ShaderProgram& shader, unsigned int features);	//Lighting and sampler units of one permutation.
+	void RequestTextureDetail(const glm::mat4& projection, const glm::mat4& viewMatrix);	//Screen size of every streamed texture.
+	void UpdateStreaming();
+	float MillisecondsSinceStartup() const;
 	void InitializeFollowTargets();
 	void CycleFollowTarget();
 	void UpdateFollowCamera();
-	void UpdateFollowHud(const FollowTargetEntry& entry);
-	void DrawFollowHud();
+	void UpdateFollowHud(size_t body);
+	void UpdateProfilerHud();
+	void UpdateQualityHud();
+	void UpdateBodyLabels(const glm::mat4& viewProjection);
+	void DrawHud(const glm::mat4& viewProjection);	//Every label (follow info, profiler, body names) in one draw.
 	void InitializeHudResources();
 	void InitializeOrbitPaths();
 	void DrawOrbitPaths(const glm::mat4& projection, const glm::mat4& viewMatrix);
-	glm::vec3 GetPlanetWorldPosition(size_t index) const;
-	glm::vec3 GetFollowTargetPosition(const FollowTargetEntry& entry) const;
-	float GetFollowTargetRadius(const FollowTargetEntry& entry) const;
-	glm::vec3 ComputeFollowCameraPosition(const FollowTargetEntry& entry, const glm::vec3& targetPos) const;
-	glm::mat4 BuildMoonModelMatrix() const;
+	void InitializeTrails();
+	void UpdateTrails();
+	void DrawTrails(const glm::mat4& viewProjection);
+	glm::vec3 ComputeFollowCameraPosition(size_t body, const glm::vec3& targetPos) const;
+	void CaptureFrame();
+	void WriteFrameStats() const;
 private:
+	std::chrono::steady_clock::time_point startupBegin = std::chrono::steady_clock::now();	//Declared first: origin of the startup timings.
+	LaunchOptions options;
 	Window window;	//Window must be constructed first, it initializes OpenGL context and GLFW window.
+	Profiler profiler;
+	bool showProfilerHud = false;
+	QualityGovernor qualityGovernor;
+	DynamicResolution dynamicResolution;
+	FramePacer framePacer;
+	FrameLatency frameLatency;
+	InputRecorder inputRecorder;
+	Window::InputState inputState;	//This frame's input while recording or replaying; the window answers from it.
+	bool renderOnDemand;		//Frames are left out while nothing on screen would change.
+	Window::DrawStatistics lastDrawStatistics;	//Statistics of the last presented frame, for the profiler HUD.
+	float timeToFirstFrameMs = -1.0f;
+	float timeToFullQualityMs = -1.0f;
 private:
-	ShaderProgram defaultShader;
-	ShaderProgram noLightShader;
-	ShaderProgram earthShader;
-	ShaderProgram overlayShader; // translucent overlays (atmospheres, rings)
+	// Disk assets are requested before the shaders so that decoding and mesh generation run on the workers
+	// while the shaders compile; textures show a placeholder until the streamer has uploaded them.
+	// Whatever the asset pack holds is read from its mapping instead of the loose files.
+	AssetPack assetPack;
+	JobSystem jobSystem;
+	TextureStreamer textureStreamer;
+	SceneDescription scene;              // read first: it names the textures
+	struct BodyTextures
+	{
+		int albedo, night, specular, clouds, atmosphere, ring; // into sceneTextures, -1 when the body has none
+	};
+	std::vector<BodyTextures> bodyTextures; // one per scene body
+	int asteroidTexture = -1;
+	std::vector<Texture> sceneTextures;  // every file once, shared by the bodies that name it
+	std::future<MeshData> sphereMeshData;                 // consumed at the end of construction
+	std::vector<std::future<MeshData>> asteroidMeshData;
+private:
+	SurfaceShaders surfaceShaders; // uber-shader permutations the scene's bodies use, plus the overlays
 	ShaderProgram textShader;
 	ShaderProgram orbitShader;
+	ShaderProgram skyboxShader;
+	ShaderProgram depthShader;     // position-only, depth prepass
+	ShaderProgram overdrawShader;  // additive constant color, overdraw view
+	ShaderProgram asteroidShader;          // asteroid.vert with surface.frag (RIM_LIGHT), depth.frag, overdraw.frag
+	ShaderProgram asteroidDepthShader;
+	ShaderProgram asteroidOverdrawShader;
+	ShaderProgram upscaleShader;   // dynamic resolution: stretches the scaled scene over the framebuffer
 	Camera camera;
 	Mesh sphereMesh;            // shared sphere geometry
-	Mesh ringMesh;              // unit ring in XZ plane; scaled per planet
-	std::vector<Texture> planetTextures; // sun + planet albedo maps
-	std::vector<Planet> planets;         // orbital/self-rotation state
-	Texture earthNightTexture;
-	Texture earthSpecularTexture;
-	Texture earthCloudsTexture;
-	Texture venusAtmosphereTexture;
-	Texture saturnRingTexture;
-	Texture moonTexture;
-	Texture uranusRingTexture;
-	Actor skyBox;
-	Texture skyboxTexture;
-	Actor venusAtmosphere;
-	Actor saturnRings;
-	Actor uranusRings;
-	Actor moon;
-	float moonOrbitDeg = 0.0f;
+	static constexpr int sphereLodSlices[] = { 64, 32, 16 }; // coarser stand-ins for sphere.obj's 128 slices
+	std::vector<Mesh> sphereLods; // one per entry of sphereLodSlices
+	std::vector<Mesh> ringMeshes;       // unit rings in the XZ plane, one per inner radius; scaled per body
+	std::vector<float> ringMeshInnerRadii;
+	std::vector<int> bodyRingMeshes;    // into ringMeshes, -1 without a ring
+	std::vector<Planet> bodies;         // one per scene body: model matrix (stars spin themselves)
+	std::vector<unsigned int> bodyPermutations; // SurfaceShaders features of each body
+	std::vector<std::string> bodyDisplayNames;  // upper case, for the HUD and the labels
+	Skybox skybox;
 	glm::vec2 lastMousePosition;
 	float lastTime;
 	float shaderTime = 0.0f; // accumulates only when not paused for stable pause state
@@ -72,57 +182,66 @@ private:
 	bool isPaused = false;   // pause flag; freezes celestial motion but camera still moves
 	double simulationTimeSec = 0.0; // advances when not paused
 	// Asteroid belt
-	struct Asteroid { float radius; float angleDeg; float angularSpeedDeg; glm::vec3 scale; glm::vec3 offset; float spinDeg; glm::vec3 spinAxis; float spinSpeedDeg; int meshIndex; };
-	std::vector<Asteroid> asteroids;
-	std::vector<Mesh> asteroidMeshes; // small pool of irregular rock meshes
-	Texture asteroidTexture;
-	unsigned int textVAO = 0;
-	unsigned int textVBO = 0;
-	std::vector<float> hudVertices;
+	AsteroidBelt asteroidBelt;
+	MeshBatch asteroidMeshes; // pool of irregular rock meshes, in one set of buffers
+	std::vector<glm::mat4> asteroidModelMatrices; // rebuilt every frame, shared by all opaque passes
+	AsteroidRenderer asteroidRenderer; // same rocks, one shape each, displaced on the GPU
+	bool asteroidDisplacement = settings::asteroidShaderDisplacement; // draw the belt with asteroidRenderer
+	TextRenderer textRenderer;
+	int followHudLabel = -1;
+	int followHudTarget = -1;	// follow target the label text was built for
+	int profilerHudLabel = -1;
+	int qualityHudLabel = -1;
+	std::vector<int> bodyLabels; // one per follow target
+	bool showBodyLabels = false;
 	glm::mat4 hudProjection = glm::mat4(1.0f);
-	struct PlanetHudInfo
-	{
-		std::string name;
-		float orbitRadiusMillionKm;
-		float orbitSpeedKmPerSec;
-		float rotationPeriodHours;
-		bool retrograde;
-	};
-	std::vector<PlanetHudInfo> planetHudData;
-	PlanetHudInfo moonHudData;
-	std::string followHudText;
-	struct OrbitPath
-	{
-		unsigned int vao = 0;
-		unsigned int vbo = 0;
-		GLsizei vertexCount = 0;
-		float radius = 0.0f;
-		glm::vec3 color = glm::vec3(0.6f);
-	};
-	std::vector<OrbitPath> orbitPaths;
-	OrbitPath moonOrbitPath;
+	OrbitRenderer orbitRenderer;
+	std::vector<int> bodyOrbitPaths;   // orbit renderer path per body (-1 for stars)
+	TrailRenderer trailRenderer;
+	std::vector<int> bodyTrails;       // one per follow target
+	std::vector<size_t> trailedAsteroids;
+	std::vector<int> asteroidTrails;   // parallel to trailedAsteroids
+	bool showTrails = false;
 	bool showOrbitPaths = false;
-	// Kepler elements per planet index (matching textures/planets vector indices)
-	std::vector<OrbitalElements> planetElements; // size planets.size(); [1..8] valid
-	std::vector<float> planetSelfRotationDeg;     // accumulate self rotation per planet (1..8)
-	std::vector<float> planetRotationSpeedDeg;    // rotation speed per planet (deg/sec equivalent of legacy)
-	std::vector<float> planetObliquityDeg;        // axial tilt per planet
-	// N-body Moon state (Earth + optional Sun acceleration)
+	// Kepler elements per body (planets; scaled to scene units)
+	std::vector<OrbitalElements> bodyElements;
+	std::vector<float> bodySelfRotationDeg;      // accumulated self rotation per planet and moon
+	// N-body moons, each around its planet
 	double lastSimTimeSec = 0.0;
-	float muEarth = 0.0f;
-	float muSun = 0.0f;
-	glm::vec3 moonRelPos = glm::vec3(0.0f); // Moon position relative to Earth
-	glm::vec3 moonRelVel = glm::vec3(0.0f); // Moon velocity relative to Earth
-	struct FollowTargetEntry
+	struct MoonState
 	{
-		enum class Kind { Planet, Moon } kind;
-		size_t index;
+		size_t body;
+		float mu;                  // parent's gravitational parameter, from the moon's orbit radius and period
+		glm::vec3 relativePosition;
+		glm::vec3 relativeVelocity;
 	};
-	std::vector<FollowTargetEntry> followTargets;
+	std::vector<MoonState> moons;
+	std::vector<size_t> followTargets; // bodies that are not stars, in scene order
 	int followTargetIndex = -1;
 	glm::vec3 savedCameraPosition;
 	float savedCameraYaw = 0.0f;
 	float savedCameraPitch = 0.0f;
 	bool hasSavedCameraPose = false;
-	glm::mat4 moonModelMatrix = glm::mat4(1.0f);
+	// Opaque render queue, sorted front to back every frame
+	struct OpaqueDraw
+	{
+		enum class Kind { Body, Asteroid } kind;
+		size_t index;
+		float distance; // camera distance to the bounding sphere's surface
+		unsigned int permutation; // SurfaceShaders features of the shaded pass
+		const Mesh* mesh; // sphere level of detail, the same in every pass; nullptr for rocks of asteroidMeshes
+	};
+	std::vector<OpaqueDraw> opaqueQueue;
+	std::vector<OpaqueDraw> shadedQueue; // opaqueQueue grouped by permutation, used after a depth prepass
+	bool depthPrepass = settings::depthPrepass;
+	bool overdrawView = false;
+	unsigned int overdrawQueries[2] = { 0, 0 }; // GL_SAMPLES_PASSED, read back one frame late
+	int overdrawFrame = 0;
+	double overdrawAccumulated = 0.0;
+	int overdrawAccumulatedFrames = 0;
+	float overdrawReportTimer = 0.0f;
+	// Run control and per-frame statistics (see LaunchOptions)
+	std::vector<FrameRecord> frameRecords;
+	int frameIndex = 0;
+	double elapsedFrameSeconds = 0.0;
 };
\ No newline at end of file
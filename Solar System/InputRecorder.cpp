@@ -0,0 +1,196 @@
+// InputRecorder: binary input log of a session and its replay.
+#include "InputRecorder.h"
+#include <cstring>
+#include <iostream>
+#include <iterator>
+#include <sstream>
+
+namespace {
+    constexpr char magic[4] = { 'S', 'S', 'I', 'R' };
+    constexpr uint32_t version = 1;
+    constexpr uint16_t mouseMovedBit = 0x8000;
+    constexpr size_t headerSize = sizeof(magic) + sizeof(uint32_t) + 2 * sizeof(float);
+
+    template <typename T>
+    void Append(std::vector<unsigned char>& bytes, const T& value)
+    {
+        const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+        bytes.insert(bytes.end(), data, data + sizeof(T));
+    }
+
+    template <typename T>
+    bool Read(const std::vector<unsigned char>& bytes, size_t& offset, T& value)
+    {
+        if (bytes.size() - offset < sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&value, bytes.data() + offset, sizeof(T));
+        offset += sizeof(T);
+        return true;
+    }
+}
+
+bool InputRecorder::StartRecording(const std::string& path, const glm::vec2& initialMousePosition)
+{
+    recordFile.open(path, std::ios::binary | std::ios::trunc);
+    if (!recordFile)
+    {
+        std::cout << "Could not write input recording: " << path << "\n";
+        return false;
+    }
+    std::vector<unsigned char> header;
+    header.insert(header.end(), std::begin(magic), std::end(magic));
+    Append(header, version);
+    Append(header, initialMousePosition.x);
+    Append(header, initialMousePosition.y);
+    recordFile.write(reinterpret_cast<const char*>(header.data()), (std::streamsize)header.size());
+    mode = Mode::Record;
+    this->path = path;
+    this->initialMousePosition = initialMousePosition;
+    previousState = Window::InputState{};
+    previousState.mousePosition = initialMousePosition;
+    frameIndex = 0;
+    return true;
+}
+
+bool InputRecorder::StartReplay(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Could not read input recording: " << path << "\n";
+        return false;
+    }
+    replayData.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    uint32_t fileVersion = 0;
+    size_t offset = sizeof(magic);
+    if (replayData.size() < headerSize || std::memcmp(replayData.data(), magic, sizeof(magic)) != 0
+        || !Read(replayData, offset, fileVersion) || fileVersion != version)
+    {
+        std::cout << "Not an input recording (or of another version): " << path << "\n";
+        replayData.clear();
+        return false;
+    }
+    Read(replayData, offset, initialMousePosition.x);
+    Read(replayData, offset, initialMousePosition.y);
+    //Walk the frames once: a damaged file is reported now rather than halfway through the replay.
+    previousState = Window::InputState{};
+    previousState.mousePosition = initialMousePosition;
+    Window::InputState scratch = previousState;
+    replayFrameCount = 0;
+    replayOffset = offset;
+    float deltaSeconds = 0.0f;
+    while (offset < replayData.size())
+    {
+        if (!DecodeFrame(offset, deltaSeconds, scratch))
+        {
+            std::cout << "Input recording ends in the middle of a frame, replaying the first " << replayFrameCount << ": " << path << "\n";
+            break;
+        }
+        ++replayFrameCount;
+    }
+    mode = Mode::Replay;
+    this->path = path;
+    frameIndex = 0;
+    return true;
+}
+
+void InputRecorder::RecordFrame(float deltaSeconds, const Window::InputState& state)
+{
+    if (mode != Mode::Record)
+    {
+        return;
+    }
+    const std::bitset<Window::keyCount> changed = state.keys ^ previousState.keys;
+    const bool mouseMoved = state.mousePosition != previousState.mousePosition;
+    std::vector<unsigned char> bytes;
+    Append(bytes, deltaSeconds);
+    Append(bytes, (uint16_t)(changed.count() | (mouseMoved ? mouseMovedBit : 0)));
+    if (mouseMoved)
+    {
+        Append(bytes, state.mousePosition.x);
+        Append(bytes, state.mousePosition.y);
+    }
+    for (uint16_t key = 0; key < Window::keyCount; ++key)
+    {
+        if (changed[key])
+        {
+            Append(bytes, key);
+        }
+    }
+    recordFile.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+    if (!recordFile)
+    {
+        std::cout << "Could not write input recording, stopped after " << frameIndex << " frames: " << path << "\n";
+        mode = Mode::Off;
+        return;
+    }
+    previousState = state;
+    ++frameIndex;
+}
+
+bool InputRecorder::ReplayFrame(float& deltaSeconds, Window::InputState& state)
+{
+    if (mode != Mode::Replay || frameIndex >= replayFrameCount)
+    {
+        return false;
+    }
+    DecodeFrame(replayOffset, deltaSeconds, previousState);
+    state = previousState;
+    ++frameIndex;
+    return true;
+}
+
+bool InputRecorder::DecodeFrame(size_t& offset, float& deltaSeconds, Window::InputState& state) const
+{
+    uint16_t header = 0;
+    if (!Read(replayData, offset, deltaSeconds) || !Read(replayData, offset, header))
+    {
+        return false;
+    }
+    if ((header & mouseMovedBit) != 0
+        && (!Read(replayData, offset, state.mousePosition.x) || !Read(replayData, offset, state.mousePosition.y)))
+    {
+        return false;
+    }
+    for (int i = 0; i < (header & ~mouseMovedBit); ++i)
+    {
+        uint16_t key = 0;
+        if (!Read(replayData, offset, key) || key >= Window::keyCount)
+        {
+            return false;
+        }
+        state.keys.flip(key);
+    }
+    return true;
+}
+
+bool InputRecorder::IsRecording() const
+{
+    return mode == Mode::Record;
+}
+
+bool InputRecorder::IsReplaying() const
+{
+    return mode == Mode::Replay;
+}
+
+glm::vec2 InputRecorder::GetInitialMousePosition() const
+{
+    return initialMousePosition;
+}
+
+std::string InputRecorder::GetHudText() const
+{
+    std::ostringstream oss;
+    if (mode == Mode::Record)
+    {
+        oss << "RECORDING INPUT  " << frameIndex << " FRAMES";
+    }
+    else if (mode == Mode::Replay)
+    {
+        oss << "REPLAYING INPUT  " << frameIndex << " / " << replayFrameCount << " FRAMES";
+    }
+    return oss.str();
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <glm/vec2.hpp>
+#include "Window.h"
+// Input recording and replay: a session is stored as the window's input state (every key and the cursor) and
+// the time step of each frame, so replaying it with the same steps puts the simulation and the camera through
+// exactly the same frames. Recording streams to the file as frames go by; a replay is read whole at the start.
+// File layout, in the machine's byte order:
+//   header: "SSIR", uint32 version, float initial mouse x, y
+//   frame:  float deltaSeconds, uint16 (bit 15: the mouse moved, bits 0-14: keys that changed),
+//           [float mouse x, y when it moved], uint16 key code per changed key
+// An idle frame takes 6 bytes.
+class InputRecorder
+{
+public:
+	InputRecorder() = default;
+	InputRecorder(const InputRecorder& other) = delete;				//No copy construction allowed.
+	InputRecorder& operator=(const InputRecorder& other) = delete;	//No copy assignment allowed.
+	bool StartRecording(const std::string& path, const glm::vec2& initialMousePosition);
+	bool StartReplay(const std::string& path);	//Reads and checks the whole file.
+	void RecordFrame(float deltaSeconds, const Window::InputState& state);
+	bool ReplayFrame(float& deltaSeconds, Window::InputState& state);	//The next frame; false once the replay is over.
+	bool IsRecording() const;
+	bool IsReplaying() const;
+	glm::vec2 GetInitialMousePosition() const;	//The cursor when the recording started.
+	std::string GetHudText() const;	//One line: mode, frames so far (and of the replay).
+private:
+	bool DecodeFrame(size_t& offset, float& deltaSeconds, Window::InputState& state) const;	//false when the data ends early.
+private:
+	enum class Mode { Off, Record, Replay };
+	Mode mode = Mode::Off;
+	std::string path;
+	glm::vec2 initialMousePosition = glm::vec2(0.0f);
+	Window::InputState previousState;	//Frames only store what changed since this one.
+	unsigned long long frameIndex = 0;	//Frames recorded or replayed so far.
+	unsigned long long replayFrameCount = 0;
+	std::ofstream recordFile;
+	std::vector<unsigned char> replayData;
+	size_t replayOffset = 0;
+};
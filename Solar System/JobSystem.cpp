@@ -0,0 +1,62 @@
+// JobSystem: fixed pool of worker threads draining one FIFO queue.
+#include "JobSystem.h"
+#include <algorithm>
+
+JobSystem::JobSystem(int workerCount)
+{
+    if (workerCount <= 0)
+    {
+        //hardware_concurrency may report 0 when unknown; keep at least one worker.
+        workerCount = std::max((int)std::thread::hardware_concurrency() - 1, 1);
+    }
+    workers.reserve(workerCount);
+    for (int i = 0; i < workerCount; ++i)
+    {
+        workers.emplace_back(&JobSystem::WorkerLoop, this);
+    }
+}
+
+JobSystem::~JobSystem() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        stopping = true;
+    }
+    queueCondition.notify_all();
+    for (std::thread& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+int JobSystem::GetWorkerCount() const
+{
+    return (int)workers.size();
+}
+
+void JobSystem::Enqueue(std::function<void()> job)
+{
+    {
+        std::lock_guard<std::mutex> lock(queueMutex);
+        queue.push_back(std::move(job));
+    }
+    queueCondition.notify_one();
+}
+
+void JobSystem::WorkerLoop()
+{
+    for (;;)
+    {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(queueMutex);
+            queueCondition.wait(lock, [this]() { return stopping || !queue.empty(); });
+            //Queued jobs still run when stopping, so no future is left without a value.
+            if (queue.empty())
+                return;
+            job = std::move(queue.front());
+            queue.pop_front();
+        }
+        job();
+    }
+}
@@ -0,0 +1,43 @@
+#pragma once
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+// Small pool of worker threads for CPU work that never touches OpenGL (image decoding, mesh generation).
+// Jobs start in submission order on whichever worker is free; results come back through std::future,
+// and whatever needs the GL context is finished by the thread that owns it.
+class JobSystem
+{
+public:
+	explicit JobSystem(int workerCount = 0);			//0 = one worker per hardware thread, minus the GL thread.
+	JobSystem(const JobSystem& other) = delete;				//No copy construction allowed.
+	JobSystem& operator=(const JobSystem& other) = delete;	//No copy assignment allowed.
+	~JobSystem() noexcept;									//Runs the jobs still queued, then joins the workers.
+	template<typename Function>
+	auto Submit(Function&& function) -> std::future<decltype(function())>;
+	int GetWorkerCount() const;
+private:
+	void Enqueue(std::function<void()> job);
+	void WorkerLoop();
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> queue;
+	std::mutex queueMutex;
+	std::condition_variable queueCondition;
+	bool stopping = false;
+};
+
+template<typename Function>
+auto JobSystem::Submit(Function&& function) -> std::future<decltype(function())>
+{
+	//std::function needs a copyable target, so the packaged task is shared with the queued wrapper.
+	using Result = decltype(function());
+	auto task = std::make_shared<std::packaged_task<Result()>>(std::forward<Function>(function));
+	std::future<Result> result = task->get_future();
+	Enqueue([task]() { (*task)(); });
+	return result;
+}
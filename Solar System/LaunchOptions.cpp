@@ -0,0 +1,162 @@
+// Command line parsing for LaunchOptions.
+#include "LaunchOptions.h"
+#include <iostream>
+#include <cstdlib>
+
+namespace {
+    void PrintUsage(const char* program)
+    {
+        std::cout << "Usage: " << program << " [options]\n"
+            << "  --headless             render offscreen, no window or display needed\n"
+            << "  --frames N             stop after N frames\n"
+            << "  --duration SECONDS     stop after SECONDS of simulated frame time\n"
+            << "  --fixed-dt SECONDS     fixed frame step (default 1/60 when headless)\n"
+            << "  --capture DIRECTORY    write frames as PPM images into DIRECTORY\n"
+            << "  --capture-every N      capture every N-th frame (default 1)\n"
+            << "  --stats FILE           write per-frame timings as CSV\n"
+            << "  --trace FILE           record CPU/GPU profiler scopes as a Chrome trace\n"
+            << "  --scene FILE           build the scene from FILE (.scene text or binary) instead of the solar system\n"
+            << "  --asteroids N          number of asteroids, shared among the scene's belts (stress testing)\n"
+            << "  --no-asset-pack        load the loose files under Resources instead of the asset pack\n"
+            << "  --quality auto|LEVEL   adapt detail to the frame time even with a fixed step, or pin a level (0 = full)\n"
+            << "  --render-scale auto|S  adapt the scene resolution to the GPU time even with a fixed step, or pin it (0.5 - 1)\n"
+            << "  --fps N                cap the frame rate at N frames per second (0 = no cap)\n"
+            << "  --no-vsync             present without waiting for the display's refresh\n"
+            << "  --always-render        redraw every frame even while nothing changes\n"
+            << "  --low-latency          limit the frames queued on the GPU and late-latch the mouse look\n"
+            << "  --record FILE          record the keyboard, mouse and frame steps of the session into FILE\n"
+            << "  --replay FILE          replay a recorded session with its frame steps instead of live input\n";
+    }
+
+    bool ParseNumber(const char* text, double& value)
+    {
+        char* end = nullptr;
+        value = std::strtod(text, &end);
+        return end != text && *end == '\0';
+    }
+}
+
+bool ParseLaunchOptions(int argc, char** argv, LaunchOptions& options)
+{
+    bool fixedDeltaGiven = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        //Options that take a value.
+        bool hasValue = i + 1 < argc;
+        double number = 0.0;
+        if (arg == "--headless")
+        {
+            options.headless = true;
+        }
+        else if (arg == "--frames" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.frameCount = (int)number;
+            ++i;
+        }
+        else if (arg == "--duration" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.durationSeconds = (float)number;
+            ++i;
+        }
+        else if (arg == "--fixed-dt" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.fixedDeltaTime = (float)number;
+            fixedDeltaGiven = true;
+            ++i;
+        }
+        else if (arg == "--capture" && hasValue)
+        {
+            options.captureDirectory = argv[++i];
+        }
+        else if (arg == "--capture-every" && hasValue && ParseNumber(argv[i + 1], number) && number >= 1.0)
+        {
+            options.captureInterval = (int)number;
+            ++i;
+        }
+        else if (arg == "--stats" && hasValue)
+        {
+            options.statsPath = argv[++i];
+        }
+        else if (arg == "--trace" && hasValue)
+        {
+            options.tracePath = argv[++i];
+        }
+        else if (arg == "--scene" && hasValue)
+        {
+            options.scenePath = argv[++i];
+        }
+        else if (arg == "--asteroids" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.asteroidCount = (int)number;
+            ++i;
+        }
+        else if (arg == "--no-asset-pack")
+        {
+            options.useAssetPack = false;
+        }
+        else if (arg == "--quality" && hasValue && std::string(argv[i + 1]) == "auto")
+        {
+            options.governQuality = true;
+            ++i;
+        }
+        else if (arg == "--quality" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.qualityLevel = (int)number;
+            ++i;
+        }
+        else if (arg == "--render-scale" && hasValue && std::string(argv[i + 1]) == "auto")
+        {
+            options.governRenderScale = true;
+            ++i;
+        }
+        else if (arg == "--render-scale" && hasValue && ParseNumber(argv[i + 1], number) && number > 0.0 && number <= 1.0)
+        {
+            options.renderScale = (float)number;
+            ++i;
+        }
+        else if (arg == "--fps" && hasValue && ParseNumber(argv[i + 1], number) && number >= 0.0)
+        {
+            options.targetFps = (float)number;
+            ++i;
+        }
+        else if (arg == "--no-vsync")
+        {
+            options.vsync = false;
+        }
+        else if (arg == "--always-render")
+        {
+            options.renderOnDemand = false;
+        }
+        else if (arg == "--low-latency")
+        {
+            options.lowLatency = true;
+        }
+        else if (arg == "--record" && hasValue)
+        {
+            options.recordPath = argv[++i];
+        }
+        else if (arg == "--replay" && hasValue)
+        {
+            options.replayPath = argv[++i];
+        }
+        else
+        {
+            std::cout << "Invalid argument: " << arg << "\n";
+            PrintUsage(argv[0]);
+            return false;
+        }
+    }
+    if (!options.recordPath.empty() && !options.replayPath.empty())
+    {
+        std::cout << "--record and --replay cannot be combined.\n";
+        PrintUsage(argv[0]);
+        return false;
+    }
+    //Headless runs are for measurements and captures, so make them reproducible by default.
+    if (options.headless && !fixedDeltaGiven)
+    {
+        options.fixedDeltaTime = 1.0f / 60.0f;
+    }
+    return true;
+}
@@ -0,0 +1,32 @@
+#pragma once
+#include <string>
+// Command line options that change how the simulation is run (as opposed to Settings.h, which tunes the scene).
+// Running without arguments behaves exactly like before: a visible window driven by the wall clock.
+struct LaunchOptions
+{
+	bool headless = false;			//Render into an offscreen framebuffer without a visible window (EGL surfaceless when available).
+	int frameCount = 0;				//Stop after this many frames (0 = no limit).
+	float durationSeconds = 0.0f;	//Stop once this much frame time has been simulated (0 = no limit).
+	float fixedDeltaTime = 0.0f;	//Advance every frame by this many seconds instead of the wall clock (0 = wall clock).
+	std::string captureDirectory;	//Write rendered frames into this directory as PPM images (empty = off).
+	int captureInterval = 1;		//Capture every N-th frame.
+	std::string statsPath;			//Write per-frame timings to this CSV file (empty = off).
+	std::string tracePath;			//Record a Chrome trace of the whole run into this file (empty = off).
+	bool recordFrames = false;		//Keep per-frame timings in memory without writing them (benchmarks read them back).
+	std::string scenePath;			//Scene to build, text or binary (empty = settings::scenePath).
+	int asteroidCount = -1;			//Asteroids over all of the scene's belts (-1 = as the scene says), for stress runs.
+	bool useAssetPack = true;		//Read assets from the asset pack when there is one (false = loose files only).
+	int qualityLevel = -1;			//Pin the scene quality to this level, 0 = full detail (-1 = governed by frame time).
+	bool governQuality = false;		//Let the quality governor adapt even with a fixed time step (off by default for reproducibility).
+	float renderScale = -1.0f;		//Pin the scene's render scale, 1 = native resolution (-1 = governed by GPU time).
+	bool governRenderScale = false;	//Let dynamic resolution adapt even with a fixed time step.
+	float targetFps = -1.0f;		//Frame rate cap, 0 = none (-1 = settings::targetFps).
+	bool vsync = true;				//Present on the display's refresh (when settings::vsync allows it).
+	bool renderOnDemand = true;		//Skip redrawing while nothing changes (when settings::renderOnDemand allows it).
+	bool lowLatency = false;		//Start in low latency mode even when settings::lowLatencyMode is off.
+	std::string recordPath;			//Record the keyboard and mouse input of every frame into this file (empty = off).
+	std::string replayPath;			//Drive the run from a recording, with its frame steps, and stop at its end (empty = off).
+};
+
+//Parses the command line into options. Prints the usage and returns false on unknown or malformed arguments.
+bool ParseLaunchOptions(int argc, char** argv, LaunchOptions& options);
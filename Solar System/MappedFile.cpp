@@ -0,0 +1,87 @@
+// MappedFile: read-only file mapping on POSIX and Windows.
+#include "MappedFile.h"
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path)
+{
+    if (path.empty())
+        return;
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+    LARGE_INTEGER fileSize;
+    if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0)
+    {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr)
+        {
+            data = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            size = (size_t)fileSize.QuadPart;
+        }
+    }
+    CloseHandle(file);  //The mapping keeps the file open.
+#else
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return;
+    struct stat status;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+    {
+        void* view = mmap(nullptr, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+        if (view != MAP_FAILED)
+        {
+            data = static_cast<const unsigned char*>(view);
+            size = (size_t)status.st_size;
+        }
+    }
+    close(file);        //The mapping keeps the file open.
+#endif
+    if (data == nullptr)
+        Close();
+}
+
+MappedFile::~MappedFile() noexcept
+{
+    Close();
+}
+
+bool MappedFile::IsOpen() const
+{
+    return data != nullptr;
+}
+
+const unsigned char* MappedFile::GetData() const
+{
+    return data;
+}
+
+size_t MappedFile::GetSize() const
+{
+    return size;
+}
+
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+    if (data != nullptr)
+        UnmapViewOfFile(data);
+    if (mapping != nullptr)
+        CloseHandle(mapping);
+#else
+    if (data != nullptr)
+        munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+    mapping = nullptr;
+}
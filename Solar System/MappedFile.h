@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <string>
+// Read-only memory mapping of a whole file (mmap, MapViewOfFile on Windows). Pages are read from disk when
+// they are first touched, so large files are "opened" instantly and never copied into a buffer.
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	explicit MappedFile(const std::string& path);	//Missing, empty or unreadable files leave it closed.
+	MappedFile(const MappedFile& other) = delete;				//No copy construction allowed.
+	MappedFile& operator=(const MappedFile& other) = delete;	//No copy assignment allowed.
+	~MappedFile() noexcept;										//Unmaps the file.
+	bool IsOpen() const;
+	const unsigned char* GetData() const;
+	size_t GetSize() const;
+	void Close();
+private:
+	const unsigned char* data = nullptr;
+	size_t size = 0;
+	void* mapping = nullptr;	//Windows file mapping handle.
+};
@@ -5,174 +5,332 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <vector>
-#include <map>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include "objload.h"
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SOLAR_NOISE_SSE2
+#include <emmintrin.h>
+#endif
 namespace {
     struct Tri { int a,b,c; };
-}
 
-Mesh Mesh::GenerateIcoSphere(int subdivisions, float radius)
-{
-    // Icosahedron vertices
-    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
-    std::vector<glm::vec3> v = {
-        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
-        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
-        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
-    };
-    for (auto &p : v) p = glm::normalize(p);
-    std::vector<Tri> f = {
-        {0,11,5},{0,5,1},{0,1,7},{0,7,10},{0,10,11},
-        {1,5,9},{5,11,4},{11,10,2},{10,7,6},{7,1,8},
-        {3,9,4},{3,4,2},{3,2,6},{3,6,8},{3,8,9},
-        {4,9,5},{2,4,11},{6,2,10},{8,6,7},{9,8,1}
-    };
-    auto midpoint = [&](int a, int b, std::map<long long,int>& cache)->int{
-        long long key = ((long long)std::min(a,b)<<32) | (long long)std::max(a,b);
-        auto it = cache.find(key);
-        if (it!=cache.end()) return it->second;
-        glm::vec3 m = glm::normalize((v[a]+v[b]) * 0.5f);
-        v.push_back(m);
-        int idx = (int)v.size()-1;
-        cache[key]=idx;
-        return idx;
+    // Midpoint of each edge during one subdivision step: open addressing over a flat, power-of-two table
+    // (the edge count of a level is known up front, so the table never grows).
+    class EdgeMidpoints
+    {
+    public:
+        explicit EdgeMidpoints(size_t edgeCount)
+        {
+            size_t capacity = 16;
+            while (capacity < edgeCount * 2)
+                capacity *= 2;
+            keys.assign(capacity, emptyKey);
+            values.resize(capacity);
+            mask = capacity - 1;
+        }
+        //Index of the midpoint of edge (a,b), added to vertices on first use.
+        int Get(int a, int b, std::vector<glm::vec3>& vertices)
+        {
+            uint64_t key = ((uint64_t)(uint32_t)std::min(a, b) << 32) | (uint32_t)std::max(a, b);
+            size_t slot = (size_t)((key * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+            while (keys[slot] != emptyKey)
+            {
+                if (keys[slot] == key)
+                    return values[slot];
+                slot = (slot + 1) & mask;
+            }
+            keys[slot] = key;
+            values[slot] = (int)vertices.size();
+            vertices.push_back(glm::normalize((vertices[a] + vertices[b]) * 0.5f));
+            return values[slot];
+        }
+    private:
+        static constexpr uint64_t emptyKey = ~0ull;
+        std::vector<uint64_t> keys;
+        std::vector<int> values;
+        size_t mask;
     };
-    for (int s=0; s<subdivisions; ++s) {
-        std::map<long long,int> cache;
+
+    // Unit icosahedron subdivided `subdivisions` times; shared vertices, projected to the sphere.
+    void SubdivideIcosahedron(int subdivisions, std::vector<glm::vec3>& v, std::vector<Tri>& f)
+    {
+        const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
+        v = {
+            {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
+            { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
+            { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+        };
+        for (auto &p : v) p = glm::normalize(p);
+        f = {
+            {0,11,5},{0,5,1},{0,1,7},{0,7,10},{0,10,11},
+            {1,5,9},{5,11,4},{11,10,2},{10,7,6},{7,1,8},
+            {3,9,4},{3,4,2},{3,2,6},{3,6,8},{3,8,9},
+            {4,9,5},{2,4,11},{6,2,10},{8,6,7},{9,8,1}
+        };
+        // Level s has 10*4^s+2 vertices and 20*4^s faces.
+        v.reserve(10 * ((size_t)1 << (2 * subdivisions)) + 2);
         std::vector<Tri> nf;
-        nf.reserve(f.size()*4);
-        for (auto &tr: f) {
-            int ab = midpoint(tr.a,tr.b,cache);
-            int bc = midpoint(tr.b,tr.c,cache);
-            int ca = midpoint(tr.c,tr.a,cache);
-            nf.push_back({tr.a,ab,ca});
-            nf.push_back({tr.b,bc,ab});
-            nf.push_back({tr.c,ca,bc});
-            nf.push_back({ab,bc,ca});
+        for (int s=0; s<subdivisions; ++s) {
+            EdgeMidpoints midpoints(f.size() * 3 / 2);
+            nf.clear();
+            nf.reserve(f.size()*4);
+            for (auto &tr: f) {
+                int ab = midpoints.Get(tr.a,tr.b,v);
+                int bc = midpoints.Get(tr.b,tr.c,v);
+                int ca = midpoints.Get(tr.c,tr.a,v);
+                nf.push_back({tr.a,ab,ca});
+                nf.push_back({tr.b,bc,ab});
+                nf.push_back({tr.c,ca,bc});
+                nf.push_back({ab,bc,ca});
+            }
+            f.swap(nf);
         }
-        f.swap(nf);
     }
-    // Build buffers (positions, trivial spherical UVs, vertex normals)
-    std::vector<glm::vec3> pos; pos.reserve(f.size()*3);
-    std::vector<glm::vec2> uv;  uv.reserve(f.size()*3);
-    std::vector<glm::vec3> nrm; nrm.reserve(f.size()*3);
-    for (auto &tr: f) {
-        int ids[3] = {tr.a,tr.b,tr.c};
-        for (int k=0;k<3;++k){
-            glm::vec3 p = glm::normalize(v[ids[k]]);
-            glm::vec3 n = p;
-            float u = 0.5f + atan2f(p.z, p.x) / (2.0f*3.14159265f);
-            float vtex = 0.5f - asinf(p.y)/3.14159265f;
-            pos.push_back(p * radius);
-            uv.push_back({u,vtex});
-            nrm.push_back(n);
+
+    float hash31(const glm::vec3& p)
+    {
+        glm::vec3 q = glm::fract(p * 0.3183099f + glm::vec3(0.71f, 0.113f, 0.419f));
+        glm::vec3 yzx = glm::vec3(q.y, q.z, q.x);
+        q += glm::dot(q, yzx + glm::vec3(19.19f));
+        return glm::fract((q.x + q.y) * q.z);
+    }
+
+    float noise3D(const glm::vec3& p)
+    {
+        // Simple value noise via hashing corners and trilinear mix
+        glm::vec3 i = glm::floor(p);
+        glm::vec3 f = p - i;
+        glm::vec3 u = f * f * (3.0f - 2.0f * f);
+        float n000 = hash31(i + glm::vec3(0,0,0));
+        float n001 = hash31(i + glm::vec3(0,0,1));
+        float n010 = hash31(i + glm::vec3(0,1,0));
+        float n011 = hash31(i + glm::vec3(0,1,1));
+        float n100 = hash31(i + glm::vec3(1,0,0));
+        float n101 = hash31(i + glm::vec3(1,0,1));
+        float n110 = hash31(i + glm::vec3(1,1,0));
+        float n111 = hash31(i + glm::vec3(1,1,1));
+        float nx00 = glm::mix(n000, n100, u.x);
+        float nx01 = glm::mix(n001, n101, u.x);
+        float nx10 = glm::mix(n010, n110, u.x);
+        float nx11 = glm::mix(n011, n111, u.x);
+        float nxy0 = glm::mix(nx00, nx10, u.y);
+        float nxy1 = glm::mix(nx01, nx11, u.y);
+        return glm::mix(nxy0, nxy1, u.z);
+    }
+
+#if defined(SOLAR_NOISE_SSE2)
+    // noise3D on four points at once. Every operation is the scalar one in the same order, so the
+    // results match noise3D bit for bit (the asteroids look the same with or without SSE2).
+    __m128 Floor4(__m128 x)
+    {
+        __m128 truncated = _mm_cvtepi32_ps(_mm_cvttps_epi32(x));
+        return _mm_sub_ps(truncated, _mm_and_ps(_mm_cmpgt_ps(truncated, x), _mm_set1_ps(1.0f)));
+    }
+
+    __m128 Fract4(__m128 x)
+    {
+        return _mm_sub_ps(x, Floor4(x));
+    }
+
+    __m128 Mix4(__m128 x, __m128 y, __m128 a)
+    {
+        return _mm_add_ps(_mm_mul_ps(x, _mm_sub_ps(_mm_set1_ps(1.0f), a)), _mm_mul_ps(y, a));
+    }
+
+    __m128 Hash31x4(__m128 x, __m128 y, __m128 z)
+    {
+        const __m128 scale = _mm_set1_ps(0.3183099f);
+        __m128 qx = Fract4(_mm_add_ps(_mm_mul_ps(x, scale), _mm_set1_ps(0.71f)));
+        __m128 qy = Fract4(_mm_add_ps(_mm_mul_ps(y, scale), _mm_set1_ps(0.113f)));
+        __m128 qz = Fract4(_mm_add_ps(_mm_mul_ps(z, scale), _mm_set1_ps(0.419f)));
+        const __m128 offset = _mm_set1_ps(19.19f);
+        __m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(qx, _mm_add_ps(qy, offset)), _mm_mul_ps(qy, _mm_add_ps(qz, offset))),
+            _mm_mul_ps(qz, _mm_add_ps(qx, offset)));
+        qx = _mm_add_ps(qx, dot);
+        qy = _mm_add_ps(qy, dot);
+        qz = _mm_add_ps(qz, dot);
+        return Fract4(_mm_mul_ps(_mm_add_ps(qx, qy), qz));
+    }
+
+    __m128 Noise3Dx4(__m128 x, __m128 y, __m128 z)
+    {
+        const __m128 one = _mm_set1_ps(1.0f);
+        __m128 ix = Floor4(x), iy = Floor4(y), iz = Floor4(z);
+        __m128 fx = _mm_sub_ps(x, ix), fy = _mm_sub_ps(y, iy), fz = _mm_sub_ps(z, iz);
+        auto smooth = [](__m128 f)
+        {
+            return _mm_mul_ps(_mm_mul_ps(f, f), _mm_sub_ps(_mm_set1_ps(3.0f), _mm_mul_ps(_mm_set1_ps(2.0f), f)));
+        };
+        __m128 ux = smooth(fx), uy = smooth(fy), uz = smooth(fz);
+        __m128 ix1 = _mm_add_ps(ix, one), iy1 = _mm_add_ps(iy, one), iz1 = _mm_add_ps(iz, one);
+        __m128 n000 = Hash31x4(ix, iy, iz);
+        __m128 n001 = Hash31x4(ix, iy, iz1);
+        __m128 n010 = Hash31x4(ix, iy1, iz);
+        __m128 n011 = Hash31x4(ix, iy1, iz1);
+        __m128 n100 = Hash31x4(ix1, iy, iz);
+        __m128 n101 = Hash31x4(ix1, iy, iz1);
+        __m128 n110 = Hash31x4(ix1, iy1, iz);
+        __m128 n111 = Hash31x4(ix1, iy1, iz1);
+        __m128 nxy0 = Mix4(Mix4(n000, n100, ux), Mix4(n010, n110, ux), uy);
+        __m128 nxy1 = Mix4(Mix4(n001, n101, ux), Mix4(n011, n111, ux), uy);
+        return Mix4(nxy0, nxy1, uz);
+    }
+#endif
+
+    // Four octaves of value noise at p * frequency + offset, for every point.
+    void FractalNoise(const std::vector<glm::vec3>& points, float frequency, float offset, std::vector<float>& out)
+    {
+        out.resize(points.size());
+        size_t i = 0;
+#if defined(SOLAR_NOISE_SSE2)
+        for (; i + 4 <= points.size(); i += 4)
+        {
+            __m128 x = _mm_setr_ps(points[i].x, points[i + 1].x, points[i + 2].x, points[i + 3].x);
+            __m128 y = _mm_setr_ps(points[i].y, points[i + 1].y, points[i + 2].y, points[i + 3].y);
+            __m128 z = _mm_setr_ps(points[i].z, points[i + 1].z, points[i + 2].z, points[i + 3].z);
+            const __m128 scaledFrequency = _mm_set1_ps(frequency), offsets = _mm_set1_ps(offset), two = _mm_set1_ps(2.0f);
+            x = _mm_add_ps(_mm_mul_ps(x, scaledFrequency), offsets);
+            y = _mm_add_ps(_mm_mul_ps(y, scaledFrequency), offsets);
+            z = _mm_add_ps(_mm_mul_ps(z, scaledFrequency), offsets);
+            __m128 n = _mm_setzero_ps();
+            float scale = 1.0f;
+            for (int o=0;o<4;++o){
+                n = _mm_add_ps(n, _mm_mul_ps(Noise3Dx4(x, y, z), _mm_set1_ps(scale)));
+                x = _mm_mul_ps(x, two); y = _mm_mul_ps(y, two); z = _mm_mul_ps(z, two);
+                scale *= 0.5f;
+            }
+            _mm_storeu_ps(&out[i], n);
+        }
+#endif
+        for (; i < points.size(); ++i)
+        {
+            float n = 0.0f, scale = 1.0f, fall = 0.5f;
+            glm::vec3 np = points[i] * frequency + offset;
+            for (int o=0;o<4;++o){ n += noise3D(np)*scale; np *= 2.0f; scale *= fall; }
+            out[i] = n;
         }
     }
-    return Mesh(pos, uv, nrm);
+
+    // Spherical UVs matching the loaded sphere.obj
+    glm::vec2 SphericalUV(const glm::vec3& n)
+    {
+        return { 0.5f + atan2f(n.z, n.x) / (2.0f*3.14159265f), 0.5f - asinf(n.y)/3.14159265f };
+    }
+
+    // One vertex per triangle corner, as the Mesh buffers expect.
+    MeshData ExpandFaces(const std::vector<Tri>& f, const std::vector<glm::vec3>& pos, const std::vector<glm::vec2>& uv,
+        const std::vector<glm::vec3>& nrm)
+    {
+        MeshData data;
+        data.positions.resize(f.size()*3);
+        data.texCoords.resize(f.size()*3);
+        data.normals.resize(f.size()*3);
+        for (size_t i=0; i<f.size(); ++i) {
+            int ids[3] = {f[i].a,f[i].b,f[i].c};
+            for (int k=0;k<3;++k){
+                data.positions[i*3+k] = pos[ids[k]];
+                data.texCoords[i*3+k] = uv[ids[k]];
+                data.normals[i*3+k] = nrm[ids[k]];
+            }
+        }
+        return data;
+    }
 }
 
-static float hash31(const glm::vec3& p)
+Mesh Mesh::GenerateIcoSphere(int subdivisions, float radius)
 {
-    glm::vec3 q = glm::fract(p * 0.3183099f + glm::vec3(0.71f, 0.113f, 0.419f));
-    glm::vec3 yzx = glm::vec3(q.y, q.z, q.x);
-    q += glm::dot(q, yzx + glm::vec3(19.19f));
-    return glm::fract((q.x + q.y) * q.z);
+    return Mesh(GenerateIcoSphereData(subdivisions, radius));
 }
 
-static float noise3D(const glm::vec3& p)
+MeshData Mesh::GenerateIcoSphereData(int subdivisions, float radius)
 {
-    // Simple value noise via hashing corners and trilinear mix
-    glm::vec3 i = glm::floor(p);
-    glm::vec3 f = p - i;
-    glm::vec3 u = f * f * (3.0f - 2.0f * f);
-    float n000 = hash31(i + glm::vec3(0,0,0));
-    float n001 = hash31(i + glm::vec3(0,0,1));
-    float n010 = hash31(i + glm::vec3(0,1,0));
-    float n011 = hash31(i + glm::vec3(0,1,1));
-    float n100 = hash31(i + glm::vec3(1,0,0));
-    float n101 = hash31(i + glm::vec3(1,0,1));
-    float n110 = hash31(i + glm::vec3(1,1,0));
-    float n111 = hash31(i + glm::vec3(1,1,1));
-    float nx00 = glm::mix(n000, n100, u.x);
-    float nx01 = glm::mix(n001, n101, u.x);
-    float nx10 = glm::mix(n010, n110, u.x);
-    float nx11 = glm::mix(n011, n111, u.x);
-    float nxy0 = glm::mix(nx00, nx10, u.y);
-    float nxy1 = glm::mix(nx01, nx11, u.y);
-    return glm::mix(nxy0, nxy1, u.z);
+    std::vector<glm::vec3> v;
+    std::vector<Tri> f;
+    SubdivideIcosahedron(subdivisions, v, f);
+    // Positions, trivial spherical UVs and vertex normals, once per shared vertex
+    std::vector<glm::vec3> pos(v.size()), nrm(v.size());
+    std::vector<glm::vec2> uv(v.size());
+    for (size_t i=0; i<v.size(); ++i) {
+        glm::vec3 p = glm::normalize(v[i]);
+        pos[i] = p * radius;
+        uv[i] = SphericalUV(p);
+        nrm[i] = p;
+    }
+    return ExpandFaces(f, pos, uv, nrm);
 }
 
-Mesh Mesh::GenerateCraggyAsteroid(int subdivisions, float radius, float amplitude, float frequency, unsigned int seed)
+MeshData Mesh::GenerateUVSphereData(int slices, int stacks, float radius)
 {
-    Mesh base = GenerateIcoSphere(subdivisions, 1.0f);
-    // Read back from base mesh buffers via temporary vectors used to construct Mesh
-    // We don't have direct access; regenerate positions/normals similarly to GenerateIcoSphere
-    const float t = (1.0f + sqrtf(5.0f)) * 0.5f;
-    std::vector<glm::vec3> v = {
-        {-1,  t,  0}, { 1,  t,  0}, {-1, -t,  0}, { 1, -t,  0},
-        { 0, -1,  t}, { 0,  1,  t}, { 0, -1, -t}, { 0,  1, -t},
-        { t,  0, -1}, { t,  0,  1}, {-t,  0, -1}, {-t,  0,  1}
+    // Same mapping as sphere.obj: u = 0.5 - atan2(z, x) / 2pi, v = 0.5 + latitude / pi, counter-clockwise outside.
+    // V is stored negated, the way loadOBJ returns it (the shaders flip it back).
+    auto vertex = [&](int slice, int stack, glm::vec3& position, glm::vec2& uv)
+    {
+        uv = glm::vec2(float(slice) / slices, float(stack) / stacks);
+        float longitude = glm::pi<float>() * (1.0f - 2.0f * uv.x);
+        float latitude = glm::pi<float>() * (uv.y - 0.5f);
+        position = glm::vec3(std::cos(latitude) * std::cos(longitude), std::sin(latitude), std::cos(latitude) * std::sin(longitude));
     };
-    for (auto &p : v) p = glm::normalize(p);
-    std::vector<Tri> f = {
-        {0,11,5},{0,5,1},{0,1,7},{0,7,10},{0,10,11},
-        {1,5,9},{5,11,4},{11,10,2},{10,7,6},{7,1,8},
-        {3,9,4},{3,4,2},{3,2,6},{3,6,8},{3,8,9},
-        {4,9,5},{2,4,11},{6,2,10},{8,6,7},{9,8,1}
+    MeshData data;
+    data.positions.reserve(size_t(slices) * stacks * 6);
+    data.texCoords.reserve(data.positions.capacity());
+    data.normals.reserve(data.positions.capacity());
+    auto emit = [&](int slice, int stack)
+    {
+        glm::vec3 p;
+        glm::vec2 uv;
+        vertex(slice, stack, p, uv);
+        data.positions.push_back(p * radius);
+        data.texCoords.push_back(glm::vec2(uv.x, -uv.y));
+        data.normals.push_back(p);
     };
-    auto midpoint = [&](int a, int b, std::map<long long,int>& cache)->int{
-        long long key = ((long long)std::min(a,b)<<32) | (long long)std::max(a,b);
-        auto it = cache.find(key);
-        if (it!=cache.end()) return it->second;
-        glm::vec3 m = glm::normalize((v[a]+v[b]) * 0.5f);
-        v.push_back(m);
-        int idx = (int)v.size()-1;
-        cache[key]=idx;
-        return idx;
-    };
-    for (int s=0; s<subdivisions; ++s) {
-        std::map<long long,int> cache;
-        std::vector<Tri> nf;
-        nf.reserve(f.size()*4);
-        for (auto &tr: f) {
-            int ab = midpoint(tr.a,tr.b,cache);
-            int bc = midpoint(tr.b,tr.c,cache);
-            int ca = midpoint(tr.c,tr.a,cache);
-            nf.push_back({tr.a,ab,ca});
-            nf.push_back({tr.b,bc,ab});
-            nf.push_back({tr.c,ca,bc});
-            nf.push_back({ab,bc,ca});
+    for (int stack = 0; stack < stacks; ++stack) {
+        for (int slice = 0; slice < slices; ++slice) {
+            // Two triangles per quad; the ones that collapse onto a pole are left out
+            if (stack > 0) {
+                emit(slice, stack); emit(slice + 1, stack); emit(slice + 1, stack + 1);
+            }
+            if (stack + 1 < stacks) {
+                emit(slice, stack); emit(slice + 1, stack + 1); emit(slice, stack + 1);
+            }
         }
-        f.swap(nf);
     }
-    std::vector<glm::vec3> pos; pos.reserve(f.size()*3);
-    std::vector<glm::vec2> uv;  uv.reserve(f.size()*3);
-    std::vector<glm::vec3> nrm; nrm.reserve(f.size()*3);
-    // Seed variation inputs
-    float freq = frequency;
-    float amp = amplitude;
-    for (auto &tr: f) {
-        int ids[3] = {tr.a,tr.b,tr.c};
-        for (int k=0;k<3;++k){
-            glm::vec3 p = glm::normalize(v[ids[k]]);
-            // Multi-octave value noise along normal direction
-            float n = 0.0f, scale = 1.0f, fall = 0.5f;
-            glm::vec3 np = p * freq + float(seed) * 0.01f;
-            for (int o=0;o<4;++o){ n += noise3D(np)*scale; np *= 2.0f; scale *= fall; }
-            float disp = 1.0f + amp * (n - 0.5f); // displace around unit radius
-            glm::vec3 pp = glm::normalize(p) * (radius * disp);
-            glm::vec3 nn = glm::normalize(pp);
-            float u = 0.5f + atan2f(nn.z, nn.x) / (2.0f*3.14159265f);
-            float vtex = 0.5f - asinf(nn.y)/3.14159265f;
-            pos.push_back(pp);
-            uv.push_back({u,vtex});
-            nrm.push_back(nn);
-        }
+    return data;
+}
+
+Mesh Mesh::GenerateCraggyAsteroid(int subdivisions, float radius, float amplitude, float frequency, unsigned int seed)
+{
+    return Mesh(GenerateCraggyAsteroidData(subdivisions, radius, amplitude, frequency, seed));
+}
+
+MeshData Mesh::GenerateCraggyAsteroidData(int subdivisions, float radius, float amplitude, float frequency, unsigned int seed)
+{
+    // Same subdivision as GenerateIcoSphere, displaced along the normal
+    std::vector<glm::vec3> v;
+    std::vector<Tri> f;
+    SubdivideIcosahedron(subdivisions, v, f);
+    for (auto &p : v) p = glm::normalize(p);
+    // Multi-octave value noise along the normal direction, four vertices at a time
+    std::vector<float> noise;
+    FractalNoise(v, frequency, float(seed) * 0.01f, noise);
+    std::vector<glm::vec3> pos(v.size()), nrm(v.size());
+    std::vector<glm::vec2> uv(v.size());
+    for (size_t i=0; i<v.size(); ++i) {
+        float disp = 1.0f + amplitude * (noise[i] - 0.5f); // displace around unit radius
+        glm::vec3 pp = glm::normalize(v[i]) * (radius * disp);
+        glm::vec3 nn = glm::normalize(pp);
+        pos[i] = pp;
+        uv[i] = SphericalUV(nn);
+        nrm[i] = nn;
     }
-    return Mesh(pos, uv, nrm);
+    return ExpandFaces(f, pos, uv, nrm);
 }
 
 Mesh::Mesh() noexcept
@@ -181,69 +339,107 @@ Mesh::Mesh() noexcept
 }
 
 Mesh::Mesh(std::string meshPath)
+	:
+	Mesh(LoadData(meshPath))
+{
+}
+
+Mesh::Mesh(const MeshData& data)
+	:
+	Mesh(data.positions, data.texCoords, data.normals)
+{
+}
+
+MeshData Mesh::LoadData(const std::string& meshPath)
 {
 	//Load the object's vertex data from disk.
-	std::vector<glm::vec3> vertexPositions;
-	std::vector<glm::vec2> textureCoordinates;
-	std::vector<glm::vec3> normals;
-	loadOBJ(meshPath.c_str(), vertexPositions, textureCoordinates, normals);
-	//Save the number of vertices.
-	vertexCount = (int)vertexPositions.size();
-	assert(vertexCount >= 3); //If assertion fails : Object could not be loaded or it does not contain enough vertices.
-	//Setup the buffers for this object.
-	//VAO
-	glGenVertexArrays(1, &VAO);
-	glBindVertexArray(VAO);
-	//VBOVertex
-	glGenBuffers(1, &VBOVertex);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOVertex);
-	glBufferData(GL_ARRAY_BUFFER, vertexPositions.size() * sizeof(glm::vec3), vertexPositions.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
-	glEnableVertexAttribArray(0);
-	//VBOTexture
-	glGenBuffers(1, &VBOTexture);
-	glBindBuffer(GL_ARRAY_BUFFER, VBOTexture);
-	glBufferData(GL_ARRAY_BUFFER, textureCoordinates.size() * sizeof(glm::vec2), textureCoordinates.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), 0);
-	glEnableVertexAttribArray(1);
-	//VBONormals
-	glGenBuffers(1, &VBONormals);
-	glBindBuffer(GL_ARRAY_BUFFER, VBONormals);
-	glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
-	glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
-	glEnableVertexAttribArray(2);
+	MeshData data;
+	ObjLoadStatistics statistics;
+	bool loaded = loadOBJ(meshPath.c_str(), data.positions, data.texCoords, data.normals, &statistics);
+	assert(loaded && data.positions.size() >= 3); //If assertion fails : Object could not be loaded or it does not contain enough vertices.
+	(void)loaded;
+	std::ostringstream message;	//One write, jobs may print at the same time.
+	message << "Loaded mesh: " << meshPath << " (" << statistics.triangles << " triangles, " << statistics.bytes / 1024 << " KB in "
+		<< std::fixed << std::setprecision(1) << statistics.milliseconds << " ms, "
+		<< statistics.bytes / (1024.0 * 1024.0) / std::max(statistics.milliseconds / 1000.0, 1e-6) << " MB/s, " << statistics.chunks << " chunks)\n";
+	std::cout << message.str();
+	return data;
 }
 
 Mesh::Mesh(const std::vector<glm::vec3>& vertexPositions,
            const std::vector<glm::vec2>& textureCoordinates,
            const std::vector<glm::vec3>& normals)
+	:
+	Mesh(vertexPositions.data(), textureCoordinates.empty() ? nullptr : textureCoordinates.data(),
+		normals.empty() ? nullptr : normals.data(), (int)vertexPositions.size())
+{
+}
+
+Mesh::Mesh(const glm::vec3* vertexPositions, const glm::vec2* textureCoordinates, const glm::vec3* normals, int count)
 {
     //Save the number of vertices.
-    vertexCount = (int)vertexPositions.size();
+    vertexCount = count;
     assert(vertexCount >= 3);
+    //Missing texture coordinates or normals leave an empty buffer behind.
     //Setup the buffers for this object.
     glGenVertexArrays(1, &VAO);
     glBindVertexArray(VAO);
     // Positions
     glGenBuffers(1, &VBOVertex);
     glBindBuffer(GL_ARRAY_BUFFER, VBOVertex);
-    glBufferData(GL_ARRAY_BUFFER, vertexPositions.size() * sizeof(glm::vec3), vertexPositions.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)count * sizeof(glm::vec3), vertexPositions, GL_STATIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
     glEnableVertexAttribArray(0);
     // Texcoords
     glGenBuffers(1, &VBOTexture);
     glBindBuffer(GL_ARRAY_BUFFER, VBOTexture);
-    glBufferData(GL_ARRAY_BUFFER, textureCoordinates.size() * sizeof(glm::vec2), textureCoordinates.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, textureCoordinates ? (size_t)count * sizeof(glm::vec2) : 0, textureCoordinates, GL_STATIC_DRAW);
     glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), 0);
     glEnableVertexAttribArray(1);
     // Normals
     glGenBuffers(1, &VBONormals);
     glBindBuffer(GL_ARRAY_BUFFER, VBONormals);
-    glBufferData(GL_ARRAY_BUFFER, normals.size() * sizeof(glm::vec3), normals.data(), GL_STATIC_DRAW);
+    glBufferData(GL_ARRAY_BUFFER, normals ? (size_t)count * sizeof(glm::vec3) : 0, normals, GL_STATIC_DRAW);
     glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(GLfloat), 0);
     glEnableVertexAttribArray(2);
 }
 
+std::vector<unsigned char> Mesh::PackData(const MeshData& data)
+{
+    //Header padded to 16 bytes; the arrays follow as they are in memory.
+    const uint32_t vertexCount = (uint32_t)data.positions.size();
+    const size_t headerSize = 16;
+    std::vector<unsigned char> payload(headerSize + vertexCount * (sizeof(glm::vec3) * 2 + sizeof(glm::vec2)), 0);
+    std::memcpy(payload.data(), &vertexCount, sizeof(vertexCount));
+    unsigned char* out = payload.data() + headerSize;
+    std::memcpy(out, data.positions.data(), vertexCount * sizeof(glm::vec3));
+    out += vertexCount * sizeof(glm::vec3);
+    if (data.texCoords.size() == vertexCount)
+        std::memcpy(out, data.texCoords.data(), vertexCount * sizeof(glm::vec2));
+    out += vertexCount * sizeof(glm::vec2);
+    if (data.normals.size() == vertexCount)
+        std::memcpy(out, data.normals.data(), vertexCount * sizeof(glm::vec3));
+    return payload;
+}
+
+Mesh Mesh::FromPacked(const unsigned char* payload, size_t size)
+{
+    uint32_t vertexCount = 0;
+    const size_t headerSize = 16;
+    if (size >= headerSize)
+        std::memcpy(&vertexCount, payload, sizeof(vertexCount));
+    if (size < headerSize || (size - headerSize) / (sizeof(glm::vec3) * 2 + sizeof(glm::vec2)) < vertexCount)
+    {
+        std::cout << "Packed mesh is truncated: " << vertexCount << " vertices in " << size << " bytes\n";
+        return Mesh();
+    }
+    const unsigned char* positions = payload + headerSize;
+    const unsigned char* texCoords = positions + vertexCount * sizeof(glm::vec3);
+    const unsigned char* normals = texCoords + vertexCount * sizeof(glm::vec2);
+    return Mesh(reinterpret_cast<const glm::vec3*>(positions), reinterpret_cast<const glm::vec2*>(texCoords),
+        reinterpret_cast<const glm::vec3*>(normals), (int)vertexCount);
+}
+
 Mesh::Mesh(Mesh&& other) noexcept
 	:
 	VAO(other.VAO),
@@ -303,3 +499,46 @@ int Mesh::GetVertexCount() const
 {
 	return vertexCount;
 }
+
+MeshBatch::MeshBatch(const std::vector<MeshData>& meshes)
+{
+    MeshData all;
+    firstVertices.reserve(meshes.size() + 1);
+    size_t total = 0;
+    for (const MeshData& data : meshes)
+    {
+        firstVertices.push_back((int)total);
+        total += data.positions.size();
+    }
+    firstVertices.push_back((int)total);
+    all.positions.reserve(total);
+    all.texCoords.reserve(total);
+    all.normals.reserve(total);
+    for (const MeshData& data : meshes)
+    {
+        all.positions.insert(all.positions.end(), data.positions.begin(), data.positions.end());
+        all.texCoords.insert(all.texCoords.end(), data.texCoords.begin(), data.texCoords.end());
+        all.normals.insert(all.normals.end(), data.normals.begin(), data.normals.end());
+    }
+    mesh = Mesh(all);
+}
+
+unsigned int MeshBatch::GetVAO() const
+{
+    return mesh.GetVAO();
+}
+
+int MeshBatch::GetMeshCount() const
+{
+    return firstVertices.empty() ? 0 : (int)firstVertices.size() - 1;
+}
+
+int MeshBatch::GetFirstVertex(int index) const
+{
+    return firstVertices[index];
+}
+
+int MeshBatch::GetVertexCount(int index) const
+{
+    return firstVertices[index + 1] - firstVertices[index];
+}
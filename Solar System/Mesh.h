@@ -2,17 +2,36 @@
 #include <string>
 #include <vector>
 #include <glm/glm.hpp>
+// CPU-side vertex data. Loading and generating it needs no GL context, so it can be done on worker threads
+// and turned into a Mesh on the GL thread.
+struct MeshData
+{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> texCoords;
+	std::vector<glm::vec3> normals;
+};
 // Represents a drawable mesh backed by OpenGL VAO/VBOs.
 // - Can be constructed from an OBJ file or raw position/UV/normal arrays
-// - Provides simple procedural generators: ico-sphere and noisy "craggy" asteroid
+// - Provides simple procedural generators: ico-sphere, UV sphere and noisy "craggy" asteroid
 class Mesh
 {
 public:
 	Mesh() noexcept; // default construct an empty mesh
 	Mesh(std::string meshPath);					//Loads the vertex, texture and normal data from disk.
 	Mesh(const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& texCoords, const std::vector<glm::vec3>& normals);
+	Mesh(const glm::vec3* positions, const glm::vec2* texCoords, const glm::vec3* normals, int vertexCount);
+	explicit Mesh(const MeshData& data);		//Uploads data prepared elsewhere (e.g. by a job).
 	static Mesh GenerateIcoSphere(int subdivisions, float radius);
 	static Mesh GenerateCraggyAsteroid(int subdivisions, float radius, float amplitude, float frequency, unsigned int seed);
+	//Thread-safe CPU halves of the constructors above.
+	static MeshData LoadData(const std::string& meshPath);
+	static MeshData GenerateIcoSphereData(int subdivisions, float radius);
+	static MeshData GenerateUVSphereData(int slices, int stacks, float radius);	//Latitude/longitude grid with sphere.obj's UVs.
+	static MeshData GenerateCraggyAsteroidData(int subdivisions, float radius, float amplitude, float frequency, unsigned int seed);
+	//Asset pack payload: the vertex count, then the three arrays back to back.
+	static std::vector<unsigned char> PackData(const MeshData& data);
+	//Uploads straight from the payload (no copy). An empty mesh when the payload is not one written by PackData.
+	static Mesh FromPacked(const unsigned char* payload, size_t size);
 	Mesh(const Mesh& other) = delete;			//No copy construction allowed.
 	Mesh& operator=(const Mesh& other) = delete;//No copy assignment allowed.
 	Mesh(Mesh&& other) noexcept;				//Move constructor.
@@ -27,4 +46,18 @@ private:
 	unsigned int VBOVertex;
 	unsigned int VBOTexture;
 	unsigned int VBONormals;
-};
\ No newline at end of file
+};// Several meshes uploaded together: one VAO and one set of buffers holding them back to back, each drawn as a
+// range of vertices. Switching between them needs no VAO change.
+class MeshBatch
+{
+public:
+	MeshBatch() = default;
+	explicit MeshBatch(const std::vector<MeshData>& meshes);	//One upload per attribute for all of them.
+	unsigned int GetVAO() const;
+	int GetMeshCount() const;
+	int GetFirstVertex(int index) const;
+	int GetVertexCount(int index) const;
+private:
+	Mesh mesh;
+	std::vector<int> firstVertices;	//Start of each mesh, plus the total at the end.
+};
@@ -0,0 +1,264 @@
+// OrbitRenderer: curvature-tessellated orbit guides in one buffer, drawn with a single multi-draw.
+#include "OrbitRenderer.h"
+#include "ShaderProgram.h"
+#include "Window.h"
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/constants.hpp>
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+
+namespace {
+    //Largest chord error of the finest level relative to the semi-major axis (a circle gets 512 segments);
+    //every coarser level allows 4x more, which halves the vertex count.
+    constexpr double finestRelativeError = 1.88e-5;
+    constexpr double levelErrorGrowth = 4.0;
+    constexpr int minSegments = 16;
+    constexpr float maxErrorPixels = 0.5f;      //Chord error allowed on screen before a finer level is used.
+    constexpr float minOrbitPixels = 2.0f;      //Orbits whose apoapsis projects smaller than this are skipped.
+
+    //Points of a Kepler ellipse with the focus at the origin and the periapsis on +X, spaced so that the sagitta
+    //of every chord is about maxError: ds = sqrt(8 * maxError / curvature), stepped in eccentric anomaly.
+    void TessellateEllipse(double a, double e, double maxError, std::vector<glm::dvec2>& points)
+    {
+        const double b = a * std::sqrt(1.0 - e * e);
+        const double maxStep = glm::two_pi<double>() / minSegments;
+        points.clear();
+        double E = 0.0;
+        while (E < glm::two_pi<double>())
+        {
+            double sinE = std::sin(E);
+            double cosE = std::cos(E);
+            points.push_back(glm::dvec2(a * (cosE - e), b * sinE));
+            double speedSquared = a * a * sinE * sinE + b * b * cosE * cosE;   //|dP/dE|^2
+            double speed = std::sqrt(speedSquared);
+            double curvature = a * b / (speedSquared * speed);
+            double arcStep = std::sqrt(8.0 * maxError / curvature);
+            E += std::min(arcStep / speed, maxStep);
+        }
+    }
+}
+
+OrbitRenderer::OrbitRenderer()
+{
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(OrbitVertex), (void*)offsetof(OrbitVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(OrbitVertex), (void*)offsetof(OrbitVertex, path));
+    glBindVertexArray(0);
+
+    glGenBuffers(1, &pathDataBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, pathDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 2 * sizeof(glm::vec4), nullptr, GL_DYNAMIC_DRAW);
+    glGenTextures(1, &pathDataTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, pathDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pathDataBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+OrbitRenderer::~OrbitRenderer() noexcept
+{
+    glDeleteTextures(1, &pathDataTexture);
+    glDeleteBuffers(1, &pathDataBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+int OrbitRenderer::AddOrbit(const OrbitalElements& elements, const glm::vec3& color, float opacity)
+{
+    return AddPath(elements, color, opacity, true);
+}
+
+int OrbitRenderer::AddCircle(float radius, const glm::vec3& color, float opacity)
+{
+    OrbitalElements circle{};
+    circle.a = radius;
+    return AddPath(circle, color, opacity, false);
+}
+
+void OrbitRenderer::SetOffset(int path, const glm::vec3& offset)
+{
+    if (path < 0 || path >= (int)paths.size() || paths[path].offset == offset)
+        return;
+    paths[path].offset = offset;
+    if (!paths[path].offsetDirty)
+    {
+        paths[path].offsetDirty = true;
+        movedPaths.push_back(path);
+    }
+}
+
+void OrbitRenderer::SetVisible(int path, bool visible)
+{
+    if (path >= 0 && path < (int)paths.size())
+        paths[path].visible = visible;
+}
+
+void OrbitRenderer::SetHighlighted(int path)
+{
+    highlightedPath = path;
+}
+
+void OrbitRenderer::SetErrorScale(float scale)
+{
+    errorScale = scale;
+}
+
+void OrbitRenderer::Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float pixelsPerRadian)
+{
+    if (geometryDirty)
+    {
+        UploadGeometry();
+    }
+    if (pathDataDirty)
+    {
+        UploadPathData();
+    }
+    else if (!movedPaths.empty())
+    {
+        UploadOffsets();
+    }
+    drawFirsts.clear();
+    drawCounts.clear();
+    drawnVertexCount = 0;
+    for (const Path& path : paths)
+    {
+        if (!path.visible)
+            continue;
+        int level = SelectLevel(path, cameraPosition, pixelsPerRadian);
+        if (level < 0)
+            continue;
+        drawFirsts.push_back(path.first[level]);
+        drawCounts.push_back(path.count[level]);
+        drawnVertexCount += path.count[level];
+    }
+    if (drawFirsts.empty())
+    {
+        return;
+    }
+    window.UseShader(shader);
+    shader.SendUniform<glm::mat4>("viewProjection", viewProjection);
+    shader.SendUniform<int>("highlightedPath", highlightedPath);
+    shader.SendUniform<int>("pathData", 0);
+    window.BindTexture(0, GL_TEXTURE_BUFFER, pathDataTexture);
+    window.BindVertexArray(vertexArray);
+    window.MultiDrawArrays(GL_LINE_LOOP, drawFirsts.data(), drawCounts.data(), (int)drawFirsts.size());
+}
+
+size_t OrbitRenderer::GetPathCount() const
+{
+    return paths.size();
+}
+
+size_t OrbitRenderer::GetDrawnPathCount() const
+{
+    return drawFirsts.size();
+}
+
+size_t OrbitRenderer::GetDrawnVertexCount() const
+{
+    return drawnVertexCount;
+}
+
+int OrbitRenderer::AddPath(const OrbitalElements& elements, const glm::vec3& color, float opacity, bool rotate)
+{
+    Path path;
+    path.semiMajorAxis = elements.a;
+    path.apoapsis = elements.a * (1.0 + elements.e);
+    path.color = color;
+    path.opacity = opacity;
+    //Same orientation as the Kepler positions: argument of periapsis, inclination, then the ascending node.
+    glm::mat4 rotation(1.0f);
+    if (rotate)
+    {
+        rotation = glm::rotate(rotation, (float)glm::radians(elements.OmegaDeg), glm::vec3(0, 1, 0));
+        rotation = glm::rotate(rotation, (float)glm::radians(elements.iDeg), glm::vec3(1, 0, 0));
+        rotation = glm::rotate(rotation, (float)glm::radians(elements.omegaDeg), glm::vec3(0, 1, 0));
+    }
+    const unsigned int index = (unsigned int)paths.size();
+    std::vector<glm::dvec2> points;
+    double maxError = finestRelativeError * elements.a;
+    for (int level = 0; level < levelCount; ++level, maxError *= levelErrorGrowth)
+    {
+        TessellateEllipse(elements.a, elements.e, maxError, points);
+        path.first[level] = (int)vertices.size();
+        path.count[level] = (int)points.size();
+        for (const glm::dvec2& point : points)
+        {
+            glm::vec3 world = glm::vec3(rotation * glm::vec4((float)point.x, 0.0f, (float)point.y, 1.0f));
+            vertices.push_back({ world.x, world.y, world.z, index });
+        }
+    }
+    paths.push_back(path);
+    geometryDirty = true;
+    pathDataDirty = true;
+    return (int)index;
+}
+
+void OrbitRenderer::UploadGeometry()
+{
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(OrbitVertex), vertices.data(), GL_STATIC_DRAW);
+    geometryDirty = false;
+}
+
+void OrbitRenderer::UploadPathData()
+{
+    std::vector<glm::vec4> data;
+    data.reserve(paths.size() * 2);
+    for (const Path& path : paths)
+    {
+        data.push_back(glm::vec4(path.color, path.opacity));
+        data.push_back(glm::vec4(path.offset, 0.0f));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, pathDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(glm::vec4), data.data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    pathDataDirty = false;
+    for (int moved : movedPaths)
+    {
+        paths[moved].offsetDirty = false;
+    }
+    movedPaths.clear();
+}
+
+void OrbitRenderer::UploadOffsets()
+{
+    glBindBuffer(GL_TEXTURE_BUFFER, pathDataBuffer);
+    for (int moved : movedPaths)
+    {
+        Path& path = paths[moved];
+        glm::vec4 offset(path.offset, 0.0f);
+        glBufferSubData(GL_TEXTURE_BUFFER, (2 * moved + 1) * sizeof(glm::vec4), sizeof(glm::vec4), &offset);
+        path.offsetDirty = false;
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    movedPaths.clear();
+}
+
+int OrbitRenderer::SelectLevel(const Path& path, const glm::vec3& cameraPosition, float pixelsPerRadian) const
+{
+    double distance = glm::length(cameraPosition - path.offset);
+    if (distance > path.apoapsis && path.apoapsis * pixelsPerRadian < minOrbitPixels * distance)
+    {
+        return -1;
+    }
+    //Distance to the nearest possible point of the path (zero when the camera is inside its band).
+    double periapsis = 2.0 * path.semiMajorAxis - path.apoapsis;
+    double nearest = distance > path.apoapsis ? distance - path.apoapsis : std::max(periapsis - distance, 0.0);
+    nearest = std::max(nearest, path.semiMajorAxis * 1e-3);
+    double errorPixels = finestRelativeError * path.semiMajorAxis * pixelsPerRadian / nearest;
+    int level = 0;
+    while (level + 1 < levelCount && errorPixels * levelErrorGrowth <= maxErrorPixels * errorScale)
+    {
+        errorPixels *= levelErrorGrowth;
+        ++level;
+    }
+    return level;
+}
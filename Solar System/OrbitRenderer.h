@@ -0,0 +1,69 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+#include "Orbital.h"
+class Window;
+class ShaderProgram;
+// Orbit guides. Every path lives in one vertex buffer, tessellated by curvature (vertices bunch up where the
+// ellipse bends, i.e. towards the apsides of eccentric orbits) at several levels of detail.
+// Each frame a level is picked per path from its projected size so the chord error stays under a pixel,
+// paths too small to see are skipped, and all of them are drawn with one glMultiDrawArrays call.
+// Color, opacity and offset are per-path data in a texture buffer, so thousands of orbits stay cheap.
+class OrbitRenderer
+{
+public:
+	OrbitRenderer();
+	OrbitRenderer(const OrbitRenderer& other) = delete;				//No copy construction allowed.
+	OrbitRenderer& operator=(const OrbitRenderer& other) = delete;	//No copy assignment allowed.
+	~OrbitRenderer() noexcept;										//Frees the buffers.
+	int AddOrbit(const OrbitalElements& elements, const glm::vec3& color, float opacity);	//Kepler ellipse around the origin, returns the path.
+	int AddCircle(float radius, const glm::vec3& color, float opacity);	//Circle in the XZ plane.
+	void SetOffset(int path, const glm::vec3& offset);	//Moves the path (orbits around a moving body).
+	void SetVisible(int path, bool visible);
+	void SetHighlighted(int path);						//Drawn brighter; -1 for none.
+	void SetErrorScale(float scale);					//Multiplies the chord error allowed on screen (> 1 = coarser levels).
+	//pixelsPerRadian converts angles to screen pixels (viewport height / (2 tan(fov / 2))).
+	void Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection, const glm::vec3& cameraPosition, float pixelsPerRadian);
+	size_t GetPathCount() const;
+	size_t GetDrawnPathCount() const;					//Paths that passed the size test in the last Draw.
+	size_t GetDrawnVertexCount() const;					//Vertices submitted in the last Draw.
+private:
+	static constexpr int levelCount = 5;
+	struct Path
+	{
+		int first[levelCount];	//Vertex range of every level in the buffer, finest first.
+		int count[levelCount];
+		double semiMajorAxis;
+		double apoapsis;		//Farthest distance from the path's center.
+		glm::vec3 offset = glm::vec3(0.0f);
+		glm::vec3 color;
+		float opacity;
+		bool visible = true;
+		bool offsetDirty = false;	//Queued in movedPaths.
+	};
+	struct OrbitVertex
+	{
+		float x, y, z;
+		unsigned int path;
+	};
+	int AddPath(const OrbitalElements& elements, const glm::vec3& color, float opacity, bool rotate);
+	void UploadGeometry();
+	void UploadPathData();
+	void UploadOffsets();				//Only the offset texels of the paths moved since the last Draw.
+	int SelectLevel(const Path& path, const glm::vec3& cameraPosition, float pixelsPerRadian) const;	//-1 = too small to see.
+private:
+	unsigned int vertexArray = 0;
+	unsigned int vertexBuffer = 0;
+	unsigned int pathDataBuffer = 0;	//Two RGBA32F texels per path: color/opacity, offset.
+	unsigned int pathDataTexture = 0;
+	std::vector<Path> paths;
+	std::vector<OrbitVertex> vertices;	//CPU copy, uploaded whole when paths are added.
+	bool geometryDirty = false;
+	bool pathDataDirty = false;			//Paths were added: the whole texture buffer is uploaded again.
+	std::vector<int> movedPaths;
+	int highlightedPath = -1;
+	float errorScale = 1.0f;
+	std::vector<int> drawFirsts;		//Scratch arrays for glMultiDrawArrays.
+	std::vector<int> drawCounts;
+	size_t drawnVertexCount = 0;
+};
@@ -52,4 +52,18 @@ glm::vec3 orbitalPositionAtJD(const OrbitalElements& el, double jd)
     return glm::vec3(pw);
 }
 
-
+void integrateLeapfrog(glm::vec3& position, glm::vec3& velocity, float mu, double dt, double maxStep)
+{
+    while (dt > 1e-6)
+    {
+        double h = std::min(dt, maxStep);
+        float dist = glm::length(position) + 1e-6f;
+        glm::vec3 acc = -mu * position / (dist * dist * dist);
+        velocity += (float)(0.5 * h) * acc;
+        position += (float)h * velocity;
+        dist = glm::length(position) + 1e-6f;
+        acc = -mu * position / (dist * dist * dist);
+        velocity += (float)(0.5 * h) * acc;
+        dt -= h;
+    }
+}
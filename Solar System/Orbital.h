@@ -17,4 +17,8 @@ struct OrbitalElements
 // Compute heliocentric position for given elements at Julian Date.
 glm::vec3 orbitalPositionAtJD(const OrbitalElements& el, double jd);
 
+// Advance a body around a point mass (gravitational parameter mu) by dt seconds with kick-drift-kick
+// leapfrog, in sub-steps of at most maxStep seconds. Position/velocity are relative to the central mass.
+void integrateLeapfrog(glm::vec3& position, glm::vec3& velocity, float mu, double dt, double maxStep);
+
 
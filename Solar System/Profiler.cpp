@@ -0,0 +1,272 @@
+// Profiler: CPU scope timing, pooled GPU timer queries, HUD averages and Chrome trace export.
+#include "Profiler.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+namespace {
+    constexpr double averageWindowUs = 500000.0;   //Refresh the HUD averages twice per second.
+    constexpr size_t frameTiming = 0;              //The "Frame" scope is always the first timing.
+}
+
+Profiler::Profiler()
+    :
+    startTime(std::chrono::steady_clock::now())
+{
+    timings.push_back({ "Frame", 0 });
+}
+
+Profiler::~Profiler() noexcept
+{
+    for (GpuFrame& frame : gpuFrames)
+    {
+        if (!frame.pool.empty())
+            glDeleteQueries((GLsizei)frame.pool.size(), frame.pool.data());
+    }
+}
+
+void Profiler::BeginFrame()
+{
+    //Read back the finished frames, oldest first; the GPU completes them in order, so the first one still running
+    //ends the search. The slot we are about to reuse was filled gpuFrameLatency frames ago and is almost always
+    //ready; if not, its queries stay pending and this frame goes without GPU timings.
+    for (int i = 1; i <= gpuFrameLatency; ++i)
+    {
+        GpuFrame& frame = gpuFrames[(gpuFrameIndex + i) % gpuFrameLatency];
+        if (frame.pending && !CollectGpuFrame(frame))
+            break;
+    }
+    gpuFrameIndex = (gpuFrameIndex + 1) % gpuFrameLatency;
+    gpuFrameFree = !gpuFrames[gpuFrameIndex].pending;
+    if (gpuFrameFree)
+    {
+        gpuFrames[gpuFrameIndex].issued.clear();
+    }
+    openScopes.clear();
+    openScopes.push_back({ frameTiming, NowUs() });
+}
+
+void Profiler::EndFrame()
+{
+    while (!openScopes.empty())
+    {
+        EndCpuScope();
+    }
+    if (gpuFrameFree && gpuFrames[gpuFrameIndex].issued.size() > 0)
+    {
+        gpuFrames[gpuFrameIndex].pending = true;
+    }
+    ++windowFrames;
+    double now = NowUs();
+    if (now - windowStartUs < averageWindowUs)
+        return;
+    for (Timing& timing : timings)
+    {
+        timing.cpuAverageMs = (float)(timing.cpuAccumulatedMs / windowFrames);
+        timing.cpuAccumulatedMs = 0.0;
+        if (gpuWindowFrames > 0)
+        {
+            timing.gpuAverageMs = (float)(timing.gpuAccumulatedMs / gpuWindowFrames);
+            timing.gpuAccumulatedMs = 0.0;
+        }
+    }
+    cpuFrameAverageMs = timings[frameTiming].cpuAverageMs;
+    if (gpuWindowFrames > 0)
+    {
+        gpuFrameAverageMs = (float)(gpuFrameAccumulatedMs / gpuWindowFrames);
+        gpuFrameAccumulatedMs = 0.0;
+        gpuWindowFrames = 0;
+    }
+    windowFrames = 0;
+    windowStartUs = now;
+}
+
+void Profiler::BeginCpuScope(const char* name)
+{
+    openScopes.push_back({ FindTiming(name, (int)openScopes.size()), NowUs() });
+}
+
+void Profiler::EndCpuScope()
+{
+    if (openScopes.empty())
+        return;
+    OpenScope scope = openScopes.back();
+    openScopes.pop_back();
+    double end = NowUs();
+    timings[scope.timing].cpuAccumulatedMs += (end - scope.startUs) * 0.001;
+    if (traceRecording && traceEvents.size() < maxTraceEvents)
+    {
+        traceEvents.push_back({ timings[scope.timing].name, scope.startUs, end - scope.startUs, 0 });
+    }
+}
+
+bool Profiler::BeginGpuScope(const char* name)
+{
+    if (gpuScopeOpen)
+    {
+        std::cout << "Profiler: GPU scope " << name << " overlaps another GPU scope, skipped\n";
+        return false;
+    }
+    if (!gpuFrameFree)
+    {
+        return false;
+    }
+    GpuFrame& frame = gpuFrames[gpuFrameIndex];
+    if (frame.issued.size() == frame.pool.size())
+    {
+        unsigned int query = 0;
+        glGenQueries(1, &query);
+        frame.pool.push_back(query);
+    }
+    unsigned int query = frame.pool[frame.issued.size()];
+    frame.issued.push_back({ query, FindTiming(name, (int)openScopes.size()), NowUs() });
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    gpuScopeOpen = true;
+    return true;
+}
+
+void Profiler::EndGpuScope()
+{
+    if (!gpuScopeOpen)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    gpuScopeOpen = false;
+}
+
+void Profiler::SetTraceRecording(bool recording)
+{
+    if (recording && !traceRecording)
+    {
+        traceEvents.clear();
+    }
+    traceRecording = recording;
+}
+
+bool Profiler::IsTraceRecording() const
+{
+    return traceRecording;
+}
+
+bool Profiler::WriteChromeTrace(const std::string& path) const
+{
+    std::ofstream file(path);
+    if (!file)
+    {
+        std::cout << "Could not write trace: " << path << "\n";
+        return false;
+    }
+    file << std::fixed << std::setprecision(3);
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"CPU\"}},\n";
+    file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"GPU\"}}";
+    for (const TraceEvent& event : traceEvents)
+    {
+        //Scope names are identifiers chosen in code, they never need JSON escaping.
+        file << ",\n{\"name\":\"" << event.name << "\",\"cat\":\"" << (event.track == 0 ? "cpu" : "gpu")
+            << "\",\"ph\":\"X\",\"ts\":" << event.startUs << ",\"dur\":" << event.durationUs
+            << ",\"pid\":1,\"tid\":" << event.track + 1 << "}";
+    }
+    file << "\n]}\n";
+    std::cout << "Wrote " << traceEvents.size() << " trace events to " << path << "\n";
+    return (bool)file;
+}
+
+std::string Profiler::GetHudText() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(2);
+    oss << "FRAME  CPU " << cpuFrameAverageMs << " MS  GPU " << gpuFrameAverageMs << " MS\n";
+    for (size_t i = 1; i < timings.size(); ++i)
+    {
+        const Timing& timing = timings[i];
+        oss << std::string((size_t)(timing.depth - 1) * 2, ' ') << timing.name << "  " << timing.cpuAverageMs;
+        if (timing.hasGpu)
+        {
+            oss << " / " << timing.gpuAverageMs;
+        }
+        oss << '\n';
+    }
+    return oss.str();
+}
+
+float Profiler::GetAverageCpuFrameMs() const
+{
+    return cpuFrameAverageMs;
+}
+
+float Profiler::GetAverageGpuFrameMs() const
+{
+    return gpuFrameAverageMs;
+}
+
+size_t Profiler::FindTiming(const char* name, int depth)
+{
+    for (size_t i = 0; i < timings.size(); ++i)
+    {
+        if (timings[i].name == name || std::strcmp(timings[i].name, name) == 0)
+            return i;
+    }
+    timings.push_back({ name, depth });
+    return timings.size() - 1;
+}
+
+bool Profiler::CollectGpuFrame(GpuFrame& frame)
+{
+    //Queries complete in order: once the last one is available, all of them are.
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.issued.back().id, GL_QUERY_RESULT_AVAILABLE, &available);
+    if (available == GL_FALSE)
+    {
+        return false;
+    }
+    //GPU work of a frame runs in submission order; place each pass after the previous one on the GPU track.
+    double gpuCursorUs = 0.0;
+    double frameMs = 0.0;
+    for (const GpuQuery& query : frame.issued)
+    {
+        GLuint64 elapsedNs = 0;
+        glGetQueryObjectui64v(query.id, GL_QUERY_RESULT, &elapsedNs);
+        double durationUs = elapsedNs * 0.001;
+        Timing& timing = timings[query.timing];
+        timing.gpuAccumulatedMs += durationUs * 0.001;
+        timing.hasGpu = true;
+        frameMs += durationUs * 0.001;
+        double startUs = std::max(query.submitUs, gpuCursorUs);
+        gpuCursorUs = startUs + durationUs;
+        if (traceRecording && traceEvents.size() < maxTraceEvents)
+        {
+            traceEvents.push_back({ timing.name, startUs, durationUs, 1 });
+        }
+    }
+    gpuFrameAccumulatedMs += frameMs;
+    ++gpuWindowFrames;
+    frame.issued.clear();
+    frame.pending = false;
+    return true;
+}
+
+double Profiler::NowUs() const
+{
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+ProfileScope::ProfileScope(Profiler& profiler, const char* name, bool gpu)
+    :
+    profiler(profiler),
+    gpu(gpu)
+{
+    profiler.BeginCpuScope(name);
+    if (gpu)
+        this->gpu = profiler.BeginGpuScope(name);
+}
+
+ProfileScope::~ProfileScope() noexcept
+{
+    if (gpu)
+        profiler.EndGpuScope();
+    profiler.EndCpuScope();
+}
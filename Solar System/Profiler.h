@@ -0,0 +1,104 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <chrono>
+// Frame profiler: named CPU scopes (steady clock) and GPU pass timings (GL_TIME_ELAPSED queries).
+// GPU queries are pooled per frame in a small ring and read back a few frames late, once the GPU reports them
+// available, so profiling never stalls the pipeline. Timings are averaged for the HUD and can be recorded as a Chrome trace
+// (chrome://tracing or https://ui.perfetto.dev).
+class Profiler
+{
+public:
+	Profiler();
+	Profiler(const Profiler& other) = delete;				//No copy construction allowed.
+	Profiler& operator=(const Profiler& other) = delete;	//No copy assignment allowed.
+	~Profiler() noexcept;									//Frees the GPU timer queries.
+	void BeginFrame();							//Starts the "Frame" scope and collects GPU results of older frames.
+	void EndFrame();							//Ends the "Frame" scope and updates the averages.
+	void BeginCpuScope(const char* name);		//Scopes nest. name must outlive the profiler (use string literals).
+	void EndCpuScope();
+	//GL_TIME_ELAPSED queries cannot nest: false when another GPU scope is open (or no query slot is free this
+	//frame), and then the matching EndGpuScope must be left out.
+	bool BeginGpuScope(const char* name);
+	void EndGpuScope();
+	void SetTraceRecording(bool recording);		//Starts or stops collecting trace events (clears the old ones when starting).
+	bool IsTraceRecording() const;
+	bool WriteChromeTrace(const std::string& path) const;	//Writes the recorded events as trace_event JSON.
+	std::string GetHudText() const;				//Averaged CPU and GPU milliseconds per scope, one line each.
+	float GetAverageCpuFrameMs() const;
+	float GetAverageGpuFrameMs() const;			//Sum of all GPU scopes of a frame.
+private:
+	struct Timing
+	{
+		const char* name;
+		int depth;						//Nesting depth of the CPU scope (for indenting the HUD).
+		double cpuAccumulatedMs = 0.0;
+		double gpuAccumulatedMs = 0.0;
+		float cpuAverageMs = 0.0f;
+		float gpuAverageMs = 0.0f;
+		bool hasGpu = false;
+	};
+	struct OpenScope
+	{
+		size_t timing;
+		double startUs;
+	};
+	struct GpuQuery
+	{
+		unsigned int id;
+		size_t timing;
+		double submitUs;				//CPU time at glBeginQuery, used to place the event on the trace's GPU track.
+	};
+	struct GpuFrame
+	{
+		std::vector<unsigned int> pool;	//Query objects owned by this ring slot.
+		std::vector<GpuQuery> issued;	//Queries issued this frame, in submission order.
+		bool pending = false;
+	};
+	struct TraceEvent
+	{
+		const char* name;
+		double startUs;
+		double durationUs;
+		int track;						//0 = CPU, 1 = GPU.
+	};
+	size_t FindTiming(const char* name, int depth);
+	bool CollectGpuFrame(GpuFrame& frame);		//False while the GPU has not finished the frame's queries.
+	double NowUs() const;
+private:
+	static constexpr int gpuFrameLatency = 4;	//Frames a GPU query may stay in flight before it is read back.
+	static constexpr size_t maxTraceEvents = 1000000;
+	std::chrono::steady_clock::time_point startTime;
+	std::vector<Timing> timings;
+	std::vector<OpenScope> openScopes;
+	GpuFrame gpuFrames[gpuFrameLatency];
+	int gpuFrameIndex = 0;
+	bool gpuFrameFree = true;			//The current ring slot holds no unread queries.
+	bool gpuScopeOpen = false;
+	std::vector<TraceEvent> traceEvents;
+	bool traceRecording = false;
+	int windowFrames = 0;				//Frames accumulated since the averages were last refreshed.
+	double windowStartUs = 0.0;
+	double gpuFrameAccumulatedMs = 0.0;
+	int gpuWindowFrames = 0;
+	float cpuFrameAverageMs = 0.0f;
+	float gpuFrameAverageMs = 0.0f;
+};
+
+//Times the enclosing block on the CPU and, for passes, on the GPU as well.
+class ProfileScope
+{
+public:
+	ProfileScope(Profiler& profiler, const char* name, bool gpu = false);
+	ProfileScope(const ProfileScope& other) = delete;
+	ProfileScope& operator=(const ProfileScope& other) = delete;
+	~ProfileScope() noexcept;
+private:
+	Profiler& profiler;
+	bool gpu;							//This scope opened a GPU query.
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name)
+#define PROFILE_PASS(profiler, name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(profiler, name, true)
@@ -0,0 +1,111 @@
+// QualityGovernor: hysteresis over the smoothed frame time and the table of quality levels.
+#include "QualityGovernor.h"
+#include "Settings.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace {
+    //Finest first. Each step sheds a third to a half of what every knob costs.
+    constexpr QualityGovernor::Level levels[QualityGovernor::levelCount] = {
+        { "FULL",   1.0f,  0.25f, 1.0f,  0.0f },
+        { "HIGH",   0.7f,  0.75f, 2.0f,  2.0f },
+        { "MEDIUM", 0.45f, 1.5f,  4.0f,  6.0f },
+        { "LOW",    0.25f, 3.0f,  8.0f,  12.0f },
+        { "LOWEST", 0.12f, 6.0f,  16.0f, 24.0f } };
+
+    constexpr float smoothingSeconds = 0.25f;   //Time constant of the frame time average.
+    constexpr float maxRaiseAfterSeconds = 60.0f;
+}
+
+QualityGovernor::QualityGovernor(float targetFrameMs) :
+    targetFrameMs(targetFrameMs),
+    raiseAfterSeconds(settings::qualityRaiseAfterSeconds)
+{
+}
+
+void QualityGovernor::AddFrame(float frameSeconds, float cpuMs, float gpuMs)
+{
+    //Exponential average with a fixed time constant, whatever the frame rate.
+    float weight = hasSample ? 1.0f - std::exp(-frameSeconds / smoothingSeconds) : 1.0f;
+    smoothedCpuMs += (cpuMs - smoothedCpuMs) * weight;
+    smoothedGpuMs += (gpuMs - smoothedGpuMs) * weight;
+    hasSample = true;
+    sinceChangeSeconds += frameSeconds;
+    if (lastChangeRaised && sinceChangeSeconds > 2.0f * raiseAfterSeconds)
+    {
+        raiseAfterSeconds = settings::qualityRaiseAfterSeconds;   //The restored level held: the backoff is over.
+    }
+    if (!enabled)
+    {
+        return;
+    }
+    if (settleSeconds > 0.0f)
+    {
+        //GPU timings arrive a few frames late and the average needs time to follow: judge the new level afterwards.
+        settleSeconds -= frameSeconds;
+        return;
+    }
+    float frameMs = std::max(smoothedCpuMs, smoothedGpuMs);
+    overBudgetSeconds = frameMs > targetFrameMs ? overBudgetSeconds + frameSeconds : 0.0f;
+    underBudgetSeconds = frameMs < targetFrameMs * settings::qualityRaiseHeadroom ? underBudgetSeconds + frameSeconds : 0.0f;
+    if (overBudgetSeconds >= settings::qualityLowerAfterSeconds && level + 1 < levelCount)
+    {
+        Step(1);
+    }
+    else if (underBudgetSeconds >= raiseAfterSeconds && level > 0)
+    {
+        Step(-1);
+    }
+}
+
+void QualityGovernor::Step(int direction)
+{
+    //Dropping again soon after a raise means the finer level does not fit: try it less often.
+    if (direction > 0 && lastChangeRaised && sinceChangeSeconds < 2.0f * raiseAfterSeconds)
+    {
+        raiseAfterSeconds = std::min(raiseAfterSeconds * 2.0f, maxRaiseAfterSeconds);
+    }
+    lastChangeRaised = direction < 0;
+    SetLevel(level + direction);
+}
+
+void QualityGovernor::SetEnabled(bool enabled)
+{
+    this->enabled = enabled;
+    overBudgetSeconds = underBudgetSeconds = 0.0f;
+}
+
+bool QualityGovernor::IsEnabled() const
+{
+    return enabled;
+}
+
+void QualityGovernor::SetLevel(int level)
+{
+    this->level = std::clamp(level, 0, levelCount - 1);
+    overBudgetSeconds = underBudgetSeconds = 0.0f;
+    settleSeconds = settings::qualitySettleSeconds;
+    sinceChangeSeconds = 0.0f;
+}
+
+int QualityGovernor::GetLevel() const
+{
+    return level;
+}
+
+const QualityGovernor::Level& QualityGovernor::GetSettings() const
+{
+    return levels[level];
+}
+
+std::string QualityGovernor::GetHudText() const
+{
+    std::ostringstream oss;
+    oss << std::fixed << std::setprecision(1);
+    oss << "QUALITY " << levels[level].name << " (" << levelCount - level << "/" << levelCount << ")"
+        << (enabled ? "" : " FIXED") << "  CPU " << smoothedCpuMs << " GPU " << smoothedGpuMs
+        << " / " << targetFrameMs << " MS";
+    return oss.str();
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include <string>
+// Frame-budget quality governor. Every frame it is given the measured CPU and GPU time of the frame and keeps a
+// smoothed estimate of the slower of the two. When that stays over the target for a while, the scene drops one
+// quality level (fewer asteroids, coarser spheres and orbit guides, small overlays skipped); when it stays well
+// under the target for longer, it climbs back. The asymmetric thresholds, the hold times and the settle period
+// after each change keep it from oscillating between two levels; a level that fails again right after being
+// restored doubles the wait before the next attempt.
+class QualityGovernor
+{
+public:
+	struct Level
+	{
+		const char* name;
+		float asteroidFraction;		//Share of the belt that is drawn.
+		float sphereErrorPixels;	//Silhouette error allowed when picking a sphere's level of detail.
+		float orbitErrorScale;		//Multiplies the chord error allowed on orbit guides (coarser tessellation).
+		float overlayMinPixels;		//Atmospheres and rings smaller than this on screen are skipped.
+	};
+	static constexpr int levelCount = 5;
+public:
+	explicit QualityGovernor(float targetFrameMs);
+	//frameSeconds is the wall-clock length of the frame; gpuMs is 0 when the GPU time is not known.
+	void AddFrame(float frameSeconds, float cpuMs, float gpuMs);
+	void SetEnabled(bool enabled);		//A disabled governor stays at its current level.
+	bool IsEnabled() const;
+	void SetLevel(int level);			//Jumps to a level, 0 = full detail.
+	int GetLevel() const;
+	const Level& GetSettings() const;	//What the current level allows.
+	std::string GetHudText() const;		//One line: level, smoothed CPU / GPU time and target.
+private:
+	void Step(int direction);			//Budget-driven change of one level.
+private:
+	float targetFrameMs;
+	bool enabled = true;
+	int level = 0;
+	float smoothedCpuMs = 0.0f;
+	float smoothedGpuMs = 0.0f;
+	bool hasSample = false;
+	float overBudgetSeconds = 0.0f;		//How long the frame time has been over the target.
+	float underBudgetSeconds = 0.0f;	//How long it has been comfortably under it.
+	float settleSeconds = 0.0f;			//Left before the measurements reflect the last change.
+	float sinceChangeSeconds = 0.0f;
+	float raiseAfterSeconds;			//Current hold time before raising, grows when raising keeps failing.
+	bool lastChangeRaised = false;
+};
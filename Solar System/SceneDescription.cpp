@@ -0,0 +1,588 @@
+// SceneDescription: .scene text parser and writer, binary packing and loading.
+#include "SceneDescription.h"
+#include "AssetPack.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <type_traits>
+#include <unordered_map>
+
+namespace {
+    constexpr char magic[4] = { 'S', 'S', 'C', 'N' };
+    constexpr uint32_t version = 1;     //Bumped when a field is added to SceneBody or AsteroidBelt::Band.
+
+    enum class KeyResult { Done, Unknown, BadValue };
+
+    std::string Trim(const std::string& text)
+    {
+        const size_t first = text.find_first_not_of(" \t\r\n");
+        if (first == std::string::npos)
+        {
+            return std::string();
+        }
+        return text.substr(first, text.find_last_not_of(" \t\r\n") - first + 1);
+    }
+
+    //Exactly count numbers, nothing else. Most keys are stored as floats, so larger magnitudes are rejected
+    //before they reach a conversion that could not represent them.
+    bool ParseNumbers(const std::string& text, double* values, size_t count)
+    {
+        std::istringstream in(text);
+        std::string token;
+        for (size_t i = 0; i < count; ++i)
+        {
+            char* end = nullptr;
+            if (!(in >> token))
+            {
+                return false;
+            }
+            values[i] = std::strtod(token.c_str(), &end);
+            if (end == token.c_str() || *end != '\0' || !std::isfinite(values[i])
+                || std::abs(values[i]) > (double)std::numeric_limits<float>::max())
+            {
+                return false;
+            }
+        }
+        return !(in >> token);
+    }
+
+    bool IsWhole(double value, double maximum)
+    {
+        return value >= 0.0 && value <= maximum && value == std::floor(value);
+    }
+
+    KeyResult ParseBodyKey(const std::string& key, const std::string& value, SceneBody& body, std::string& parentName)
+    {
+        double v[7] = {};
+        auto numbers = [&](size_t count) { return ParseNumbers(value, v, count) ? KeyResult::Done : KeyResult::BadValue; };
+        auto file = [&](std::string& target) { target = value; return value.empty() ? KeyResult::BadValue : KeyResult::Done; };
+        auto flag = [&](bool& target) { target = true; return value.empty() ? KeyResult::Done : KeyResult::BadValue; };
+        KeyResult result = KeyResult::Unknown;
+        if (key == "radius") { result = numbers(1); body.radius = (float)v[0]; }
+        else if (key == "rotation") { result = numbers(1); body.rotationSpeedDeg = (float)v[0]; }
+        else if (key == "obliquity") { result = numbers(1); body.obliquityDeg = (float)v[0]; }
+        else if (key == "orbit")
+        {
+            result = numbers(7);
+            body.semiMajorAxisAU = v[0];
+            body.eccentricity = v[1];
+            body.inclinationDeg = v[2];
+            body.ascendingNodeDeg = v[3];
+            body.periapsisDeg = v[4];
+            body.meanAnomalyDeg = v[5];
+            body.periodDays = v[6];
+        }
+        else if (key == "parent") { result = file(parentName); }
+        else if (key == "orbit_radius") { result = numbers(1); body.orbitRadius = (float)v[0]; }
+        else if (key == "period") { result = numbers(1); body.periodDays = v[0]; }
+        else if (key == "phase") { result = numbers(1); body.phaseDeg = (float)v[0]; }
+        else if (key == "texture") { result = file(body.texture); }
+        else if (key == "color") { result = numbers(4); body.color = glm::vec4(v[0], v[1], v[2], v[3]); }
+        else if (key == "unlit") { result = flag(body.unlit); }
+        else if (key == "rim_light") { result = flag(body.rimLight); }
+        else if (key == "uv_flow") { result = flag(body.uvFlow); }
+        else if (key == "night_map") { result = file(body.nightMap); }
+        else if (key == "specular_map") { result = file(body.specularMap); }
+        else if (key == "clouds_map") { result = file(body.cloudsMap); }
+        else if (key == "atmosphere") { result = file(body.atmosphereTexture); }
+        else if (key == "atmosphere_color") { result = numbers(4); body.atmosphereColor = glm::vec4(v[0], v[1], v[2], v[3]); }
+        else if (key == "atmosphere_scale") { result = numbers(1); body.atmosphereScale = (float)v[0]; }
+        else if (key == "atmosphere_alpha") { result = numbers(1); body.atmosphereAlpha = (float)v[0]; }
+        else if (key == "atmosphere_tint") { result = numbers(3); body.atmosphereTint = glm::vec3(v[0], v[1], v[2]); }
+        else if (key == "ring") { result = file(body.ringTexture); }
+        else if (key == "ring_color") { result = numbers(4); body.ringColor = glm::vec4(v[0], v[1], v[2], v[3]); }
+        else if (key == "ring_radii") { result = numbers(2); body.ringInner = (float)v[0]; body.ringOuter = (float)v[1]; }
+        else if (key == "ring_tilt") { result = numbers(2); body.ringTiltDeg = glm::vec2(v[0], v[1]); }
+        else if (key == "ring_alpha") { result = numbers(1); body.ringAlpha = (float)v[0]; }
+        else if (key == "ring_tint") { result = numbers(3); body.ringTint = glm::vec3(v[0], v[1], v[2]); }
+        else if (key == "ring_spin") { result = numbers(1); body.ringSpinDeg = (float)v[0]; }
+        else if (key == "orbit_color")
+        {
+            result = numbers(3);
+            body.customOrbitColor = true;
+            body.orbitColor = glm::vec3(v[0], v[1], v[2]);
+        }
+        else if (key == "facts")
+        {
+            result = numbers(3);
+            body.orbitRadiusMillionKm = (float)v[0];
+            body.orbitSpeedKmPerSec = (float)v[1];
+            body.rotationPeriodHours = (float)v[2];
+        }
+        else if (key == "retrograde") { result = flag(body.retrograde); }
+        return result;
+    }
+
+    KeyResult ParseBeltKey(const std::string& key, const std::string& value, AsteroidBelt::Band& band)
+    {
+        double v[2] = {};
+        auto numbers = [&](size_t count) { return ParseNumbers(value, v, count) ? KeyResult::Done : KeyResult::BadValue; };
+        KeyResult result = KeyResult::Unknown;
+        if (key == "count")
+        {
+            result = numbers(1) == KeyResult::Done && IsWhole(v[0], 2147483647.0) ? KeyResult::Done : KeyResult::BadValue;
+            if (result == KeyResult::Done)
+                band.count = (int)v[0];
+        }
+        else if (key == "radii") { result = numbers(2); band.innerRadiusAU = (float)v[0]; band.outerRadiusAU = (float)v[1]; }
+        else if (key == "tilt") { result = numbers(1); band.tiltDegrees = (float)v[0]; }
+        else if (key == "half_thickness") { result = numbers(1); band.halfThickness = (float)v[0]; }
+        else if (key == "rock_size") { result = numbers(2); band.minScale = (float)v[0]; band.maxScale = (float)v[1]; }
+        else if (key == "angular_speed") { result = numbers(1); band.angularSpeedDegrees = (float)v[0]; }
+        else if (key == "speed_exponent") { result = numbers(1); band.speedExponent = (float)v[0]; }
+        else if (key == "seed")
+        {
+            result = numbers(1) == KeyResult::Done && IsWhole(v[0], 4294967295.0) ? KeyResult::Done : KeyResult::BadValue;
+            if (result == KeyResult::Done)
+                band.seed = (unsigned int)v[0];
+        }
+        return result;
+    }
+
+    //Keys that only make sense for one kind of body.
+    bool IsKeyForKind(const std::string& key, SceneBody::Kind kind)
+    {
+        if (key == "orbit")
+            return kind == SceneBody::Kind::Planet;
+        if (key == "parent" || key == "orbit_radius" || key == "period" || key == "phase")
+            return kind == SceneBody::Kind::Moon;
+        return true;
+    }
+
+    //What the parser cannot see line by line; the binary form goes through it too.
+    bool CheckScene(const SceneDescription& scene, const std::string& sourceName)
+    {
+        auto fail = [&](const std::string& name, const std::string& message)
+        {
+            std::cout << sourceName << ": " << name << ": " << message << "\n";
+            return false;
+        };
+        for (size_t i = 0; i < scene.bodies.size(); ++i)
+        {
+            const SceneBody& body = scene.bodies[i];
+            if (!(body.radius > 0.0f))
+                return fail(body.name, "radius must be positive");
+            if (body.texture.empty())
+                return fail(body.name, "no texture");
+            if (body.kind == SceneBody::Kind::Planet
+                && !(body.semiMajorAxisAU > 0.0 && body.eccentricity >= 0.0 && body.eccentricity < 1.0 && body.periodDays > 0.0))
+                return fail(body.name, "orbit needs a > 0, 0 <= e < 1 and a positive period");
+            if (body.kind == SceneBody::Kind::Moon)
+            {
+                if (body.parent < 0 || body.parent >= (int)i || scene.bodies[body.parent].kind != SceneBody::Kind::Planet)
+                    return fail(body.name, "a moon's parent must be a planet listed before it");
+                if (!(body.orbitRadius > 0.0f && body.periodDays > 0.0))
+                    return fail(body.name, "orbit_radius and period must be positive");
+            }
+            if (!body.atmosphereTexture.empty() && !(body.atmosphereScale > 0.0f))
+                return fail(body.name, "atmosphere_scale must be positive");
+            if (!body.ringTexture.empty() && !(body.ringInner >= 0.0f && body.ringInner < body.ringOuter))
+                return fail(body.name, "ring_radii must be 0 <= inner < outer");
+        }
+        for (const SceneBelt& belt : scene.belts)
+        {
+            const AsteroidBelt::Band& band = belt.band;
+            if (band.count < 0 || !(band.innerRadiusAU > 0.0f && band.innerRadiusAU <= band.outerRadiusAU))
+                return fail(belt.name, "belt needs count >= 0 and 0 < inner <= outer radii");
+            if (!(band.minScale > 0.0f && band.minScale <= band.maxScale))
+                return fail(belt.name, "rock_size must be 0 < min <= max");
+        }
+        if (scene.asteroidTexture.empty())
+            return fail("asteroid_texture", "no texture");
+        return true;
+    }
+
+    //Shortest text that reads back to the same value.
+    std::string Number(double value, int minDigits, int maxDigits, bool isFloat)
+    {
+        char text[64];
+        for (int digits = minDigits; digits <= maxDigits; ++digits)
+        {
+            std::snprintf(text, sizeof(text), "%.*g", digits, value);
+            double parsed = std::strtod(text, nullptr);
+            if (isFloat ? (float)parsed == (float)value : parsed == value)
+                break;
+        }
+        return text;
+    }
+
+    std::string Number(float value)
+    {
+        return Number(value, 6, 9, true);
+    }
+
+    std::string Number(double value)
+    {
+        return Number(value, 15, 17, false);
+    }
+
+    //Binary form: the same visit writes and reads every field, so the two cannot drift apart.
+    class Writer
+    {
+    public:
+        explicit Writer(std::vector<unsigned char>& bytes) : bytes(bytes) {}
+        template <typename T>
+        void operator()(const T& value)
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "binary scene fields are plain values");
+            const unsigned char* data = reinterpret_cast<const unsigned char*>(&value);
+            bytes.insert(bytes.end(), data, data + sizeof(T));
+        }
+        void operator()(const std::string& text)
+        {
+            (*this)((uint32_t)text.size());
+            bytes.insert(bytes.end(), text.begin(), text.end());
+        }
+    private:
+        std::vector<unsigned char>& bytes;
+    };
+
+    class Reader
+    {
+    public:
+        Reader(const unsigned char* data, size_t size) : data(data), size(size) {}
+        template <typename T>
+        void operator()(T& value)
+        {
+            if (Take(sizeof(T)))
+                std::memcpy(&value, data + offset - sizeof(T), sizeof(T));
+        }
+        void operator()(std::string& text)
+        {
+            uint32_t length = 0;
+            (*this)(length);
+            if (Take(length))
+                text.assign(reinterpret_cast<const char*>(data + offset - length), length);
+        }
+        bool IsGood() const { return good; }
+        bool IsAtEnd() const { return offset == size; }
+    private:
+        bool Take(size_t count)
+        {
+            good = good && size - offset >= count;
+            offset += good ? count : 0;
+            return good;
+        }
+    private:
+        const unsigned char* data;
+        size_t size;
+        size_t offset = 0;
+        bool good = true;
+    };
+
+    template <typename Body, typename Visitor>
+    void VisitBody(Body& body, Visitor& visit)
+    {
+        visit(body.kind); visit(body.name); visit(body.parent);
+        visit(body.radius); visit(body.rotationSpeedDeg); visit(body.obliquityDeg);
+        visit(body.semiMajorAxisAU); visit(body.eccentricity); visit(body.inclinationDeg);
+        visit(body.ascendingNodeDeg); visit(body.periapsisDeg); visit(body.meanAnomalyDeg); visit(body.periodDays);
+        visit(body.orbitRadius); visit(body.phaseDeg);
+        visit(body.texture); visit(body.color); visit(body.unlit); visit(body.rimLight); visit(body.uvFlow);
+        visit(body.nightMap); visit(body.specularMap); visit(body.cloudsMap);
+        visit(body.atmosphereTexture); visit(body.atmosphereColor); visit(body.atmosphereScale);
+        visit(body.atmosphereAlpha); visit(body.atmosphereTint);
+        visit(body.ringTexture); visit(body.ringColor); visit(body.ringInner); visit(body.ringOuter);
+        visit(body.ringTiltDeg); visit(body.ringAlpha); visit(body.ringTint); visit(body.ringSpinDeg);
+        visit(body.customOrbitColor); visit(body.orbitColor);
+        visit(body.orbitRadiusMillionKm); visit(body.orbitSpeedKmPerSec); visit(body.rotationPeriodHours); visit(body.retrograde);
+    }
+}
+
+bool ParseScene(const std::string& text, const std::string& sourceName, SceneDescription& scene)
+{
+    scene = SceneDescription{};
+    std::vector<std::string> parentNames;   //Per body, resolved once every body is known.
+    std::vector<int> bodyLines;
+    std::unordered_map<std::string, int> bodyIndices;   //Generated scenes have thousands of bodies.
+    enum class Block { None, Body, Belt } block = Block::None;
+    int lineNumber = 0;
+    auto fail = [&](const std::string& message)
+    {
+        std::cout << sourceName << ":" << lineNumber << ": " << message << "\n";
+        return false;
+    };
+    std::istringstream lines(text);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        ++lineNumber;
+        line = Trim(line.substr(0, line.find('#')));
+        if (line.empty())
+        {
+            continue;
+        }
+        const size_t keyEnd = line.find_first_of(" \t");
+        const std::string key = line.substr(0, keyEnd);
+        const std::string value = keyEnd == std::string::npos ? std::string() : Trim(line.substr(keyEnd));
+        if (key == "star" || key == "planet" || key == "moon")
+        {
+            if (value.empty() || bodyIndices.count(value) != 0)
+            {
+                return fail(value.empty() ? key + " without a name" : "a body named " + value + " exists already");
+            }
+            SceneBody body;
+            body.kind = key == "star" ? SceneBody::Kind::Star : key == "planet" ? SceneBody::Kind::Planet : SceneBody::Kind::Moon;
+            body.name = value;
+            bodyIndices[value] = (int)scene.bodies.size();
+            scene.bodies.push_back(body);
+            parentNames.emplace_back();
+            bodyLines.push_back(lineNumber);
+            block = Block::Body;
+            continue;
+        }
+        if (key == "belt")
+        {
+            scene.belts.push_back({ value, AsteroidBelt::Band{} });
+            block = Block::Belt;
+            continue;
+        }
+        KeyResult result = KeyResult::Unknown;
+        if (key == "asteroid_texture")
+        {
+            scene.asteroidTexture = value;
+            result = value.empty() ? KeyResult::BadValue : KeyResult::Done;
+        }
+        else if (key == "asteroid_color")
+        {
+            double v[4] = {};
+            result = ParseNumbers(value, v, 4) ? KeyResult::Done : KeyResult::BadValue;
+            scene.asteroidColor = glm::vec4(v[0], v[1], v[2], v[3]);
+        }
+        else if (block == Block::Belt)
+        {
+            result = ParseBeltKey(key, value, scene.belts.back().band);
+        }
+        else if (block == Block::Body)
+        {
+            if (!IsKeyForKind(key, scene.bodies.back().kind))
+            {
+                return fail(key + " does not apply to " + scene.bodies.back().name);
+            }
+            result = ParseBodyKey(key, value, scene.bodies.back(), parentNames.back());
+        }
+        if (result == KeyResult::Unknown)
+        {
+            return fail("unknown key " + key);
+        }
+        if (result == KeyResult::BadValue)
+        {
+            return fail("bad value for " + key + ": " + value);
+        }
+    }
+    for (size_t i = 0; i < scene.bodies.size(); ++i)
+    {
+        SceneBody& body = scene.bodies[i];
+        if (body.kind == SceneBody::Kind::Moon)
+        {
+            auto parent = bodyIndices.find(parentNames[i]);
+            body.parent = parent != bodyIndices.end() ? parent->second : -1;
+            if (body.parent < 0)
+            {
+                lineNumber = bodyLines[i];
+                return fail(parentNames[i].empty() ? body.name + " has no parent" : "no body named " + parentNames[i]);
+            }
+        }
+    }
+    return CheckScene(scene, sourceName);
+}
+
+std::string WriteSceneText(const SceneDescription& scene)
+{
+    std::ostringstream out;
+    auto vec = [](const float* values, int count)
+    {
+        std::string text;
+        for (int i = 0; i < count; ++i)
+        {
+            text += (i > 0 ? " " : "") + Number(values[i]);
+        }
+        return text;
+    };
+    out << "asteroid_texture " << scene.asteroidTexture << "\n";
+    out << "asteroid_color " << vec(&scene.asteroidColor.x, 4) << "\n";
+    for (const SceneBody& body : scene.bodies)
+    {
+        const char* kinds[] = { "star", "planet", "moon" };
+        out << "\n" << kinds[(int)body.kind] << " " << body.name << "\n";
+        out << "    radius " << Number(body.radius) << "\n";
+        if (body.rotationSpeedDeg != 0.0f)
+            out << "    rotation " << Number(body.rotationSpeedDeg) << "\n";
+        if (body.obliquityDeg != 0.0f)
+            out << "    obliquity " << Number(body.obliquityDeg) << "\n";
+        if (body.kind == SceneBody::Kind::Planet)
+        {
+            out << "    orbit " << Number(body.semiMajorAxisAU) << " " << Number(body.eccentricity) << " " << Number(body.inclinationDeg)
+                << " " << Number(body.ascendingNodeDeg) << " " << Number(body.periapsisDeg) << " " << Number(body.meanAnomalyDeg)
+                << " " << Number(body.periodDays) << "\n";
+        }
+        if (body.kind == SceneBody::Kind::Moon)
+        {
+            out << "    parent " << scene.bodies[body.parent].name << "\n";
+            out << "    orbit_radius " << Number(body.orbitRadius) << "\n";
+            out << "    period " << Number(body.periodDays) << "\n";
+            if (body.phaseDeg != 0.0f)
+                out << "    phase " << Number(body.phaseDeg) << "\n";
+        }
+        out << "    texture " << body.texture << "\n";
+        out << "    color " << vec(&body.color.x, 4) << "\n";
+        if (body.unlit)
+            out << "    unlit\n";
+        if (body.rimLight)
+            out << "    rim_light\n";
+        if (body.uvFlow)
+            out << "    uv_flow\n";
+        if (!body.nightMap.empty())
+            out << "    night_map " << body.nightMap << "\n";
+        if (!body.specularMap.empty())
+            out << "    specular_map " << body.specularMap << "\n";
+        if (!body.cloudsMap.empty())
+            out << "    clouds_map " << body.cloudsMap << "\n";
+        if (!body.atmosphereTexture.empty())
+        {
+            out << "    atmosphere " << body.atmosphereTexture << "\n";
+            out << "    atmosphere_color " << vec(&body.atmosphereColor.x, 4) << "\n";
+            out << "    atmosphere_scale " << Number(body.atmosphereScale) << "\n";
+            out << "    atmosphere_alpha " << Number(body.atmosphereAlpha) << "\n";
+            out << "    atmosphere_tint " << vec(&body.atmosphereTint.x, 3) << "\n";
+        }
+        if (!body.ringTexture.empty())
+        {
+            out << "    ring " << body.ringTexture << "\n";
+            out << "    ring_color " << vec(&body.ringColor.x, 4) << "\n";
+            out << "    ring_radii " << Number(body.ringInner) << " " << Number(body.ringOuter) << "\n";
+            out << "    ring_tilt " << vec(&body.ringTiltDeg.x, 2) << "\n";
+            out << "    ring_alpha " << Number(body.ringAlpha) << "\n";
+            out << "    ring_tint " << vec(&body.ringTint.x, 3) << "\n";
+            out << "    ring_spin " << Number(body.ringSpinDeg) << "\n";
+        }
+        if (body.customOrbitColor)
+            out << "    orbit_color " << vec(&body.orbitColor.x, 3) << "\n";
+        if (body.orbitRadiusMillionKm != 0.0f || body.orbitSpeedKmPerSec != 0.0f || body.rotationPeriodHours != 0.0f)
+        {
+            out << "    facts " << Number(body.orbitRadiusMillionKm) << " " << Number(body.orbitSpeedKmPerSec)
+                << " " << Number(body.rotationPeriodHours) << "\n";
+        }
+        if (body.retrograde)
+            out << "    retrograde\n";
+    }
+    for (const SceneBelt& belt : scene.belts)
+    {
+        const AsteroidBelt::Band& band = belt.band;
+        out << "\nbelt " << belt.name << "\n";
+        out << "    count " << band.count << "\n";
+        out << "    radii " << Number(band.innerRadiusAU) << " " << Number(band.outerRadiusAU) << "\n";
+        out << "    tilt " << Number(band.tiltDegrees) << "\n";
+        out << "    half_thickness " << Number(band.halfThickness) << "\n";
+        out << "    rock_size " << Number(band.minScale) << " " << Number(band.maxScale) << "\n";
+        out << "    angular_speed " << Number(band.angularSpeedDegrees) << "\n";
+        out << "    speed_exponent " << Number(band.speedExponent) << "\n";
+        out << "    seed " << band.seed << "\n";
+    }
+    return out.str();
+}
+
+std::vector<unsigned char> PackScene(const SceneDescription& scene)
+{
+    std::vector<unsigned char> bytes(std::begin(magic), std::end(magic));
+    Writer write(bytes);
+    write(version);
+    write(scene.asteroidTexture);
+    write(scene.asteroidColor);
+    write((uint32_t)scene.bodies.size());
+    for (const SceneBody& body : scene.bodies)
+    {
+        VisitBody(body, write);
+    }
+    write((uint32_t)scene.belts.size());
+    for (const SceneBelt& belt : scene.belts)
+    {
+        write(belt.name);
+        write(belt.band);
+    }
+    return bytes;
+}
+
+bool UnpackScene(const unsigned char* data, size_t size, const std::string& sourceName, SceneDescription& scene)
+{
+    scene = SceneDescription{};
+    char fileMagic[4] = {};
+    uint32_t fileVersion = 0;
+    Reader read(data, size);
+    read(fileMagic);
+    read(fileVersion);
+    if (!read.IsGood() || std::memcmp(fileMagic, magic, sizeof(magic)) != 0 || fileVersion != version)
+    {
+        std::cout << "Not a binary scene (or of another version): " << sourceName << "\n";
+        return false;
+    }
+    read(scene.asteroidTexture);
+    read(scene.asteroidColor);
+    uint32_t count = 0;
+    read(count);
+    for (uint32_t i = 0; i < count && read.IsGood(); ++i)
+    {
+        scene.bodies.emplace_back();
+        VisitBody(scene.bodies.back(), read);
+    }
+    read(count);
+    for (uint32_t i = 0; i < count && read.IsGood(); ++i)
+    {
+        scene.belts.emplace_back();
+        read(scene.belts.back().name);
+        read(scene.belts.back().band);
+    }
+    if (!read.IsGood() || !read.IsAtEnd())
+    {
+        std::cout << "Damaged binary scene: " << sourceName << "\n";
+        return false;
+    }
+    return CheckScene(scene, sourceName);
+}
+
+void SetAsteroidCount(SceneDescription& scene, int count)
+{
+    long long sceneTotal = 0;
+    for (const SceneBelt& belt : scene.belts)
+    {
+        sceneTotal += belt.band.count;
+    }
+    long long assigned = 0;
+    for (size_t i = 0; i < scene.belts.size(); ++i)
+    {
+        AsteroidBelt::Band& band = scene.belts[i].band;
+        long long share = sceneTotal > 0 ? (long long)count * band.count / sceneTotal : (long long)count / (long long)scene.belts.size();
+        if (i + 1 == scene.belts.size())
+        {
+            share = count - assigned;   //The rounding remainder.
+        }
+        band.count = (int)share;
+        assigned += share;
+    }
+}
+
+bool LoadScene(const std::string& path, const AssetPack& assets, SceneDescription& scene)
+{
+    if (const AssetPack::Entry* entry = assets.Find(path, AssetPack::Type::Scene))
+    {
+        return UnpackScene(entry->data, entry->size, path, scene);
+    }
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+    {
+        std::cout << "Could not read scene: " << path << "\n";
+        return false;
+    }
+    const std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() >= sizeof(magic) && std::memcmp(bytes.data(), magic, sizeof(magic)) == 0)
+    {
+        return UnpackScene(reinterpret_cast<const unsigned char*>(bytes.data()), bytes.size(), path, scene);
+    }
+    return ParseScene(bytes, path, scene);
+}
@@ -0,0 +1,92 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "AsteroidBelt.h"
+class AssetPack;
+// Description of the scene the game builds at startup: stars, planets on Kepler orbits, moons, atmospheres,
+// rings, asteroid belts and the facts the follow HUD shows, read from a .scene file instead of being compiled in.
+// The text form is the one to edit (Resources/Scenes/solar_system.scene documents every key): '#' starts a
+// comment, "star NAME", "planet NAME", "moon NAME" and "belt NAME" open a block, and every other line is a key
+// of the current block followed by its values; file names take the rest of the line. The binary form
+// (PackScene) is what asset_packer stores and what generated stress scenes are written as: it is read without
+// any parsing, so a scene with tens of thousands of bodies loads in a few milliseconds.
+struct SceneBody
+{
+	enum class Kind : uint32_t { Star, Planet, Moon };
+	Kind kind = Kind::Planet;
+	std::string name;
+	int parent = -1;						//Moons: index of the planet they orbit (set from the "parent" name).
+	float radius = 1.0f;
+	float rotationSpeedDeg = 0.0f;			//Self rotation, degrees per second (negative = retrograde).
+	float obliquityDeg = 0.0f;				//Axial tilt.
+	//Planets: Kepler elements around the stars, which sit at the origin.
+	double semiMajorAxisAU = 1.0;
+	double eccentricity = 0.0;
+	double inclinationDeg = 0.0;
+	double ascendingNodeDeg = 0.0;
+	double periapsisDeg = 0.0;
+	double meanAnomalyDeg = 0.0;			//At the J2000 epoch.
+	double periodDays = 365.256;			//Orbital period (moons as well).
+	//Moons: start on a circle around the parent, then integrated under its gravity.
+	float orbitRadius = 0.0f;				//Scene units.
+	float phaseDeg = 0.0f;					//Starting angle on the circle.
+	//Surface: file names below Resources/Textures; the color shows until the texture has streamed in.
+	std::string texture;
+	glm::vec4 color = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+	bool unlit = false;						//Emissive and scrolling (stars).
+	bool rimLight = false;
+	bool uvFlow = false;					//Drifting UVs (gas giants).
+	std::string nightMap;					//Each map enables its surface shader feature.
+	std::string specularMap;
+	std::string cloudsMap;
+	//Translucent shell around the body (empty texture = none).
+	std::string atmosphereTexture;
+	glm::vec4 atmosphereColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+	float atmosphereScale = 1.05f;			//Of the body radius.
+	float atmosphereAlpha = 0.5f;
+	glm::vec3 atmosphereTint = glm::vec3(1.0f);
+	//Ring in the equatorial plane (empty texture = none).
+	std::string ringTexture;
+	glm::vec4 ringColor = glm::vec4(0.0f);
+	float ringInner = 1.2f;					//Radii in body radii.
+	float ringOuter = 2.4f;
+	glm::vec2 ringTiltDeg = glm::vec2(0.0f);	//About X, then Z.
+	float ringAlpha = 0.7f;
+	glm::vec3 ringTint = glm::vec3(1.0f);
+	float ringSpinDeg = 0.0f;				//Shimmer, degrees per second.
+	//Orbit guide color (otherwise from the palette).
+	bool customOrbitColor = false;
+	glm::vec3 orbitColor = glm::vec3(1.0f);
+	//Follow HUD facts.
+	float orbitRadiusMillionKm = 0.0f;
+	float orbitSpeedKmPerSec = 0.0f;
+	float rotationPeriodHours = 0.0f;
+	bool retrograde = false;
+};
+
+struct SceneBelt
+{
+	std::string name;
+	AsteroidBelt::Band band;
+};
+
+struct SceneDescription
+{
+	std::vector<SceneBody> bodies;			//Parents come before their moons.
+	std::vector<SceneBelt> belts;
+	std::string asteroidTexture = "asteroid.jpg";	//Shared by every belt.
+	glm::vec4 asteroidColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f);
+};
+
+//Reads the text form. Prints the first error with its line (sourceName:line: ...) and returns false.
+bool ParseScene(const std::string& text, const std::string& sourceName, SceneDescription& scene);
+std::string WriteSceneText(const SceneDescription& scene);	//Text form that parses back to the same values.
+std::vector<unsigned char> PackScene(const SceneDescription& scene);	//Binary form.
+bool UnpackScene(const unsigned char* data, size_t size, const std::string& sourceName, SceneDescription& scene);
+//Shares count asteroids among the belts in the proportions they already have (evenly when they are all empty).
+void SetAsteroidCount(SceneDescription& scene, int count);
+//From the asset pack when it holds the scene, else the file (text or binary). Prints what went wrong.
+bool LoadScene(const std::string& path, const AssetPack& assets, SceneDescription& scene);
@@ -6,19 +6,14 @@ namespace settings
 {
     // Julian date epoch and Sun GM (only JD used for simple mean motion approach)
     constexpr double epochJD_J2000 = 2451545.0; // 2000-01-01 12:00 TT
-    // Obliquity (axial tilt) per planet (degrees)
-    constexpr float obliqMercury = 0.03f;
-    constexpr float obliqVenus   = 177.36f; // retrograde
-    constexpr float obliqEarth   = 23.44f;
-    constexpr float obliqMars    = 25.19f;
-    constexpr float obliqJupiter = 3.12f;
-    constexpr float obliqSaturn  = 26.73f;
-    constexpr float obliqUranus  = 97.77f;  // retrograde
-    constexpr float obliqNeptune = 28.32f;
 	//Directory paths.
 	const std::string texturesPath = "..\\Resources\\Textures\\";
 	const std::string meshesPath = "..\\Resources\\Meshes\\";
 	const std::string shadersPath = "..\\Resources\\Shaders\\";
+	const std::string assetPackPath = "..\\Resources\\assets.pack";	//Built by asset_packer; loose files are used without it.
+	const std::string cachePath = "..\\Resources\\Cache\\";	//Generated data (converted skybox, ...), safe to delete.
+	const std::string scenesPath = "..\\Resources\\Scenes\\";
+	const std::string scenePath = scenesPath + "solar_system.scene";	//Bodies, rings and belts the game builds (--scene picks another).
 
 	//Simulation settings.
 	//Lighting.
@@ -27,47 +22,6 @@ namespace settings
 	constexpr glm::vec3 earthAmbientColor = {0.7f,0.7f,0.7f};//The ambient color of the earth.
 	constexpr float earthSpecularStrength = 1.5f;//Controls the strength of the specular of the ware's surface of earth.
 	constexpr float earthSpecularShininess = 4;	//Controls the shininess of the water's surface of earth (powers of 2).
-	//Radiuses.
-	constexpr float earthOrbitRadius = 300.0f;		//The radius of the earth around the sun (other planet's radiuses are scaled based on this value).
-	constexpr float mercuryOrbitRadius = earthOrbitRadius * 0.6f;
-	constexpr float venusOrbitRadius = earthOrbitRadius * 0.8f;
-	constexpr float marsOrbitRadius = earthOrbitRadius * 1.3f;
-	constexpr float jupiterOrbitRadius = earthOrbitRadius * 2.0f;
-	constexpr float saturnOrbitRadius = earthOrbitRadius * 3.0f;
-	constexpr float uranusOrbitRadius = earthOrbitRadius * 3.8f;
-	constexpr float neptuneOrbitRadius = earthOrbitRadius * 4.3f;
-
-	//Scales.
-	constexpr float sunScale = 80.f;				
-	constexpr float earthScale = 10.f;				//The scale of the earth (other planet's scales are adjusted based on this value).
-	constexpr float mercuryScale = earthScale * 0.3f;
-	constexpr float venusScale = earthScale * 0.9f;	
-	constexpr float marsScale = earthScale * 0.5f;	
-	constexpr float jupiterScale = earthScale * 5.0f;
-	constexpr float saturnScale = earthScale * 4.0f;	
-	constexpr float uranusScale = earthScale * 2.5f;	
-	constexpr float neptuneScale = earthScale * 2.3f;
-
-	//Orbit speeds (in degrees per second).
-	constexpr float earthOrbitSpeed = 20.f;	//The number of degrees the earth should travel around its orbit every second (other planet's orbit speeds are adjusted based on this value).
-	constexpr float mercuryOrbitSpeed = earthOrbitSpeed * 4.149f;
-	constexpr float venusOrbitSpeed = earthOrbitSpeed * 1.623f;
-	constexpr float marsOrbitSpeed = earthOrbitSpeed * 0.531f;
-	constexpr float jupiterOrbitSpeed = earthOrbitSpeed * 0.084f;
-	constexpr float saturnOrbitSpeed = earthOrbitSpeed * 0.033f;
-	constexpr float uranusOrbitSpeed = earthOrbitSpeed * 0.011f;
-	constexpr float neptuneOrbitSpeed = earthOrbitSpeed * 0.006f;
-
-	//Rotation Speeds (in degrees per second).
-	constexpr float earthRotationSpeed = 50.f;
-	constexpr float sunRotationSpeed = earthRotationSpeed * 0.037f;	//The number of degrees the earth should rotate around itself every second (other planet's rotation speeds are adjusted based on this value).
-	constexpr float mercuryRotationSpeed = earthRotationSpeed * 17.241f;
-	constexpr float venusRotationSpeed = -earthRotationSpeed * 4.115f;	//Rotates the other way compared to earth.
-	constexpr float marsRotationSpeed = earthRotationSpeed * 0.960f;
-	constexpr float jupiterRotationSpeed = earthRotationSpeed * 2.403f;
-	constexpr float saturnRotationSpeed = earthRotationSpeed * 2.183f;
-	constexpr float uranusRotationSpeed = -earthRotationSpeed * 1.412f;	//Rotates the other way compared to earth.
-	constexpr float neptuneRotationSpeed = earthRotationSpeed * 1.501f;
 
 	//Time settings.
 	constexpr float timeAdjustSpeed = 0.1f;
@@ -76,33 +30,14 @@ namespace settings
 	// Scene units per 1 AU for Keplerian orbits (chosen to keep Mercury > Sun radius and Neptune < far plane)
 	constexpr float keplerAUScale = 326.0f;
 
-	// Moon (approximate, scaled to simulation units)
-	constexpr float moonOrbitRadius = earthScale * 3.5f; // keep near Earth in this simulation scale
-	constexpr float moonScale = earthScale * 0.27f;
-	constexpr float moonOrbitSpeed = earthOrbitSpeed * 13.0f; // ~13x per Earth year (approximate monthly)
-	constexpr float moonRotationSpeed = moonOrbitSpeed; // tidally locked approximation
-
-	// Saturn rings (relative to Saturn scale)
-	constexpr float saturnRingInner = 1.2f; // inner radius multiplier of Saturn radius
-	constexpr float saturnRingOuter = 2.4f; // outer radius multiplier of Saturn radius
-	constexpr float saturnRingTiltDegrees = 26.7f; // axial tilt
-	constexpr float saturnRingAngularSpeed = 25.0f; // degrees per second for animated particle-like motion
-	constexpr float saturnRingDifferential = 0.8f; // inner faster than outer (0..1)
-
-	// Venus atmosphere
-	constexpr float venusAtmosphereScale = 1.05f; // slightly larger than Venus sphere (more visible rim)
-	constexpr float venusAtmosphereRotation = -earthRotationSpeed * 1.0f; // super-rotation approximation
-
-	// Asteroid belt (between Mars and Jupiter, approximate)
-	constexpr int asteroidCount = 4000;
-	constexpr float asteroidBeltInner = marsOrbitRadius + marsScale * 8.0f; // wider safe margin from Mars
-	constexpr float asteroidBeltOuter = jupiterOrbitRadius - jupiterScale * 2.0f; // safe margin from Jupiter
-	constexpr float asteroidBeltTiltDegrees = 2.0f; // small inclination
-	constexpr float asteroidBeltHalfThickness = earthScale * 1.5f; // vertical half-thickness
-	constexpr float asteroidMinScale = earthScale * 0.08f;
-	constexpr float asteroidMaxScale = earthScale * 0.22f;
-	constexpr float asteroidBaseAngularSpeed = earthOrbitSpeed * 0.35f; // inner band speed benchmark
-	constexpr float asteroidSpeedExponent = 1.5f; // Kepler-like
+	// Asteroid belts (their bands come from the scene)
+	constexpr int asteroidMeshVariants = 64; // rock shapes, generated in parallel on the workers at startup
+	constexpr bool asteroidShaderDisplacement = true; // one shape per rock, displaced in asteroid.vert (else the mesh pool)
+	constexpr int asteroidBaseSubdivisions = 2; // icosphere all the displaced rocks share (320 triangles)
+
+	// Trajectory trails
+	constexpr float trailOrbitFraction = 0.12f; // share of its orbital period a body's trail covers
+	constexpr int trailAsteroidCount = 12;      // asteroids that get a trail as well
 
 	//Keyboard bindings (US layout, use https://www.glfw.org/docs/3.3/group__keys.html for looking up the key's values).
 	constexpr int forwardKey = 87;		//W
@@ -117,10 +52,64 @@ namespace settings
 	constexpr int cameraSlowdownKey = 67;//C
 	constexpr int cameraCycleKey = 70;     //F
 	constexpr int orbitToggleKey = 79;     //O
+	constexpr int bodyLabelsKey = 78;      //N (name labels above the planets and the Moon)
+	constexpr int trailsKey = 82;          //R (fading trajectory trails)
 	constexpr int pauseKey = 80;			//P
 	constexpr int timeSpeedupKey = 334;	//Keypad ADD
 	constexpr int timeSlowdownKey = 333;	//Keypad SUBTRACT
 	constexpr int exitKey = 256;			//Escape
+	constexpr int overdrawViewKey = 290;	//F1 (debug: visualize and measure opaque overdraw)
+	constexpr int depthPrepassKey = 291;	//F2 (toggle the depth-only prepass)
+	constexpr int profilerHudKey = 292;	//F3 (show CPU/GPU timings per phase and pass)
+	constexpr int profilerTraceKey = 293;	//F4 (start/stop recording a Chrome trace)
+	constexpr int asteroidDisplacementKey = 294;	//F5 (asteroids displaced in the vertex shader / mesh pool)
+	constexpr int qualityGovernorKey = 295;	//F6 (quality governor on/off; off returns to full detail)
+	constexpr int dynamicResolutionKey = 296;	//F7 (dynamic resolution on/off; off returns to native resolution)
+	constexpr int lowLatencyKey = 297;	//F8 (low latency mode on/off)
+
+	//Opaque pass.
+	constexpr bool depthPrepass = false;	//Lay down depth for all opaque bodies first so every pixel is shaded once (worth it for heavy scenes).
+
+	//Quality governor (fixed-step runs keep full detail unless --quality auto is given).
+	constexpr bool qualityGovernor = true;				//Shed detail (asteroids, sphere and orbit tessellation, small overlays) when frames run over budget.
+	constexpr float frameTimeTargetMs = 16.6f;			//Frame budget, met by the slower of the CPU and the GPU.
+	constexpr float qualityLowerAfterSeconds = 0.5f;	//Over budget this long before a level is dropped.
+	constexpr float qualityRaiseAfterSeconds = 3.0f;	//Under the headroom this long before a level comes back.
+	constexpr float qualityRaiseHeadroom = 0.7f;		//Share of the budget frames must stay under for a level to come back.
+	constexpr float qualitySettleSeconds = 0.5f;		//Measurements ignored after a change while they catch up.
+
+	//Frame pacing and render on demand (windowed runs; headless runs keep drawing every frame).
+	constexpr bool vsync = true;						//Wait for the display's refresh when presenting (swap interval 1).
+	constexpr float targetFps = 0.0f;					//Frame rate cap on top of vsync (0 = none), e.g. 30 for exhibit displays.
+	constexpr float frameSpinMs = 1.5f;					//Last part of a frame cap wait that is spun instead of slept (sleeps overshoot).
+	constexpr bool renderOnDemand = true;				//Skip redrawing while nothing changes (paused, no input) or the window is hidden.
+	constexpr float idleWaitSeconds = 0.25f;			//Longest idle sleep before background work (texture streaming) is looked at again.
+
+	//Low latency mode (F8 toggles it).
+	constexpr bool lowLatencyMode = false;				//Cap the frames queued on the GPU and re-read the mouse look right before drawing.
+	constexpr int maxFramesInFlight = 1;				//Frames the GPU may still be working on when the next one starts (low latency mode).
+
+	//Dynamic resolution (fixed-step runs render at native resolution unless --render-scale is given).
+	constexpr bool dynamicResolution = true;			//Render the scene below native resolution when the GPU runs over budget (the HUD stays native).
+	constexpr float minRenderScale = 0.5f;				//Smallest share of the framebuffer width and height the scene is rendered at.
+	constexpr float renderScaleLowerAfterSeconds = 0.25f;	//GPU time over budget this long before the scale shrinks.
+	constexpr float renderScaleRaiseAfterSeconds = 1.0f;	//Room for a larger scale this long before it grows.
+	constexpr float renderScaleAim = 0.85f;				//Share of the budget a new scale is picked to use.
+	constexpr float renderScaleSettleSeconds = 0.75f;	//Measurements ignored after a change (the profiler averages over 0.5 s).
+	constexpr float upscaleSharpness = 0.6f;			//Edge-aware sharpening of the upscale at the minimum scale (0 = plain bilinear).
+
+	//Profiler.
+	const std::string traceFileName = "solar_trace.json";	//Where F4 writes the trace when --trace was not given.
+
+	//Skybox.
+	constexpr int skyboxFaceSize = 2048;	//Edge length of each cubemap face (the 8k equirect map is ~2048 texels per 90 degrees).
+
+	//Asset streaming.
+	constexpr int textureUploadBytesPerFrame = 16 * 1024 * 1024;	//Decoded texture data copied to the GPU per frame (at least one image).
+	constexpr bool textureCompression = true;	//Bake textures to BC1/BC3 when the GPU supports S3TC (4-8x less video memory).
+	constexpr int textureResidentLevelSize = 256;	//Mip levels up to this size are loaded at startup and always kept.
+	constexpr int textureMemoryBudget = 64 * 1024 * 1024;	//GPU memory for streamed textures; when short, the least visible ones lose their finest levels.
+	constexpr bool shaderBinaryCache = true;	//Keep linked shader programs in the cache so later launches skip compiling.
 
 	//Default window values.
 	constexpr int windowWidth = 1280;				//The width of the window.
@@ -131,6 +120,7 @@ namespace settings
 	constexpr int viewportHeight = 720;				//The height of the viewport rectangle (from bottom of window).
 	constexpr char windowTitle[] = "Solar system";	//The title of the window.
 	constexpr bool captureMouse = true;				//Whether or not the window should capture the mouse.
+	constexpr glm::vec3 clearColor = { 0.2f, 0.3f, 0.3f };	//The background clear color.
 
 	//Default camera values.
 	constexpr glm::vec3 cameraInitialPosition = { 0.0f, 0.0f, 1000.0f }; //The initial position of the camera in world space.
@@ -153,4 +143,5 @@ namespace settings
 	static_assert(cameraNearPlaneDistance > 0.0f);			//Near plane distance must be a positive non-zero.
 	static_assert(cameraNearPlaneDistance < cameraFarPlaneDistance);//Near plane must be "nearer" than the far plane.
 	static_assert(cameraSensitivity > 0.0f);				//Sensitivity must be a positive non-zero.
+	static_assert(minRenderScale > 0.0f && minRenderScale < 1.0f);	//The scene must still cover some pixels, and there must be room to scale.
 }
\ No newline at end of file
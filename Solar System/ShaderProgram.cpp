@@ -1,12 +1,110 @@
 // ShaderProgram: compiles vertex/fragment shaders, links program, sends uniforms.
 #include "ShaderProgram.h"
+#include "AssetPack.h"
+#include "GLExtensions.h"
+#include "Settings.h"
 #include <glad/glad.h>
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <vector>
+
+namespace {
+    constexpr GLenum programBinaryRetrievableHint = 0x8257;    //GL_PROGRAM_BINARY_RETRIEVABLE_HINT
+    constexpr GLenum programBinaryLength = 0x8741;             //GL_PROGRAM_BINARY_LENGTH
+    constexpr char binaryMagic[4] = { 'S', 'P', 'R', 'G' };
+
+    struct BinaryHeader
+    {
+        char magic[4];
+        uint32_t format;        //Driver-defined, handed back to glProgramBinary.
+        uint64_t key;           //Guards against a renamed or colliding file.
+        uint64_t size;
+    };
+
+    using Clock = std::chrono::steady_clock;
+
+    double MillisecondsSince(Clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+    }
+
+    std::string GetFileName(const std::string& path)
+    {
+        size_t separator = path.find_last_of("/\\");
+        return separator == std::string::npos ? path : path.substr(separator + 1);
+    }
+
+    //Copies the source with the defines after its #version line (which must come before anything else but
+    //comments); a #line directive keeps the compiler's line numbers those of the file.
+    std::string InjectDefines(const char* code, int length, const std::string& defineLines)
+    {
+        std::string source(code, length >= 0 ? (size_t)length : std::strlen(code));
+        size_t version = source.compare(0, 8, "#version") == 0 ? 0 : source.find("\n#version");
+        size_t lineEnd = version == std::string::npos ? std::string::npos : source.find('\n', version + 1);
+        if (lineEnd == std::string::npos)
+        {
+            return source;
+        }
+        int nextLine = 2 + (int)std::count(source.begin(), source.begin() + lineEnd, '\n');
+        source.insert(lineEnd + 1, defineLines + "#line " + std::to_string(nextLine) + "\n");
+        return source;
+    }
+
+    //Prints the info log of a shader that failed to compile.
+    bool CheckCompileStatus(unsigned int shader, const char* stage, const std::string& name)
+    {
+        int success = 0;
+        glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+        if (!success)
+        {
+            char infoLog[512];
+            glGetShaderInfoLog(shader, 512, NULL, infoLog);
+            std::cout << "ERROR::SHADER::" << stage << "::COMPILATION_FAILED (" << name << ")\n" << infoLog << std::endl;
+        }
+        return success != 0;
+    }
+}
 
 ShaderProgram::ShaderProgram(std::string vertexShaderPath, std::string fragmentShaderPath)
+{
+    name = GetFileName(vertexShaderPath) + " + " + GetFileName(fragmentShaderPath);
+    LoadFiles(vertexShaderPath, fragmentShaderPath);
+    Finish();
+}
+
+ShaderProgram::ShaderProgram(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, const AssetPack& assets,
+    const std::vector<std::string>& defines)
+{
+    for (const std::string& define : defines)
+    {
+        defineLines += "#define " + define + "\n";
+    }
+    name = GetFileName(vertexShaderPath) + " + " + GetFileName(fragmentShaderPath);
+    for (size_t i = 0; i < defines.size(); ++i)
+    {
+        name += (i == 0 ? " [" : " ") + defines[i] + (i + 1 == defines.size() ? "]" : "");
+    }
+    const AssetPack::Entry* vertexSource = assets.Find(vertexShaderPath, AssetPack::Type::Raw);
+    const AssetPack::Entry* fragmentSource = assets.Find(fragmentShaderPath, AssetPack::Type::Raw);
+    if (vertexSource == nullptr || fragmentSource == nullptr)
+    {
+        LoadFiles(vertexShaderPath, fragmentShaderPath);
+        return;
+    }
+    //The mapped sources are not null-terminated, their lengths are passed along instead.
+    Build(reinterpret_cast<const char*>(vertexSource->data), (int)vertexSource->size,
+        reinterpret_cast<const char*>(fragmentSource->data), (int)fragmentSource->size);
+}
+
+void ShaderProgram::LoadFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath)
 {
     //1.Retrieve the vertex/fragment source code from filePath.
     std::string vertexCode;
@@ -27,53 +125,191 @@ ShaderProgram::ShaderProgram(std::string vertexShaderPath, std::string fragmentS
     //Convert stream into string.
     vertexCode = vShaderStream.str();
     fragmentCode = fShaderStream.str();
-    const char* vShaderCode = vertexCode.c_str();
-    const char* fShaderCode = fragmentCode.c_str();
-    //2. Compile shaders.
-    unsigned int vertex, fragment;
-    int success;
-    char infoLog[512];
-    //Compile vertex Shader.
-    vertex = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertex, 1, &vShaderCode, NULL);
-    glCompileShader(vertex);
-    //Print compile errors if any.
-    glGetShaderiv(vertex, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
-    //Compile fragment Shader.
-    fragment = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragment, 1, &fShaderCode, NULL);
-    glCompileShader(fragment);
-    //Print compile errors if any.
-    glGetShaderiv(fragment, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(vertex, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-    };
-    //Link shader program.
+    Build(vertexCode.c_str(), -1, fragmentCode.c_str(), -1);
+}
+
+void ShaderProgram::Build(const char* vShaderCode, int vertexLength, const char* fShaderCode, int fragmentLength)
+{
+    const Clock::time_point start = Clock::now();
+    std::string vertexSource, fragmentSource;
+    if (!defineLines.empty())
+    {
+        vertexSource = InjectDefines(vShaderCode, vertexLength, defineLines);
+        fragmentSource = InjectDefines(fShaderCode, fragmentLength, defineLines);
+        vShaderCode = vertexSource.c_str();
+        fShaderCode = fragmentSource.c_str();
+        vertexLength = fragmentLength = -1;
+    }
     shaderProgramID = glCreateProgram();
-    glAttachShader(shaderProgramID, vertex);
-    glAttachShader(shaderProgramID, fragment);
+    //The binary only fits the driver that produced it, so the driver takes part in the key.
+    if (settings::shaderBinaryCache && GetGLExtensions().hasProgramBinary)
+    {
+        std::string keySource;
+        for (GLenum driverString : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+        {
+            const char* value = reinterpret_cast<const char*>(glGetString(driverString));
+            keySource.append(value != nullptr ? value : "").push_back('\n');
+        }
+        keySource.append(vShaderCode, vertexLength >= 0 ? (size_t)vertexLength : std::strlen(vShaderCode)).push_back('\n');
+        keySource.append(fShaderCode, fragmentLength >= 0 ? (size_t)fragmentLength : std::strlen(fShaderCode));
+        binaryKey = AssetPack::Hash(keySource.data(), keySource.size());
+        if (LoadBinary())
+        {
+            fromBinaryCache = true;
+            buildMilliseconds = MillisecondsSince(start);
+            return;
+        }
+        GetGLExtensions().programParameteri(shaderProgramID, programBinaryRetrievableHint, GL_TRUE);
+    }
+    //2. Compile shaders. Nothing is queried until Finish, so parallel compilation can run in the background.
+    vertexShader = glCreateShader(GL_VERTEX_SHADER);
+    glShaderSource(vertexShader, 1, &vShaderCode, &vertexLength);
+    glCompileShader(vertexShader);
+    fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
+    glShaderSource(fragmentShader, 1, &fShaderCode, &fragmentLength);
+    glCompileShader(fragmentShader);
+    //Link shader program.
+    glAttachShader(shaderProgramID, vertexShader);
+    glAttachShader(shaderProgramID, fragmentShader);
     glLinkProgram(shaderProgramID);
-    //Print linking errors if any.
-    glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &success);
-    if (!success)
+    buildMilliseconds = MillisecondsSince(start);
+}
+
+bool ShaderProgram::Finish()
+{
+    if (finished)
     {
+        return true;
+    }
+    finished = true;
+    std::ostringstream message;
+    message << std::fixed << std::setprecision(1);
+    if (fromBinaryCache)
+    {
+        message << "Shader " << name << ": loaded from the shader cache in " << buildMilliseconds << " ms\n";
+        std::cout << message.str();
+        return true;
+    }
+    const Clock::time_point start = Clock::now();
+    //Print compile and linking errors if any (these queries wait for the driver threads).
+    bool success = CheckCompileStatus(vertexShader, "VERTEX", name);
+    success = CheckCompileStatus(fragmentShader, "FRAGMENT", name) && success;
+    int linked = 0;
+    glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &linked);
+    if (!linked)
+    {
+        char infoLog[512];
         glGetProgramInfoLog(shaderProgramID, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED (" << name << ")\n" << infoLog << std::endl;
+        success = false;
     }
     //Delete the shaders as they're linked into our program now and no longer necessary.
-    glDeleteShader(vertex);
-    glDeleteShader(fragment);
+    glDetachShader(shaderProgramID, vertexShader);
+    glDetachShader(shaderProgramID, fragmentShader);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+    vertexShader = fragmentShader = 0;
+    if (success && binaryKey != 0)
+    {
+        SaveBinary();
+    }
+    buildMilliseconds += MillisecondsSince(start);
+    message << "Shader " << name << ": compiled in " << buildMilliseconds << " ms"
+        << (GetGLExtensions().hasParallelShaderCompile ? " (parallel)\n" : "\n");
+    std::cout << message.str();
+    return success;
+}
+
+bool ShaderProgram::IsFromBinaryCache() const
+{
+    return fromBinaryCache;
+}
+
+double ShaderProgram::GetBuildMilliseconds() const
+{
+    return buildMilliseconds;
+}
+
+const std::string& ShaderProgram::GetName() const
+{
+    return name;
+}
+
+bool ShaderProgram::LoadBinary()
+{
+    std::ifstream file(GetBinaryPath(), std::ios::binary);
+    BinaryHeader header{};
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header))
+        || std::memcmp(header.magic, binaryMagic, sizeof(binaryMagic)) != 0 || header.key != binaryKey)
+    {
+        return false;
+    }
+    //A damaged size must not turn into a huge allocation: the binary has to fit in what is left of the file.
+    std::error_code ec;
+    const uintmax_t fileSize = std::filesystem::file_size(GetBinaryPath(), ec);
+    if (ec || header.size == 0 || header.size > fileSize - sizeof(header))
+    {
+        return false;
+    }
+    std::vector<char> binary((size_t)header.size);
+    if (!file.read(binary.data(), (std::streamsize)binary.size()))
+    {
+        return false;
+    }
+    //A driver update may still refuse it; the program is then compiled from source as usual.
+    GetGLExtensions().programBinary(shaderProgramID, header.format, binary.data(), (GLsizei)binary.size());
+    int linked = 0;
+    glGetProgramiv(shaderProgramID, GL_LINK_STATUS, &linked);
+    return linked != 0;
+}
+
+void ShaderProgram::SaveBinary() const
+{
+    GLint length = 0;
+    glGetProgramiv(shaderProgramID, programBinaryLength, &length);
+    if (length <= 0)
+    {
+        return;
+    }
+    std::vector<char> binary((size_t)length);
+    GLenum format = 0;
+    GetGLExtensions().getProgramBinary(shaderProgramID, length, &length, &format, binary.data());
+    BinaryHeader header{};
+    std::memcpy(header.magic, binaryMagic, sizeof(binaryMagic));
+    header.format = format;
+    header.key = binaryKey;
+    header.size = (uint64_t)length;
+    //Written next to the final file and renamed, so a crash never leaves a truncated binary behind.
+    const std::string path = GetBinaryPath();
+    const std::string temporaryPath = path + ".tmp";
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, ec);
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(binary.data(), length);
+        if (!file)
+        {
+            std::cout << "Could not write the shader cache: " << temporaryPath << "\n";
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, ec);
+}
+
+std::string ShaderProgram::GetBinaryPath() const
+{
+    char fileName[32];
+    std::snprintf(fileName, sizeof(fileName), "%016llx.program", (unsigned long long)binaryKey);
+    return settings::cachePath + fileName;
 }
 
 ShaderProgram::~ShaderProgram() noexcept
 {
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
     glDeleteProgram(shaderProgramID);
 }
 
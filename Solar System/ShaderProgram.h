@@ -2,17 +2,32 @@
 #include <assert.h>
 #include "glm/glm.hpp"
 #include <glad/glad.h>
+#include <cstdint>
 #include <string>
+#include <vector>
+class AssetPack;
 //A class that represents a shader program, manages the loading from disk, compiling and linking of shaders.
 //Also manages the uniform attributes of the shader program.
+//Linked programs are kept in the shader cache (ARB_get_program_binary), keyed by their sources and the driver,
+//so later launches skip compiling. Compiling and linking only start in the constructor: with
+//KHR_parallel_shader_compile they run on driver threads, and Finish collects the result.
 class ShaderProgram
 {
 public:
 	ShaderProgram(std::string vertexShaderPath, std::string fragmentShaderPath);//Compiles and links the shaders.
+	//Reads the sources straight from the asset pack when it has both, from disk otherwise. Call Finish before use.
+	//Every name in defines becomes a #define right after the #version line of both shaders.
+	ShaderProgram(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, const AssetPack& assets,
+		const std::vector<std::string>& defines = {});
 	ShaderProgram(const ShaderProgram& other) = delete;
 	ShaderProgram& operator=(const ShaderProgram& other) = delete;
 	~ShaderProgram() noexcept;
 	unsigned int GetID() const;	//Returns the shader program ID generated by OpenGL.
+	//Waits for the link, prints the errors and the build time, and saves the binary. Returns false on errors.
+	bool Finish();
+	bool IsFromBinaryCache() const;	//Loaded from the shader cache instead of compiled.
+	double GetBuildMilliseconds() const;	//Time the calling thread spent building the program.
+	const std::string& GetName() const;		//The two file names and the defines.
 public:
 	//Define the uniform sending functions using some elegant templating.
 	template<typename T>
@@ -20,11 +35,26 @@ public:
 	{
 		assert(false); //Trying to send an unsupported type.
 	}
+	void SendUniformArray(std::string uniformName, const glm::vec4* values, int count);	//Sends uniformName[0..count).
 	// Specializations are defined out-of-class below for GCC/Clang compatibility.
 private:
 	unsigned int GetUniformID(std::string uniformName) const;	//Returns the identifier of the given uniform.
+	void LoadFiles(const std::string& vertexShaderPath, const std::string& fragmentShaderPath);	//Reads both sources, then Build.
+	//Loads the cached binary, or starts compiling and linking. Lengths of -1 mean null-terminated sources.
+	void Build(const char* vertexCode, int vertexLength, const char* fragmentCode, int fragmentLength);
+	bool LoadBinary();
+	void SaveBinary() const;
+	std::string GetBinaryPath() const;
 private:
-	unsigned int shaderProgramID;
+	unsigned int shaderProgramID = 0;
+	unsigned int vertexShader = 0;		//Kept until Finish has read their logs.
+	unsigned int fragmentShader = 0;
+	std::string name;					//The two file names and the defines, for the messages.
+	std::string defineLines;			//Injected into both sources.
+	uint64_t binaryKey = 0;				//Hash of both sources and the driver strings.
+	bool fromBinaryCache = false;
+	bool finished = false;
+	double buildMilliseconds = 0.0;
 	};
 
 // Define template specializations out-of-class to satisfy GCC
@@ -40,6 +70,12 @@ inline void ShaderProgram::SendUniform<glm::mat3>(std::string uniformName, const
 	glUniformMatrix3fv(GetUniformID(uniformName), 1, GL_FALSE, &value[0][0]);
 }
 
+template<>
+inline void ShaderProgram::SendUniform<glm::vec2>(std::string uniformName, const glm::vec2& value)
+{
+	glUniform2fv(GetUniformID(uniformName), 1, &value[0]);
+}
+
 template<>
 inline void ShaderProgram::SendUniform<glm::vec3>(std::string uniformName, const glm::vec3& value)
 {
@@ -62,4 +98,9 @@ template<>
 inline void ShaderProgram::SendUniform<float>(std::string uniformName, const float& value)
 {
 	glUniform1f(GetUniformID(uniformName), value);
+}
+
+inline void ShaderProgram::SendUniformArray(std::string uniformName, const glm::vec4* values, int count)
+{
+	glUniform4fv(GetUniformID(uniformName), count, &values[0][0]);
 }
\ No newline at end of file
@@ -0,0 +1,254 @@
+// Skybox: equirectangular -> cubemap conversion (cached on disk) and cubemap upload.
+#include "Skybox.h"
+#include "AssetPack.h"
+#include <glad/glad.h>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <filesystem>
+#include <iostream>
+#include "stb_image.h"
+
+namespace {
+    constexpr char cacheMagic[4] = { 'S', 'K', 'Y', 'C' };
+    constexpr uint32_t cacheVersion = 1;
+    constexpr int faceChannels = 3;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t faceSize;
+        uint32_t channels;
+        uint64_t sourceSize;        //Size of the equirectangular image the faces were built from.
+        int64_t sourceWriteTime;    //Last write time of that image, invalidates the cache when the image changes.
+    };
+
+    //Header of the faces in the asset pack, the faces follow.
+    struct PackedFacesHeader
+    {
+        uint32_t faceSize;
+        uint32_t channels;
+        uint64_t reserved;
+    };
+
+    bool DescribeSource(const std::string& path, uint64_t& size, int64_t& writeTime)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
+        auto time = std::filesystem::last_write_time(path, ec);
+        if (ec)
+            return false;
+        writeTime = (int64_t)time.time_since_epoch().count();
+        return true;
+    }
+
+    //Direction through texel (s,t) of a cube face, following the GL face orientation table.
+    void FaceDirection(int face, float s, float t, float& x, float& y, float& z)
+    {
+        switch (face)
+        {
+        case 0: x = 1.0f;  y = -t;    z = -s;    break; // +X
+        case 1: x = -1.0f; y = -t;    z = s;     break; // -X
+        case 2: x = s;     y = 1.0f;  z = t;     break; // +Y
+        case 3: x = s;     y = -1.0f; z = -t;    break; // -Y
+        case 4: x = s;     y = -t;    z = 1.0f;  break; // +Z
+        default: x = -s;   y = -t;    z = -1.0f; break; // -Z
+        }
+    }
+}
+
+Skybox::Skybox(const std::string& equirectPath, const std::string& cacheFilePath, int faceSize)
+    :
+    faceSize(faceSize)
+{
+    LoadFaces(equirectPath, cacheFilePath);
+}
+
+Skybox::Skybox(const std::string& equirectPath, const std::string& cacheFilePath, int faceSize, const AssetPack& assets)
+    :
+    faceSize(faceSize)
+{
+    const AssetPack::Entry* entry = assets.Find(equirectPath, AssetPack::Type::Cubemap);
+    PackedFacesHeader header{};
+    if (entry != nullptr && entry->size >= sizeof(header))
+        std::memcpy(&header, entry->data, sizeof(header));
+    const size_t facesBytes = (size_t)faceSize * faceSize * faceChannels * 6;
+    if (entry == nullptr || header.faceSize != (uint32_t)faceSize || header.channels != (uint32_t)faceChannels
+        || entry->size < sizeof(header) + facesBytes)
+    {
+        LoadFaces(equirectPath, cacheFilePath);
+        return;
+    }
+    Upload(entry->data + sizeof(header));
+}
+
+Skybox::~Skybox() noexcept
+{
+    if (cubemapID != 0)
+        glDeleteTextures(1, &cubemapID);
+    if (VAO != 0)
+        glDeleteVertexArrays(1, &VAO);
+}
+
+unsigned int Skybox::GetCubemapID() const
+{
+    return cubemapID;
+}
+
+unsigned int Skybox::GetVAO() const
+{
+    return VAO;
+}
+
+std::vector<unsigned char> Skybox::PackFaces(const std::string& equirectPath, int faceSize)
+{
+    std::vector<unsigned char> faces;
+    ConvertEquirect(equirectPath, faceSize, faces);
+    PackedFacesHeader header{ (uint32_t)faceSize, (uint32_t)faceChannels, 0 };
+    std::vector<unsigned char> payload(sizeof(header) + faces.size());
+    std::memcpy(payload.data(), &header, sizeof(header));
+    std::memcpy(payload.data() + sizeof(header), faces.data(), faces.size());
+    return payload;
+}
+
+void Skybox::LoadFaces(const std::string& equirectPath, const std::string& cacheFilePath)
+{
+    std::vector<unsigned char> faces;
+    if (!LoadCache(cacheFilePath, equirectPath, faces))
+    {
+        std::cout << "Building skybox cubemap from: " << equirectPath << "\n";
+        ConvertEquirect(equirectPath, faceSize, faces);
+        SaveCache(cacheFilePath, equirectPath, faces);
+    }
+    Upload(faces.data());
+}
+
+void Skybox::Upload(const unsigned char* faces)
+{
+    //Upload the six faces.
+    glGenTextures(1, &cubemapID);
+    glBindTexture(GL_TEXTURE_CUBE_MAP, cubemapID);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    const size_t faceBytes = (size_t)faceSize * faceSize * faceChannels;
+    for (int face = 0; face < 6; ++face)
+    {
+        glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + face, 0, GL_RGB, faceSize, faceSize, 0, GL_RGB, GL_UNSIGNED_BYTE, faces + face * faceBytes);
+    }
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+    //Core profile requires a bound VAO even when the vertex shader reads no attributes.
+    glGenVertexArrays(1, &VAO);
+}
+
+bool Skybox::LoadCache(const std::string& cacheFilePath, const std::string& equirectPath, std::vector<unsigned char>& faces) const
+{
+    uint64_t sourceSize = 0;
+    int64_t sourceWriteTime = 0;
+    if (!DescribeSource(equirectPath, sourceSize, sourceWriteTime))
+        return false;
+    std::ifstream file(cacheFilePath, std::ios::binary);
+    if (!file)
+        return false;
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion
+        || header.faceSize != (uint32_t)faceSize || header.channels != (uint32_t)faceChannels
+        || header.sourceSize != sourceSize || header.sourceWriteTime != sourceWriteTime)
+    {
+        return false;
+    }
+    faces.resize((size_t)faceSize * faceSize * faceChannels * 6);
+    file.read(reinterpret_cast<char*>(faces.data()), (std::streamsize)faces.size());
+    return (bool)file;
+}
+
+void Skybox::SaveCache(const std::string& cacheFilePath, const std::string& equirectPath, const std::vector<unsigned char>& faces) const
+{
+    CacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.faceSize = (uint32_t)faceSize;
+    header.channels = (uint32_t)faceChannels;
+    if (!DescribeSource(equirectPath, header.sourceSize, header.sourceWriteTime))
+        return;
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(cacheFilePath).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, ec);
+    std::ofstream file(cacheFilePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Could not write skybox cache: " << cacheFilePath << "\n";
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(faces.data()), (std::streamsize)faces.size());
+}
+
+void Skybox::ConvertEquirect(const std::string& equirectPath, int faceSize, std::vector<unsigned char>& faces)
+{
+    //Top row first so that v = 0 is the north pole.
+    stbi_set_flip_vertically_on_load(0);
+    int width = 0, height = 0, channels = 0;
+    unsigned char* data = stbi_load(equirectPath.c_str(), &width, &height, &channels, faceChannels);
+    if (!data)
+    {
+        std::cout << "Failed to load texture : " << equirectPath << "\n";
+        exit(EXIT_FAILURE);
+    }
+    const float invTwoPi = 0.15915494309f;
+    const float invPi = 0.31830988618f;
+    const size_t faceBytes = (size_t)faceSize * faceSize * faceChannels;
+    faces.resize(faceBytes * 6);
+    for (int face = 0; face < 6; ++face)
+    {
+        unsigned char* out = faces.data() + face * faceBytes;
+        for (int row = 0; row < faceSize; ++row)
+        {
+            float t = ((row + 0.5f) / faceSize) * 2.0f - 1.0f;
+            for (int col = 0; col < faceSize; ++col)
+            {
+                float s = ((col + 0.5f) / faceSize) * 2.0f - 1.0f;
+                float x, y, z;
+                FaceDirection(face, s, t, x, y, z);
+                float invLength = 1.0f / sqrtf(x * x + y * y + z * z);
+                x *= invLength; y *= invLength; z *= invLength;
+                //Same spherical mapping as the generated sphere meshes.
+                float u = 0.5f + atan2f(z, x) * invTwoPi;
+                float v = 0.5f - asinf(y) * invPi;
+                //Bilinear sample, wrapping horizontally and clamping at the poles.
+                float fx = u * width - 0.5f;
+                float fy = std::fmin(std::fmax(v * height - 0.5f, 0.0f), (float)(height - 1));
+                int x0 = (int)floorf(fx);
+                int y0 = (int)fy;
+                float ax = fx - x0;
+                float ay = fy - y0;
+                int x1 = x0 + 1;
+                int y1 = y0 + 1 < height ? y0 + 1 : y0;
+                x0 = ((x0 % width) + width) % width;
+                x1 = ((x1 % width) + width) % width;
+                const unsigned char* p00 = data + ((size_t)y0 * width + x0) * faceChannels;
+                const unsigned char* p10 = data + ((size_t)y0 * width + x1) * faceChannels;
+                const unsigned char* p01 = data + ((size_t)y1 * width + x0) * faceChannels;
+                const unsigned char* p11 = data + ((size_t)y1 * width + x1) * faceChannels;
+                unsigned char* texel = out + ((size_t)row * faceSize + col) * faceChannels;
+                for (int c = 0; c < faceChannels; ++c)
+                {
+                    float top = p00[c] + (p10[c] - p00[c]) * ax;
+                    float bottom = p01[c] + (p11[c] - p01[c]) * ax;
+                    texel[c] = (unsigned char)(top + (bottom - top) * ay + 0.5f);
+                }
+            }
+        }
+    }
+    stbi_image_free(data);
+}
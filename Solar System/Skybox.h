@@ -0,0 +1,31 @@
+#pragma once
+#include <string>
+#include <vector>
+// Star background stored as a cubemap and drawn as a single full-screen triangle at the far plane.
+// The equirectangular source image is resampled into six cube faces once; the faces are cached on
+// disk (keyed by the source file's size and timestamp) so later launches skip the decode and resampling.
+// When the asset pack holds the faces they are uploaded straight from the mapped file instead.
+class AssetPack;
+class Skybox
+{
+public:
+	Skybox(const std::string& equirectPath, const std::string& cacheFilePath, int faceSize);
+	Skybox(const std::string& equirectPath, const std::string& cacheFilePath, int faceSize, const AssetPack& assets);
+	Skybox(const Skybox& other) = delete;				//No copy construction allowed.
+	Skybox& operator=(const Skybox& other) = delete;	//No copy assignment allowed.
+	~Skybox() noexcept;									//Frees the cubemap and the empty VAO.
+	unsigned int GetCubemapID() const;
+	unsigned int GetVAO() const;						//Attribute-less VAO; vertices are generated from gl_VertexID.
+	//The asset pack payload for the image (a small header and the six faces), built by asset_packer.
+	static std::vector<unsigned char> PackFaces(const std::string& equirectPath, int faceSize);
+private:
+	void LoadFaces(const std::string& equirectPath, const std::string& cacheFilePath);	//Cache, else conversion, then Upload.
+	void Upload(const unsigned char* faces);
+	bool LoadCache(const std::string& cacheFilePath, const std::string& equirectPath, std::vector<unsigned char>& faces) const;
+	void SaveCache(const std::string& cacheFilePath, const std::string& equirectPath, const std::vector<unsigned char>& faces) const;
+	static void ConvertEquirect(const std::string& equirectPath, int faceSize, std::vector<unsigned char>& faces);
+private:
+	unsigned int cubemapID = 0;
+	unsigned int VAO = 0;
+	int faceSize;
+};
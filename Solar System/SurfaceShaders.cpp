@@ -0,0 +1,62 @@
+// SurfaceShaders: builds the surface uber-shader permutations on demand.
+#include "SurfaceShaders.h"
+#include "AssetPack.h"
+#include <cassert>
+#include <iostream>
+
+SurfaceShaders::SurfaceShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath,
+    const AssetPack& assets, const std::vector<unsigned int>& permutations) :
+    vertexShaderPath(vertexShaderPath),
+    fragmentShaderPath(fragmentShaderPath),
+    assets(assets)
+{
+    for (unsigned int features : permutations)
+    {
+        Request(features);
+    }
+}
+
+void SurfaceShaders::Request(unsigned int features)
+{
+    if (programs.find(features) == programs.end())
+    {
+        programs.emplace(features, std::make_unique<ShaderProgram>(vertexShaderPath, fragmentShaderPath, assets,
+            GetDefines(features)));
+    }
+}
+
+ShaderProgram& SurfaceShaders::Get(unsigned int features)
+{
+    auto found = programs.find(features);
+    if (found == programs.end())
+    {
+        std::cout << "SurfaceShaders: permutation " << features << " was never requested, its uniforms are not set\n";
+        assert(false); //Add the permutation to the ones requested at startup.
+        Request(features);
+        found = programs.find(features);
+    }
+    ShaderProgram& program = *found->second;
+    program.Finish();   //Returns at once when the program is done already.
+    return program;
+}
+
+const std::map<unsigned int, std::unique_ptr<ShaderProgram>>& SurfaceShaders::GetPrograms() const
+{
+    return programs;
+}
+
+std::vector<std::string> SurfaceShaders::GetDefines(unsigned int features)
+{
+    static const std::pair<Feature, const char*> names[] = {
+        { RimLight, "RIM_LIGHT" }, { UvFlow, "UV_FLOW" }, { NightLights, "NIGHT_LIGHTS" },
+        { SpecularMask, "SPECULAR_MASK" }, { Clouds, "CLOUDS" }, { AlphaOverlay, "ALPHA_OVERLAY" }, { Unlit, "UNLIT" } };
+    std::vector<std::string> defines;
+    for (const auto& name : names)
+    {
+        if (features & name.first)
+        {
+            defines.push_back(name.second);
+        }
+    }
+    return defines;
+}
@@ -0,0 +1,37 @@
+#pragma once
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ShaderProgram.h"
+class AssetPack;
+// Permutations of the surface uber-shader (surface.vert + surface.frag). Each feature a body needs is a
+// compile-time #define, so a program only contains the lighting terms and texture fetches of its own
+// combination instead of branching on uniforms per fragment. The combinations the scene uses are requested
+// up front and compile in parallel with the rest of startup, and the game sets their uniforms once they are built.
+class SurfaceShaders
+{
+public:
+	enum Feature : unsigned int
+	{
+		RimLight = 1,		//Soft rim on the dark side (rocky bodies).
+		UvFlow = 2,			//Drifting UVs (gas giants).
+		NightLights = 4,	//Night map on unit 1 (Earth).
+		SpecularMask = 8,	//Masked sun highlight, mask on unit 2 (Earth's oceans).
+		Clouds = 16,		//Cloud layer on unit 3.
+		AlphaOverlay = 32,	//Translucent, tinted overlays (atmospheres, rings).
+		Unlit = 64			//Emissive and scrolling (the Sun).
+	};
+	SurfaceShaders(const std::string& vertexShaderPath, const std::string& fragmentShaderPath, const AssetPack& assets,
+		const std::vector<unsigned int>& permutations);
+	void Request(unsigned int features);	//Starts compiling the permutation unless it exists already.
+	//Ready to use. Asking for a permutation that was never requested is an error: it would lack its uniform setup.
+	ShaderProgram& Get(unsigned int features);
+	const std::map<unsigned int, std::unique_ptr<ShaderProgram>>& GetPrograms() const;
+	static std::vector<std::string> GetDefines(unsigned int features);	//"RIM_LIGHT", "UV_FLOW", ...
+private:
+	std::string vertexShaderPath;
+	std::string fragmentShaderPath;
+	const AssetPack& assets;
+	std::map<unsigned int, std::unique_ptr<ShaderProgram>> programs;	//Ordered, so draws can be sorted by key.
+};
@@ -0,0 +1,343 @@
+// TextRenderer: SDF glyph atlas built from stb_easy_font and instanced label drawing.
+#include "TextRenderer.h"
+#include "ShaderProgram.h"
+#include "Window.h"
+#include "../Dependencies/stb_easy_font.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <iostream>
+
+namespace {
+    constexpr int firstGlyph = 32;              //Printable ASCII only.
+    constexpr int glyphCount = 96;
+    constexpr int atlasColumns = 16;
+    constexpr int texelsPerUnit = 8;            //One font pixel becomes 8x8 atlas texels.
+    constexpr int paddingUnits = 1;             //Room around each glyph for the distance falloff.
+    constexpr float spreadTexels = 6.0f;        //Distance mapped to the full 0..1 range of the atlas.
+    constexpr float farAway = 1e20f;
+
+    //Squared Euclidean distance transform of one row or column (Felzenszwalb and Huttenlocher).
+    void DistanceTransform1D(const float* f, float* d, int n, std::vector<int>& v, std::vector<float>& z)
+    {
+        int k = 0;
+        v[0] = 0;
+        z[0] = -farAway;
+        z[1] = farAway;
+        for (int q = 1; q < n; ++q)
+        {
+            float s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+            while (s <= z[k])
+            {
+                --k;
+                s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2.0f * q - 2.0f * v[k]);
+            }
+            ++k;
+            v[k] = q;
+            z[k] = s;
+            z[k + 1] = farAway;
+        }
+        k = 0;
+        for (int q = 0; q < n; ++q)
+        {
+            while (z[k + 1] < q)
+                ++k;
+            d[q] = (float)((q - v[k]) * (q - v[k])) + f[v[k]];
+        }
+    }
+
+    //grid holds 0 on features and farAway elsewhere; on return it holds the squared distance to the nearest feature.
+    void DistanceTransform2D(std::vector<float>& grid, int width, int height)
+    {
+        int n = std::max(width, height);
+        std::vector<float> f(n), d(n), z(n + 1);
+        std::vector<int> v(n);
+        for (int x = 0; x < width; ++x)
+        {
+            for (int y = 0; y < height; ++y)
+                f[y] = grid[y * width + x];
+            DistanceTransform1D(f.data(), d.data(), height, v, z);
+            for (int y = 0; y < height; ++y)
+                grid[y * width + x] = d[y];
+        }
+        for (int y = 0; y < height; ++y)
+        {
+            DistanceTransform1D(&grid[y * width], d.data(), width, v, z);
+            std::copy(d.begin(), d.begin() + width, grid.begin() + y * width);
+        }
+    }
+}
+
+TextRenderer::TextRenderer()
+    :
+    placementUniforms(maxLabels, glm::vec4(0.0f)),
+    colorUniforms(maxLabels, glm::vec4(1.0f))
+{
+    BuildAtlas();
+    CreateBuffers();
+}
+
+TextRenderer::~TextRenderer() noexcept
+{
+    glDeleteTextures(1, &atlasTexture);
+    glDeleteBuffers(1, &quadBuffer);
+    glDeleteBuffers(1, &indexBuffer);
+    glDeleteBuffers(1, &instanceBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+int TextRenderer::CreateLabel()
+{
+    if ((int)labels.size() >= maxLabels)
+    {
+        std::cout << "TextRenderer: all " << maxLabels << " label slots are taken\n";
+        return -1;
+    }
+    labels.push_back(Label{});
+    int label = (int)labels.size() - 1;
+    placementUniforms[label] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    colorUniforms[label] = glm::vec4(1.0f);
+    return label;
+}
+
+int TextRenderer::GetFreeLabelCount() const
+{
+    return maxLabels - (int)labels.size();
+}
+
+void TextRenderer::SetText(int label, const std::string& text)
+{
+    if (!IsValid(label) || labels[label].text == text)
+        return;
+    labels[label].text = text;
+    instancesDirty = true;
+}
+
+void TextRenderer::SetPlacement(int label, const glm::vec2& origin, float scale)
+{
+    if (!IsValid(label))
+        return;
+    labels[label].origin = origin;
+    labels[label].scale = scale;
+    placementUniforms[label] = glm::vec4(origin, labels[label].visible ? scale : 0.0f, 0.0f);
+}
+
+void TextRenderer::SetColor(int label, const glm::vec4& color)
+{
+    if (!IsValid(label))
+        return;
+    labels[label].color = color;
+    colorUniforms[label] = color;
+}
+
+void TextRenderer::SetVisible(int label, bool visible)
+{
+    if (!IsValid(label))
+        return;
+    labels[label].visible = visible;
+    //A zero scale collapses the label's quads, so hiding never touches the instance buffer.
+    placementUniforms[label].z = visible ? labels[label].scale : 0.0f;
+}
+
+glm::vec2 TextRenderer::MeasureText(const std::string& text) const
+{
+    return glm::vec2((float)stb_easy_font_width(text.c_str()), (float)stb_easy_font_height(text.c_str()));
+}
+
+void TextRenderer::Draw(Window& window, ShaderProgram& shader, const glm::mat4& projection)
+{
+    if (instancesDirty)
+    {
+        RebuildInstances();
+    }
+    bool anyVisible = std::any_of(labels.begin(), labels.end(), [](const Label& label) { return label.visible && !label.text.empty(); });
+    if (instances.empty() || !anyVisible)
+    {
+        return;
+    }
+    window.UseShader(shader);
+    shader.SendUniform<glm::mat4>("projection", projection);
+    shader.SendUniformArray("labelPlacements", placementUniforms.data(), (int)labels.size());
+    shader.SendUniformArray("labelColors", colorUniforms.data(), (int)labels.size());
+    shader.SendUniform<glm::vec2>("cellSize", cellSize);
+    shader.SendUniform<glm::vec2>("atlasCellSize", atlasCellSize);
+    shader.SendUniform<int>("atlasColumns", atlasColumns);
+    shader.SendUniform<int>("atlas", 0);
+    window.BindTexture(0, GL_TEXTURE_2D, atlasTexture);
+    window.BindVertexArray(vertexArray);
+    window.DrawElementsInstanced(GL_TRIANGLES, 6, GL_UNSIGNED_SHORT, (int)instances.size());
+}
+
+unsigned int TextRenderer::GetRebuildCount() const
+{
+    return rebuildCount;
+}
+
+void TextRenderer::BuildAtlas()
+{
+    //Rasterize every glyph with stb_easy_font first: the cell size depends on the widest glyph.
+    std::vector<std::vector<float>> glyphVertices(glyphCount);
+    glyphAdvances.assign(glyphCount, 0.0f);
+    glyphHasInk.assign(glyphCount, false);
+    float widest = 0.0f;
+    for (int i = 0; i < glyphCount; ++i)
+    {
+        char text[2] = { (char)(firstGlyph + i), '\0' };
+        std::vector<float>& vertices = glyphVertices[i];
+        vertices.resize(6 * 2 * 64);
+        int vertexCount = stb_easy_font_print(0.0f, 0.0f, text, nullptr, vertices.data(), (int)(vertices.size() * sizeof(float)));
+        vertices.resize((size_t)vertexCount * 2);
+        glyphAdvances[i] = (float)stb_easy_font_width(text);
+        glyphHasInk[i] = vertexCount > 0;
+        for (int v = 0; v < vertexCount; ++v)
+        {
+            widest = std::max(widest, vertices[v * 2]);
+        }
+    }
+    lineHeight = (float)stb_easy_font_height("A");
+    cellSize = glm::vec2(std::ceil(widest) + 2 * paddingUnits, lineHeight + 2 * paddingUnits);
+
+    const int cellWidth = (int)cellSize.x * texelsPerUnit;
+    const int cellHeight = (int)cellSize.y * texelsPerUnit;
+    const int atlasRows = (glyphCount + atlasColumns - 1) / atlasColumns;
+    const int atlasWidth = cellWidth * atlasColumns;
+    const int atlasHeight = cellHeight * atlasRows;
+    atlasCellSize = glm::vec2(1.0f / atlasColumns, 1.0f / atlasRows);
+
+    std::vector<unsigned char> atlas((size_t)atlasWidth * atlasHeight, 0);
+    std::vector<bool> inside((size_t)cellWidth * cellHeight);
+    std::vector<float> toInside((size_t)cellWidth * cellHeight);
+    std::vector<float> toOutside((size_t)cellWidth * cellHeight);
+    for (int i = 0; i < glyphCount; ++i)
+    {
+        if (!glyphHasInk[i])
+            continue;
+        //Every 6 vertices form one axis-aligned font pixel.
+        std::fill(inside.begin(), inside.end(), false);
+        const std::vector<float>& vertices = glyphVertices[i];
+        for (size_t quad = 0; quad + 12 <= vertices.size(); quad += 12)
+        {
+            float x0 = vertices[quad], y0 = vertices[quad + 1], x1 = x0, y1 = y0;
+            for (size_t v = quad; v < quad + 12; v += 2)
+            {
+                x0 = std::min(x0, vertices[v]);
+                x1 = std::max(x1, vertices[v]);
+                y0 = std::min(y0, vertices[v + 1]);
+                y1 = std::max(y1, vertices[v + 1]);
+            }
+            for (int y = (int)((y0 + paddingUnits) * texelsPerUnit); y < (int)((y1 + paddingUnits) * texelsPerUnit); ++y)
+            {
+                for (int x = (int)((x0 + paddingUnits) * texelsPerUnit); x < (int)((x1 + paddingUnits) * texelsPerUnit); ++x)
+                {
+                    inside[y * cellWidth + x] = true;
+                }
+            }
+        }
+        for (size_t t = 0; t < inside.size(); ++t)
+        {
+            toInside[t] = inside[t] ? 0.0f : farAway;
+            toOutside[t] = inside[t] ? farAway : 0.0f;
+        }
+        DistanceTransform2D(toInside, cellWidth, cellHeight);
+        DistanceTransform2D(toOutside, cellWidth, cellHeight);
+        //Distances are measured between texel centers, the edge lies half a texel away from both sides.
+        const int cellX = (i % atlasColumns) * cellWidth;
+        const int cellY = (i / atlasColumns) * cellHeight;
+        for (int y = 0; y < cellHeight; ++y)
+        {
+            for (int x = 0; x < cellWidth; ++x)
+            {
+                size_t t = (size_t)y * cellWidth + x;
+                float distance = inside[t] ? std::sqrt(toOutside[t]) - 0.5f : 0.5f - std::sqrt(toInside[t]);
+                float value = std::clamp(0.5f + distance / (2.0f * spreadTexels), 0.0f, 1.0f);
+                atlas[(size_t)(cellY + y) * atlasWidth + cellX + x] = (unsigned char)std::lround(value * 255.0f);
+            }
+        }
+    }
+
+    glGenTextures(1, &atlasTexture);
+    glBindTexture(GL_TEXTURE_2D, atlasTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasWidth, atlasHeight, 0, GL_RED, GL_UNSIGNED_BYTE, atlas.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    //Small HUD text samples the atlas heavily minified; a few mips keep it from shimmering.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 3);
+    glGenerateMipmap(GL_TEXTURE_2D);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+void TextRenderer::CreateBuffers()
+{
+    const float corners[] = { 0.0f, 0.0f, 1.0f, 0.0f, 1.0f, 1.0f, 0.0f, 1.0f };
+    const unsigned short indices[] = { 0, 1, 2, 0, 2, 3 };
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &quadBuffer);
+    glGenBuffers(1, &indexBuffer);
+    glGenBuffers(1, &instanceBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, quadBuffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, offsetX));
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2);
+    glVertexAttribIPointer(2, 2, GL_UNSIGNED_SHORT, sizeof(GlyphInstance), (void*)offsetof(GlyphInstance, glyph));
+    glVertexAttribDivisor(2, 1);
+    glBindVertexArray(0);
+}
+
+void TextRenderer::RebuildInstances()
+{
+    instances.clear();
+    for (size_t label = 0; label < labels.size(); ++label)
+    {
+        float cursorX = 0.0f;
+        float cursorY = 0.0f;
+        for (char c : labels[label].text)
+        {
+            if (c == '\n')
+            {
+                cursorX = 0.0f;
+                cursorY += lineHeight;
+                continue;
+            }
+            int glyph = (unsigned char)c - firstGlyph;
+            if (glyph < 0 || glyph >= glyphCount)
+            {
+                glyph = 0;
+            }
+            if (glyphHasInk[glyph])
+            {
+                instances.push_back({ cursorX - paddingUnits, cursorY - paddingUnits, (unsigned short)glyph, (unsigned short)label });
+            }
+            cursorX += glyphAdvances[glyph];
+        }
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+    if (instances.size() > instanceCapacity)
+    {
+        instanceCapacity = std::max(instances.size(), instanceCapacity * 2);
+        glBufferData(GL_ARRAY_BUFFER, instanceCapacity * sizeof(GlyphInstance), nullptr, GL_DYNAMIC_DRAW);
+    }
+    if (!instances.empty())
+    {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(GlyphInstance), instances.data());
+    }
+    instancesDirty = false;
+    ++rebuildCount;
+}
+
+bool TextRenderer::IsValid(int label) const
+{
+    return label >= 0 && label < (int)labels.size();
+}
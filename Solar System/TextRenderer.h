@@ -0,0 +1,67 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "glm/glm.hpp"
+class Window;
+class ShaderProgram;
+// Screen-space text. The stb_easy_font glyphs are rasterized once into a signed distance field atlas, and every
+// label is drawn as indexed instanced quads (one instance per glyph) in a single draw call.
+// Glyph instances are only rebuilt when the text of a label changes; moving, recoloring or hiding a label just
+// updates its uniform slot.
+class TextRenderer
+{
+public:
+	static constexpr int maxLabels = 64;	//Must match MAX_LABELS in text.vert.
+public:
+	TextRenderer();										//Builds the atlas and the GL buffers, needs a current context.
+	TextRenderer(const TextRenderer& other) = delete;				//No copy construction allowed.
+	TextRenderer& operator=(const TextRenderer& other) = delete;	//No copy assignment allowed.
+	~TextRenderer() noexcept;							//Frees the atlas and the buffers.
+	int CreateLabel();									//Returns the new label, or -1 when all slots are taken.
+	int GetFreeLabelCount() const;
+	void SetText(int label, const std::string& text);	//Rebuilds the glyph instances only if the text differs.
+	void SetPlacement(int label, const glm::vec2& origin, float scale);	//Top-left corner in pixels, pixels per font unit.
+	void SetColor(int label, const glm::vec4& color);
+	void SetVisible(int label, bool visible);
+	glm::vec2 MeasureText(const std::string& text) const;	//Size of the text block in font units.
+	void Draw(Window& window, ShaderProgram& shader, const glm::mat4& projection);	//All visible labels in one call.
+	unsigned int GetRebuildCount() const;				//How many times the glyph instances were regenerated.
+private:
+	struct Label
+	{
+		std::string text;
+		glm::vec2 origin = glm::vec2(0.0f);
+		float scale = 1.0f;
+		glm::vec4 color = glm::vec4(1.0f);
+		bool visible = true;
+	};
+	struct GlyphInstance
+	{
+		float offsetX;			//Glyph cell origin relative to the label, in font units.
+		float offsetY;
+		unsigned short glyph;	//Atlas cell.
+		unsigned short label;	//Label slot, indexes the placement and color uniforms.
+	};
+	void BuildAtlas();
+	void CreateBuffers();
+	void RebuildInstances();
+	bool IsValid(int label) const;
+private:
+	unsigned int atlasTexture = 0;
+	unsigned int vertexArray = 0;
+	unsigned int quadBuffer = 0;
+	unsigned int indexBuffer = 0;
+	unsigned int instanceBuffer = 0;
+	size_t instanceCapacity = 0;			//Instances the instance buffer can hold without reallocating.
+	std::vector<Label> labels;
+	std::vector<GlyphInstance> instances;
+	bool instancesDirty = false;
+	unsigned int rebuildCount = 0;
+	std::vector<glm::vec4> placementUniforms;	//xy origin, z scale (0 while hidden).
+	std::vector<glm::vec4> colorUniforms;
+	std::vector<float> glyphAdvances;			//Font units, spacing included.
+	std::vector<bool> glyphHasInk;				//Blank glyphs only advance the cursor.
+	glm::vec2 cellSize = glm::vec2(0.0f);		//Glyph cell in font units, padding included.
+	glm::vec2 atlasCellSize = glm::vec2(0.0f);	//Glyph cell in texture coordinates.
+	float lineHeight = 0.0f;
+};
@@ -1,5 +1,6 @@
 // Texture: loads image via stb_image and uploads to OpenGL with mipmaps.
 #include "Texture.h"
+#include "TextureStreamer.h"
 #include "glad/glad.h"
 #include "stb_image.h"
 #include <iostream>
@@ -33,12 +34,33 @@ Texture::Texture(std::string texturePath)
     stbi_image_free(data);
 }
 
+Texture::Texture(std::string texturePath, TextureStreamer& streamer, const glm::vec4& placeholderColor)
+    :
+    width(1),
+    height(1),
+    channelsCount(4)
+{
+    std::cout << "Loading texture: " << texturePath << "\n";
+    glGenTextures(1, &textureID);
+    glBindTexture(GL_TEXTURE_2D, textureID);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    //A single texel is a complete mip chain, so the placeholder samples like any other texture.
+    glm::vec4 clamped = glm::clamp(placeholderColor, 0.0f, 1.0f) * 255.0f + 0.5f;
+    unsigned char texel[4] = { (unsigned char)clamped.r, (unsigned char)clamped.g, (unsigned char)clamped.b, (unsigned char)clamped.a };
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, texel);
+    streamedImage = streamer.Request(textureID, texturePath);
+}
+
 Texture::Texture(Texture&& other) noexcept
     :
     textureID(other.textureID),
     width(other.width),
     height(other.height),
-    channelsCount(other.channelsCount)
+    channelsCount(other.channelsCount),
+    streamedImage(std::move(other.streamedImage))
 {
     other.textureID = 0;
     other.width = 0;
@@ -56,6 +78,7 @@ Texture& Texture::operator=(Texture&& other) noexcept
         width = other.width;
         height = other.height;
         channelsCount = other.channelsCount;
+        streamedImage = std::move(other.streamedImage);
         other.textureID = 0;
         other.width = 0;
         other.height = 0;
@@ -77,15 +100,20 @@ unsigned int Texture::GetID() const
 
 int Texture::GetWidth() const
 {
-    return width;
+    return streamedImage ? streamedImage->width : width;
 }
 
 int Texture::GetHeight() const
 {
-    return height;
+    return streamedImage ? streamedImage->height : height;
 }
 
 int Texture::GetChannelsCount() const
 {
-    return channelsCount;
+    return streamedImage ? streamedImage->channelsCount : channelsCount;
+}
+
+bool Texture::IsLoaded() const
+{
+    return !streamedImage || streamedImage->loaded;
 }
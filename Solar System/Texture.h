@@ -1,10 +1,16 @@
 #pragma once
 #include <string>
+#include <memory>
+#include "glm/glm.hpp"
+class TextureStreamer;
+struct StreamedImage;
 //Represents a texture, handles its loading from disk.
 class Texture
 {
 public:
 	Texture(std::string texturePath);					//Load the texture data from disk.
+	//Shows a 1x1 placeholder of the given color until the streamer has decoded and uploaded the image.
+	Texture(std::string texturePath, TextureStreamer& streamer, const glm::vec4& placeholderColor = glm::vec4(0.5f, 0.5f, 0.5f, 1.0f));
 	Texture(const Texture& other) = delete;				//No copy construction allowed.
 	Texture& operator=(const Texture& other) = delete;	//No copy assignment allowed.
 	Texture(Texture&& other) noexcept;					//Move constructor.
@@ -14,9 +20,11 @@ public:
 	int GetWidth() const;
 	int GetHeight() const;
 	int GetChannelsCount() const;
+	bool IsLoaded() const;								//False while a streamed texture still shows its placeholder.
 private:
 	unsigned int textureID;
 	int width;
 	int height;
 	int channelsCount;
+	std::shared_ptr<const StreamedImage> streamedImage;	//Set for streamed textures, sizes are read from it.
 };
\ No newline at end of file
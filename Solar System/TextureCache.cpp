@@ -0,0 +1,522 @@
+// TextureCache: linear-light mip chains, BC1/BC3 block compression and the baked texture cache files.
+#include "TextureCache.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+
+namespace {
+    constexpr char cacheMagic[4] = { 'B', 'T', 'E', 'X' };
+    constexpr uint32_t cacheVersion = 1;
+
+    struct CacheHeader
+    {
+        char magic[4];
+        uint32_t version;
+        uint32_t format;
+        uint32_t levelCount;
+        uint64_t sourceSize;        //Size of the image the texture was baked from.
+        int64_t sourceWriteTime;    //Last write time of that image, invalidates the cache when the image changes.
+    };
+
+    struct CacheLevel
+    {
+        uint32_t width;
+        uint32_t height;
+        uint64_t size;
+    };
+
+    //Asset pack payload header, followed by the CacheLevel table and the levels.
+    struct PackedTextureHeader
+    {
+        uint32_t format;
+        uint32_t levelCount;
+        uint64_t dataOffset;    //From the start of the payload, 64-byte aligned.
+    };
+
+    bool DescribeSource(const std::string& path, uint64_t& size, int64_t& writeTime)
+    {
+        std::error_code ec;
+        size = std::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
+        auto time = std::filesystem::last_write_time(path, ec);
+        if (ec)
+            return false;
+        writeTime = (int64_t)time.time_since_epoch().count();
+        return true;
+    }
+
+    //sRGB transfer function both ways; the way back is a 12-bit table, fine enough for 8-bit output.
+    struct GammaTables
+    {
+        float toLinear[256];
+        unsigned char toSrgb[4096];
+        GammaTables()
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                float c = i / 255.0f;
+                toLinear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+            }
+            for (int i = 0; i < 4096; ++i)
+            {
+                float l = i / 4095.0f;
+                float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+                toSrgb[i] = (unsigned char)std::clamp((int)(c * 255.0f + 0.5f), 0, 255);
+            }
+        }
+    };
+
+    const GammaTables& Gamma()
+    {
+        static const GammaTables tables;
+        return tables;
+    }
+
+    //Half size with a 2x2 box filter in linear light. Colors are weighted by alpha so that fully transparent
+    //texels (whose color is meaningless) do not darken the edges of what stays visible.
+    void Downsample(const std::vector<unsigned char>& source, int width, int height, int channels,
+        std::vector<unsigned char>& target, int& targetWidth, int& targetHeight)
+    {
+        const GammaTables& gamma = Gamma();
+        targetWidth = std::max(width / 2, 1);
+        targetHeight = std::max(height / 2, 1);
+        target.resize((size_t)targetWidth * targetHeight * channels);
+        for (int y = 0; y < targetHeight; ++y)
+        {
+            const int rows[2] = { std::min(2 * y, height - 1), std::min(2 * y + 1, height - 1) };
+            for (int x = 0; x < targetWidth; ++x)
+            {
+                const int columns[2] = { std::min(2 * x, width - 1), std::min(2 * x + 1, width - 1) };
+                float color[3] = { 0.0f, 0.0f, 0.0f };
+                float weightSum = 0.0f;
+                float alphaSum = 0.0f;
+                for (int row : rows)
+                {
+                    for (int column : columns)
+                    {
+                        const unsigned char* texel = &source[((size_t)row * width + column) * channels];
+                        float alpha = channels == 4 ? texel[3] / 255.0f : 1.0f;
+                        float weight = alpha + 1e-4f;   //Plain average when all four are transparent.
+                        for (int c = 0; c < 3; ++c)
+                            color[c] += gamma.toLinear[texel[c]] * weight;
+                        weightSum += weight;
+                        alphaSum += alpha;
+                    }
+                }
+                unsigned char* out = &target[((size_t)y * targetWidth + x) * channels];
+                for (int c = 0; c < 3; ++c)
+                    out[c] = gamma.toSrgb[std::min((int)(color[c] / weightSum * 4095.0f + 0.5f), 4095)];
+                if (channels == 4)
+                    out[3] = (unsigned char)std::min((int)(alphaSum * 0.25f * 255.0f + 0.5f), 255);
+            }
+        }
+    }
+
+    uint16_t Pack565(const float color[3])
+    {
+        int r = std::clamp((int)(color[0] * (31.0f / 255.0f) + 0.5f), 0, 31);
+        int g = std::clamp((int)(color[1] * (63.0f / 255.0f) + 0.5f), 0, 63);
+        int b = std::clamp((int)(color[2] * (31.0f / 255.0f) + 0.5f), 0, 31);
+        return (uint16_t)((r << 11) | (g << 5) | b);
+    }
+
+    void Unpack565(uint16_t packed, float color[3])
+    {
+        int r = (packed >> 11) & 31, g = (packed >> 5) & 63, b = packed & 31;
+        color[0] = (float)((r << 3) | (r >> 2));
+        color[1] = (float)((g << 2) | (g >> 4));
+        color[2] = (float)((b << 3) | (b >> 2));
+    }
+
+    //Quantizes the endpoints and picks the nearest of the four palette entries for every texel.
+    //Returns the squared error; c0 > c1 always, which selects the four-color mode.
+    float FitColorBlock(const float texels[16][3], const float end0[3], const float end1[3],
+        uint16_t& c0, uint16_t& c1, uint32_t& indices)
+    {
+        c0 = Pack565(end0);
+        c1 = Pack565(end1);
+        if (c0 < c1)
+            std::swap(c0, c1);
+        float palette[4][3];
+        Unpack565(c0, palette[0]);
+        Unpack565(c1, palette[1]);
+        for (int c = 0; c < 3; ++c)
+        {
+            palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+            palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+        }
+        indices = 0;
+        float error = 0.0f;
+        for (int i = 0; i < 16; ++i)
+        {
+            int best = 0;
+            float bestDistance = 1e30f;
+            for (int p = 0; p < (c0 == c1 ? 1 : 4); ++p)
+            {
+                float dr = texels[i][0] - palette[p][0], dg = texels[i][1] - palette[p][1], db = texels[i][2] - palette[p][2];
+                float distance = dr * dr + dg * dg + db * db;
+                if (distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    best = p;
+                }
+            }
+            indices |= (uint32_t)best << (2 * i);
+            error += bestDistance;
+        }
+        return error;
+    }
+
+    //BC1 block: endpoints at the extremes of the principal axis, then refined once by least squares.
+    void EncodeColorBlock(const float texels[16][3], unsigned char* out)
+    {
+        float mean[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; ++i)
+            for (int c = 0; c < 3; ++c)
+                mean[c] += texels[i][c] / 16.0f;
+        float cov[6] = { 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f };  //xx xy xz yy yz zz
+        for (int i = 0; i < 16; ++i)
+        {
+            float d[3] = { texels[i][0] - mean[0], texels[i][1] - mean[1], texels[i][2] - mean[2] };
+            cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+            cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+        }
+        float axis[3] = { 1.0f, 1.0f, 1.0f };
+        for (int iteration = 0; iteration < 4; ++iteration)  //Power iteration towards the largest eigenvector.
+        {
+            float next[3] = {
+                cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+                cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+                cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2] };
+            float length = std::max({ std::abs(next[0]), std::abs(next[1]), std::abs(next[2]) });
+            if (length < 1e-6f)
+                break;
+            for (int c = 0; c < 3; ++c)
+                axis[c] = next[c] / length;
+        }
+        int minIndex = 0, maxIndex = 0;
+        float minProjection = 1e30f, maxProjection = -1e30f;
+        for (int i = 0; i < 16; ++i)
+        {
+            float projection = texels[i][0] * axis[0] + texels[i][1] * axis[1] + texels[i][2] * axis[2];
+            if (projection < minProjection) { minProjection = projection; minIndex = i; }
+            if (projection > maxProjection) { maxProjection = projection; maxIndex = i; }
+        }
+        uint16_t c0, c1;
+        uint32_t indices;
+        float error = FitColorBlock(texels, texels[maxIndex], texels[minIndex], c0, c1, indices);
+        if (c0 != c1)
+        {
+            //Least squares endpoints for the chosen indices: texel ~ w * end0 + (1 - w) * end1.
+            const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+            float aa = 0.0f, ab = 0.0f, bb = 0.0f, ax[3] = { 0.0f, 0.0f, 0.0f }, bx[3] = { 0.0f, 0.0f, 0.0f };
+            for (int i = 0; i < 16; ++i)
+            {
+                float w = weights[(indices >> (2 * i)) & 3];
+                aa += w * w; ab += w * (1.0f - w); bb += (1.0f - w) * (1.0f - w);
+                for (int c = 0; c < 3; ++c)
+                {
+                    ax[c] += w * texels[i][c];
+                    bx[c] += (1.0f - w) * texels[i][c];
+                }
+            }
+            float determinant = aa * bb - ab * ab;
+            if (std::abs(determinant) > 1e-6f)
+            {
+                float end0[3], end1[3];
+                for (int c = 0; c < 3; ++c)
+                {
+                    end0[c] = (ax[c] * bb - bx[c] * ab) / determinant;
+                    end1[c] = (bx[c] * aa - ax[c] * ab) / determinant;
+                }
+                uint16_t r0, r1;
+                uint32_t refined;
+                if (FitColorBlock(texels, end0, end1, r0, r1, refined) < error)
+                {
+                    c0 = r0; c1 = r1; indices = refined;
+                }
+            }
+        }
+        out[0] = (unsigned char)(c0 & 0xFF); out[1] = (unsigned char)(c0 >> 8);
+        out[2] = (unsigned char)(c1 & 0xFF); out[3] = (unsigned char)(c1 >> 8);
+        for (int i = 0; i < 4; ++i)
+            out[4 + i] = (unsigned char)(indices >> (8 * i));
+    }
+
+    //BC3 alpha block: the block's extremes with six interpolated steps in between, 3-bit indices.
+    void EncodeAlphaBlock(const unsigned char alpha[16], unsigned char* out)
+    {
+        unsigned char a0 = *std::max_element(alpha, alpha + 16);
+        unsigned char a1 = *std::min_element(alpha, alpha + 16);
+        out[0] = a0;
+        out[1] = a1;
+        uint64_t bits = 0;
+        if (a0 != a1)
+        {
+            float palette[8] = { (float)a0, (float)a1 };
+            for (int k = 1; k <= 6; ++k)
+                palette[k + 1] = ((7 - k) * a0 + k * a1) / 7.0f;
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                for (int p = 1; p < 8; ++p)
+                    if (std::abs(alpha[i] - palette[p]) < std::abs(alpha[i] - palette[best]))
+                        best = p;
+                bits |= (uint64_t)best << (3 * i);
+            }
+        }
+        for (int i = 0; i < 6; ++i)
+            out[2 + i] = (unsigned char)(bits >> (8 * i));
+    }
+
+    void CompressLevel(const std::vector<unsigned char>& pixels, int width, int height, int channels, std::vector<unsigned char>& out)
+    {
+        const bool withAlpha = channels == 4;
+        const int blockBytes = withAlpha ? 16 : 8;
+        const int blocksX = (width + 3) / 4, blocksY = (height + 3) / 4;
+        size_t start = out.size();
+        out.resize(start + (size_t)blocksX * blocksY * blockBytes);
+        unsigned char* block = &out[start];
+        for (int by = 0; by < blocksY; ++by)
+        {
+            for (int bx = 0; bx < blocksX; ++bx, block += blockBytes)
+            {
+                float texels[16][3];
+                unsigned char alpha[16];
+                for (int i = 0; i < 16; ++i)
+                {
+                    //Levels smaller than a block repeat their edge texels.
+                    int x = std::min(bx * 4 + (i & 3), width - 1);
+                    int y = std::min(by * 4 + (i >> 2), height - 1);
+                    const unsigned char* texel = &pixels[((size_t)y * width + x) * channels];
+                    for (int c = 0; c < 3; ++c)
+                        texels[i][c] = texel[c];
+                    alpha[i] = withAlpha ? texel[3] : 255;
+                }
+                if (withAlpha)
+                {
+                    EncodeAlphaBlock(alpha, block);
+                    EncodeColorBlock(texels, block + 8);
+                }
+                else
+                {
+                    EncodeColorBlock(texels, block);
+                }
+            }
+        }
+    }
+}
+
+bool BakedTexture::IsCompressed() const
+{
+    return format == Format::BC1 || format == Format::BC3;
+}
+
+int BakedTexture::GetChannelsCount() const
+{
+    return (format == Format::RGBA8 || format == Format::BC3) ? 4 : 3;
+}
+
+int BakedTexture::GetTailLevel(int maxSize) const
+{
+    int level = 0;
+    while (level + 1 < (int)levels.size() && (levels[level].width > maxSize || levels[level].height > maxSize))
+        ++level;
+    return level;
+}
+
+const unsigned char* BakedTexture::GetLevelData(int level) const
+{
+    if (mappedData != nullptr)
+        return level >= 0 && level < (int)levels.size() ? mappedData + levels[level].offset : nullptr;
+    if (level < firstLevel || level >= (int)levels.size())
+        return nullptr;
+    return data.data() + (levels[level].offset - levels[firstLevel].offset);
+}
+
+void BakedTexture::DropLevelsBefore(int level)
+{
+    if (mappedData != nullptr || level <= firstLevel)
+        return;
+    data.erase(data.begin(), data.begin() + (levels[level].offset - levels[firstLevel].offset));
+    data.shrink_to_fit();
+    firstLevel = level;
+}
+
+BakedTexture BakeTexture(const unsigned char* pixels, int width, int height, int channelsCount, bool compress)
+{
+    //Only RGB and RGBA are baked: grey (with or without alpha) is expanded.
+    const int channels = (channelsCount == 2 || channelsCount == 4) ? 4 : 3;
+    std::vector<unsigned char> level((size_t)width * height * channels);
+    for (size_t i = 0; i < (size_t)width * height; ++i)
+    {
+        const unsigned char* in = pixels + i * channelsCount;
+        unsigned char* out = &level[i * channels];
+        bool grey = channelsCount <= 2;
+        out[0] = in[0];
+        out[1] = grey ? in[0] : in[1];
+        out[2] = grey ? in[0] : in[2];
+        if (channels == 4)
+            out[3] = in[channelsCount - 1];
+    }
+
+    BakedTexture texture;
+    if (compress)
+        texture.format = channels == 4 ? BakedTexture::Format::BC3 : BakedTexture::Format::BC1;
+    else
+        texture.format = channels == 4 ? BakedTexture::Format::RGBA8 : BakedTexture::Format::RGB8;
+    std::vector<unsigned char> next;
+    for (;;)
+    {
+        size_t offset = texture.data.size();
+        if (compress)
+            CompressLevel(level, width, height, channels, texture.data);
+        else
+            texture.data.insert(texture.data.end(), level.begin(), level.end());
+        texture.levels.push_back({ width, height, offset, texture.data.size() - offset });
+        if (width == 1 && height == 1)
+            break;
+        Downsample(level, width, height, channels, next, width, height);
+        level.swap(next);
+    }
+    return texture;
+}
+
+bool LoadBakedTexture(const std::string& cacheFilePath, const std::string& sourcePath, bool compress, BakedTexture& texture, int maxLevelSize)
+{
+    uint64_t sourceSize = 0;
+    int64_t sourceWriteTime = 0;
+    if (!DescribeSource(sourcePath, sourceSize, sourceWriteTime))
+        return false;
+    std::ifstream file(cacheFilePath, std::ios::binary);
+    if (!file)
+        return false;
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    if (!file || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion
+        || header.format > (uint32_t)BakedTexture::Format::BC3 || header.levelCount == 0 || header.levelCount > 32
+        || header.sourceSize != sourceSize || header.sourceWriteTime != sourceWriteTime)
+    {
+        return false;
+    }
+    texture.format = (BakedTexture::Format)header.format;
+    if (texture.IsCompressed() != compress)
+        return false;
+    std::vector<CacheLevel> levels(header.levelCount);
+    file.read(reinterpret_cast<char*>(levels.data()), (std::streamsize)(levels.size() * sizeof(CacheLevel)));
+    if (!file)
+        return false;
+    texture.levels.clear();
+    size_t offset = 0;
+    for (const CacheLevel& level : levels)
+    {
+        texture.levels.push_back({ (int)level.width, (int)level.height, offset, (size_t)level.size });
+        offset += (size_t)level.size;
+    }
+    texture.firstLevel = maxLevelSize > 0 ? texture.GetTailLevel(maxLevelSize) : 0;
+    const size_t skipped = texture.levels[texture.firstLevel].offset;
+    texture.data.resize(offset - skipped);
+    file.seekg((std::streamoff)skipped, std::ios::cur);
+    file.read(reinterpret_cast<char*>(texture.data.data()), (std::streamsize)texture.data.size());
+    return (bool)file;
+}
+
+bool LoadBakedLevel(const std::string& cacheFilePath, const BakedTexture& texture, int level, std::vector<unsigned char>& data)
+{
+    std::ifstream file(cacheFilePath, std::ios::binary);
+    if (!file || level < 0 || level >= (int)texture.levels.size())
+        return false;
+    CacheHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+    //The file may have been rebaked since the texture was loaded; the layout has to be the same.
+    if (!file || std::memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != cacheVersion
+        || header.format != (uint32_t)texture.format || header.levelCount != texture.levels.size())
+    {
+        return false;
+    }
+    const BakedTexture::Level& mip = texture.levels[level];
+    file.seekg((std::streamoff)(sizeof(CacheHeader) + texture.levels.size() * sizeof(CacheLevel) + mip.offset));
+    data.resize(mip.size);
+    file.read(reinterpret_cast<char*>(data.data()), (std::streamsize)data.size());
+    return (bool)file;
+}
+
+bool SaveBakedTexture(const std::string& cacheFilePath, const std::string& sourcePath, const BakedTexture& texture)
+{
+    CacheHeader header{};
+    std::memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = cacheVersion;
+    header.format = (uint32_t)texture.format;
+    header.levelCount = (uint32_t)texture.levels.size();
+    if (texture.firstLevel != 0 || !DescribeSource(sourcePath, header.sourceSize, header.sourceWriteTime))
+        return false;
+    std::vector<CacheLevel> levels;
+    for (const BakedTexture::Level& level : texture.levels)
+        levels.push_back({ (uint32_t)level.width, (uint32_t)level.height, (uint64_t)level.size });
+    std::error_code ec;
+    std::filesystem::path parent = std::filesystem::path(cacheFilePath).parent_path();
+    if (!parent.empty())
+        std::filesystem::create_directories(parent, ec);
+    std::ofstream file(cacheFilePath, std::ios::binary | std::ios::trunc);
+    if (!file)
+    {
+        std::cout << "Could not write texture cache: " + cacheFilePath + "\n";
+        return false;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    file.write(reinterpret_cast<const char*>(levels.data()), (std::streamsize)(levels.size() * sizeof(CacheLevel)));
+    file.write(reinterpret_cast<const char*>(texture.data.data()), (std::streamsize)texture.data.size());
+    file.close();   //Flushed now: the finer levels are read back from this file.
+    return !file.fail();
+}
+
+std::vector<unsigned char> PackBakedTexture(const BakedTexture& texture)
+{
+    PackedTextureHeader header{};
+    header.format = (uint32_t)texture.format;
+    header.levelCount = (uint32_t)texture.levels.size();
+    const size_t tableEnd = sizeof(header) + texture.levels.size() * sizeof(CacheLevel);
+    header.dataOffset = (tableEnd + 63) / 64 * 64;
+    std::vector<unsigned char> payload((size_t)header.dataOffset + texture.data.size(), 0);
+    std::memcpy(payload.data(), &header, sizeof(header));
+    for (size_t i = 0; i < texture.levels.size(); ++i)
+    {
+        CacheLevel level = { (uint32_t)texture.levels[i].width, (uint32_t)texture.levels[i].height, (uint64_t)texture.levels[i].size };
+        std::memcpy(payload.data() + sizeof(header) + i * sizeof(CacheLevel), &level, sizeof(level));
+    }
+    std::memcpy(payload.data() + header.dataOffset, texture.data.data(), texture.data.size());
+    return payload;
+}
+
+bool ViewPackedTexture(const unsigned char* payload, size_t size, BakedTexture& texture)
+{
+    PackedTextureHeader header{};
+    if (size < sizeof(header))
+        return false;
+    std::memcpy(&header, payload, sizeof(header));
+    if (header.format > (uint32_t)BakedTexture::Format::BC3 || header.levelCount == 0 || header.levelCount > 32
+        || sizeof(header) + header.levelCount * sizeof(CacheLevel) > header.dataOffset || header.dataOffset > size)
+    {
+        return false;
+    }
+    texture.format = (BakedTexture::Format)header.format;
+    texture.levels.clear();
+    size_t offset = 0;
+    for (uint32_t i = 0; i < header.levelCount; ++i)
+    {
+        CacheLevel level;
+        std::memcpy(&level, payload + sizeof(header) + i * sizeof(CacheLevel), sizeof(level));
+        texture.levels.push_back({ (int)level.width, (int)level.height, offset, (size_t)level.size });
+        offset += (size_t)level.size;
+    }
+    if (header.dataOffset + offset > size)
+        return false;
+    texture.data.clear();
+    texture.firstLevel = 0;
+    texture.mappedData = payload + header.dataOffset;
+    return true;
+}
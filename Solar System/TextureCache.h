@@ -0,0 +1,42 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+// Baked textures: the complete mip chain, filtered in linear light and optionally block-compressed (BC1 for RGB,
+// BC3 for RGBA) so it can be handed to the GPU as is. An image is baked once; the result is kept in a versioned
+// cache file and reused until the source image changes, so later launches skip both the decode and the mip build.
+struct BakedTexture
+{
+	enum class Format : uint32_t { RGB8, RGBA8, BC1, BC3 };
+	struct Level
+	{
+		int width;
+		int height;
+		size_t offset;	//Start of the level in the complete chain.
+		size_t size;
+	};
+	Format format = Format::RGB8;
+	std::vector<Level> levels;			//Largest first, down to 1x1.
+	std::vector<unsigned char> data;	//The levels from firstLevel on, back to back.
+	int firstLevel = 0;					//Finest level held in data; finer ones are only in the cache file.
+	const unsigned char* mappedData = nullptr;	//Every level, in place in a mapped asset pack (data stays empty).
+	bool IsCompressed() const;
+	int GetChannelsCount() const;
+	int GetTailLevel(int maxSize) const;					//Finest level whose sides are both at most maxSize.
+	const unsigned char* GetLevelData(int level) const;		//Null when the level is not held in data.
+	void DropLevelsBefore(int level);						//Frees the finer levels, they can be read back with LoadBakedLevel.
+};
+
+//Builds the mip chain of an 8-bit image (1 to 4 channels, grey is expanded to RGB) and compresses it if asked.
+BakedTexture BakeTexture(const unsigned char* pixels, int width, int height, int channelsCount, bool compress);
+//Reads the texture baked from sourcePath. False when the file is missing, outdated or (not) compressed unlike asked.
+//With maxLevelSize set, only the coarse levels up to that size are read; the others are left in the file.
+bool LoadBakedTexture(const std::string& cacheFilePath, const std::string& sourcePath, bool compress, BakedTexture& texture, int maxLevelSize = 0);
+//Reads a single level of a texture loaded from (or saved to) cacheFilePath.
+bool LoadBakedLevel(const std::string& cacheFilePath, const BakedTexture& texture, int level, std::vector<unsigned char>& data);
+bool SaveBakedTexture(const std::string& cacheFilePath, const std::string& sourcePath, const BakedTexture& texture);	//Needs every level.
+//Asset pack payload: the level table followed by every level, as uploaded.
+std::vector<unsigned char> PackBakedTexture(const BakedTexture& texture);
+//Points texture at a payload written by PackBakedTexture (through mappedData, nothing is copied).
+bool ViewPackedTexture(const unsigned char* payload, size_t size, BakedTexture& texture);
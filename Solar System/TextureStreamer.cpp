@@ -0,0 +1,429 @@
+// TextureStreamer: baked texture loading on the job system, pixel-buffer uploads and mip residency on the GL thread.
+#include "TextureStreamer.h"
+#include "AssetPack.h"
+#include "GLExtensions.h"
+#include "JobSystem.h"
+#include "Window.h"
+#include "stb_image.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <limits>
+
+namespace {
+    //EXT_texture_compression_s3tc; not part of the core profile the loader was generated for.
+    constexpr GLenum compressedRgbBc1 = 0x83F0;     //GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+    constexpr GLenum compressedRgbaBc3 = 0x83F3;    //GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+
+    //Drivers usually pad RGB8 to four bytes per texel.
+    size_t GetLevelBytes(const BakedTexture& baked, int level)
+    {
+        const BakedTexture::Level& mip = baked.levels[level];
+        return baked.format == BakedTexture::Format::RGB8 ? (size_t)mip.width * mip.height * 4 : mip.size;
+    }
+
+    GLenum GetCompressedFormat(const BakedTexture& baked)
+    {
+        return baked.format == BakedTexture::Format::BC1 ? compressedRgbBc1 : compressedRgbaBc3;
+    }
+}
+
+TextureStreamer::TextureStreamer(JobSystem& jobSystem, const AssetPack& assets, const std::string& cacheDirectory)
+    :
+    jobSystem(jobSystem),
+    assets(assets),
+    cacheDirectory(cacheDirectory)
+{
+    compress = settings::textureCompression && HasGLExtension("GL_EXT_texture_compression_s3tc");
+}
+
+TextureStreamer::~TextureStreamer() noexcept
+{
+    //Jobs still running only touch their own result, which is dropped with the futures.
+    if (pixelBuffer != 0)
+        glDeleteBuffers(1, &pixelBuffer);
+}
+
+std::shared_ptr<const StreamedImage> TextureStreamer::Request(unsigned int texture, const std::string& path)
+{
+    StreamedTexture entry;
+    entry.texture = texture;
+    entry.path = path;
+    entry.cacheFile = GetCacheFilePath(path);
+    entry.image = std::make_shared<StreamedImage>();
+    for (const StreamedTexture& other : textures)
+    {
+        if (other.path == path)
+        {
+            entry.baked = other.baked;  //Same image: load it once, upload it twice.
+            break;
+        }
+    }
+    //The pack is baked with compression; without S3TC its textures cannot be used as they are.
+    const AssetPack::Entry* packed = compress ? assets.Find(path, AssetPack::Type::Texture) : nullptr;
+    if (!entry.baked.valid() && packed != nullptr)
+    {
+        //Only the level table is read here; the levels themselves stay in the mapping until they are uploaded.
+        auto baked = std::make_shared<BakedTexture>();
+        if (ViewPackedTexture(packed->data, packed->size, *baked))
+        {
+            std::promise<std::shared_ptr<const BakedTexture>> ready;
+            ready.set_value(baked);
+            entry.baked = ready.get_future().share();
+        }
+    }
+    if (!entry.baked.valid())
+    {
+        std::string cacheFile = entry.cacheFile;
+        bool compressed = compress;
+        entry.baked = jobSystem.Submit([path, cacheFile, compressed]()
+        {
+            auto baked = std::make_shared<BakedTexture>();
+            if (LoadBakedTexture(cacheFile, path, compressed, *baked, settings::textureResidentLevelSize))
+                return std::shared_ptr<const BakedTexture>(baked);
+            //The flip flag is per thread here; the global one is still used by the skybox on the GL thread.
+            stbi_set_flip_vertically_on_load_thread(1);
+            int width = 0, height = 0, channelsCount = 0;
+            unsigned char* data = stbi_load(path.c_str(), &width, &height, &channelsCount, 0);
+            if (data == nullptr)
+                return std::shared_ptr<const BakedTexture>();
+            *baked = BakeTexture(data, width, height, channelsCount, compressed);
+            stbi_image_free(data);
+            //Without a cache file the finer levels have nowhere to be read back from, so they stay in memory.
+            if (SaveBakedTexture(cacheFile, path, *baked))
+                baked->DropLevelsBefore(baked->GetTailLevel(settings::textureResidentLevelSize));
+            return std::shared_ptr<const BakedTexture>(baked);
+        }).share();
+    }
+    textureIndices[texture] = textures.size();
+    textures.push_back(std::move(entry));
+    return textures.back().image;
+}
+
+void TextureStreamer::RequestDetail(unsigned int texture, float screenSize)
+{
+    auto found = textureIndices.find(texture);
+    if (found != textureIndices.end())
+    {
+        StreamedTexture& entry = textures[found->second];
+        entry.screenSize = std::max(entry.screenSize, screenSize);
+    }
+}
+
+void TextureStreamer::Update(Window& window, size_t byteBudget)
+{
+    CommitRequests();
+    UpdateResidency(window);
+    Stream(window, byteBudget);
+}
+
+void TextureStreamer::Finish(Window& window)
+{
+    CommitRequests();
+    for (;;)
+    {
+        UpdateResidency(window);
+        Stream(window, std::numeric_limits<size_t>::max());
+        auto waiting = std::find_if(textures.begin(), textures.end(),
+            [this](const StreamedTexture& entry) { return !IsResolved(entry); });
+        if (waiting == textures.end())
+            break;
+        if (waiting->residentLevel < 0)
+            waiting->baked.wait();
+        else if (waiting->loadingLevel >= 0)
+            waiting->levelData.wait();
+    }
+}
+
+bool TextureStreamer::IsIdle() const
+{
+    return GetPendingCount() == 0;
+}
+
+size_t TextureStreamer::GetPendingCount() const
+{
+    return (size_t)std::count_if(textures.begin(), textures.end(),
+        [this](const StreamedTexture& entry) { return !IsResolved(entry); });
+}
+
+bool TextureStreamer::IsCompressionEnabled() const
+{
+    return compress;
+}
+
+size_t TextureStreamer::GetResidentBytes() const
+{
+    return residentBytes;
+}
+
+size_t TextureStreamer::GetUncompressedBytes() const
+{
+    return uncompressedBytes;
+}
+
+void TextureStreamer::CommitRequests()
+{
+    for (StreamedTexture& entry : textures)
+    {
+        entry.priority = entry.screenSize;
+        entry.screenSize = 0.0f;
+    }
+}
+
+int TextureStreamer::GetDesiredLevel(const StreamedTexture& entry) const
+{
+    if (entry.priority <= 0.0f)
+        return entry.tailLevel;
+    //Level n has 2^n texels per texel of level 0; the sampler goes no finer than one texel per pixel.
+    float texelsPerPixel = entry.layout->levels.front().width / entry.priority;
+    int level = texelsPerPixel > 1.0f ? (int)std::floor(std::log2(texelsPerPixel)) : 0;
+    return std::clamp(level, entry.finestLevel, entry.tailLevel);
+}
+
+void TextureStreamer::UpdateResidency(Window& window)
+{
+    std::vector<StreamedTexture*> loaded;
+    std::vector<int> desired;
+    size_t wanted = 0;
+    for (StreamedTexture& entry : textures)
+    {
+        if (entry.residentLevel < 0)
+            continue;
+        loaded.push_back(&entry);
+        desired.push_back(GetDesiredLevel(entry));
+        entry.targetLevel = desired.back();
+        wanted += GetChainBytes(entry, entry.targetLevel);
+    }
+    //Over budget: the texture furthest from what it needs keeps its detail, the others lose a level in turn,
+    //least visible first.
+    const size_t budget = (size_t)settings::textureMemoryBudget;
+    while (wanted > budget)
+    {
+        size_t pick = loaded.size();
+        for (size_t i = 0; i < loaded.size(); ++i)
+        {
+            if (loaded[i]->targetLevel >= loaded[i]->tailLevel)
+                continue;
+            if (pick == loaded.size())
+            {
+                pick = i;
+                continue;
+            }
+            int deficit = loaded[i]->targetLevel - desired[i];
+            int pickDeficit = loaded[pick]->targetLevel - desired[pick];
+            if (deficit < pickDeficit || (deficit == pickDeficit && loaded[i]->priority < loaded[pick]->priority))
+                pick = i;
+        }
+        if (pick == loaded.size())
+            break;  //Only the coarse levels are left.
+        StreamedTexture& entry = *loaded[pick];
+        wanted -= GetChainBytes(entry, entry.targetLevel) - GetChainBytes(entry, entry.targetLevel + 1);
+        ++entry.targetLevel;
+    }
+
+    //Levels no longer needed stay until their memory is wanted, so a planet leaving the screen for a moment
+    //does not have to stream them again.
+    size_t kept = 0;
+    for (StreamedTexture* entry : loaded)
+        kept += GetChainBytes(*entry, std::min(entry->residentLevel, entry->targetLevel));
+    if (kept <= budget)
+        return;
+    std::sort(loaded.begin(), loaded.end(),
+        [](const StreamedTexture* lhs, const StreamedTexture* rhs) { return lhs->priority < rhs->priority; });
+    for (StreamedTexture* entry : loaded)
+    {
+        if (kept <= budget)
+            break;
+        if (entry->residentLevel >= entry->targetLevel)
+            continue;
+        kept -= GetChainBytes(*entry, entry->residentLevel) - GetChainBytes(*entry, entry->targetLevel);
+        DropLevels(window, *entry, entry->targetLevel);
+    }
+}
+
+size_t TextureStreamer::Stream(Window& window, size_t byteBudget)
+{
+    //The largest textures on screen are refined first.
+    std::vector<StreamedTexture*> order;
+    order.reserve(textures.size());
+    for (StreamedTexture& entry : textures)
+        order.push_back(&entry);
+    std::stable_sort(order.begin(), order.end(),
+        [](const StreamedTexture* lhs, const StreamedTexture* rhs) { return lhs->priority > rhs->priority; });
+
+    size_t uploaded = 0;
+    for (StreamedTexture* streamed : order)
+    {
+        if (uploaded >= byteBudget)
+            break;
+        StreamedTexture& entry = *streamed;
+        if (entry.residentLevel < 0)
+        {
+            if (entry.baked.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+                continue;
+            std::shared_ptr<const BakedTexture> baked = entry.baked.get();
+            if (!baked)
+            {
+                std::cout << "Failed to load texture : " << entry.path << "\n";
+                exit(EXIT_FAILURE);
+            }
+            entry.layout = baked;
+            entry.tailLevel = baked->GetTailLevel(settings::textureResidentLevelSize);
+            const int lastLevel = (int)baked->levels.size() - 1;
+            uploaded += UploadLevels(window, entry, *baked, entry.tailLevel, lastLevel, baked->GetLevelData(entry.tailLevel));
+            entry.targetLevel = GetDesiredLevel(entry);	//Settled against the budget on the next residency update.
+            for (const BakedTexture::Level& mip : baked->levels)
+                uncompressedBytes += (size_t)mip.width * mip.height * 4;
+            entry.image->width = baked->levels.front().width;
+            entry.image->height = baked->levels.front().height;
+            entry.image->channelsCount = baked->GetChannelsCount();
+            entry.image->compressed = baked->IsCompressed();
+            entry.image->loaded = true;
+            continue;
+        }
+        if (entry.residentLevel <= entry.targetLevel)
+            continue;
+        //One level at a time, so the texture sharpens progressively and never skips a level.
+        const int next = entry.residentLevel - 1;
+        const unsigned char* held = entry.layout->GetLevelData(next);
+        if (held != nullptr && entry.layout->mappedData == nullptr)
+        {
+            uploaded += UploadLevels(window, entry, *entry.layout, next, next, held);
+            continue;
+        }
+        if (entry.loadingLevel < 0)
+        {
+            std::string cacheFile = entry.cacheFile;
+            std::shared_ptr<const BakedTexture> layout = entry.layout;
+            entry.loadingLevel = next;
+            entry.levelData = jobSystem.Submit([cacheFile, layout, next]()
+            {
+                std::vector<unsigned char> data;
+                if (layout->mappedData != nullptr)
+                    AssetPack::Prefetch(layout->GetLevelData(next), layout->levels[next].size);  //Uploaded in place.
+                else if (!LoadBakedLevel(cacheFile, *layout, next, data))
+                    data.clear();
+                return data;
+            });
+            continue;
+        }
+        if (entry.levelData.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            continue;
+        std::vector<unsigned char> data = entry.levelData.get();
+        const int level = entry.loadingLevel;
+        entry.loadingLevel = -1;
+        if (level != next)
+            continue;   //Levels were dropped while it loaded; the right one is requested next time.
+        if (held != nullptr)
+        {
+            uploaded += UploadLevels(window, entry, *entry.layout, level, level, held);
+            continue;
+        }
+        if (data.empty())
+        {
+            std::cout << "Could not read texture level " << level << " from " << entry.cacheFile << "\n";
+            entry.finestLevel = entry.residentLevel;    //Keep what is there rather than retrying every frame.
+            entry.targetLevel = entry.residentLevel;
+            continue;
+        }
+        uploaded += UploadLevels(window, entry, *entry.layout, level, level, data.data());
+    }
+    return uploaded;
+}
+
+bool TextureStreamer::IsResolved(const StreamedTexture& entry) const
+{
+    return entry.residentLevel >= 0 && entry.residentLevel <= entry.targetLevel;
+}
+
+size_t TextureStreamer::UploadLevels(Window& window, StreamedTexture& entry, const BakedTexture& baked, int first, int last, const unsigned char* data)
+{
+    const BakedTexture::Level& firstMip = baked.levels[first];
+    const BakedTexture::Level& lastMip = baked.levels[last];
+    const size_t size = lastMip.offset + lastMip.size - firstMip.offset;
+    if (pixelBuffer == 0)
+    {
+        glGenBuffers(1, &pixelBuffer);
+    }
+    //Orphan the previous contents so the copy never waits for the GPU to finish reading the last upload.
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pixelBuffer);
+    glBufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    const unsigned char* source = nullptr;	//Null: the levels are read from the bound pixel buffer.
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped != nullptr)
+    {
+        std::memcpy(mapped, data, size);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    }
+    else
+    {
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        source = data;
+    }
+    window.BindTexture(0, GL_TEXTURE_2D, entry.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);	//Baked levels are tightly packed.
+    for (int level = first; level <= last; ++level)
+    {
+        const BakedTexture::Level& mip = baked.levels[level];
+        const size_t offset = mip.offset - firstMip.offset;
+        const void* pixels = source != nullptr ? (const void*)(source + offset) : (const void*)(uintptr_t)offset;
+        switch (baked.format)
+        {
+        case BakedTexture::Format::BC1:
+        case BakedTexture::Format::BC3:
+            glCompressedTexImage2D(GL_TEXTURE_2D, level, GetCompressedFormat(baked), mip.width, mip.height, 0, (GLsizei)mip.size, pixels);
+            break;
+        case BakedTexture::Format::RGBA8:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGBA8, mip.width, mip.height, 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+            break;
+        default:
+            glTexImage2D(GL_TEXTURE_2D, level, GL_RGB8, mip.width, mip.height, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+            break;
+        }
+        residentBytes += GetLevelBytes(baked, level);
+    }
+    //The base level hides the finer levels that are not there (yet), the texture stays complete.
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, first);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)baked.levels.size() - 1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    entry.residentLevel = first;
+    return size;
+}
+
+void TextureStreamer::DropLevels(Window& window, StreamedTexture& entry, int level)
+{
+    const BakedTexture& baked = *entry.layout;
+    window.BindTexture(0, GL_TEXTURE_2D, entry.texture);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, level);
+    //Respecifying a level as empty is how a mutable texture gives its memory back.
+    for (int dropped = entry.residentLevel; dropped < level; ++dropped)
+    {
+        if (baked.IsCompressed())
+            glCompressedTexImage2D(GL_TEXTURE_2D, dropped, GetCompressedFormat(baked), 0, 0, 0, 0, nullptr);
+        else
+            glTexImage2D(GL_TEXTURE_2D, dropped, baked.format == BakedTexture::Format::RGBA8 ? GL_RGBA8 : GL_RGB8, 0, 0, 0,
+                baked.format == BakedTexture::Format::RGBA8 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        residentBytes -= GetLevelBytes(baked, dropped);
+    }
+    entry.residentLevel = level;
+}
+
+size_t TextureStreamer::GetChainBytes(const StreamedTexture& entry, int level) const
+{
+    size_t bytes = 0;
+    for (int i = level; i < (int)entry.layout->levels.size(); ++i)
+        bytes += GetLevelBytes(*entry.layout, i);
+    return bytes;
+}
+
+std::string TextureStreamer::GetCacheFilePath(const std::string& path) const
+{
+    //Paths use either separator; the cache is flat, one file per source image.
+    size_t separator = path.find_last_of("\\/");
+    std::string name = separator == std::string::npos ? path : path.substr(separator + 1);
+    return cacheDirectory + name + (compress ? ".bc.tex" : ".tex");
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "Settings.h"
+#include "TextureCache.h"
+class AssetPack;
+class JobSystem;
+class Window;
+//Size of a streamed image; stays 1x1 (the placeholder) until the real data has been uploaded.
+struct StreamedImage
+{
+	int width = 1;
+	int height = 1;
+	int channelsCount = 4;
+	bool loaded = false;
+	bool compressed = false;
+};
+// Loads textures without stalling startup. Images are read on the job system while a placeholder stands in:
+// straight from the mapped asset pack when it has them, else from the baked texture cache, otherwise decoded
+// and baked (mip chain, BC1/BC3 when the GPU supports S3TC) and written to the cache for the next launch.
+// The GL thread then copies finished levels into a pixel buffer object and uploads them from there, a few per frame.
+// Only the coarse levels (up to settings::textureResidentLevelSize) are loaded up front. Every frame the game
+// tells how large each texture is on screen; finer levels are then read from the cache file and added one at a
+// time (pack pages are faulted in on a worker first), and levels no longer needed are dropped when the GPU
+// memory budget runs short.
+class TextureStreamer
+{
+public:
+	//Needs the GL context (queries S3TC support). The pack must outlive the streamer.
+	TextureStreamer(JobSystem& jobSystem, const AssetPack& assets, const std::string& cacheDirectory);
+	TextureStreamer(const TextureStreamer& other) = delete;				//No copy construction allowed.
+	TextureStreamer& operator=(const TextureStreamer& other) = delete;	//No copy assignment allowed.
+	~TextureStreamer() noexcept;										//Frees the pixel buffer (loads in flight are dropped).
+	//Decodes the image in the background; its texels replace the content of texture once uploaded.
+	std::shared_ptr<const StreamedImage> Request(unsigned int texture, const std::string& path);
+	//The texture is drawn this frame, its full width spanning screenSize pixels at the closest visible point.
+	//Textures not mentioned between two updates only keep their coarse levels (when memory is needed).
+	void RequestDetail(unsigned int texture, float screenSize);
+	void Update(Window& window, size_t byteBudget = settings::textureUploadBytesPerFrame);	//Uploads loaded levels, at least one.
+	void Finish(Window& window);			//Blocks until every texture has the levels requested since the last update.
+	bool IsIdle() const;					//Nothing left to load or upload.
+	size_t GetPendingCount() const;			//Textures still missing a level they need.
+	bool IsCompressionEnabled() const;
+	size_t GetResidentBytes() const;		//GPU memory of the uploaded levels.
+	size_t GetUncompressedBytes() const;	//What the complete mip chains would take as RGBA8.
+private:
+	struct StreamedTexture
+	{
+		unsigned int texture;
+		std::string path;
+		std::string cacheFile;
+		std::shared_ptr<StreamedImage> image;
+		std::shared_future<std::shared_ptr<const BakedTexture>> baked;	//Coarse levels; shared by requests for the same image.
+		std::shared_ptr<const BakedTexture> layout;		//Set once the coarse levels are on the GPU.
+		int tailLevel = 0;			//Finest level that is always resident.
+		int finestLevel = 0;		//Finest level that can be read (raised when the cache file fails).
+		int residentLevel = -1;		//Finest level on the GPU (the base level), -1 for the placeholder.
+		int targetLevel = 0;		//Finest level wanted under the budget.
+		float screenSize = 0.0f;	//Largest size requested since the last update.
+		float priority = 0.0f;		//Screen size the target was chosen for.
+		int loadingLevel = -1;
+		std::future<std::vector<unsigned char>> levelData;
+	};
+	void CommitRequests();	//The sizes requested since the last update become the priorities.
+	int GetDesiredLevel(const StreamedTexture& entry) const;
+	void UpdateResidency(Window& window);	//Target levels that fit the budget; drops levels to make room.
+	size_t Stream(Window& window, size_t byteBudget);	//Returns the bytes uploaded.
+	bool IsResolved(const StreamedTexture& entry) const;
+	size_t UploadLevels(Window& window, StreamedTexture& entry, const BakedTexture& baked, int first, int last, const unsigned char* data);
+	void DropLevels(Window& window, StreamedTexture& entry, int level);	//Keeps level and the coarser ones.
+	size_t GetChainBytes(const StreamedTexture& entry, int level) const;	//Resident size from level down to 1x1.
+	std::string GetCacheFilePath(const std::string& path) const;
+private:
+	JobSystem& jobSystem;
+	const AssetPack& assets;
+	std::string cacheDirectory;
+	bool compress = false;
+	std::vector<StreamedTexture> textures;
+	std::unordered_map<unsigned int, size_t> textureIndices;	//GL name to entry of textures.
+	unsigned int pixelBuffer = 0;
+	size_t residentBytes = 0;
+	size_t uncompressedBytes = 0;
+};
@@ -0,0 +1,225 @@
+// TrailRenderer: per-body sample rings in one vertex buffer, streamed with unsynchronized sub-range writes.
+#include "TrailRenderer.h"
+#include "ShaderProgram.h"
+#include "Window.h"
+#include <glad/glad.h>
+#include <algorithm>
+#include <cstddef>
+
+TrailRenderer::TrailRenderer()
+{
+    glGenVertexArrays(1, &vertexArray);
+    glGenBuffers(1, &vertexBuffer);
+    glBindVertexArray(vertexArray);
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(TrailVertex), (void*)offsetof(TrailVertex, x));
+    glEnableVertexAttribArray(1);
+    glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(TrailVertex), (void*)offsetof(TrailVertex, path));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(TrailVertex), (void*)offsetof(TrailVertex, time));
+    glBindVertexArray(0);
+
+    glGenBuffers(1, &pathDataBuffer);
+    glBindBuffer(GL_TEXTURE_BUFFER, pathDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, 2 * sizeof(glm::vec4), nullptr, GL_STATIC_DRAW);
+    glGenTextures(1, &pathDataTexture);
+    glBindTexture(GL_TEXTURE_BUFFER, pathDataTexture);
+    glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, pathDataBuffer);
+    glBindTexture(GL_TEXTURE_BUFFER, 0);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+TrailRenderer::~TrailRenderer() noexcept
+{
+    glDeleteTextures(1, &pathDataTexture);
+    glDeleteBuffers(1, &pathDataBuffer);
+    glDeleteBuffers(1, &vertexBuffer);
+    glDeleteVertexArrays(1, &vertexArray);
+}
+
+int TrailRenderer::AddTrail(const glm::vec3& color, float opacity, double durationSeconds, int capacity)
+{
+    Trail trail;
+    trail.firstVertex = vertexCount;
+    trail.capacity = std::max(capacity, 2);
+    trail.interval = durationSeconds / (trail.capacity - 1);
+    trail.color = color;
+    trail.opacity = opacity;
+    trail.duration = (float)durationSeconds;
+    trails.push_back(trail);
+    vertexCount += trail.capacity + 1;
+    pendingSlots.resize(vertexCount, -1);
+    buffersDirty = true;
+    return (int)trails.size() - 1;
+}
+
+void TrailRenderer::Update(int trailIndex, const glm::vec3& position, double time)
+{
+    if (trailIndex < 0 || trailIndex >= (int)trails.size())
+        return;
+    if (!hasTimeOrigin)
+    {
+        timeOrigin = time;
+        hasTimeOrigin = true;
+    }
+    Trail& trail = trails[trailIndex];
+    if (trail.count == 0 || time - trail.lastCommit >= trail.interval)
+    {
+        //Keep the live sample where it is and start a new one (it overwrites the oldest once the ring is full).
+        ++trail.live;
+        trail.count = std::min(trail.count + 1, trail.capacity);
+        trail.lastCommit = time;
+    }
+    TrailVertex vertex{ position.x, position.y, position.z, (unsigned int)trailIndex, (float)(time - timeOrigin) };
+    WriteSample(trail, (int)(trail.live % trail.capacity), vertex);
+}
+
+void TrailRenderer::Clear()
+{
+    for (Trail& trail : trails)
+    {
+        trail.count = 0;
+        trail.live = -1;
+    }
+    ClearPendingWrites();
+    hasTimeOrigin = false;
+}
+
+void TrailRenderer::Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection, double time)
+{
+    if (buffersDirty)
+    {
+        AllocateBuffers();
+    }
+    FlushPendingWrites();
+
+    drawFirsts.clear();
+    drawCounts.clear();
+    for (const Trail& trail : trails)
+    {
+        if (trail.count < 2)
+            continue;
+        int oldest = (int)((trail.live - trail.count + 1) % trail.capacity);
+        int newest = (int)(trail.live % trail.capacity);
+        if (oldest <= newest)
+        {
+            drawFirsts.push_back(trail.firstVertex + oldest);
+            drawCounts.push_back(newest - oldest + 1);
+            continue;
+        }
+        //Wrapped: the extra vertex after the ring repeats slot 0, so the two strips share an endpoint.
+        drawFirsts.push_back(trail.firstVertex + oldest);
+        drawCounts.push_back(trail.capacity + 1 - oldest);
+        if (newest > 0)
+        {
+            drawFirsts.push_back(trail.firstVertex);
+            drawCounts.push_back(newest + 1);
+        }
+    }
+    if (drawFirsts.empty())
+    {
+        return;
+    }
+    window.UseShader(shader);
+    shader.SendUniform<glm::mat4>("viewProjection", viewProjection);
+    shader.SendUniform<int>("highlightedPath", -1);
+    shader.SendUniform<int>("pathData", 0);
+    shader.SendUniform<float>("time", (float)(time - timeOrigin));
+    window.BindTexture(0, GL_TEXTURE_BUFFER, pathDataTexture);
+    window.BindVertexArray(vertexArray);
+    window.MultiDrawArrays(GL_LINE_STRIP, drawFirsts.data(), drawCounts.data(), (int)drawFirsts.size());
+}
+
+size_t TrailRenderer::GetTrailCount() const
+{
+    return trails.size();
+}
+
+size_t TrailRenderer::GetUploadedSampleCount() const
+{
+    return uploadedSampleCount;
+}
+
+void TrailRenderer::WriteSample(const Trail& trail, int slot, const TrailVertex& vertex)
+{
+    //A position written again before the flush (every frame for the live sample, and all of them when frames go
+    //by without drawing the trails) keeps one entry, so the pending writes never outgrow the buffer.
+    auto write = [&](int position, const TrailVertex& data)
+    {
+        int& pending = pendingSlots[position];
+        if (pending >= 0)
+        {
+            pendingData[pending] = data;
+            return;
+        }
+        pending = (int)pendingVertices.size();
+        pendingVertices.push_back(position);
+        pendingData.push_back(data);
+    };
+    write(trail.firstVertex + slot, vertex);
+    if (slot == 0)
+    {
+        write(trail.firstVertex + trail.capacity, vertex);
+    }
+}
+
+void TrailRenderer::AllocateBuffers()
+{
+    //Only happens when trails are added (start-up); the rings start over in the new buffer.
+    Clear();
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    glBufferData(GL_ARRAY_BUFFER, (size_t)vertexCount * sizeof(TrailVertex), nullptr, GL_DYNAMIC_DRAW);
+    std::vector<glm::vec4> data;
+    data.reserve(trails.size() * 2);
+    for (const Trail& trail : trails)
+    {
+        data.push_back(glm::vec4(trail.color, trail.opacity));
+        data.push_back(glm::vec4(0.0f, 0.0f, 0.0f, trail.duration));
+    }
+    glBindBuffer(GL_TEXTURE_BUFFER, pathDataBuffer);
+    glBufferData(GL_TEXTURE_BUFFER, data.size() * sizeof(glm::vec4), data.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_TEXTURE_BUFFER, 0);
+    buffersDirty = false;
+}
+
+void TrailRenderer::FlushPendingWrites()
+{
+    uploadedSampleCount = pendingVertices.size();
+    if (pendingVertices.empty())
+    {
+        return;
+    }
+    //Unsynchronized: the GPU may still be drawing earlier frames from this buffer. The only slots rewritten are
+    //the live sample (which just moves along the trail) and the oldest one (already faded out), so a frame
+    //in flight can at worst see the newer value.
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    int lowest = *std::min_element(pendingVertices.begin(), pendingVertices.end());
+    int highest = *std::max_element(pendingVertices.begin(), pendingVertices.end());
+    GLintptr rangeOffset = (GLintptr)lowest * sizeof(TrailVertex);
+    GLsizeiptr rangeLength = (GLsizeiptr)(highest - lowest + 1) * sizeof(TrailVertex);
+    void* mapped = glMapBufferRange(GL_ARRAY_BUFFER, rangeOffset, rangeLength,
+        GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_FLUSH_EXPLICIT_BIT);
+    if (mapped != nullptr)
+    {
+        TrailVertex* destination = static_cast<TrailVertex*>(mapped);
+        for (size_t i = 0; i < pendingVertices.size(); ++i)
+        {
+            int index = pendingVertices[i] - lowest;
+            destination[index] = pendingData[i];
+            glFlushMappedBufferRange(GL_ARRAY_BUFFER, (GLintptr)index * sizeof(TrailVertex), sizeof(TrailVertex));
+        }
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    ClearPendingWrites();
+}
+
+void TrailRenderer::ClearPendingWrites()
+{
+    for (int position : pendingVertices)
+    {
+        pendingSlots[position] = -1;
+    }
+    pendingVertices.clear();
+    pendingData.clear();
+}
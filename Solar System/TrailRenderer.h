@@ -0,0 +1,66 @@
+#pragma once
+#include <vector>
+#include "glm/glm.hpp"
+class Window;
+class ShaderProgram;
+// Fading trajectory trails. Every trail owns a ring of samples inside one shared vertex buffer; a new sample
+// is committed every duration / capacity seconds and the newest one follows the body in between.
+// Each frame only the samples that changed are written, through an unsynchronized, explicitly flushed
+// glMapBufferRange, and all trails are drawn in one glMultiDrawArrays call (a wrapped ring is two ranges).
+// Drawn with the orbit shader: samples fade out with their age.
+class TrailRenderer
+{
+public:
+	TrailRenderer();
+	TrailRenderer(const TrailRenderer& other) = delete;				//No copy construction allowed.
+	TrailRenderer& operator=(const TrailRenderer& other) = delete;	//No copy assignment allowed.
+	~TrailRenderer() noexcept;										//Frees the buffers.
+	//durationSeconds: how far back the trail reaches, in the clock passed to Update (simulation seconds).
+	int AddTrail(const glm::vec3& color, float opacity, double durationSeconds, int capacity = defaultCapacity);
+	void Update(int trail, const glm::vec3& position, double time);	//Records the body's current position.
+	void Clear();														//Drops every sample (e.g. after trails were hidden).
+	void Draw(Window& window, ShaderProgram& shader, const glm::mat4& viewProjection, double time);
+	size_t GetTrailCount() const;
+	size_t GetUploadedSampleCount() const;		//Samples written to the GPU by the last Draw.
+public:
+	static constexpr int defaultCapacity = 256;
+private:
+	struct Trail
+	{
+		int firstVertex;		//Ring start in the shared buffer; the ring holds capacity + 1 vertices.
+		int capacity;
+		int count = 0;			//Valid samples, the live one included.
+		long long live = -1;	//Ordinal of the live sample; its slot is live % capacity.
+		double interval;		//Time between committed samples.
+		double lastCommit = 0.0;
+		glm::vec3 color;
+		float opacity;
+		float duration;
+	};
+	struct TrailVertex
+	{
+		float x, y, z;
+		unsigned int path;		//Trail index, looks up the color in the path data buffer.
+		float time;				//Sample time relative to timeOrigin.
+	};
+	void WriteSample(const Trail& trail, int slot, const TrailVertex& vertex);
+	void AllocateBuffers();
+	void FlushPendingWrites();
+	void ClearPendingWrites();
+private:
+	unsigned int vertexArray = 0;
+	unsigned int vertexBuffer = 0;
+	unsigned int pathDataBuffer = 0;	//Two RGBA32F texels per trail: color/opacity, (0, 0, 0, duration).
+	unsigned int pathDataTexture = 0;
+	std::vector<Trail> trails;
+	int vertexCount = 0;				//Size of the shared buffer in vertices.
+	bool buffersDirty = false;			//Trails were added since the buffers were allocated.
+	std::vector<int> pendingVertices;	//Buffer positions written since the last flush, each once.
+	std::vector<TrailVertex> pendingData;
+	std::vector<int> pendingSlots;		//Per buffer position: its index in pendingData, -1 when not written.
+	size_t uploadedSampleCount = 0;
+	bool hasTimeOrigin = false;
+	double timeOrigin = 0.0;			//Sample times are stored as floats relative to this.
+	std::vector<int> drawFirsts;		//Scratch arrays for glMultiDrawArrays.
+	std::vector<int> drawCounts;
+};
@@ -3,110 +3,431 @@
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
 #include <iostream>
+#include <algorithm>
+#include <cstring>
 #include "Settings.h"
+#include "GLExtensions.h"
+#ifdef SOLAR_HAS_EGL
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#endif
 
-Window::Window(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight, const std::string title, GLFWmonitor* monitor, GLFWwindow* share)
+Window::Window(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight, const std::string title, GLFWmonitor* monitor, GLFWwindow* share, bool headless)
     :
-    window(nullptr, [](GLFWwindow* window) { glfwDestroyWindow(window); }) //Set the deleter for the managed window.
+    window(nullptr, [](GLFWwindow* window) { glfwDestroyWindow(window); }), //Set the deleter for the managed window.
+    headless(headless)
 {
-    //Initialize GLFW.
-    glfwInit();
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_SAMPLES, 4);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
-    #ifdef __APPLE__
-        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
-    #endif
-    //Create a window and bind its context to the current thread.
-    window.reset(glfwCreateWindow(windowWidth, windowHeight, title.c_str(), monitor, share));
-    if (window == nullptr)
+    if (headless)
     {
-        std::cout << "Failed to init GLFW.\n";
-        exit(EXIT_FAILURE);
+        CreateHeadlessContext(windowWidth, windowHeight);
     }
-    glfwMakeContextCurrent(window.get());
-    //Get the openGL functions addresses using GLAD.
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    else
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        exit(EXIT_FAILURE);
+        //Initialize GLFW.
+        glfwInit();
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_SAMPLES, 4);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+        #ifdef __APPLE__
+            glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        #endif
+        //Create a window and bind its context to the current thread.
+        window.reset(glfwCreateWindow(windowWidth, windowHeight, title.c_str(), monitor, share));
+        if (window == nullptr)
+        {
+            std::cout << "Failed to init GLFW (run with --headless on machines without a display).\n";
+            exit(EXIT_FAILURE);
+        }
+        glfwMakeContextCurrent(window.get());
+        //Get the openGL functions addresses using GLAD.
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+        {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            exit(EXIT_FAILURE);
+        }
+        LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+        glfwGetFramebufferSize(window.get(), &framebufferWidth, &framebufferHeight);
     }
     //Set the viewport of the window.
     glViewport(viewportX, viewportY, viewportWidth, viewportHeight);
     //Set the background clear color.
-    glClearColor(0.2f, 0.3f, 0.3f, 1.0f);
+    SetClearColor(settings::clearColor);
+    InvalidateStateCache();
     //Enable depth to remove hidden parts.
-    glEnable(GL_DEPTH_TEST);
-    glDepthFunc(GL_LESS);
+    SetDepthTest(true);
+    SetDepthFunc(GL_LESS);
+    //Filter across cubemap face edges (skybox).
+    glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
     //Enable MSAA (anti-aliasing).
     glEnable(GL_MULTISAMPLE);
-    // Enable blending for transparent overlays (atmospheres, rings)
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    //Blending is enabled per pass (overlays, orbits, HUD); this is the function they share.
+    SetBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (headless)
+    {
+        return;
+    }
     //Capture the mouse.
     if (settings::captureMouse)
     {
         glfwSetInputMode(window.get(), GLFW_CURSOR, GLFW_CURSOR_DISABLED);
     }
     //Make sure that the viewport size is updated when window is resized.
+    glfwSetWindowUserPointer(window.get(), this);
     glfwSetFramebufferSizeCallback(window.get(),
-        [](GLFWwindow* window, int width, int height) {glViewport(0, 0, width, height); });
+        [](GLFWwindow* window, int width, int height)
+        {
+            glViewport(0, 0, width, height);
+            static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true;
+        });
+    //Everything that can change what should be on screen counts as activity (render on demand).
+    glfwSetKeyCallback(window.get(), [](GLFWwindow* window, int /*key*/, int /*scancode*/, int action, int /*mods*/)
+        {
+            Window* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+            self->activity = true;
+            if (action == GLFW_PRESS)
+                ++self->keysHeld;
+            else if (action == GLFW_RELEASE && self->keysHeld > 0)
+                --self->keysHeld;
+        });
+    glfwSetMouseButtonCallback(window.get(), [](GLFWwindow* window, int /*button*/, int action, int /*mods*/)
+        {
+            Window* self = static_cast<Window*>(glfwGetWindowUserPointer(window));
+            self->activity = true;
+            if (action == GLFW_PRESS)
+                ++self->buttonsHeld;
+            else if (action == GLFW_RELEASE && self->buttonsHeld > 0)
+                --self->buttonsHeld;
+        });
+    glfwSetCursorPosCallback(window.get(), [](GLFWwindow* window, double /*x*/, double /*y*/)
+        { static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true; });
+    glfwSetScrollCallback(window.get(), [](GLFWwindow* window, double /*x*/, double /*y*/)
+        { static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true; });
+    glfwSetWindowRefreshCallback(window.get(), [](GLFWwindow* window)
+        { static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true; });
+    glfwSetWindowFocusCallback(window.get(), [](GLFWwindow* window, int /*focused*/)
+        { static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true; });
+    glfwSetWindowIconifyCallback(window.get(), [](GLFWwindow* window, int /*iconified*/)
+        { static_cast<Window*>(glfwGetWindowUserPointer(window))->activity = true; });
 }
 
 Window::~Window() noexcept
 {
+    if (fullscreenVertexArray != 0)
+    {
+        glDeleteVertexArrays(1, &fullscreenVertexArray);
+    }
+    if (headless)
+    {
+        DestroyHeadlessContext();
+    }
     window.reset();		//Release and safely destroy the window (via the unique pointer deleter).
     glfwTerminate();
 }
 
+void Window::CreateHeadlessContext(int width, int height)
+{
+#ifdef SOLAR_HAS_EGL
+    //Prefer Mesa's surfaceless platform (works without X11/Wayland, e.g. llvmpipe on GPU-less nodes),
+    //fall back to the default display (vendor EGL implementations).
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    auto getPlatformDisplay = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    if (clientExtensions && std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") && getPlatformDisplay)
+    {
+        display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+    }
+    if (display == EGL_NO_DISPLAY)
+    {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+    EGLint major = 0, minor = 0;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor) || !eglBindAPI(EGL_OPENGL_API))
+    {
+        std::cout << "Failed to init EGL.\n";
+        exit(EXIT_FAILURE);
+    }
+    const EGLint configAttributes[] = { EGL_SURFACE_TYPE, EGL_PBUFFER_BIT, EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE };
+    EGLConfig config = nullptr;
+    EGLint configCount = 0;
+    eglChooseConfig(display, configAttributes, &config, 1, &configCount);
+    const EGLint contextAttributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE };
+    //The surfaceless platform may expose no configs at all; rendering goes to our own FBO anyway.
+    EGLContext context = eglCreateContext(display, configCount > 0 ? config : EGL_NO_CONFIG_KHR, EGL_NO_CONTEXT, contextAttributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context))
+    {
+        std::cout << "Failed to create a surfaceless OpenGL 3.3 context (EGL error 0x" << std::hex << eglGetError() << std::dec << ").\n";
+        exit(EXIT_FAILURE);
+    }
+    eglDisplay = display;
+    eglContext = context;
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    LoadGLExtensions((GLADloadproc)eglGetProcAddress);
+#else
+    //Without EGL use an invisible GLFW window; its default framebuffer is never shown or read.
+    glfwInit();
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    #ifdef __APPLE__
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+    #endif
+    window.reset(glfwCreateWindow(1, 1, "", nullptr, nullptr));
+    if (window == nullptr)
+    {
+        std::cout << "Failed to create a hidden GLFW window for headless rendering.\n";
+        exit(EXIT_FAILURE);
+    }
+    glfwMakeContextCurrent(window.get());
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        exit(EXIT_FAILURE);
+    }
+    LoadGLExtensions((GLADloadproc)glfwGetProcAddress);
+#endif
+    std::cout << "Headless renderer: " << glGetString(GL_RENDERER) << "\n";
+    CreateOffscreenFramebuffer(width, height);
+}
+
+void Window::CreateOffscreenFramebuffer(int width, int height)
+{
+    framebufferWidth = width;
+    framebufferHeight = height;
+    //Same 4x MSAA the window asks GLFW for.
+    GLint maxSamples = 0;
+    glGetIntegerv(GL_MAX_SAMPLES, &maxSamples);
+    GLsizei samples = std::min(4, (int)maxSamples);
+    glGenRenderbuffers(1, &offscreenColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenColor);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_RGBA8, width, height);
+    glGenRenderbuffers(1, &offscreenDepth);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreenDepth);
+    glRenderbufferStorageMultisample(GL_RENDERBUFFER, samples, GL_DEPTH_COMPONENT24, width, height);
+    glGenFramebuffers(1, &offscreenFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreenColor);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, offscreenDepth);
+    bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    //Multisampled storage cannot be read directly; frames are resolved into this one first.
+    glGenRenderbuffers(1, &resolveColor);
+    glBindRenderbuffer(GL_RENDERBUFFER, resolveColor);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    glGenFramebuffers(1, &resolveFBO);
+    glBindFramebuffer(GL_FRAMEBUFFER, resolveFBO);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, resolveColor);
+    complete = complete && glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+    if (!complete)
+    {
+        std::cout << "Failed to create the offscreen framebuffer.\n";
+        exit(EXIT_FAILURE);
+    }
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    //Everything from here on renders offscreen.
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreenFBO);
+}
+
+void Window::DestroyHeadlessContext() noexcept
+{
+    if (offscreenFBO != 0)
+    {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        glDeleteFramebuffers(1, &offscreenFBO);
+        glDeleteFramebuffers(1, &resolveFBO);
+        glDeleteRenderbuffers(1, &offscreenColor);
+        glDeleteRenderbuffers(1, &offscreenDepth);
+        glDeleteRenderbuffers(1, &resolveColor);
+        offscreenFBO = resolveFBO = offscreenColor = offscreenDepth = resolveColor = 0;
+    }
+#ifdef SOLAR_HAS_EGL
+    if (eglDisplay != nullptr)
+    {
+        eglMakeCurrent(eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (eglContext != nullptr)
+        {
+            eglDestroyContext(eglDisplay, eglContext);
+        }
+        eglTerminate(eglDisplay);
+        eglDisplay = nullptr;
+        eglContext = nullptr;
+    }
+#endif
+}
+
 void Window::UseShader(const ShaderProgram& shaderProgram)
 {
-    glUseProgram(shaderProgram.GetID());
+    unsigned int program = shaderProgram.GetID();
+    if (ShouldIssue(stateCache.program != program))
+    {
+        glUseProgram(program);
+        stateCache.program = program;
+    }
+}
+
+void Window::BindVertexArray(unsigned int vertexArray)
+{
+    if (ShouldIssue(stateCache.vertexArray != vertexArray))
+    {
+        glBindVertexArray(vertexArray);
+        stateCache.vertexArray = vertexArray;
+    }
+}
+
+void Window::BindTexture(unsigned int unit, unsigned int target, unsigned int texture)
+{
+    unsigned int* bound = nullptr;
+    if (unit < (unsigned int)cachedTextureUnits)
+    {
+        bound = (target == GL_TEXTURE_CUBE_MAP) ? &stateCache.texturesCube[unit] : &stateCache.textures2D[unit];
+    }
+    if (!ShouldIssue(bound == nullptr || *bound != texture))
+    {
+        return;
+    }
+    //Switching the active unit is only needed when something is actually bound.
+    if (ShouldIssue(stateCache.activeTextureUnit != unit))
+    {
+        glActiveTexture(GL_TEXTURE0 + unit);
+        stateCache.activeTextureUnit = unit;
+    }
+    glBindTexture(target, texture);
+    if (bound != nullptr)
+    {
+        *bound = texture;
+    }
+}
+
+void Window::SetBlend(bool enabled)
+{
+    if (ShouldIssue(stateCache.blend != (unsigned int)enabled))
+    {
+        if (enabled)
+            glEnable(GL_BLEND);
+        else
+            glDisable(GL_BLEND);
+        stateCache.blend = enabled;
+    }
+}
+
+void Window::SetBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor)
+{
+    if (ShouldIssue(stateCache.blendSource != sourceFactor || stateCache.blendDestination != destinationFactor))
+    {
+        glBlendFunc(sourceFactor, destinationFactor);
+        stateCache.blendSource = sourceFactor;
+        stateCache.blendDestination = destinationFactor;
+    }
+}
+
+void Window::SetDepthTest(bool enabled)
+{
+    if (ShouldIssue(stateCache.depthTest != (unsigned int)enabled))
+    {
+        if (enabled)
+            glEnable(GL_DEPTH_TEST);
+        else
+            glDisable(GL_DEPTH_TEST);
+        stateCache.depthTest = enabled;
+    }
+}
+
+void Window::SetDepthFunc(unsigned int function)
+{
+    if (ShouldIssue(stateCache.depthFunc != function))
+    {
+        glDepthFunc(function);
+        stateCache.depthFunc = function;
+    }
+}
+
+void Window::SetDepthMask(bool enabled)
+{
+    if (ShouldIssue(stateCache.depthMask != (unsigned int)enabled))
+    {
+        glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+        stateCache.depthMask = enabled;
+    }
+}
+
+void Window::SetColorMask(bool enabled)
+{
+    if (ShouldIssue(stateCache.colorMask != (unsigned int)enabled))
+    {
+        GLboolean mask = enabled ? GL_TRUE : GL_FALSE;
+        glColorMask(mask, mask, mask, mask);
+        stateCache.colorMask = enabled;
+    }
+}
+
+void Window::SetPolygonMode(unsigned int mode)
+{
+    if (ShouldIssue(stateCache.polygonMode != mode))
+    {
+        glPolygonMode(GL_FRONT_AND_BACK, mode);
+        stateCache.polygonMode = mode;
+    }
+}
+
+void Window::InvalidateStateCache()
+{
+    stateCache = StateCache{};
+    for (int unit = 0; unit < cachedTextureUnits; ++unit)
+    {
+        stateCache.textures2D[unit] = unknownState;
+        stateCache.texturesCube[unit] = unknownState;
+    }
+}
+
+bool Window::ShouldIssue(bool changed)
+{
+    if (changed)
+        ++drawStatistics.stateChangesIssued;
+    else
+        ++drawStatistics.stateChangesElided;
+    return changed;
 }
 
 void Window::DrawActor(const Mesh& mesh, const Texture& texture)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture.GetID());
-    glBindVertexArray(mesh.GetVAO());
-    glDrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
+    BindTexture(0, GL_TEXTURE_2D, texture.GetID());
+    BindVertexArray(mesh.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
 }
 
 void Window::DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1.GetID());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2.GetID());
-    glBindVertexArray(mesh.GetVAO());
-    glDrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
+    BindTexture(0, GL_TEXTURE_2D, texture1.GetID());
+    BindTexture(1, GL_TEXTURE_2D, texture2.GetID());
+    BindVertexArray(mesh.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
 }
 
 void Window::DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2, const Texture& texture3)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1.GetID());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2.GetID());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, texture3.GetID());
-    glBindVertexArray(mesh.GetVAO());
-    glDrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
+    BindTexture(0, GL_TEXTURE_2D, texture1.GetID());
+    BindTexture(1, GL_TEXTURE_2D, texture2.GetID());
+    BindTexture(2, GL_TEXTURE_2D, texture3.GetID());
+    BindVertexArray(mesh.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
 }
 
 void Window::DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2, const Texture& texture3, const Texture& texture4)
 {
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, texture1.GetID());
-    glActiveTexture(GL_TEXTURE1);
-    glBindTexture(GL_TEXTURE_2D, texture2.GetID());
-    glActiveTexture(GL_TEXTURE2);
-    glBindTexture(GL_TEXTURE_2D, texture3.GetID());
-    glActiveTexture(GL_TEXTURE3);
-    glBindTexture(GL_TEXTURE_2D, texture4.GetID());
-    glBindVertexArray(mesh.GetVAO());
-    glDrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
+    BindTexture(0, GL_TEXTURE_2D, texture1.GetID());
+    BindTexture(1, GL_TEXTURE_2D, texture2.GetID());
+    BindTexture(2, GL_TEXTURE_2D, texture3.GetID());
+    BindTexture(3, GL_TEXTURE_2D, texture4.GetID());
+    BindVertexArray(mesh.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
 }
 
 void Window::DrawActor(const Mesh& mesh, const Texture& texture, const ShaderProgram& shaderProgram)
@@ -115,23 +436,142 @@ void Window::DrawActor(const Mesh& mesh, const Texture& texture, const ShaderPro
     DrawActor(mesh, texture);
 }
 
+void Window::DrawMesh(const Mesh& mesh)
+{
+    BindVertexArray(mesh.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, mesh.GetVertexCount());
+}
+
+void Window::DrawMesh(const MeshBatch& batch, int index)
+{
+    BindVertexArray(batch.GetVAO());
+    DrawArrays(GL_TRIANGLES, batch.GetFirstVertex(index), batch.GetVertexCount(index));
+}
+
+void Window::DrawActor(const MeshBatch& batch, int index, const Texture& texture)
+{
+    BindTexture(0, GL_TEXTURE_2D, texture.GetID());
+    DrawMesh(batch, index);
+}
+
+void Window::DrawSkybox(const Skybox& skybox)
+{
+    //The triangle sits exactly on the far plane: LEQUAL lets it pass only where nothing was drawn,
+    //and depth writes are skipped since the buffer already holds 1 there.
+    SetDepthTest(true);
+    SetDepthFunc(GL_LEQUAL);
+    SetDepthMask(false);
+    SetBlend(false);
+    BindTexture(0, GL_TEXTURE_CUBE_MAP, skybox.GetCubemapID());
+    BindVertexArray(skybox.GetVAO());
+    DrawArrays(GL_TRIANGLES, 0, 3);
+}
+
+void Window::DrawArrays(unsigned int mode, int first, int count)
+{
+    glDrawArrays(mode, first, count);
+    ++drawStatistics.drawCalls;
+    if (mode == GL_TRIANGLES)
+        drawStatistics.triangles += count / 3;
+    else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+        drawStatistics.triangles += count > 2 ? count - 2 : 0;
+}
+
+void Window::DrawElementsInstanced(unsigned int mode, int count, unsigned int indexType, int instanceCount)
+{
+    glDrawElementsInstanced(mode, count, indexType, nullptr, instanceCount);
+    ++drawStatistics.drawCalls;
+    if (mode == GL_TRIANGLES)
+        drawStatistics.triangles += (unsigned long long)(count / 3) * instanceCount;
+}
+
+void Window::MultiDrawArrays(unsigned int mode, const int* firsts, const int* counts, int drawCount)
+{
+    glMultiDrawArrays(mode, firsts, counts, drawCount);
+    ++drawStatistics.drawCalls;
+    for (int i = 0; i < drawCount; ++i)
+    {
+        if (mode == GL_TRIANGLES)
+            drawStatistics.triangles += counts[i] / 3;
+        else if (mode == GL_TRIANGLE_STRIP || mode == GL_TRIANGLE_FAN)
+            drawStatistics.triangles += counts[i] > 2 ? counts[i] - 2 : 0;
+    }
+}
+
+const Window::DrawStatistics& Window::GetDrawStatistics() const
+{
+    return drawStatistics;
+}
+
+void Window::DrawFullscreenTriangle()
+{
+    if (fullscreenVertexArray == 0)
+    {
+        glGenVertexArrays(1, &fullscreenVertexArray);
+    }
+    SetPolygonMode(GL_FILL);
+    BindVertexArray(fullscreenVertexArray);
+    DrawArrays(GL_TRIANGLES, 0, 3);
+    SetPolygonMode(wireframeMode ? GL_LINE : GL_FILL);
+}
+
 void Window::ClearBuffers()
 {
+    drawStatistics = DrawStatistics{};
+    InvalidateStateCache();
+    //Clears honour the write masks.
+    SetDepthMask(true);
+    SetColorMask(true);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 }
 
+void Window::SetClearColor(const glm::vec3& color)
+{
+    glClearColor(color.r, color.g, color.b, 1.0f);
+}
+
 void Window::SwapBuffers()
 {
+    if (headless)
+    {
+        //Nothing to present; finishing keeps frames from queueing up and makes frame times meaningful.
+        glFinish();
+        return;
+    }
     glfwSwapBuffers(window.get());
 }
 
 void Window::PollEvents() const
 {
-    glfwPollEvents();
+    if (!headless)
+    {
+        glfwPollEvents();
+    }
+}
+
+void Window::WaitEvents(float timeoutSeconds) const
+{
+    if (!headless)
+    {
+        glfwWaitEventsTimeout(timeoutSeconds);
+    }
+}
+
+void Window::SetSwapInterval(int interval)
+{
+    if (!headless)
+    {
+        glfwSwapInterval(interval);
+    }
 }
 
 void Window::Close()
 {
+    if (headless)
+    {
+        closeRequested = true;
+        return;
+    }
     glfwSetWindowShouldClose(window.get(), true);
 }
 
@@ -139,23 +579,58 @@ void Window::ToggleWireframe()
 {
     if (wireframeMode)
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+        SetPolygonMode(GL_FILL);
         wireframeMode = false;
     }
     else
     {
-        glPolygonMode(GL_FRONT_AND_BACK, GL_LINE);
+        SetPolygonMode(GL_LINE);
         wireframeMode = true;
     }
 }
 
+void Window::SampleInput(InputState& state) const
+{
+    state.keys.reset();
+    if (headless)
+    {
+        state.mousePosition = glm::vec2(0.0f);
+        return;
+    }
+    //Key codes below GLFW_KEY_SPACE are not keys (glfwGetKey rejects them).
+    for (int key = GLFW_KEY_SPACE; key < keyCount; ++key)
+    {
+        state.keys[key] = glfwGetKey(window.get(), key) == GLFW_PRESS;
+    }
+    double xpos, ypos;
+    glfwGetCursorPos(window.get(), &xpos, &ypos);
+    state.mousePosition = glm::vec2(xpos, ypos);
+}
+
+void Window::SetInputOverride(const InputState* state)
+{
+    inputOverride = state;
+}
+
 bool Window::ShouldClose() const
 {
+    if (headless)
+    {
+        return closeRequested;
+    }
     return glfwWindowShouldClose(window.get());
 }
 
 bool Window::IsKeyPressed(int key) const
 {
+    if (inputOverride)
+    {
+        return key >= 0 && key < keyCount && inputOverride->keys[key];
+    }
+    if (headless)
+    {
+        return false;
+    }
     return glfwGetKey(window.get(), key) == GLFW_PRESS;
 }
 
@@ -182,12 +657,86 @@ bool Window::IsKeyPressedOnce(int key)
 
 float Window::GetElapsedTime() const
 {
+    if (headless)
+    {
+        return std::chrono::duration<float>(std::chrono::steady_clock::now() - startTime).count();
+    }
     return (float)glfwGetTime();
 }
 
 glm::vec2 Window::GetMousePosition() const
 {
+    if (inputOverride)
+    {
+        return inputOverride->mousePosition;
+    }
+    if (headless)
+    {
+        return glm::vec2(0.0f);
+    }
     double xpos, ypos;
     glfwGetCursorPos(window.get(), &xpos, &ypos);
     return glm::vec2(xpos, ypos);
-}
\ No newline at end of file
+}
+
+bool Window::IsHeadless() const
+{
+    return headless;
+}
+
+bool Window::IsHidden() const
+{
+    if (headless)
+    {
+        return false;
+    }
+    return glfwGetWindowAttrib(window.get(), GLFW_ICONIFIED) || !glfwGetWindowAttrib(window.get(), GLFW_VISIBLE);
+}
+
+bool Window::TakeActivity()
+{
+    bool active = activity || keysHeld > 0 || buttonsHeld > 0;
+    activity = false;
+    return active;
+}
+
+unsigned int Window::GetFramebuffer() const
+{
+    return offscreenFBO;
+}
+
+glm::ivec2 Window::GetFramebufferSize() const
+{
+    if (headless)
+    {
+        return glm::ivec2(framebufferWidth, framebufferHeight);
+    }
+    int width = 0, height = 0;
+    glfwGetFramebufferSize(window.get(), &width, &height);
+    return glm::ivec2(width, height);
+}
+
+void Window::ReadPixels(std::vector<unsigned char>& rgb, int& width, int& height)
+{
+    if (headless)
+    {
+        //Resolve the multisampled frame, then read the resolved copy.
+        width = framebufferWidth;
+        height = framebufferHeight;
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, offscreenFBO);
+        glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resolveFBO);
+        glBlitFramebuffer(0, 0, width, height, 0, 0, width, height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, resolveFBO);
+    }
+    else
+    {
+        glfwGetFramebufferSize(window.get(), &width, &height);
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glReadBuffer(GL_BACK);
+    }
+    rgb.resize((size_t)width * height * 3);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(0, 0, width, height, GL_RGB, GL_UNSIGNED_BYTE, rgb.data());
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindFramebuffer(GL_FRAMEBUFFER, GetFramebuffer());
+}
@@ -2,42 +2,141 @@
 #include <string>
 #include <memory>
 #include <functional>
+#include <vector>
+#include <chrono>
+#include <bitset>
 #include <glm/vec2.hpp>
+#include <glm/vec3.hpp>
 #include "ShaderProgram.h"
 #include "Actor.h"
 #include "Mesh.h"
 #include "Texture.h"
+#include "Skybox.h"
 // Creates and owns the GLFW window and OpenGL context; configures global GL state
 // and offers minimal helpers to bind shaders and draw VAO-backed meshes with up to 4 textures.
+// Shadows the GL state it sets (program, VAO, texture units, blend, depth, color mask, polygon mode) and skips
+// calls that would not change anything; the shadow is invalidated every frame in ClearBuffers, so GL calls made
+// elsewhere between frames (resource loading) cannot leave it stale.
+// In headless mode no window is created: the context is an offscreen one (EGL surfaceless when built
+// with EGL, otherwise a hidden GLFW window) and frames are rendered into a multisampled framebuffer object.
+// Keyboard and mouse queries can be answered from an InputState instead of the devices (input recording and replay).
 class Window
 {
+public:
+	struct DrawStatistics
+	{
+		unsigned int drawCalls = 0;
+		unsigned long long triangles = 0;
+		unsigned int stateChangesIssued = 0;	//GL state calls that reached the driver.
+		unsigned int stateChangesElided = 0;	//GL state calls skipped because the state was already set.
+	};
+	static constexpr int keyCount = 349;	//GLFW_KEY_LAST + 1.
+	struct InputState
+	{
+		glm::vec2 mousePosition = glm::vec2(0.0f);
+		std::bitset<keyCount> keys;		//Pressed keys, by GLFW key code.
+	};
 public:
 	Window(int windowWidth, int windowHeight, int viewportX, int viewportY, int viewportWidth, int viewportHeight,
-		const std::string title, struct GLFWmonitor* monitor = nullptr, struct GLFWwindow* share = nullptr);
+		const std::string title, struct GLFWmonitor* monitor = nullptr, struct GLFWwindow* share = nullptr, bool headless = false);
 	Window(const Window& other) = delete;				//No copy construction allowed.
 	Window& operator=(const Window& other) = delete;	//No copy assignment allowed.
 	~Window() noexcept;
 	void UseShader(const ShaderProgram& shaderProgram);	//Binds the given shader.
+	void BindVertexArray(unsigned int vertexArray);
+	void BindTexture(unsigned int unit, unsigned int target, unsigned int texture);	//target: GL_TEXTURE_2D or GL_TEXTURE_CUBE_MAP.
+	void SetBlend(bool enabled);
+	void SetBlendFunc(unsigned int sourceFactor, unsigned int destinationFactor);
+	void SetDepthTest(bool enabled);
+	void SetDepthFunc(unsigned int function);
+	void SetDepthMask(bool enabled);
+	void SetColorMask(bool enabled);
+	void InvalidateStateCache();		//Forget the shadowed state (after GL calls made outside Window).
 	void DrawActor(const Mesh& mesh, const Texture& texture);	//Draws actor with the given mesh and texture.
 	void DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2);	//Draws actor with the given mesh and textures.
 	void DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2, const Texture& texture3);	//Draws actor with the given mesh and textures.
 	void DrawActor(const Mesh& mesh, const Texture& texture1, const Texture& texture2, const Texture& texture3, const Texture& texture4);	//Draws actor with the given mesh and textures.
 	void DrawActor(const Mesh& mesh, const Texture& texture, const ShaderProgram& shaderProgram); //Binds the given shader, then draws actor.
-	void ClearBuffers();				//Clears the color and depth buffers.
-	void SwapBuffers();					//Swaps the buffers to display a frame.
+	void DrawMesh(const Mesh& mesh);	//Draws the mesh without binding textures (depth-only/debug passes).
+	void DrawMesh(const MeshBatch& batch, int index);	//Same for one mesh of a batch.
+	void DrawActor(const MeshBatch& batch, int index, const Texture& texture);	//Draws one mesh of a batch with the given texture.
+	void DrawSkybox(const Skybox& skybox);	//Draws the skybox triangle behind everything already in the depth buffer (leaves LEQUAL, depth writes off).
+	void DrawArrays(unsigned int mode, int first, int count);	//glDrawArrays on the bound VAO, counted in the draw statistics.
+	void DrawElementsInstanced(unsigned int mode, int count, unsigned int indexType, int instanceCount);	//Same for the bound VAO's index buffer.
+	void MultiDrawArrays(unsigned int mode, const int* firsts, const int* counts, int drawCount);	//Several ranges, one call.
+	void DrawFullscreenTriangle();		//One gl_VertexID-only triangle over the viewport, filled even in wireframe mode (post passes).
+	void ClearBuffers();				//Clears the color and depth buffers and starts a new frame of draw statistics.
+	void SetClearColor(const glm::vec3& color);	//Sets the color the color buffer is cleared to.
+	void SwapBuffers();					//Swaps the buffers to display a frame (headless: waits for the frame to finish).
 	void PollEvents() const;			//Processes the pending window events.
+	void WaitEvents(float timeoutSeconds) const;	//Sleeps until an event arrives or the timeout passes, then processes the events.
+	void SetSwapInterval(int interval);	//Refreshes to wait for when presenting (0 = no vsync).
 	void Close();						//Flags the window for closing.
 	void ToggleWireframe(); //Enables or disables wireframe mode.
+	void SampleInput(InputState& state) const;		//Reads every key and the cursor from the devices.
+	void SetInputOverride(const InputState* state);	//Key and mouse queries answer from state until reset with nullptr.
 public:
 	bool ShouldClose() const;			//Returns whether or not the window is flagged for closing.
 	bool IsKeyPressed(int key) const;	//Returns true if the given key is currently pressed, false otherwise.
 	bool IsKeyPressedOnce(int key);		//Returns true when key is pressed, then false until the key is released and pressed again.
 	float GetElapsedTime() const;		//Returns the time elapsed since the creation of the window (in seconds).
 	glm::vec2 GetMousePosition() const;	//Returns the mouse position in screen coordinates.
+	bool IsHeadless() const;
+	bool IsHidden() const;				//Iconified or not visible, nothing drawn would be seen (never while headless).
+	bool TakeActivity();				//Whether input, a resize or an expose arrived since the last call, or a key or button is held.
+	unsigned int GetFramebuffer() const;	//The framebuffer frames are rendered into (0 for the window's back buffer).
+	glm::ivec2 GetFramebufferSize() const;	//Its size in pixels (can differ from the window size on high-DPI screens).
+	void ReadPixels(std::vector<unsigned char>& rgb, int& width, int& height);	//Reads the current frame as tightly packed RGB rows, bottom row first.
+	const DrawStatistics& GetDrawStatistics() const;	//Draw calls and triangles submitted since the last ClearBuffers.
+private:
+	void CreateHeadlessContext(int width, int height);
+	void CreateOffscreenFramebuffer(int width, int height);
+	void DestroyHeadlessContext() noexcept;
+	void SetPolygonMode(unsigned int mode);
+	bool ShouldIssue(bool changed);		//Counts the call as issued or elided.
 private:
 	//The GLFW window is a third party struct that lacks a destructor, so a unique pointer is used to safely manage
 	//it and automatically destroy it using a custom deleter. Preventing any potential memory leaks.
 	std::unique_ptr<GLFWwindow, std::function<void(GLFWwindow*)>> window;
-	bool keyStates[349] = { false };//Whether a keyboard key is in the pressed state or not.
+	bool keyStates[keyCount] = { false };//Whether a keyboard key is in the pressed state or not.
+	const InputState* inputOverride = nullptr;	//Answers the key and mouse queries instead of the devices when set.
 	bool wireframeMode = false;
+	bool activity = false;			//Set by the event callbacks, cleared by TakeActivity.
+	int keysHeld = 0;
+	int buttonsHeld = 0;
+	DrawStatistics drawStatistics;
+	//Shadowed GL state; unknownState means "not known, always issue".
+	static constexpr unsigned int unknownState = 0xFFFFFFFFu;
+	static constexpr int cachedTextureUnits = 8;
+	struct StateCache
+	{
+		unsigned int program = unknownState;
+		unsigned int vertexArray = unknownState;
+		unsigned int activeTextureUnit = unknownState;
+		unsigned int textures2D[cachedTextureUnits];
+		unsigned int texturesCube[cachedTextureUnits];
+		unsigned int blend = unknownState;
+		unsigned int blendSource = unknownState;
+		unsigned int blendDestination = unknownState;
+		unsigned int depthTest = unknownState;
+		unsigned int depthFunc = unknownState;
+		unsigned int depthMask = unknownState;
+		unsigned int colorMask = unknownState;
+		unsigned int polygonMode = unknownState;
+	};
+	StateCache stateCache;
+	//Headless state.
+	bool headless = false;
+	bool closeRequested = false;
+	void* eglDisplay = nullptr;		//EGLDisplay/EGLContext, kept opaque so EGL headers stay out of this header.
+	void* eglContext = nullptr;
+	unsigned int offscreenFBO = 0;	//Multisampled render target.
+	unsigned int resolveFBO = 0;	//Single-sample copy used for reading pixels back.
+	unsigned int offscreenColor = 0;
+	unsigned int offscreenDepth = 0;
+	unsigned int resolveColor = 0;
+	unsigned int fullscreenVertexArray = 0;	//Empty VAO for DrawFullscreenTriangle (the core profile needs one bound).
+	int framebufferWidth = 0;
+	int framebufferHeight = 0;
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
 };
\ No newline at end of file
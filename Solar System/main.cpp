@@ -1,12 +1,19 @@
-// Entry point: creates Game and runs the main loop until the window signals close.
+// Entry point: parses the launch options, creates Game and runs the main loop until the window signals close
+// (window closed, Escape, or the frame/duration limit of a headless run).
 #include <iostream>
 #include "Game.h"
 #include "Settings.h"
+#include "LaunchOptions.h"
 
-int main()
+int main(int argc, char** argv)
 {
 	using namespace settings;
-	Game game{ windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, windowTitle };
+	LaunchOptions options;
+	if (!ParseLaunchOptions(argc, argv, options))
+	{
+		return EXIT_FAILURE;
+	}
+	Game game{ windowWidth, windowHeight, viewportX, viewportY, viewportWidth, viewportHeight, windowTitle, options };
 
 	while (!game.ShouldClose())
 	{
@@ -1,99 +1,355 @@
-// Very simple OBJ parser: reads vertices, uvs, normals and triangulated faces.
-#include <vector>
-#include <stdio.h>
-#include <string>
+// OBJ parser: the mapped file is split at line boundaries and the chunks are parsed on their own threads with
+// std::from_chars. Chunks only know their own element counts, so indices are resolved in a second parallel
+// pass once the counts of the previous chunks are known; the output is sized up front and written in place.
+#include <algorithm>
+#include <charconv>
+#include <chrono>
 #include <cstring>
+#include <string>
+#include <thread>
+#include "MappedFile.h"
 #include "objload.h"
-#pragma warning( push )
-#pragma warning( disable : 4996)
-// Very, VERY simple OBJ loader.
 
-bool loadOBJ(
-	const char * path,
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
-)
-{
-	printf("Loading OBJ file %s...\n", path);
+namespace {
+	constexpr size_t minChunkBytes = 256 * 1024;	//Smaller files are not worth a thread.
+	constexpr int missingIndex = -1;
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices;
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
+	//A face corner: 0-based indices, either file-wide or relative to the chunk's first element (negative ones
+	//then point into earlier chunks).
+	struct Corner
+	{
+		int indices[3];			//Position, texture coordinate, normal.
+		unsigned char present;	//Bit i set: the corner has attribute i.
+		unsigned char absolute;	//Bit i set: indices[i] was given as a positive (file-wide) index.
+	};
 
+	struct Chunk
+	{
+		const char* begin;
+		const char* end;
+		std::vector<glm::vec3> positions;
+		std::vector<glm::vec2> uvs;
+		std::vector<glm::vec3> normals;
+		std::vector<Corner> corners;	//Three per triangle.
+		size_t positionOffset = 0;		//Elements in the chunks before this one.
+		size_t uvOffset = 0;
+		size_t normalOffset = 0;
+		size_t cornerOffset = 0;
+		bool hasUVs = false;
+		std::string error;
+	};
 
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
-		printf("Impossible to open the file !\n");
-		getchar();
-		return false;
+	const char* SkipBlanks(const char* p, const char* end)
+	{
+		while (p < end && (*p == ' ' || *p == '\t'))
+			++p;
+		return p;
+	}
+
+	const char* NextLine(const char* p, const char* end)
+	{
+		const void* newline = std::memchr(p, '\n', (size_t)(end - p));
+		return newline ? static_cast<const char*>(newline) + 1 : end;
 	}
 
-	while( 1 ){
-
-		char lineHeader[128];
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF
-		if ( strcmp( lineHeader, "v" ) == 0 ){
-			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
-			uv.y = -uv.y;
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read \n");
+	bool ParseFloats(const char* p, const char* end, float* values, int count, int required)
+	{
+		for (int i = 0; i < count; ++i)
+		{
+			p = SkipBlanks(p, end);
+			if (p < end && *p == '+')
+				++p;	//from_chars does not take a leading '+'.
+			std::from_chars_result result = std::from_chars(p, end, values[i]);
+			if (result.ec != std::errc())
+				return i >= required;
+			p = result.ptr;
+		}
+		return true;
+	}
+
+	//One v, v/t, v//n or v/t/n group. Indices stay as written (1-based or negative), 0 when absent.
+	bool ParseCorner(const char*& p, const char* end, int (&values)[3])
+	{
+		values[0] = values[1] = values[2] = 0;
+		for (int i = 0; i < 3; ++i)
+		{
+			if (i > 0)
+			{
+				if (p >= end || *p != '/')
+					break;
+				++p;
+				if (p < end && *p == '/')
+					continue;	//Empty texture coordinate.
+			}
+			std::from_chars_result result = std::from_chars(p, end, values[i]);
+			if (result.ec != std::errc() || values[i] == 0)
 				return false;
+			p = result.ptr;
+		}
+		return p >= end || *p == ' ' || *p == '\t' || *p == '\r' || *p == '\n';
+	}
+
+	//Counts the lines of each kind so that nothing grows while parsing.
+	void ReserveChunk(Chunk& chunk)
+	{
+		size_t positions = 0, uvs = 0, normals = 0, faces = 0;
+		for (const char* p = chunk.begin; p < chunk.end; p = NextLine(p, chunk.end))
+		{
+			const char* line = SkipBlanks(p, chunk.end);
+			if (chunk.end - line < 2)
+				continue;
+			if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+				++faces;
+			else if (line[0] == 'v')
+			{
+				if (line[1] == ' ' || line[1] == '\t')
+					++positions;
+				else if (line[1] == 't')
+					++uvs;
+				else if (line[1] == 'n')
+					++normals;
 			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
 		}
+		chunk.positions.reserve(positions);
+		chunk.uvs.reserve(uvs);
+		chunk.normals.reserve(normals);
+		chunk.corners.reserve(faces * 3);	//Exact for triangles, n-gons grow it.
+	}
 
+	void ParseChunk(Chunk& chunk)
+	{
+		ReserveChunk(chunk);
+		std::vector<Corner> polygon;
+		for (const char* p = chunk.begin; p < chunk.end; p = NextLine(p, chunk.end))
+		{
+			const char* line = SkipBlanks(p, chunk.end);
+			const char* lineEnd = NextLine(line, chunk.end);
+			if (lineEnd - line < 2)
+				continue;
+			bool valid = true;
+			if (line[0] == 'v' && (line[1] == ' ' || line[1] == '\t'))
+			{
+				glm::vec3 position(0.0f);
+				valid = ParseFloats(line + 2, lineEnd, &position.x, 3, 3);
+				chunk.positions.push_back(position);
+			}
+			else if (line[0] == 'v' && line[1] == 't')
+			{
+				glm::vec2 uv(0.0f);
+				valid = ParseFloats(line + 2, lineEnd, &uv.x, 2, 1);
+				uv.y = -uv.y;
+				chunk.uvs.push_back(uv);
+			}
+			else if (line[0] == 'v' && line[1] == 'n')
+			{
+				glm::vec3 normal(0.0f);
+				valid = ParseFloats(line + 2, lineEnd, &normal.x, 3, 3);
+				chunk.normals.push_back(normal);
+			}
+			else if (line[0] == 'f' && (line[1] == ' ' || line[1] == '\t'))
+			{
+				//Relative indices are resolved against what this chunk has read so far.
+				const int counts[3] = { (int)chunk.positions.size(), (int)chunk.uvs.size(), (int)chunk.normals.size() };
+				polygon.clear();
+				const char* q = SkipBlanks(line + 1, lineEnd);
+				while (valid && q < lineEnd && *q != '\r' && *q != '\n')
+				{
+					int values[3];
+					valid = ParseCorner(q, lineEnd, values);
+					Corner corner{ { 0, 0, 0 }, 0, 0 };
+					for (int i = 0; i < 3; ++i)
+					{
+						if (values[i] == 0)
+							continue;
+						corner.present |= (unsigned char)(1 << i);
+						if (values[i] > 0)
+						{
+							corner.indices[i] = values[i] - 1;
+							corner.absolute |= (unsigned char)(1 << i);
+						}
+						else
+							corner.indices[i] = counts[i] + values[i];
+					}
+					chunk.hasUVs |= (corner.present & 2) != 0;
+					polygon.push_back(corner);
+					q = SkipBlanks(q, lineEnd);
+				}
+				valid = valid && polygon.size() >= 3;
+				for (size_t i = 2; valid && i < polygon.size(); ++i)
+				{
+					chunk.corners.push_back(polygon[0]);
+					chunk.corners.push_back(polygon[i - 1]);
+					chunk.corners.push_back(polygon[i]);
+				}
+			}
+			if (!valid)
+			{
+				const char* textEnd = lineEnd;
+				while (textEnd > line && (textEnd[-1] == '\n' || textEnd[-1] == '\r'))
+					--textEnd;
+				chunk.error = "Malformed line in OBJ file: " + std::string(line, textEnd);
+				return;
+			}
+		}
 	}
 
-std::cout<<vertexIndices.size()<<std::endl;
+	//File-wide 0-based index of a corner attribute, or missingIndex when it is out of range.
+	int ResolveIndex(const Corner& corner, int attribute, size_t chunkOffset, size_t count)
+	{
+		if (!(corner.present & (1 << attribute)))
+			return missingIndex;
+		const int index = corner.indices[attribute];
+		long long resolved = (corner.absolute & (1 << attribute)) ? (long long)index : (long long)chunkOffset + index;
+		return resolved >= 0 && resolved < (long long)count ? (int)resolved : missingIndex;
+	}
+
+	void ResolveChunk(Chunk& chunk, const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs,
+		const std::vector<glm::vec3>& normals, glm::vec3* outPositions, glm::vec2* outUVs, glm::vec3* outNormals)
+	{
+		for (size_t i = 0; i < chunk.corners.size(); i += 3)
+		{
+			int positionIndices[3];
+			for (int k = 0; k < 3; ++k)
+			{
+				positionIndices[k] = ResolveIndex(chunk.corners[i + k], 0, chunk.positionOffset, positions.size());
+				if (positionIndices[k] == missingIndex)
+				{
+					chunk.error = "OBJ face refers to a missing vertex";
+					return;
+				}
+			}
+			const glm::vec3& a = positions[positionIndices[0]];
+			const glm::vec3& b = positions[positionIndices[1]];
+			const glm::vec3& c = positions[positionIndices[2]];
+			glm::vec3 faceNormal = glm::cross(b - a, c - a);
+			float length = glm::length(faceNormal);
+			faceNormal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f, 1.0f, 0.0f);
+			const size_t out = chunk.cornerOffset + i;
+			for (int k = 0; k < 3; ++k)
+			{
+				const Corner& corner = chunk.corners[i + k];
+				outPositions[out + k] = positions[positionIndices[k]];
+				int normalIndex = ResolveIndex(corner, 2, chunk.normalOffset, normals.size());
+				outNormals[out + k] = normalIndex != missingIndex ? normals[normalIndex] : faceNormal;
+				if (outUVs)
+				{
+					int uvIndex = ResolveIndex(corner, 1, chunk.uvOffset, uvs.size());
+					outUVs[out + k] = uvIndex != missingIndex ? uvs[uvIndex] : glm::vec2(0.0f);
+				}
+			}
+		}
+	}
 
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
+	template<typename Function>
+	void ForEachChunk(std::vector<Chunk>& chunks, Function function)
+	{
+		std::vector<std::thread> threads;
+		for (size_t i = 1; i < chunks.size(); ++i)
+			threads.emplace_back([&, i]() { function(chunks[i]); });
+		function(chunks[0]);	//The calling thread takes the first chunk.
+		for (std::thread& thread : threads)
+			thread.join();
+	}
+
+	template<typename T>
+	void Concatenate(const std::vector<Chunk>& chunks, std::vector<T> Chunk::* member, std::vector<T>& out)
+	{
+		size_t total = 0;
+		for (const Chunk& chunk : chunks)
+			total += (chunk.*member).size();
+		out.reserve(total);
+		for (const Chunk& chunk : chunks)
+			out.insert(out.end(), (chunk.*member).begin(), (chunk.*member).end());
+	}
+}
+
+bool loadOBJ(
+	const char * path,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	ObjLoadStatistics * statistics
+)
+{
+	const auto start = std::chrono::steady_clock::now();
+	MappedFile file(path);
+	if (!file.IsOpen())
+	{
+		std::cout << "Impossible to open the file: " << path << "\n";
+		return false;
+	}
+	const char* text = reinterpret_cast<const char*>(file.GetData());
+	const size_t size = file.GetSize();
 
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
+	//Split at line starts, one chunk per hardware thread at most.
+	const size_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+	const size_t chunkCount = std::max<size_t>(1, std::min(hardwareThreads, size / minChunkBytes));
+	std::vector<Chunk> chunks(chunkCount);
+	const char* begin = text;
+	for (size_t i = 0; i < chunkCount; ++i)
+	{
+		const char* end = (i + 1 == chunkCount) ? text + size : NextLine(std::max(begin, text + size * (i + 1) / chunkCount - 1), text + size);
+		chunks[i].begin = begin;
+		chunks[i].end = end;
+		begin = end;
+	}
+	ForEachChunk(chunks, ParseChunk);
 
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
+	bool hasUVs = false;
+	size_t positionCount = 0, uvCount = 0, normalCount = 0, cornerCount = 0;
+	for (Chunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cout << chunk.error << "\n";
+			return false;
+		}
+		chunk.positionOffset = positionCount;
+		chunk.uvOffset = uvCount;
+		chunk.normalOffset = normalCount;
+		chunk.cornerOffset = cornerCount;
+		positionCount += chunk.positions.size();
+		uvCount += chunk.uvs.size();
+		normalCount += chunk.normals.size();
+		cornerCount += chunk.corners.size();
+		hasUVs |= chunk.hasUVs;
+	}
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	Concatenate(chunks, &Chunk::positions, positions);
+	Concatenate(chunks, &Chunk::uvs, uvs);
+	Concatenate(chunks, &Chunk::normals, normals);
 
+	//Appended after whatever the vectors already hold.
+	const size_t first = out_vertices.size();
+	out_vertices.resize(first + cornerCount);
+	out_normals.resize(first + cornerCount);
+	if (hasUVs)
+		out_uvs.resize(first + cornerCount);
+	ForEachChunk(chunks, [&](Chunk& chunk)
+	{
+		ResolveChunk(chunk, positions, uvs, normals, out_vertices.data() + first,
+			hasUVs ? out_uvs.data() + first : nullptr, out_normals.data() + first);
+	});
+	for (const Chunk& chunk : chunks)
+	{
+		if (!chunk.error.empty())
+		{
+			std::cout << chunk.error << ": " << path << "\n";
+			out_vertices.resize(first);
+			out_normals.resize(first);
+			out_uvs.resize(std::min(out_uvs.size(), first));
+			return false;
+		}
 	}
 
+	if (statistics)
+	{
+		statistics->bytes = size;
+		statistics->triangles = cornerCount / 3;
+		statistics->chunks = (int)chunkCount;
+		statistics->milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
 	return true;
 }
-#pragma warning( pop )
\ No newline at end of file
@@ -1,15 +1,30 @@
-// Minimal OBJ loader for positions/UVs/normals (triangle faces in v/vt/vn format).
+// OBJ loader for positions/UVs/normals: memory-mapped and parsed in parallel chunks.
 #include <glm/glm.hpp>
+#include <cstddef>
 #include <vector>
 #include <iostream>
 #ifndef OBJLOAD_H
 #define OBJLOAD_H
 
+//Filled by loadOBJ when asked for.
+struct ObjLoadStatistics
+{
+	size_t bytes = 0;			//Size of the file.
+	size_t triangles = 0;		//After triangulating the faces.
+	int chunks = 0;				//Parts parsed in parallel.
+	double milliseconds = 0.0;	//Mapping, parsing and building the output.
+};
+
+//Outputs one vertex per triangle corner (faces are fanned into triangles). Indices may be negative (relative
+//to the end of the list so far). Corners without a normal get the normal of their face; texture coordinates
+//are left empty when no face has them and zero for corners without one. Returns false (with a message) when
+//the file cannot be read or a face is malformed.
 bool loadOBJ(
 	const char * path,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals
+	std::vector<glm::vec3> & out_normals,
+	ObjLoadStatistics * statistics = nullptr
 );
 
 #endif
@@ -0,0 +1,168 @@
+// asset_packer: builds the asset pack read by the game (see AssetPack.h) from the Resources directory.
+// Shaders are stored as they are, meshes as vertex arrays, textures as baked BC1/BC3 mip chains, the star
+// map as the six skybox faces and scenes in their binary form. An asset whose source file did not change is
+// copied from the previous pack instead of being rebuilt, so rerunning the packer after editing one shader takes
+// no time. Pack the Resources directory the game reads from: the pack records each file's size and write time,
+// and the game ignores an entry whose file no longer matches them.
+// Usage: asset_packer <ResourcesDirectory> <OutputPack>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "Mesh.h"
+#include "SceneDescription.h"
+#include "Settings.h"
+#include "Skybox.h"
+#include "TextureCache.h"
+#include "stb_image.h"
+
+namespace {
+	//Bumped when a payload layout changes, so that the old payloads are rebuilt.
+	constexpr uint64_t packerVersion = 1;
+
+	bool ReadFile(const std::filesystem::path& path, std::vector<unsigned char>& bytes)
+	{
+		std::ifstream file(path, std::ios::binary);
+		if (!file)
+			return false;
+		bytes.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		return true;
+	}
+
+	//Hash of everything besides the source file that the payload depends on.
+	uint64_t GetBuildHash(uint64_t parameters)
+	{
+		uint64_t values[2] = { packerVersion, parameters };
+		return AssetPack::Hash(values, sizeof(values));
+	}
+
+	std::vector<unsigned char> BuildTexture(const std::filesystem::path& path)
+	{
+		//Same orientation and channels as the textures decoded by the game.
+		stbi_set_flip_vertically_on_load(1);
+		int width = 0, height = 0, channelsCount = 0;
+		unsigned char* data = stbi_load(path.string().c_str(), &width, &height, &channelsCount, 0);
+		if (!data)
+		{
+			std::cout << "Failed to load texture : " << path.string() << "\n";
+			exit(EXIT_FAILURE);
+		}
+		BakedTexture baked = BakeTexture(data, width, height, channelsCount, true);
+		stbi_image_free(data);
+		return PackBakedTexture(baked);
+	}
+
+	std::vector<unsigned char> BuildScene(const std::filesystem::path& path, const std::vector<unsigned char>& bytes)
+	{
+		SceneDescription scene;
+		if (!ParseScene(std::string(bytes.begin(), bytes.end()), path.string(), scene))
+		{
+			exit(EXIT_FAILURE);
+		}
+		return PackScene(scene);
+	}
+
+	//Sorted so that the pack only changes when the resources do.
+	std::vector<std::filesystem::path> ListFiles(const std::filesystem::path& directory, const std::string& extension)
+	{
+		std::vector<std::filesystem::path> files;
+		std::error_code ec;
+		for (const auto& item : std::filesystem::directory_iterator(directory, ec))
+		{
+			if (item.is_regular_file() && (extension.empty() || item.path().extension() == extension))
+				files.push_back(item.path());
+		}
+		std::sort(files.begin(), files.end());
+		return files;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 3)
+	{
+		std::cout << "Usage: " << argv[0] << " <ResourcesDirectory> <OutputPack>\n";
+		return EXIT_FAILURE;
+	}
+	const std::filesystem::path resources = argv[1];
+	const std::string packPath = argv[2];
+	const std::string skyboxName = "Textures/stars_milkyway.jpg";
+
+	struct Source
+	{
+		std::filesystem::path path;
+		std::string name;
+		AssetPack::Type type;
+		uint64_t parameters;
+	};
+	std::vector<Source> sources;
+	for (const auto& path : ListFiles(resources / "Shaders", ""))
+		sources.push_back({ path, "Shaders/" + path.filename().string(), AssetPack::Type::Raw, 0 });
+	for (const auto& path : ListFiles(resources / "Meshes", ".obj"))
+		sources.push_back({ path, "Meshes/" + path.filename().string(), AssetPack::Type::Mesh, 0 });
+	for (const auto& path : ListFiles(resources / "Textures", ""))
+	{
+		std::string name = "Textures/" + path.filename().string();
+		if (name == skyboxName)
+			sources.push_back({ path, name, AssetPack::Type::Cubemap, (uint64_t)settings::skyboxFaceSize });
+		else
+			sources.push_back({ path, name, AssetPack::Type::Texture, 0 });
+	}
+	for (const auto& path : ListFiles(resources / "Scenes", ".scene"))
+		sources.push_back({ path, "Scenes/" + path.filename().string(), AssetPack::Type::Scene, 0 });
+
+	std::vector<PackedAsset> assets;
+	size_t reused = 0;
+	{
+		const AssetPack previous(packPath);
+		for (const Source& source : sources)
+		{
+			std::vector<unsigned char> bytes;
+			if (!ReadFile(source.path, bytes))
+			{
+				std::cout << "Could not read: " << source.path.string() << "\n";
+				return EXIT_FAILURE;
+			}
+			PackedAsset asset{ source.name, source.type, AssetPack::Hash(bytes.data(), bytes.size()), 0, 0,
+				GetBuildHash(source.parameters), {} };
+			AssetPack::GetSourceStamp(source.path.string(), asset.sourceSize, asset.sourceWriteTime);
+			const AssetPack::Entry* old = previous.FindByName(source.name);
+			if (old != nullptr && old->type == source.type && old->sourceHash == asset.sourceHash
+				&& old->buildHash == asset.buildHash && AssetPack::Hash(old->data, old->size) == old->payloadHash)
+			{
+				asset.payload.assign(old->data, old->data + old->size);
+				++reused;
+			}
+			else if (source.type == AssetPack::Type::Raw)
+				asset.payload = std::move(bytes);
+			else if (source.type == AssetPack::Type::Mesh)
+				asset.payload = Mesh::PackData(Mesh::LoadData(source.path.string()));
+			else if (source.type == AssetPack::Type::Texture)
+				asset.payload = BuildTexture(source.path);
+			else if (source.type == AssetPack::Type::Scene)
+				asset.payload = BuildScene(source.path, bytes);
+			else
+				asset.payload = Skybox::PackFaces(source.path.string(), settings::skyboxFaceSize);
+			assets.push_back(std::move(asset));
+		}
+	}	//The previous pack is unmapped before it is replaced.
+
+	//Written next to the pack and renamed, so that a failed run leaves the previous pack in place.
+	const std::string temporaryPath = packPath + ".tmp";
+	if (!WriteAssetPack(temporaryPath, assets))
+		return EXIT_FAILURE;
+	std::error_code ec;
+	std::filesystem::rename(temporaryPath, packPath, ec);
+	if (ec)
+	{
+		std::cout << "Could not replace " << packPath << ": " << ec.message() << "\n";
+		return EXIT_FAILURE;
+	}
+	std::cout << "Packed " << assets.size() << " assets (" << reused << " unchanged) into " << packPath << "\n";
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,237 @@
+// scene_generator: writes stress scenes for solar_system --scene and solar_bench --scene. It starts from a base
+// scene (the solar system by default), adds planets on random Kepler orbits and moons around them, all dressed
+// like the base scene's bodies so they reuse its textures, and resizes the asteroid belts. Large scenes are best
+// written in the binary form (--binary), which the game reads without parsing.
+// Usage: scene_generator --out FILE [--base FILE] [--planets N] [--moons N] [--asteroids N] [--seed S] [--binary]
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "AssetPack.h"
+#include "SceneDescription.h"
+#include "Settings.h"
+
+namespace {
+	struct GeneratorOptions
+	{
+		std::string basePath = settings::scenePath;
+		std::string outputPath;
+		int planets = 0;				//Planets added to the base scene.
+		int moons = 0;					//Moons added, each around a random planet.
+		int asteroids = -1;				//Asteroids over all belts (-1 = as the base scene says).
+		unsigned int seed = 1;
+		bool binary = false;
+	};
+
+	void PrintUsage(const char* program)
+	{
+		std::cout << "Usage: " << program << " --out FILE [options]\n"
+			<< "  --base FILE              scene to start from (default: the solar system)\n"
+			<< "  --planets N              add N planets on random orbits between 0.35 and 45 AU\n"
+			<< "  --moons N                add N moons, each around a random planet\n"
+			<< "  --asteroids N            share N asteroids among the belts (adds a belt if there is none)\n"
+			<< "  --seed S                 random seed (default 1)\n"
+			<< "  --binary                 write the binary form instead of text\n";
+	}
+
+	bool ParseCount(const char* text, int& value)
+	{
+		char* end = nullptr;
+		long parsed = std::strtol(text, &end, 10);
+		if (end == text || *end != '\0' || parsed < 0 || parsed > 100000000)
+			return false;
+		value = (int)parsed;
+		return true;
+	}
+
+	bool ParseGeneratorOptions(int argc, char** argv, GeneratorOptions& options)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			std::string arg = argv[i];
+			bool hasValue = i + 1 < argc;
+			int count = 0;
+			if (arg == "--out" && hasValue)
+			{
+				options.outputPath = argv[++i];
+			}
+			else if (arg == "--base" && hasValue)
+			{
+				options.basePath = argv[++i];
+			}
+			else if (arg == "--planets" && hasValue && ParseCount(argv[i + 1], count))
+			{
+				options.planets = count;
+				++i;
+			}
+			else if (arg == "--moons" && hasValue && ParseCount(argv[i + 1], count))
+			{
+				options.moons = count;
+				++i;
+			}
+			else if (arg == "--asteroids" && hasValue && ParseCount(argv[i + 1], count))
+			{
+				options.asteroids = count;
+				++i;
+			}
+			else if (arg == "--seed" && hasValue && ParseCount(argv[i + 1], count))
+			{
+				options.seed = (unsigned int)count;
+				++i;
+			}
+			else if (arg == "--binary")
+			{
+				options.binary = true;
+			}
+			else
+			{
+				std::cout << "Invalid argument: " << arg << "\n";
+				PrintUsage(argv[0]);
+				return false;
+			}
+		}
+		if (options.outputPath.empty())
+		{
+			PrintUsage(argv[0]);
+			return false;
+		}
+		return true;
+	}
+
+	//The base bodies of a kind, to copy the look of; falls back to any body that is not a star.
+	std::vector<SceneBody> CollectTemplates(const SceneDescription& scene, SceneBody::Kind kind)
+	{
+		std::vector<SceneBody> templates;
+		for (const SceneBody& body : scene.bodies)
+		{
+			if (body.kind == kind)
+				templates.push_back(body);
+		}
+		for (const SceneBody& body : scene.bodies)
+		{
+			if (templates.empty() && body.kind != SceneBody::Kind::Star)
+				templates.push_back(body);
+		}
+		return templates;
+	}
+
+	void AddPlanets(SceneDescription& scene, int count, std::mt19937& rng)
+	{
+		const std::vector<SceneBody> templates = CollectTemplates(scene, SceneBody::Kind::Planet);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		for (int i = 0; i < count && !templates.empty(); ++i)
+		{
+			SceneBody planet = templates[rng() % templates.size()];
+			planet.kind = SceneBody::Kind::Planet;
+			planet.name = "Planet " + std::to_string(i + 1);
+			planet.parent = -1;
+			planet.radius = (float)(2.0 + 13.0 * unit(rng));
+			planet.rotationSpeedDeg = (float)((unit(rng) < 0.1 ? -1.0 : 1.0) * (20.0 + 880.0 * unit(rng)));
+			planet.obliquityDeg = (float)(40.0 * unit(rng));
+			//Spread evenly in log(a) so the inner system is as busy as the outer one.
+			planet.semiMajorAxisAU = 0.35 * std::pow(45.0 / 0.35, unit(rng));
+			planet.eccentricity = 0.25 * unit(rng) * unit(rng);
+			planet.inclinationDeg = 8.0 * unit(rng) * unit(rng);
+			planet.ascendingNodeDeg = 360.0 * unit(rng);
+			planet.periapsisDeg = 360.0 * unit(rng);
+			planet.meanAnomalyDeg = 360.0 * unit(rng);
+			planet.periodDays = 365.256 * std::pow(planet.semiMajorAxisAU, 1.5);
+			planet.customOrbitColor = false;
+			planet.orbitRadiusMillionKm = (float)(planet.semiMajorAxisAU * 149.6);
+			planet.orbitSpeedKmPerSec = (float)(29.78 / std::sqrt(planet.semiMajorAxisAU));
+			planet.rotationPeriodHours = 360.0f / std::abs(planet.rotationSpeedDeg) * 24.0f;
+			planet.retrograde = planet.rotationSpeedDeg < 0.0f;
+			scene.bodies.push_back(planet);
+		}
+	}
+
+	void AddMoons(SceneDescription& scene, int count, std::mt19937& rng)
+	{
+		std::vector<int> planets;
+		for (size_t i = 0; i < scene.bodies.size(); ++i)
+		{
+			if (scene.bodies[i].kind == SceneBody::Kind::Planet)
+				planets.push_back((int)i);
+		}
+		const std::vector<SceneBody> templates = CollectTemplates(scene, SceneBody::Kind::Moon);
+		std::uniform_real_distribution<double> unit(0.0, 1.0);
+		for (int i = 0; i < count && !planets.empty() && !templates.empty(); ++i)
+		{
+			const int parent = planets[rng() % planets.size()];
+			const SceneBody& parentBody = scene.bodies[parent];
+			SceneBody moon = templates[rng() % templates.size()];
+			moon.kind = SceneBody::Kind::Moon;
+			moon.name = "Moon " + std::to_string(i + 1);
+			moon.parent = parent;
+			moon.radius = parentBody.radius * (float)(0.08 + 0.22 * unit(rng));
+			moon.rotationSpeedDeg = 0.0f;
+			moon.obliquityDeg = 0.0f;
+			moon.orbitRadius = parentBody.radius * (float)(2.5 + 5.0 * unit(rng));
+			moon.periodDays = 2.0 + 58.0 * unit(rng);
+			moon.phaseDeg = (float)(360.0 * unit(rng));
+			moon.atmosphereTexture.clear();
+			moon.ringTexture.clear();
+			moon.customOrbitColor = false;
+			moon.orbitRadiusMillionKm = 0.0f;
+			moon.orbitSpeedKmPerSec = 0.0f;
+			moon.rotationPeriodHours = (float)(moon.periodDays * 24.0);
+			moon.retrograde = false;
+			scene.bodies.push_back(moon);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	GeneratorOptions options;
+	if (!ParseGeneratorOptions(argc, argv, options))
+	{
+		return EXIT_FAILURE;
+	}
+	SceneDescription scene;
+	{
+		const AssetPack noPack("");
+		if (!LoadScene(options.basePath, noPack, scene))
+		{
+			return EXIT_FAILURE;
+		}
+	}
+	std::mt19937 rng(options.seed);
+	AddPlanets(scene, options.planets, rng);
+	AddMoons(scene, options.moons, rng);
+	if (options.asteroids >= 0)
+	{
+		if (scene.belts.empty())
+		{
+			scene.belts.push_back({ "Main", AsteroidBelt::Band() });
+		}
+		SetAsteroidCount(scene, options.asteroids);
+	}
+
+	std::ofstream file(options.outputPath, std::ios::binary);
+	if (options.binary)
+	{
+		const std::vector<unsigned char> bytes = PackScene(scene);
+		file.write(reinterpret_cast<const char*>(bytes.data()), (std::streamsize)bytes.size());
+	}
+	else
+	{
+		file << WriteSceneText(scene);
+	}
+	if (!file)
+	{
+		std::cout << "Could not write: " << options.outputPath << "\n";
+		return EXIT_FAILURE;
+	}
+	size_t asteroidCount = 0;
+	for (const SceneBelt& belt : scene.belts)
+	{
+		asteroidCount += (size_t)belt.band.count;
+	}
+	std::cout << "Wrote " << options.outputPath << ": " << scene.bodies.size() << " bodies, " << asteroidCount
+		<< " asteroids in " << scene.belts.size() << " belts\n";
+	return EXIT_SUCCESS;
+}